@@ -0,0 +1,87 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+
+namespace chromium_playwright::crawl {
+
+// Multi-producer, multi-consumer FIFO with a fixed capacity. Push blocks
+// while the queue is full, which is how a slow consumer slows down its
+// producers instead of letting the backlog grow without bound.
+template <typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(size_t capacity) : capacity_(capacity > 0 ? capacity : 1) {}
+
+    BoundedQueue(const BoundedQueue&) = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+    // Blocks while full; false (item dropped) once closed
+    bool Push(T item) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (items_.size() >= capacity_ && !closed_) {
+            ++full_waits_;
+            not_full_.wait(lock, [this] { return items_.size() < capacity_ || closed_; });
+        }
+        if (closed_) return false;
+
+        items_.push_back(std::move(item));
+        if (items_.size() > max_size_) max_size_ = items_.size();
+        lock.unlock();
+        not_empty_.notify_one();
+        return true;
+    }
+
+    // Blocks while empty; false once closed and drained
+    bool Pop(T& item) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_empty_.wait(lock, [this] { return !items_.empty() || closed_; });
+        if (items_.empty()) return false;
+
+        item = std::move(items_.front());
+        items_.pop_front();
+        lock.unlock();
+        not_full_.notify_one();
+        return true;
+    }
+
+    // Producers fail from now on; consumers drain what is left
+    void Close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            closed_ = true;
+        }
+        not_full_.notify_all();
+        not_empty_.notify_all();
+    }
+
+    size_t Size() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return items_.size();
+    }
+    size_t Capacity() const { return capacity_; }
+    size_t GetMaxSize() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return max_size_;
+    }
+    // Pushes that had to wait for room
+    uint64_t GetFullWaits() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return full_waits_;
+    }
+
+private:
+    const size_t capacity_;
+    mutable std::mutex mutex_;
+    std::condition_variable not_full_;
+    std::condition_variable not_empty_;
+    std::deque<T> items_;
+    bool closed_ = false;
+    size_t max_size_ = 0;
+    uint64_t full_waits_ = 0;
+};
+
+} // namespace chromium_playwright::crawl
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <string>
+#include <vector>
+#include "crawl_frontier.h"
+#include "crawl_options.h"
+#include "crawl_task.h"
+#include "visited_set.h"
+
+namespace chromium_playwright::crawl {
+
+// Everything needed to continue a crawl in a new process: the pages
+// already fetched are exactly the visited URLs not in `frontier`
+struct CrawlCheckpoint {
+    CrawlOptions options;
+    std::map<std::string, std::string> metadata;  // Caller session settings
+    std::chrono::system_clock::time_point saved_at;
+    size_t total_pages = 0;
+    std::vector<uint64_t> visited;    // URL fingerprints, see UrlFingerprint
+    std::vector<CrawlTask> frontier;  // Queued, not yet fetched
+};
+
+// Binary format inside a record file (see record_file.h): version,
+// options and metadata, page counter, visited fingerprints sorted and
+// delta-coded as varints, then the frontier as front-coded SpillQueue
+// segments ended by an empty one.
+bool WriteCheckpoint(const std::filesystem::path& path, const CrawlCheckpoint& checkpoint);
+
+// Same format, streamed from a live crawl: fingerprints go out one shard
+// and tasks one segment at a time, so writing costs little memory beyond
+// what the set and frontier already hold. The `visited` and `frontier`
+// members of `header` are ignored.
+bool WriteCheckpoint(const std::filesystem::path& path, const CrawlCheckpoint& header, const VisitedUrlSet& visited,
+                     const CrawlFrontier& frontier);
+
+// False if the file is missing, truncated or fails its checksum
+bool ReadCheckpoint(const std::filesystem::path& path, CrawlCheckpoint& checkpoint);
+
+} // namespace chromium_playwright::crawl
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "checkpoint.h"
+#include "crawl_frontier.h"
+#include "crawl_options.h"
+#include "domain_matcher.h"
+#include "robots.h"
+#include "trap_detector.h"
+#include "visited_set.h"
+
+namespace chromium_playwright::crawl {
+
+// Reported by the worker that just finished a page
+struct CrawlProgress {
+    size_t worker = 0;
+    const CrawlTask* task = nullptr;
+    size_t worker_pages = 0;  // Pages this worker has processed
+    size_t total_pages = 0;   // Pages processed by all workers
+    size_t queued = 0;        // Tasks waiting in the frontier
+};
+
+struct CrawlStats {
+    size_t total_pages = 0;
+    std::vector<size_t> pages_per_worker;
+    std::vector<size_t> steals_per_worker;
+    VisitedSetStats visited;
+    SpillQueueStats spill;
+    size_t checkpoints = 0;  // Written during the last run
+    size_t filtered_links = 0;  // Seeds and links dropped by the domain rules
+    TrapStats traps;
+    size_t robots_blocked = 0;  // Seeds and links robots.txt disallows, each time one is found
+};
+
+// Multi-threaded crawl over a WorkStealingFrontier. The page handler runs
+// on worker threads and returns the links it found; the engine dedupes
+// them, tracks depth and stops at max_depth / max_pages. Handler and
+// progress callback must be safe to call concurrently.
+class CrawlEngine {
+public:
+    using PageHandler = std::function<std::vector<std::string>(const CrawlTask& task, size_t worker)>;
+    using ProgressCallback = std::function<void(const CrawlProgress& progress)>;
+
+    explicit CrawlEngine(CrawlOptions options = {});
+
+    void SetProgressCallback(ProgressCallback callback) { progress_callback_ = std::move(callback); }
+
+    // Seeds and links robots.txt disallows are dropped; the cache fetches
+    // each origin's rules from a worker thread on first sight. An origin's
+    // Crawl-delay raises its politeness delay under HOST_PRIORITY. Set
+    // before Run; null turns the check off.
+    void SetRobotsCache(std::shared_ptr<RobotsCache> robots) { robots_ = std::move(robots); }
+
+    // Called for every template the trap detector throttles or prunes
+    void SetTrapCallback(TrapDetector::ReportCallback callback) { trap_callback_ = std::move(callback); }
+
+    // Tells the trap detector whether a page the handler fetched had new
+    // content; without it only link growth and looping paths are judged.
+    // Call from the handler. No-op unless detect_traps is set.
+    void RecordContentNovelty(const CrawlTask& task, bool novel);
+
+    // Blocks until the crawl completes or Stop() is called; returns the
+    // number of pages handed to `handler`
+    size_t Run(const std::vector<std::string>& seeds, const PageHandler& handler);
+
+    // Continues a crawl saved by checkpointing (see CrawlOptions): options
+    // other than worker_count, visited URLs, queued tasks and the page
+    // count come from the file, and checkpoints keep going to `path`.
+    // Pages fetched before the checkpoint are not handed to `handler`
+    // again. Returns the total page count, or 0 if the file is unusable.
+    size_t ResumeFromCheckpoint(const std::filesystem::path& path, const PageHandler& handler);
+
+    // Stored with every checkpoint, e.g. the scraping session's config
+    void SetCheckpointMetadata(std::map<std::string, std::string> metadata) { metadata_ = std::move(metadata); }
+    const std::map<std::string, std::string>& GetCheckpointMetadata() const { return metadata_; }
+
+    // Safe from any thread, including from inside the handler
+    void Stop();
+    bool IsRunning() const { return running_.load(std::memory_order_acquire); }
+
+    CrawlStats GetStats() const;
+    const CrawlOptions& GetOptions() const { return options_; }
+
+private:
+    struct alignas(64) WorkerCounter {
+        std::atomic<size_t> pages{0};
+    };
+
+    CrawlOptions options_;
+    ProgressCallback progress_callback_;
+    TrapDetector::ReportCallback trap_callback_;
+    std::shared_ptr<RobotsCache> robots_;
+    VisitedUrlSet visited_;  // Canonical URL fingerprints, seeds included
+    std::map<std::string, std::string> metadata_;
+    DomainFilter domain_filter_;  // Compiled from options_ at the start of a run
+
+    mutable std::mutex run_mutex_;  // Guards per-run state against Stop() and GetStats()
+    std::shared_ptr<CrawlFrontier> frontier_;
+    std::unique_ptr<TrapDetector> trap_detector_;  // Set when detect_traps is
+    std::vector<std::unique_ptr<WorkerCounter>> worker_pages_;
+    std::atomic<size_t> claimed_pages_{0};
+    std::atomic<size_t> total_pages_{0};
+    std::atomic<size_t> filtered_links_{0};
+    std::atomic<size_t> robots_blocked_{0};
+    std::atomic<bool> running_{false};
+    std::atomic<bool> stop_requested_{false};
+
+    // Checkpoints are taken between pages: the worker that finds one due
+    // waits for the others to park or exit, so the frontier, visited set
+    // and counters are consistent with no page half-processed
+    std::mutex checkpoint_mutex_;
+    std::condition_variable checkpoint_cv_;
+    std::atomic<bool> checkpoint_requested_{false};
+    std::atomic<std::chrono::steady_clock::rep> next_checkpoint_{0};
+    size_t parked_workers_ = 0;
+    size_t exited_workers_ = 0;
+    std::atomic<size_t> checkpoints_written_{0};
+
+    std::shared_ptr<CrawlFrontier> BeginRun();
+    size_t RunWorkers(const std::shared_ptr<CrawlFrontier>& frontier, const PageHandler& handler);
+    void WorkerLoop(size_t worker, CrawlFrontier& frontier, const PageHandler& handler);
+    bool RobotsAllow(CrawlFrontier& frontier, const std::string& url);
+    void ParkForCheckpoint();
+    void MaybeCheckpoint(CrawlFrontier& frontier);
+    bool WriteEngineCheckpoint(const CrawlFrontier& frontier);
+};
+
+} // namespace chromium_playwright::crawl
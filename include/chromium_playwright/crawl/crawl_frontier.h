@@ -0,0 +1,112 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "crawl_task.h"
+#include "spill_queue.h"
+
+namespace chromium_playwright::crawl {
+
+struct FrontierOptions {
+    size_t memory_limit = 0;  // Queued tasks kept in RAM before spilling; 0: never spill
+    std::filesystem::path spill_directory;  // Empty: a fresh directory under the temp dir
+    size_t segment_tasks = SpillQueue::kDefaultSegmentTasks;
+};
+
+// Queue of crawl tasks shared by a fixed pool of workers. Implementations
+// track tasks that are queued or still being processed: Pop blocks until
+// a task is available and returns false once both reach zero (the crawl
+// is complete) or after Close().
+class CrawlFrontier {
+public:
+    virtual ~CrawlFrontier() = default;
+
+    // Worker indices wrap, so seeds can be spread with any counter
+    virtual void Push(size_t worker, CrawlTask task) = 0;
+    virtual bool Pop(size_t worker, CrawlTask& task) = 0;
+
+    // Marks a popped task finished. Push its children first, so the
+    // frontier never looks drained while work is still being expanded.
+    virtual void TaskDone() = 0;
+
+    // Pop returns false from now on; tasks pushed later are still kept,
+    // so a checkpoint of a stopped crawl records them
+    virtual void Close() = 0;
+    virtual bool IsClosed() const = 0;
+    virtual size_t Size() const = 0;
+
+    // Visits every queued task without consuming it; false if some could
+    // not be read back. Only consistent while no worker is pushing or
+    // popping, as during an engine checkpoint.
+    virtual bool ForEachQueued(const std::function<void(const CrawlTask&)>& visit) const = 0;
+
+    // Minimum gap between fetches from `host`, e.g. its robots.txt
+    // Crawl-delay. Frontiers that do not pace hosts ignore it.
+    virtual void SetHostDelay(const std::string& /*host*/, std::chrono::milliseconds /*delay*/) {}
+
+    virtual size_t GetStealCount(size_t /*worker*/) const { return 0; }
+    virtual SpillQueueStats GetSpillStats() const { return {}; }
+};
+
+// Frontier shared by a fixed pool of crawl workers. Each worker owns a
+// deque: it pushes the links it discovers and pops them back LIFO, so a
+// worker tends to stay on the site it just fetched. A worker whose deque
+// is empty steals the oldest task from another worker's deque.
+//
+// With a memory limit, tasks pushed while the deques already hold that
+// many go to a SpillQueue instead; workers that find every deque empty
+// refill their own from the oldest spilled tasks in small batches.
+class WorkStealingFrontier : public CrawlFrontier {
+public:
+    explicit WorkStealingFrontier(size_t worker_count, FrontierOptions options = {});
+
+    void Push(size_t worker, CrawlTask task) override;
+    bool Pop(size_t worker, CrawlTask& task) override;
+    void TaskDone() override;
+
+    void Close() override;
+    bool IsClosed() const override { return closed_.load(std::memory_order_acquire); }
+
+    size_t GetWorkerCount() const { return queues_.size(); }
+    size_t Size() const override { return queued_.load(std::memory_order_acquire); }
+    bool ForEachQueued(const std::function<void(const CrawlTask&)>& visit) const override;
+    size_t GetStealCount(size_t worker) const override;
+    size_t GetSpilledCount() const { return spilled_.load(std::memory_order_acquire); }
+    SpillQueueStats GetSpillStats() const override;
+
+private:
+    struct alignas(64) WorkerQueue {
+        mutable std::mutex mutex;
+        std::deque<CrawlTask> tasks;
+        size_t steals = 0;  // Tasks this worker took from others
+    };
+
+    FrontierOptions options_;
+    std::vector<std::unique_ptr<WorkerQueue>> queues_;
+    std::atomic<size_t> queued_{0};     // In deques or spilled
+    std::atomic<size_t> in_memory_{0};  // In deques only
+    std::atomic<size_t> spilled_{0};
+    std::atomic<size_t> outstanding_{0};  // Queued or in flight
+    std::atomic<bool> closed_{false};
+
+    std::mutex idle_mutex_;
+    std::condition_variable idle_cv_;
+
+    mutable std::mutex spill_mutex_;
+    std::unique_ptr<SpillQueue> spill_;  // Created on first spill
+
+    bool TryPop(size_t worker, CrawlTask& task);
+    bool Refill(size_t worker, CrawlTask& task);
+    void WakeIdle(bool all);
+};
+
+} // namespace chromium_playwright::crawl
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include "host_frontier.h"
+#include "trap_detector.h"
+
+namespace chromium_playwright::crawl {
+
+enum class FrontierPolicy {
+    WORK_STEALING,  // Per-worker deques, LIFO locally; fastest for one site
+    HOST_PRIORITY   // Per-host score queues with politeness delays
+};
+
+struct CrawlOptions {
+    size_t worker_count = 0;  // 0: one worker per hardware thread
+    int max_depth = 3;        // Seeds are depth 0; pages at max_depth are not fetched
+    size_t max_pages = 0;     // 0: unlimited
+
+    // Seeds and links these reject are never queued; rule syntax as for
+    // DomainMatcher. Empty allowed_domains: every domain not blocked
+    std::vector<std::string> allowed_domains;
+    std::vector<std::string> blocked_domains;
+
+    // Throttle or prune URL templates that look like crawl traps, so they
+    // cannot drain max_depth/max_pages; see TrapDetector and
+    // CrawlEngine::RecordContentNovelty
+    bool detect_traps = false;
+    TrapOptions trap_options;
+
+    FrontierPolicy frontier_policy = FrontierPolicy::WORK_STEALING;
+    std::chrono::milliseconds politeness_delay{0};  // HOST_PRIORITY only
+    ScoreWeights score_weights;                     // HOST_PRIORITY only
+
+    // Queued tasks held in memory; beyond this the frontier spills to
+    // segment files under spill_directory (empty: the temp dir). 0: no
+    // limit
+    size_t frontier_memory_limit = 0;
+    std::filesystem::path spill_directory;
+
+    // Periodic crash-consistent checkpoints; empty path: none
+    std::filesystem::path checkpoint_path;
+    std::chrono::seconds checkpoint_interval{60};
+};
+
+} // namespace chromium_playwright::crawl
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace chromium_playwright::crawl {
+
+struct CrawlTask {
+    std::string url;
+    int depth = 0;
+    std::string parent_url;
+    size_t link_count = 0;   // Links on the page that discovered this one
+    double freshness = 0.0;  // 0..1, how recently the page is known to have changed
+};
+
+} // namespace chromium_playwright::crawl
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "sitemap_parser.h"
+
+namespace chromium_playwright::crawl {
+
+// Seed and politeness sources beyond the start URL, switched on through
+// ScrapingConfig::custom_settings:
+//   crawl.sitemaps          "true": seed from the site's sitemaps
+//   crawl.sitemap_max_urls  most URLs taken from sitemaps
+//   crawl.robots            "true": skip URLs robots.txt disallows
+//   crawl.user_agent        product token matched against robots.txt groups
+struct DiscoveryOptions {
+    bool use_sitemaps = false;
+    size_t sitemap_max_urls = 50000;
+    bool respect_robots = false;
+    std::string user_agent = "chromium-playwright";
+};
+
+// Unknown keys and unparsable values keep their defaults
+DiscoveryOptions ParseDiscoverySettings(const std::map<std::string, std::string>& settings);
+
+// Streams `url`'s body to `sink` in chunks, stopping early if the sink
+// returns false; false if the fetch failed
+using ChunkFetcher =
+    std::function<bool(const std::string& url, const std::function<bool(std::string_view chunk)>& sink)>;
+
+constexpr size_t kMaxSitemapFiles = 1000;
+
+// Reads `sitemap_urls` and the sitemaps their indexes list, at most
+// kMaxSitemapFiles files, passing each page entry to `emit` until
+// `max_urls` have been. Returns the number emitted.
+size_t CollectSitemapUrls(const std::vector<std::string>& sitemap_urls, const ChunkFetcher& fetch, size_t max_urls,
+                          const std::function<void(const SitemapEntry& entry)>& emit);
+
+} // namespace chromium_playwright::crawl
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace chromium_playwright::crawl {
+
+// Set of domain rules compiled into a trie keyed by reversed host labels
+// (com -> example -> www), so a lookup walks the URL's host once instead
+// of testing every rule. Rules:
+//   example.com           example.com and all of its subdomains
+//   *.example.com         subdomains only
+//   example.com/private   as above, for paths starting with /private
+// A scheme, port or trailing dot in a rule is ignored; hosts compare
+// case-insensitively, paths (prefix match, query included) exactly.
+//
+// Not thread-safe while rules are added; lookups are const.
+class DomainMatcher {
+public:
+    DomainMatcher();
+
+    // False for a rule without a host
+    bool Add(std::string_view rule);
+    void Add(const std::vector<std::string>& rules);
+
+    // `url` is absolute, or host[/path] without a scheme
+    bool Matches(std::string_view url) const;
+
+    size_t Size() const { return rule_count_; }
+    bool Empty() const { return rule_count_ == 0; }
+
+private:
+    static constexpr uint8_t kSelf = 1;        // The node's domain itself
+    static constexpr uint8_t kSubdomains = 2;  // Anything below it
+
+    struct PathRule {
+        std::string prefix;
+        uint8_t scope = 0;
+    };
+
+    struct Node {
+        uint8_t scope = 0;  // Rules without a path
+        std::vector<PathRule> paths;
+    };
+
+    // Child edges of every node in one table, keyed by (parent, label)
+    struct EdgeKey {
+        uint32_t parent;
+        std::string label;
+    };
+    struct EdgeView {
+        uint32_t parent;
+        std::string_view label;
+    };
+    struct EdgeHash {
+        using is_transparent = void;
+        size_t operator()(const EdgeView& edge) const;
+        size_t operator()(const EdgeKey& edge) const { return (*this)(EdgeView{edge.parent, edge.label}); }
+    };
+    struct EdgeEqual {
+        using is_transparent = void;
+        template <typename A, typename B>
+        bool operator()(const A& a, const B& b) const {
+            return a.parent == b.parent && std::string_view(a.label) == std::string_view(b.label);
+        }
+    };
+
+    std::vector<Node> nodes_;  // nodes_[0] is the root
+    std::unordered_map<EdgeKey, uint32_t, EdgeHash, EdgeEqual> edges_;
+    size_t rule_count_ = 0;
+
+    static bool Applies(uint8_t scope, bool at_host);
+};
+
+// Allow and block lists as used by ScrapingConfig: a URL passes if no
+// blocked rule matches and, when there are allowed rules, one of them does
+class DomainFilter {
+public:
+    DomainFilter() = default;
+    DomainFilter(const std::vector<std::string>& allowed, const std::vector<std::string>& blocked);
+
+    bool IsAllowed(std::string_view url) const;
+    bool Empty() const { return allowed_.Empty() && blocked_.Empty(); }
+
+private:
+    DomainMatcher allowed_;
+    DomainMatcher blocked_;
+};
+
+} // namespace chromium_playwright::crawl
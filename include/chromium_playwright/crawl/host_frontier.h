@@ -0,0 +1,114 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "crawl_frontier.h"
+#include "spill_queue.h"
+
+namespace chromium_playwright::crawl {
+
+// Lower-cased host[:port] of an absolute URL; empty if there is none
+std::string UrlHost(std::string_view url);
+
+struct ScoreWeights {
+    double depth = 1.0;      // Shallow pages first
+    double links = 0.5;      // Pages found on link-sparse pages first
+    double freshness = 1.0;  // Recently changed pages first
+};
+
+// Higher scores are fetched first
+double ScoreCrawlTask(const CrawlTask& task, const ScoreWeights& weights = {});
+
+struct HostFrontierOptions {
+    std::chrono::milliseconds politeness_delay{0};  // Minimum gap between fetches from one host
+    std::chrono::milliseconds max_host_delay{std::chrono::seconds(60)};  // Cap on SetHostDelay
+    ScoreWeights weights;
+
+    size_t memory_limit = 0;  // Queued tasks kept in the host queues before spilling; 0: never spill
+    std::filesystem::path spill_directory;  // Empty: a fresh directory under the temp dir
+    size_t segment_tasks = SpillQueue::kDefaultSegmentTasks;
+};
+
+// Two-level frontier for polite crawling. Each host keeps its own queue
+// ordered by ScoreCrawlTask; hosts with queued work sit in a ready queue
+// ordered by the time their politeness delay expires. Pop takes the best
+// task of the earliest fetchable host, so a large site cannot starve the
+// others and a worker only waits when every host is cooling down.
+//
+// With a memory limit, tasks pushed while the host queues already hold
+// that many go to a SpillQueue in arrival order. They are scored and
+// queued under their host again once the host queues drain to half the
+// limit, so ordering and per-host rotation only apply to the tasks in
+// memory.
+class HostPriorityFrontier : public CrawlFrontier {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit HostPriorityFrontier(HostFrontierOptions options = {});
+
+    void Push(size_t worker, CrawlTask task) override;
+    bool Pop(size_t worker, CrawlTask& task) override;
+    void TaskDone() override;
+
+    void Close() override;
+    bool IsClosed() const override { return closed_.load(std::memory_order_acquire); }
+    size_t Size() const override;
+    bool ForEachQueued(const std::function<void(const CrawlTask&)>& visit) const override;
+    SpillQueueStats GetSpillStats() const override;
+
+    // Raises `host`'s gap above politeness_delay, up to max_host_delay.
+    // Such hosts are never swept, so the delay holds for the whole run.
+    void SetHostDelay(const std::string& host, std::chrono::milliseconds delay) override;
+
+    size_t GetHostCount() const;  // Hosts with queued tasks
+
+private:
+    struct Entry {
+        double score = 0.0;
+        uint64_t sequence = 0;  // FIFO among equal scores
+        CrawlTask task;
+    };
+
+    struct Host {
+        std::vector<Entry> tasks;  // Max-heap on (score, -sequence)
+        Clock::time_point next_fetch{};
+        std::chrono::milliseconds delay{0};  // Set by SetHostDelay
+        bool ready = false;  // Listed in ready_
+    };
+
+    struct ReadyHost {
+        Clock::time_point next_fetch;
+        Host* host;
+    };
+
+    HostFrontierOptions options_;
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::unordered_map<std::string, Host> hosts_;  // Node-based: Host* stays valid
+    std::vector<ReadyHost> ready_;                 // Min-heap on next_fetch
+    uint64_t sequence_ = 0;
+    size_t queued_ = 0;       // In host queues or spilled
+    size_t in_memory_ = 0;    // In host queues only
+    size_t outstanding_ = 0;  // Queued or in flight
+    size_t sweep_threshold_ = 1024;
+    std::atomic<bool> closed_{false};
+    std::unique_ptr<SpillQueue> spill_;  // Created on first spill
+
+    static bool ScoresLower(const Entry& a, const Entry& b);
+    static bool FetchesLater(const ReadyHost& a, const ReadyHost& b);
+    void QueueLocked(CrawlTask task, double score);
+    void RefillLocked();
+    void SweepIdleHosts(Clock::time_point now);
+};
+
+} // namespace chromium_playwright::crawl
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace chromium_playwright::crawl {
+
+// 64-bit SimHash over shingles of `shingle_words` consecutive words
+// (lower-cased runs of letters and digits). Pages that differ only in a
+// session id, a timestamp or a pager widget land a few bits apart.
+// 0 if the text has no words.
+uint64_t SimHash(std::string_view text, size_t shingle_words = 3);
+
+int HammingDistance(uint64_t a, uint64_t b);
+
+// Near-duplicate lookup over SimHash fingerprints. The 64 bits are cut
+// into max_distance + 1 bands; two fingerprints within max_distance bits
+// must agree exactly on at least one band, so a lookup only compares
+// against pages sharing a band instead of scanning them all.
+// Fingerprint 0 is never stored or matched: pages without text say
+// nothing about each other. Thread-safe.
+class NearDuplicateIndex {
+public:
+    static constexpr int kMaxDistanceLimit = 7;
+
+    // max_distance is clamped to 0..kMaxDistanceLimit
+    explicit NearDuplicateIndex(int max_distance = 3);
+
+    // URL of a stored page within max_distance bits, if any
+    std::optional<std::string> Find(uint64_t fingerprint) const;
+
+    // Stores the page unless it is a near-duplicate; returns the URL it
+    // duplicates in that case
+    std::optional<std::string> InsertOrFind(std::string_view url, uint64_t fingerprint);
+
+    size_t Size() const;
+    int GetMaxDistance() const { return max_distance_; }
+
+private:
+    struct Page {
+        uint64_t fingerprint;
+        std::string url;
+    };
+
+    const int max_distance_;
+    const int band_bits_;
+    mutable std::mutex mutex_;
+    std::vector<Page> pages_;
+    std::vector<std::unordered_map<uint64_t, std::vector<uint32_t>>> bands_;  // Band value -> page indices
+
+    uint64_t BandValue(uint64_t fingerprint, size_t band) const;
+    std::optional<size_t> FindLocked(uint64_t fingerprint) const;
+};
+
+} // namespace chromium_playwright::crawl
@@ -0,0 +1,168 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "bounded_queue.h"
+
+namespace chromium_playwright::crawl {
+
+struct StageOptions {
+    std::string name;
+    size_t threads = 1;
+    size_t queue_capacity = 64;  // Items waiting in front of this stage
+};
+
+struct StageMetrics {
+    std::string name;
+    size_t threads = 0;
+    uint64_t processed = 0;  // Items passed on (or finished, for the last stage)
+    uint64_t dropped = 0;    // Rejected by the stage or thrown out of it
+    double mean_latency_ms = 0.0;
+    double max_latency_ms = 0.0;
+    size_t queue_depth = 0;
+    size_t max_queue_depth = 0;
+    uint64_t full_waits = 0;  // Pushes into this stage that hit backpressure
+};
+
+// One INFO line per stage
+void LogStageMetrics(const std::vector<StageMetrics>& metrics);
+
+// Logs an exception thrown out of a stage function
+void LogStageFailure(const std::string& stage, const char* what);
+
+// Fixed chain of stages, each with its own thread pool and a bounded
+// queue in front of it. An item flows through the stages in order; a
+// stage returns false to drop it. Because every queue is bounded, a slow
+// stage fills its queue and then blocks the stage before it, and so on
+// back to Submit(), so memory stays bounded without any stage polling.
+template <typename Item>
+class Pipeline {
+public:
+    using StageFunction = std::function<bool(Item& item)>;
+
+    Pipeline() = default;
+    ~Pipeline() { Finish(); }
+
+    Pipeline(const Pipeline&) = delete;
+    Pipeline& operator=(const Pipeline&) = delete;
+
+    // Stages run in the order added; add them all before Start()
+    void AddStage(StageOptions options, StageFunction function) {
+        auto stage = std::make_unique<Stage>(options.queue_capacity);
+        stage->options = std::move(options);
+        stage->options.threads = std::max<size_t>(1, stage->options.threads);
+        stage->function = std::move(function);
+        stages_.push_back(std::move(stage));
+    }
+
+    void Start() {
+        for (size_t index = 0; index < stages_.size(); ++index) {
+            Stage& stage = *stages_[index];
+            stage.active_threads = stage.options.threads;
+            for (size_t i = 0; i < stage.options.threads; ++i) {
+                stage.threads.emplace_back([this, index] { RunStage(index); });
+            }
+        }
+    }
+
+    // Blocks while the first stage is backed up; false after Finish()
+    bool Submit(Item item) { return !stages_.empty() && stages_.front()->queue.Push(std::move(item)); }
+
+    // Stops accepting items, lets everything queued drain through every
+    // stage, then joins all threads
+    void Finish() {
+        if (stages_.empty()) return;
+        stages_.front()->queue.Close();
+        for (auto& stage : stages_) {
+            for (auto& thread : stage->threads) {
+                if (thread.joinable()) thread.join();
+            }
+        }
+    }
+
+    std::vector<StageMetrics> GetMetrics() const {
+        std::vector<StageMetrics> metrics;
+        metrics.reserve(stages_.size());
+        for (const auto& stage : stages_) {
+            StageMetrics stage_metrics;
+            stage_metrics.name = stage->options.name;
+            stage_metrics.threads = stage->options.threads;
+            stage_metrics.processed = stage->processed.load(std::memory_order_relaxed);
+            stage_metrics.dropped = stage->dropped.load(std::memory_order_relaxed);
+            const uint64_t items = stage_metrics.processed + stage_metrics.dropped;
+            if (items > 0) {
+                stage_metrics.mean_latency_ms =
+                    static_cast<double>(stage->busy_ns.load(std::memory_order_relaxed)) / 1e6 / static_cast<double>(items);
+            }
+            stage_metrics.max_latency_ms = static_cast<double>(stage->max_ns.load(std::memory_order_relaxed)) / 1e6;
+            stage_metrics.queue_depth = stage->queue.Size();
+            stage_metrics.max_queue_depth = stage->queue.GetMaxSize();
+            stage_metrics.full_waits = stage->queue.GetFullWaits();
+            metrics.push_back(std::move(stage_metrics));
+        }
+        return metrics;
+    }
+
+private:
+    struct Stage {
+        explicit Stage(size_t capacity) : queue(capacity) {}
+
+        StageOptions options;
+        StageFunction function;
+        BoundedQueue<Item> queue;
+        std::vector<std::thread> threads;
+        std::atomic<size_t> active_threads{0};
+        std::atomic<uint64_t> processed{0};
+        std::atomic<uint64_t> dropped{0};
+        std::atomic<uint64_t> busy_ns{0};
+        std::atomic<uint64_t> max_ns{0};
+    };
+
+    std::vector<std::unique_ptr<Stage>> stages_;
+
+    void RunStage(size_t index) {
+        Stage& stage = *stages_[index];
+        Stage* next = index + 1 < stages_.size() ? stages_[index + 1].get() : nullptr;
+
+        Item item;
+        while (stage.queue.Pop(item)) {
+            const auto start = std::chrono::steady_clock::now();
+            bool keep = false;
+            try {
+                keep = stage.function(item);
+            } catch (const std::exception& e) {
+                LogStageFailure(stage.options.name, e.what());
+            }
+            const auto elapsed = static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+
+            stage.busy_ns.fetch_add(elapsed, std::memory_order_relaxed);
+            uint64_t max_ns = stage.max_ns.load(std::memory_order_relaxed);
+            while (elapsed > max_ns && !stage.max_ns.compare_exchange_weak(max_ns, elapsed, std::memory_order_relaxed)) {
+            }
+
+            if (!keep) {
+                stage.dropped.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+            stage.processed.fetch_add(1, std::memory_order_relaxed);
+            if (next) next->queue.Push(std::move(item));
+        }
+
+        // The last thread out closes the next queue so it can drain in turn
+        if (stage.active_threads.fetch_sub(1, std::memory_order_acq_rel) == 1 && next) {
+            next->queue.Close();
+        }
+    }
+};
+
+} // namespace chromium_playwright::crawl
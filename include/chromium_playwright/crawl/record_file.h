@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <string_view>
+
+namespace chromium_playwright::crawl {
+
+// Framing for the crawl's state files: a 4-byte magic, the payload, then
+// an FNV-1a checksum of both.
+//
+// The file is written next to `path`, synced, renamed over it and the
+// directory synced, so after a crash `path` holds either the previous
+// file or the new one in full.
+bool WriteRecordFile(const std::filesystem::path& path, const char (&magic)[4], const std::string& payload);
+
+// False if the file is missing, has another magic, or fails its checksum
+bool ReadRecordFile(const std::filesystem::path& path, const char (&magic)[4], std::string& payload);
+
+// Writes a record file piece by piece, keeping only the running checksum
+// in memory. `path` is untouched until Commit succeeds; an uncommitted
+// writer removes its temporary file.
+class RecordFileWriter {
+public:
+    RecordFileWriter(std::filesystem::path path, const char (&magic)[4]);
+    ~RecordFileWriter();
+
+    RecordFileWriter(const RecordFileWriter&) = delete;
+    RecordFileWriter& operator=(const RecordFileWriter&) = delete;
+
+    void Append(std::string_view data);
+    bool Commit();
+
+private:
+    std::filesystem::path path_;
+    std::filesystem::path temp_path_;
+    std::FILE* file_ = nullptr;
+    uint64_t checksum_;
+    bool failed_ = false;
+};
+
+} // namespace chromium_playwright::crawl
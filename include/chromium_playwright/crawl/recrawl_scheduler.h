@@ -0,0 +1,92 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace chromium_playwright::crawl {
+
+struct RecrawlOptions {
+    // Expected time until a page fetched now can be revisited, i.e. the
+    // length of one recrawl round; freshness gains are measured over it
+    std::chrono::seconds revisit_horizon{std::chrono::hours(24)};
+
+    // Assumed for pages fetched only once (changes per second)
+    double initial_change_rate = 1.0 / (7 * 24 * 3600);
+};
+
+// Per-URL visit history, as persisted
+struct UrlChangeHistory {
+    std::chrono::system_clock::time_point last_visit;
+    uint32_t visits = 0;
+    uint32_t changes = 0;              // Visits that found the content changed
+    double observed_seconds = 0.0;     // Sum of the intervals between visits
+    uint64_t content_hash = 0;         // As of last_visit, see RecordContent
+};
+
+// Decides which known pages to refetch. Each page is modelled as changing
+// by a Poisson process; its rate is estimated from how many revisits found
+// it changed, using Cho & Garcia-Molina's estimator
+//   rate = -ln((n - X + 0.5) / (n + 0.5)) / mean interval
+// for n revisits with X changes, which stays finite when every revisit saw
+// a change.
+//
+// Schedule ranks pages by the expected freshness a fetch now adds over the
+// revisit horizon H, for a page last fetched t ago:
+//   (1 - e^(-rate t)) (1 - e^(-rate H)) / (rate H)
+// The first factor is the chance the stored copy is stale; the second is
+// how long a fresh copy then stays fresh. Pages changing much faster than
+// H are stale again almost at once, so the budget goes to pages a fetch
+// actually keeps fresh rather than to the busiest ones.
+//
+// Thread-safe.
+class RecrawlScheduler {
+public:
+    using Clock = std::chrono::system_clock;
+
+    explicit RecrawlScheduler(RecrawlOptions options = {});
+
+    // Records a fetch of `url` and whether its content differed from the
+    // previous fetch; the first fetch of a URL only starts its history
+    void RecordVisit(const std::string& url, bool changed, Clock::time_point at = Clock::now());
+
+    // Same, deciding `changed` by comparing with the hash stored at the
+    // previous visit, e.g. ChangeDetector::ComputeContentHash output;
+    // returns whether it changed
+    bool RecordContent(const std::string& url, std::string_view content_hash, Clock::time_point at = Clock::now());
+
+    // Estimated changes per second; initial_change_rate until revisited
+    double EstimateChangeRate(const std::string& url) const;
+
+    // Expected freshness gained by fetching `url` at `now`, in [0, 1]
+    double RevisitGain(const std::string& url, Clock::time_point now = Clock::now()) const;
+
+    // Up to `budget` known URLs worth refetching at `now`, best first
+    std::vector<std::string> Schedule(size_t budget, Clock::time_point now = Clock::now()) const;
+
+    // Binary record file (see record_file.h) holding every URL's history
+    bool Save(const std::filesystem::path& path) const;
+    // Replaces the current histories; false if the file is unusable
+    bool Load(const std::filesystem::path& path);
+
+    bool GetHistory(const std::string& url, UrlChangeHistory& history) const;
+    size_t Size() const;
+    const RecrawlOptions& GetOptions() const { return options_; }
+
+private:
+    RecrawlOptions options_;
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, UrlChangeHistory> history_;
+
+    void RecordLocked(UrlChangeHistory& history, bool changed, Clock::time_point at);
+    double RateLocked(const UrlChangeHistory& history) const;
+    double GainLocked(const UrlChangeHistory& history, Clock::time_point now) const;
+};
+
+} // namespace chromium_playwright::crawl
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include "bounded_queue.h"
+
+namespace chromium_playwright::crawl {
+
+// Pull-based cursor over results as a crawl produces them. At most
+// `capacity` results wait unconsumed: past that, Publish blocks, which
+// stalls the stage calling it and, through the pipeline's bounded
+// queues, the crawl workers. The consumer owns each result it pulls, so
+// nothing is retained once it has been handed over.
+template <typename T>
+class ResultStream {
+public:
+    explicit ResultStream(size_t capacity = 64) : queue_(capacity) {}
+
+    // Producer side. Blocks while the consumer is `capacity` behind;
+    // false once the consumer has cancelled, so the crawl can stop.
+    bool Publish(T result) {
+        if (cancelled_.load(std::memory_order_acquire)) return false;
+        if (!queue_.Push(std::move(result))) return false;
+        published_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Producer side: no more results; Next drains what is queued
+    void Finish() { queue_.Close(); }
+
+    // Blocks until a result is ready; false once the producer finished
+    // and everything was delivered, or after Cancel()
+    bool Next(T& result) {
+        if (cancelled_.load(std::memory_order_acquire) || !queue_.Pop(result)) return false;
+        delivered_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Consumer side: stop listening and release anything still queued
+    void Cancel() {
+        cancelled_.store(true, std::memory_order_release);
+        queue_.Close();
+        T discarded;
+        while (queue_.Pop(discarded)) {
+        }
+    }
+
+    bool IsCancelled() const { return cancelled_.load(std::memory_order_acquire); }
+    size_t Pending() const { return queue_.Size(); }
+    size_t Capacity() const { return queue_.Capacity(); }
+    uint64_t GetPublishedCount() const { return published_.load(std::memory_order_relaxed); }
+    uint64_t GetDeliveredCount() const { return delivered_.load(std::memory_order_relaxed); }
+    // Times the producer had to wait for the consumer
+    uint64_t GetStallCount() const { return queue_.GetFullWaits(); }
+
+private:
+    BoundedQueue<T> queue_;
+    std::atomic<bool> cancelled_{false};
+    std::atomic<uint64_t> published_{0};
+    std::atomic<uint64_t> delivered_{0};
+};
+
+} // namespace chromium_playwright::crawl
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace chromium_playwright::crawl {
+
+// scheme://host[:port], lower-cased; empty if `url` is not absolute
+std::string UrlOrigin(std::string_view url);
+
+// Path and query of an absolute URL, without the fragment; "/" if it has none
+std::string_view UrlPath(std::string_view url);
+
+// robots.txt rules for one user agent, per RFC 9309: the longest matching
+// Allow/Disallow pattern decides, Allow winning ties, and no match allows.
+// Plain patterns are compiled into a byte trie walked once per path;
+// patterns with * or $ are tried longest first, and only while they could
+// still beat the trie's match.
+class RobotsRules {
+public:
+    RobotsRules() = default;  // Allows everything
+
+    // Uses the groups naming `user_agent`'s product token (case-insensitive),
+    // else the * groups
+    static RobotsRules Parse(std::string_view robots_txt, std::string_view user_agent);
+    static RobotsRules DisallowAll();
+
+    // `path` is the URL's path and query
+    bool IsAllowed(std::string_view path) const;
+
+    std::chrono::milliseconds GetCrawlDelay() const { return crawl_delay_; }
+    const std::vector<std::string>& GetSitemaps() const { return sitemaps_; }
+    size_t GetRuleCount() const { return rule_count_; }
+
+private:
+    static constexpr int8_t kNoRule = -1;
+
+    struct WildcardRule {
+        std::string pattern;
+        bool allow = false;
+    };
+
+    // Trie over plain patterns; node 0 is the root. Edges are keyed by
+    // parent node and byte.
+    std::vector<int8_t> verdicts_{kNoRule};  // Per node: kNoRule, 0 disallow, 1 allow
+    std::unordered_map<uint64_t, uint32_t> edges_;
+    std::vector<WildcardRule> wildcard_rules_;  // Longest first, Allow first among equals
+
+    std::chrono::milliseconds crawl_delay_{0};
+    std::vector<std::string> sitemaps_;
+    size_t rule_count_ = 0;
+
+    void AddRule(std::string_view pattern, bool allow);
+    static bool WildcardMatches(std::string_view pattern, std::string_view path);
+};
+
+// How a robots.txt fetch ended, as RFC 9309 section 2.3.1 classifies it
+enum class RobotsFetchStatus {
+    OK,           // 2xx; the body holds the file
+    UNAVAILABLE,  // 4xx: there are no rules, so everything is allowed
+    UNREACHABLE   // 5xx, network failure or timeout: everything is disallowed
+};
+
+// Classifies the final HTTP status of a robots.txt fetch; 0 means there
+// was no response. 429 counts as unreachable, like a 5xx.
+RobotsFetchStatus RobotsFetchStatusForHttp(int status_code);
+
+struct RobotsCacheOptions {
+    std::chrono::seconds ttl{std::chrono::hours(24)};
+    std::chrono::seconds unreachable_ttl{std::chrono::minutes(10)};  // Retry a down origin sooner
+    size_t max_hosts = 10000;
+};
+
+// robots.txt rules per origin, fetched on first use and kept for `ttl`.
+// Concurrent lookups for an origin being fetched wait for that one fetch.
+// Thread-safe.
+class RobotsCache {
+public:
+    // Fills `body` with robots_url's content on OK. A fetcher that throws
+    // counts as UNREACHABLE.
+    using Fetcher = std::function<RobotsFetchStatus(const std::string& robots_url, std::string& body)>;
+
+    RobotsCache(Fetcher fetcher, std::string user_agent, RobotsCacheOptions options = {});
+
+    // Relative URLs are allowed
+    bool IsAllowed(std::string_view url);
+
+    // Null for relative URLs
+    std::shared_ptr<const RobotsRules> GetRules(std::string_view url);
+
+    size_t Size() const;
+    size_t GetFetchCount() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Entry {
+        std::shared_future<std::shared_ptr<const RobotsRules>> rules;
+        Clock::time_point expires_at;
+    };
+
+    Fetcher fetcher_;
+    std::string user_agent_;
+    RobotsCacheOptions options_;
+
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, Entry> entries_;  // By origin
+    size_t fetches_ = 0;
+
+    std::shared_ptr<const RobotsRules> Fetch(const std::string& origin, bool& reachable);
+    void EvictLocked(Clock::time_point now);
+};
+
+} // namespace chromium_playwright::crawl
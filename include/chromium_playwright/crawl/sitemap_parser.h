@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace chromium_playwright::crawl {
+
+struct SitemapEntry {
+    std::string url;
+    std::string lastmod;      // As written, e.g. 2024-05-01; empty if absent
+    double priority = -1.0;   // 0..1; -1 if absent
+    bool is_sitemap = false;  // From a sitemap index: another sitemap to read
+};
+
+// Push parser for sitemap.xml files and sitemap indexes, plain or gzipped
+// (detected from the first byte). Input arrives in chunks of any size and
+// entries are reported as each <url> or <sitemap> element closes, so memory
+// stays constant however large the file is: only the current tag and the
+// current field are buffered, and fields beyond kMaxFieldBytes are dropped.
+//
+// Namespace prefixes, comments, CDATA and the five XML entities plus
+// numeric character references are handled; anything else in the
+// document is skipped. Fields count only as direct children of the entry
+// in its own prefix, so extensions such as <image:image><image:loc> are
+// ignored.
+class SitemapParser {
+public:
+    // Returning false stops parsing
+    using EntryCallback = std::function<bool(const SitemapEntry& entry)>;
+
+    static constexpr size_t kMaxFieldBytes = 4096;  // The protocol caps URLs at 2048
+
+    explicit SitemapParser(EntryCallback callback);
+    ~SitemapParser();
+
+    SitemapParser(const SitemapParser&) = delete;
+    SitemapParser& operator=(const SitemapParser&) = delete;
+
+    // False once the callback stopped parsing or gzip data is corrupt
+    bool Feed(std::string_view chunk);
+
+    // End of input; false if a gzip stream was cut short
+    bool Finish();
+
+    size_t GetEntryCount() const { return entries_; }
+
+private:
+    enum class State { TEXT, TAG, COMMENT, CDATA };
+    enum class Field { NONE, LOC, LASTMOD, PRIORITY };
+
+    struct Inflater;
+
+    EntryCallback callback_;
+    std::unique_ptr<Inflater> inflater_;
+    bool started_ = false;
+    bool stopped_ = false;
+    size_t entries_ = 0;
+
+    State state_ = State::TEXT;
+    std::string tag_;     // Name of the tag being read, up to a bound
+    size_t tag_size_ = 0;  // Including what did not fit
+    std::string marker_;  // Recent characters, to spot "-->" and "]]>"
+
+    Field field_ = Field::NONE;
+    std::string text_;
+    bool text_overflow_ = false;
+    bool in_entry_ = false;
+    size_t entry_depth_ = 0;    // Open elements inside the entry
+    std::string entry_prefix_;  // Namespace prefix of the entry element
+    SitemapEntry entry_;
+
+    bool ParseXml(std::string_view data);
+    void OnTag();
+    void AppendText(char c);
+    void CloseEntry();
+};
+
+// Decodes &amp; &lt; &gt; &quot; &apos; and &#NN; / &#xNN; references
+std::string DecodeXmlEntities(std::string_view text);
+
+} // namespace chromium_playwright::crawl
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <vector>
+#include "crawl_task.h"
+
+namespace chromium_playwright::crawl {
+
+struct SpillQueueStats {
+    size_t segments_written = 0;
+    size_t segments_read = 0;
+    uint64_t raw_bytes = 0;      // URL bytes before encoding
+    uint64_t encoded_bytes = 0;  // Bytes written to segment files
+    size_t tasks_on_disk = 0;
+};
+
+// FIFO queue of crawl tasks kept mostly on disk. New tasks collect in a
+// write buffer; every `segment_tasks` of them are encoded into one
+// append-only segment file. Pop drains the oldest segment first, reading
+// each file sequentially in one go and deleting it once loaded, so at
+// most two segments' worth of tasks are ever in memory.
+//
+// Segments are compressed by front coding: each URL (and parent URL)
+// stores only the suffix that differs from the previous record's, which
+// is most of the win for link lists harvested page by page.
+//
+// Not thread-safe. If a segment cannot be written the tasks stay in
+// memory; unreadable segments are logged and skipped.
+class SpillQueue {
+public:
+    static constexpr size_t kDefaultSegmentTasks = 64 * 1024;
+
+    // An empty directory means a fresh one under the system temp directory
+    explicit SpillQueue(std::filesystem::path directory = {}, size_t segment_tasks = kDefaultSegmentTasks);
+    ~SpillQueue();  // Removes any remaining segment files
+
+    SpillQueue(const SpillQueue&) = delete;
+    SpillQueue& operator=(const SpillQueue&) = delete;
+
+    void Push(CrawlTask task);
+    bool Pop(CrawlTask& task);
+
+    // Visits every queued task, oldest first, without consuming them.
+    // Segments are decoded one at a time; false if one could not be read.
+    bool ForEach(const std::function<void(const CrawlTask&)>& visit) const;
+
+    size_t Size() const { return size_; }
+    bool Empty() const { return size_ == 0; }
+    size_t InMemory() const { return read_buffer_.size() + write_buffer_.size(); }
+    const std::filesystem::path& GetDirectory() const { return directory_; }
+    SpillQueueStats GetStats() const;
+
+    // Segment encoding, exposed for tests and tooling
+    static std::string EncodeSegment(const std::vector<CrawlTask>& tasks);
+    static bool DecodeSegment(const std::string& data, std::deque<CrawlTask>& tasks);
+
+private:
+    std::filesystem::path directory_;
+    bool owns_directory_ = false;
+    size_t segment_tasks_;
+
+    struct Segment {
+        std::filesystem::path path;
+        size_t tasks = 0;
+    };
+
+    std::deque<CrawlTask> read_buffer_;    // Decoded oldest segment
+    std::vector<CrawlTask> write_buffer_;  // Newest tasks, not yet on disk
+    std::deque<Segment> segments_;         // On disk, oldest first
+    size_t next_segment_ = 0;
+    size_t size_ = 0;
+    SpillQueueStats stats_;
+
+    bool WriteSegment();
+    bool LoadOldestSegment();
+};
+
+} // namespace chromium_playwright::crawl
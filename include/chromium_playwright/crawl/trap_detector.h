@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace chromium_playwright::crawl {
+
+// Path and query shape of a URL: digit runs become {n}, long hex ids
+// {id}, and the query keeps only its sorted parameter names, so
+//   /events/2024-05-01?sid=9f&view=day  ->  /events/{n}-{n}-{n}?sid&view
+std::string UrlTemplate(std::string_view url);
+
+enum class TrapAction {
+    ADMIT,     // Queue every new URL
+    THROTTLE,  // Queue one in TrapOptions::throttle_keep
+    PRUNE      // Queue none
+};
+
+struct TrapOptions {
+    size_t min_samples = 16;         // Pages judged before a novelty ratio counts
+    double throttle_below = 0.25;    // Novel share of judged pages below which to throttle
+    double prune_below = 0.05;       // ... and below which to prune
+    size_t throttle_keep = 8;
+    size_t max_template_urls = 1000;  // URLs queued under one template before it is throttled
+    size_t max_segment_repeats = 3;   // Paths repeating a segment this often are pruned
+    size_t max_segment_values = 100;  // Distinct segments after one path prefix before it becomes {*}
+    size_t max_host_templates = 1024; // Templates tracked per host; later ones share {other}
+};
+
+// One escalation of a template's action
+struct TrapReport {
+    std::string host;
+    std::string url_template;
+    TrapAction action = TrapAction::ADMIT;
+    std::string reason;
+    size_t discovered = 0;  // New URLs seen under the template
+    size_t judged = 0;      // Fetched pages with a novelty verdict
+    size_t novel = 0;
+};
+
+struct TrapStats {
+    size_t templates = 0;
+    size_t admitted = 0;
+    size_t throttled = 0;  // URLs dropped by throttled templates
+    size_t pruned = 0;     // URLs dropped by pruned templates
+};
+
+// Learns URL templates per host and spots infinite spaces such as
+// calendars, faceted search and session ids in paths: templates whose
+// pages rarely bring novel content, that keep producing new URLs, or
+// whose paths loop. Their further URLs are throttled, then pruned;
+// actions only escalate, and each escalation is logged and reported.
+//
+// Slugs and other free-form segments would give every page its own
+// template, so per host the detector counts the distinct segments seen
+// after each path prefix and turns a position with too many into {*}
+// (/blog/{*}). Templates and prefixes per host are capped as well.
+//
+// Thread-safe. The report callback runs on the calling thread with no
+// lock held.
+class TrapDetector {
+public:
+    using ReportCallback = std::function<void(const TrapReport& report)>;
+
+    explicit TrapDetector(TrapOptions options = {});
+
+    void SetReportCallback(ReportCallback callback) { report_callback_ = std::move(callback); }
+
+    // Call once per newly discovered URL; false if it should not be queued
+    bool Admit(std::string_view url);
+
+    // Whether a fetched page brought content not seen before, e.g. it was
+    // not a near-duplicate (see NearDuplicateIndex)
+    void RecordContent(std::string_view url, bool novel);
+
+    TrapAction GetAction(std::string_view url) const;
+    std::vector<TrapReport> GetReports() const;
+    TrapStats GetStats() const;
+
+private:
+    struct Pattern {
+        TrapAction action = TrapAction::ADMIT;
+        size_t discovered = 0;
+        size_t admitted = 0;
+        size_t judged = 0;
+        size_t novel = 0;
+    };
+
+    struct SegmentValues {
+        std::unordered_set<std::string> values;  // Cleared once collapsed
+        bool collapsed = false;
+    };
+
+    struct Host {
+        std::unordered_map<std::string, Pattern> patterns;        // By template
+        std::unordered_map<std::string, SegmentValues> segments;  // By generalized path prefix
+    };
+
+    TrapOptions options_;
+    ReportCallback report_callback_;
+
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, Host> hosts_;
+    std::vector<TrapReport> reports_;
+    TrapStats stats_;
+
+    void LearnSegments(Host& host, std::string_view url) const;
+    std::string TemplateFor(const Host& host, std::string_view url) const;
+    Pattern& PatternFor(std::string_view url, std::string& host, std::string& url_template);
+    bool Escalate(Pattern& pattern, TrapAction action, const std::string& host, const std::string& url_template,
+                  std::string reason, TrapReport& report);
+    void Publish(const TrapReport& report);
+};
+
+} // namespace chromium_playwright::crawl
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+namespace chromium_playwright::crawl {
+
+// LEB128 varints and fixed-width fields shared by the on-disk crawl formats
+
+inline void PutVarint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out += static_cast<char>((value & 0x7f) | 0x80);
+        value >>= 7;
+    }
+    out += static_cast<char>(value);
+}
+
+inline bool GetVarint(const char*& cursor, const char* end, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64 && cursor < end; shift += 7) {
+        const auto byte = static_cast<unsigned char>(*cursor++);
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) return true;
+    }
+    return false;
+}
+
+template <typename T>
+bool GetInteger(const char*& cursor, const char* end, T& value) {
+    uint64_t raw = 0;
+    if (!GetVarint(cursor, end, raw)) return false;
+    value = static_cast<T>(raw);
+    return true;
+}
+
+// Little-endian
+inline void PutFixed64(std::string& out, uint64_t value) {
+    for (int i = 0; i < 8; ++i) {
+        out += static_cast<char>(value >> (8 * i));
+    }
+}
+
+inline bool GetFixed64(const char*& cursor, const char* end, uint64_t& value) {
+    if (end - cursor < 8) return false;
+    value = 0;
+    for (int i = 0; i < 8; ++i) {
+        value |= static_cast<uint64_t>(static_cast<unsigned char>(cursor[i])) << (8 * i);
+    }
+    cursor += 8;
+    return true;
+}
+
+inline void PutDouble(std::string& out, double value) {
+    uint64_t bits = 0;
+    std::memcpy(&bits, &value, sizeof(bits));
+    PutFixed64(out, bits);
+}
+
+inline bool GetDouble(const char*& cursor, const char* end, double& value) {
+    uint64_t bits = 0;
+    if (!GetFixed64(cursor, end, bits)) return false;
+    std::memcpy(&value, &bits, sizeof(value));
+    return true;
+}
+
+// Length-prefixed
+inline void PutString(std::string& out, const std::string& value) {
+    PutVarint(out, value.size());
+    out += value;
+}
+
+inline bool GetString(const char*& cursor, const char* end, std::string& value) {
+    uint64_t size = 0;
+    if (!GetVarint(cursor, end, size) || size > static_cast<uint64_t>(end - cursor)) return false;
+    value.assign(cursor, static_cast<size_t>(size));
+    cursor += size;
+    return true;
+}
+
+} // namespace chromium_playwright::crawl
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace chromium_playwright::crawl {
+
+// Canonical form used for visited checks: lower-cased scheme and host,
+// default port and fragment dropped, empty path replaced by "/"
+std::string CanonicalizeUrl(std::string_view url);
+
+// 64-bit hash of raw bytes: FNV-1a followed by the MurmurHash3 finalizer
+uint64_t HashBytes(std::string_view data);
+
+// 64-bit fingerprint of the canonical URL; never 0
+uint64_t UrlFingerprint(std::string_view url);
+
+struct VisitedSetStats {
+    size_t urls = 0;
+    size_t table_bytes = 0;
+    size_t bloom_bytes = 0;
+    uint64_t bloom_rejections = 0;  // Lookups answered by the filter alone
+
+    size_t TotalBytes() const { return table_bytes + bloom_bytes; }
+    double BytesPerUrl() const { return urls ? static_cast<double>(TotalBytes()) / static_cast<double>(urls) : 0.0; }
+};
+
+// Set of URL fingerprints: an open-addressing table of 64-bit values
+// (linear probing, 0 marks an empty slot) behind a blocked Bloom filter
+// whose bits for one key share a 64-bit word, so a miss costs one cache
+// line. Two distinct URLs collide with probability ~n^2 / 2^65, which
+// for crawl-sized sets is negligible. Not thread-safe.
+class FingerprintSet {
+public:
+    explicit FingerprintSet(size_t expected = 0);
+
+    // True if the fingerprint was not present
+    bool Insert(uint64_t fingerprint);
+    bool Contains(uint64_t fingerprint) const;
+    void Clear();
+
+    // Appends every stored fingerprint, in table order
+    void CopyTo(std::vector<uint64_t>& fingerprints) const;
+
+    size_t Size() const { return size_; }
+    VisitedSetStats GetStats() const;
+
+private:
+    static constexpr size_t kMinCapacity = 64;
+    static constexpr size_t kMaxLoadPercent = 80;
+
+    std::vector<uint64_t> slots_;  // Power-of-two size
+    std::vector<uint64_t> bloom_;  // One word per 8 slots: 8 bits per slot
+    size_t size_ = 0;
+    mutable uint64_t bloom_rejections_ = 0;
+
+    void Rehash(size_t capacity);
+    void InsertUnchecked(uint64_t fingerprint);
+    uint64_t BloomMask(uint64_t fingerprint) const;
+    size_t BloomWord(uint64_t fingerprint) const;
+};
+
+// Thread-safe visited-URL set: fingerprints are spread over independently
+// locked shards so concurrent crawl workers rarely contend.
+class VisitedUrlSet {
+public:
+    bool Insert(std::string_view url);
+    bool Contains(std::string_view url) const;
+    void Clear();
+
+    // Raw fingerprint access, used to checkpoint and restore the set.
+    // ForEachSorted visits in ascending order; shards split on the top
+    // bits, so only one shard is copied and sorted at a time.
+    bool InsertFingerprint(uint64_t fingerprint);
+    void ForEachSorted(const std::function<void(uint64_t)>& visit) const;
+
+    size_t Size() const;
+    VisitedSetStats GetStats() const;
+
+private:
+    static constexpr size_t kShards = 16;  // Must match the 4-bit shift in ShardFor
+
+    struct alignas(64) Shard {
+        mutable std::mutex mutex;
+        FingerprintSet fingerprints;
+    };
+
+    Shard shards_[kShards];
+
+    // Top bits pick the shard; the table and filter use the lower ones
+    Shard& ShardFor(uint64_t fingerprint) { return shards_[fingerprint >> 60]; }
+    const Shard& ShardFor(uint64_t fingerprint) const { return shards_[fingerprint >> 60]; }
+};
+
+} // namespace chromium_playwright::crawl
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <array>
+#include <unordered_map>
+#include <cstddef>
+#include <cstdint>
+
+namespace chromium_playwright::dom {
+
+struct DOMNode;
+using NodeIndex = uint32_t;
+
+// Attributes with an inverted index
+enum class IndexedAttribute {
+    ID,
+    CLASS,       // One entry per class token
+    TAG,         // Lower-cased tag name
+    TEST_ID,     // data-testid
+    ROLE,        // Explicit role attribute, else the implicit ARIA role
+    TITLE,
+    PLACEHOLDER,
+    ALT
+};
+
+// Per-document hash indexes from attribute values to nodes. Lists are
+// unordered; callers that need document order sort the (small) result.
+class AttributeIndex {
+public:
+    static constexpr size_t kIndexCount = 8;
+
+    void AddNode(NodeIndex index, const DOMNode& node);
+    void RemoveNode(NodeIndex index, const DOMNode& node);
+    void Clear();
+
+    const std::vector<NodeIndex>& Lookup(IndexedAttribute attribute, const std::string& value) const;
+    size_t Count(IndexedAttribute attribute, const std::string& value) const;
+
+    // True if changing this attribute can change an index entry
+    static bool AffectsIndex(const std::string& attribute_name);
+
+    // Explicit role attribute, or the implicit ARIA role of the element
+    static std::string ComputeRole(const DOMNode& node);
+
+private:
+    using ValueMap = std::unordered_map<std::string, std::vector<NodeIndex>>;
+    std::array<ValueMap, kIndexCount> indexes_;
+
+    ValueMap& IndexFor(IndexedAttribute attribute) { return indexes_[static_cast<size_t>(attribute)]; }
+    const ValueMap& IndexFor(IndexedAttribute attribute) const { return indexes_[static_cast<size_t>(attribute)]; }
+
+    template <typename Callback>
+    static void ForEachEntry(const DOMNode& node, Callback&& callback);
+};
+
+} // namespace chromium_playwright::dom
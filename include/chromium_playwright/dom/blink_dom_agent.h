@@ -6,9 +6,18 @@
 #include <functional>
 #include <memory>
 #include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <optional>
+#include <string_view>
 
 namespace chromium_playwright::dom {
 
+struct DOMEvent;
+
+// Allocation-free event listener: plain function pointer plus context
+using DOMEventCallback = void (*)(DOMEvent& event, void* context);
+
 // Element search types
 enum class ElementSearchType {
     CSS_SELECTOR,
@@ -21,6 +30,13 @@ enum class ElementSearchType {
     TEST_ID
 };
 
+// Text matching options, mirroring LocatorOptions::exact / ignore_case.
+// Both the pattern and the element text are whitespace-normalized.
+struct TextMatchOptions {
+    bool exact = false;       // Whole text must match instead of a substring
+    bool ignore_case = false;
+};
+
 // Rectangle structure
 struct Rect {
     double x = 0.0;
@@ -34,8 +50,26 @@ struct Rect {
     }
 };
 
+// Compact element reference: document generation in the high 32 bits and
+// node index in the low 32. Handles from an older generation (the document
+// was cleared or restored since) no longer resolve. 0 is the null handle.
+struct NodeHandle {
+    uint64_t value = 0;
+    
+    static NodeHandle Make(uint32_t generation, uint32_t index) {
+        return NodeHandle{(static_cast<uint64_t>(generation) << 32) | index};
+    }
+    uint32_t Generation() const { return static_cast<uint32_t>(value >> 32); }
+    uint32_t Index() const { return static_cast<uint32_t>(value); }
+    bool IsNull() const { return value == 0; }
+    
+    bool operator==(const NodeHandle& other) const { return value == other.value; }
+    bool operator!=(const NodeHandle& other) const { return value != other.value; }
+};
+
 // Element handle structure
 struct ElementHandle {
+    NodeHandle handle;
     std::string element_id;
     std::string tag_name;
     std::string text_content;
@@ -52,6 +86,25 @@ struct ElementHandle {
     uint64_t last_click_time = 0;
 };
 
+// Journaled DOM mutation kinds
+enum class DOMMutationType {
+    INSERT,     // Node appended to a parent
+    REMOVE,     // Node detached from its parent
+    ATTRIBUTE,  // Attribute set or removed
+    TEXT,       // Text content replaced
+    CLEAR,      // Whole document discarded
+    VALUE       // Form control value or checked state changed
+};
+
+// Journaled DOM mutation as seen through the agent
+struct DOMMutation {
+    uint64_t sequence = 0;
+    DOMMutationType type = DOMMutationType::INSERT;
+    std::string element_id;
+    std::string parent_id;       // INSERT / REMOVE: the (former) parent
+    std::string attribute_name;  // ATTRIBUTE only
+};
+
 // Blink DOM Agent interface
 class BlinkDOMAgent {
 public:
@@ -59,6 +112,14 @@ public:
     
     // Element finding
     virtual std::vector<ElementHandle> FindElements(const std::string& selector, ElementSearchType type) = 0;
+    virtual std::vector<NodeHandle> FindElementHandles(const std::string& selector, ElementSearchType type) = 0;
+    virtual std::vector<ElementHandle> FindElementsByText(const std::string& text, const TextMatchOptions& options) = 0;
+    
+    // CSS selectors and simple XPath ("//tag[@attr='value']") share one
+    // pass over the document; other XPath is evaluated per query. Results
+    // are returned per query, in the order the queries were given.
+    virtual std::vector<std::vector<ElementHandle>> FindElementsBatch(
+        const std::vector<std::pair<std::string, ElementSearchType>>& queries) = 0;
     
     // Element actions
     virtual bool ClickElement(const std::string& element_id) = 0;
@@ -78,6 +139,14 @@ public:
     virtual bool SetElementAttribute(const std::string& element_id, const std::string& attribute_name, const std::string& value) = 0;
     virtual bool RemoveElementAttribute(const std::string& element_id, const std::string& attribute_name) = 0;
     
+    // Handle accessors. Views stay valid until the element is next mutated;
+    // stale or null handles yield empty results.
+    virtual std::string GetElementId(NodeHandle handle) = 0;
+    virtual std::string_view GetElementTextView(NodeHandle handle) = 0;
+    virtual std::string_view GetElementTagName(NodeHandle handle) = 0;
+    virtual std::optional<std::string_view> GetElementAttributeView(NodeHandle handle, std::string_view attribute_name) = 0;
+    virtual Rect GetElementBoundingBox(NodeHandle handle) = 0;
+    
     // Element state
     virtual bool IsElementVisible(const std::string& element_id) = 0;
     virtual bool IsElementEnabled(const std::string& element_id) = 0;
@@ -89,6 +158,10 @@ public:
     virtual Rect GetElementBoundingBox(const std::string& element_id) = 0;
     virtual std::vector<Rect> GetElementAllBoundingBoxes(const std::string& element_id) = 0;
     virtual bool IsElementInViewport(const std::string& element_id) = 0;
+    virtual void SetViewport(const Rect& viewport) = 0;
+    virtual std::vector<ElementHandle> GetElementsInViewport() = 0;
+    virtual std::vector<ElementHandle> GetElementsInRect(const Rect& rect) = 0;
+    virtual std::string GetElementAtPoint(double x, double y) = 0;  // Topmost visible element id, or ""
     
     // JavaScript execution
     virtual std::string ExecuteJavaScript(const std::string& script) = 0;
@@ -104,7 +177,13 @@ public:
     
     // Page content
     virtual std::string GetPageHTML() = 0;
-    virtual std::string GetPageText() = 0;
+    virtual std::string GetPageText() = 0;  // Skips script and style content
+    
+    // Streamed page content: written straight to `out` without building
+    // an intermediate string. Return the number of bytes written.
+    virtual size_t WritePageHTML(std::ostream& out) = 0;
+    virtual size_t WritePageText(std::ostream& out) = 0;
+    virtual size_t WriteElementHTML(const std::string& element_id, std::ostream& out) = 0;
     virtual std::vector<std::string> GetPageLinks() = 0;
     virtual std::vector<std::string> GetPageImages() = 0;
     
@@ -114,6 +193,11 @@ public:
     virtual void RemoveEventListener(const std::string& element_id, const std::string& event_type) = 0;
     virtual void TriggerEvent(const std::string& element_id, const std::string& event_type) = 0;
     
+    // Typed listeners with capture/bubble propagation; returns a listener id (0 on failure)
+    virtual uint32_t AddEventListener(NodeHandle element, const std::string& event_type, DOMEventCallback callback,
+                                      void* context, bool capture = false) = 0;
+    virtual bool RemoveEventListener(NodeHandle element, uint32_t listener_id) = 0;
+    
     // Wait conditions
     virtual bool WaitForElement(const std::string& selector, ElementSearchType type, int timeout_ms = 5000) = 0;
     virtual bool WaitForElementVisible(const std::string& element_id, int timeout_ms = 5000) = 0;
@@ -122,11 +206,28 @@ public:
     virtual bool WaitForNavigation(int timeout_ms = 5000) = 0;
     virtual bool WaitForLoadState(const std::string& state, int timeout_ms = 5000) = 0;
     
+    // Mutation journal. Sequence numbers increase monotonically; the
+    // queries return false when entries after `sequence` were already
+    // dropped, in which case callers must fall back to a full rescan.
+    virtual uint64_t GetMutationSequence() = 0;
+    virtual bool GetMutationsSince(uint64_t sequence, std::vector<DOMMutation>& mutations) = 0;
+    virtual bool GetDirtySubtreesSince(uint64_t sequence, std::vector<std::string>& element_ids) = 0;
+    
+    // DOM state snapshots for branching exploration. Snapshots share
+    // unchanged node pages, indexes and listeners with the live document,
+    // so taking or restoring one does not copy the document; ids are never 0.
+    // Restore also puts back the event listeners registered at the time.
+    virtual uint64_t Snapshot() = 0;
+    virtual bool Restore(uint64_t snapshot_id) = 0;
+    virtual void ReleaseSnapshot(uint64_t snapshot_id) = 0;
+    
     // Screenshot
     virtual std::vector<uint8_t> CaptureElementScreenshot(const std::string& element_id) = 0;
     virtual std::vector<uint8_t> CapturePageScreenshot() = 0;
     
-    // Form handling
+    // Form handling. FillForm keys are element ids or control names; it
+    // changes nothing unless every key resolves, and fires input/change
+    // once per changed control after all values are applied.
     virtual bool FillForm(const std::map<std::string, std::string>& form_data) = 0;
     virtual bool SubmitForm(const std::string& form_id) = 0;
     virtual std::map<std::string, std::string> GetFormData(const std::string& form_id) = 0;
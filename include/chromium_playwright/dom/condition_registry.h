@@ -0,0 +1,68 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace chromium_playwright::dom {
+
+using NodeIndex = uint32_t;
+
+// Kinds of change a waiter can subscribe to
+enum class DOMSignal : uint32_t {
+    STRUCTURE = 1u << 0,  // Nodes inserted, removed or the document cleared
+    ATTRIBUTE = 1u << 1,
+    TEXT      = 1u << 2,
+    STATE     = 1u << 3,  // Visibility, enabled/checked state, geometry
+    LIFECYCLE = 1u << 4   // Navigation and load state
+};
+
+using DOMSignalMask = uint32_t;
+constexpr DOMSignalMask kAllDOMSignals = 0x1f;
+
+constexpr DOMSignalMask operator|(DOMSignal a, DOMSignal b) {
+    return static_cast<DOMSignalMask>(a) | static_cast<DOMSignalMask>(b);
+}
+constexpr DOMSignalMask operator|(DOMSignalMask a, DOMSignal b) {
+    return a | static_cast<DOMSignalMask>(b);
+}
+
+// Registry of blocked WaitFor* calls. A waiter subscribes to a signal mask
+// and, optionally, a single node; its predicate is re-evaluated only when a
+// matching signal fires, never on a polling interval. Structural signals
+// wake node-scoped waiters regardless of node, since an ancestor change can
+// attach or detach the watched element.
+//
+// Predicates run on the waiting thread without the registry lock held; the
+// waiter is registered before the first check, so a signal raised between
+// the check and the wait is never lost.
+class ConditionRegistry {
+public:
+    static constexpr NodeIndex kAnyNode = UINT32_MAX;
+
+    // True once the predicate holds, false if the timeout expires first
+    bool WaitFor(DOMSignalMask signals, NodeIndex node, const std::function<bool()>& predicate,
+                 std::chrono::milliseconds timeout);
+
+    void Notify(DOMSignal signal, NodeIndex node = kAnyNode);
+
+    size_t GetWaiterCount() const;
+    uint64_t GetWakeupCount() const;
+
+private:
+    struct Waiter {
+        DOMSignalMask signals = 0;
+        NodeIndex node = kAnyNode;
+        bool signaled = false;
+        std::condition_variable cv;
+    };
+
+    mutable std::mutex mutex_;
+    std::vector<Waiter*> waiters_;
+    uint64_t wakeups_ = 0;
+};
+
+} // namespace chromium_playwright::dom
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string_view>
+#include <vector>
+#include "dom_tree.h"
+
+namespace chromium_playwright::dom {
+
+// Interned event type. Built-in types have fixed ids; other names are
+// interned on first use and numbered after EventType::COUNT.
+using EventTypeId = uint16_t;
+
+enum class EventType : EventTypeId {
+    CLICK,
+    DBLCLICK,
+    MOUSEDOWN,
+    MOUSEUP,
+    MOUSEMOVE,
+    MOUSEOVER,
+    MOUSEOUT,
+    MOUSEENTER,
+    MOUSELEAVE,
+    KEYDOWN,
+    KEYUP,
+    KEYPRESS,
+    INPUT,
+    CHANGE,
+    FOCUS,
+    BLUR,
+    FOCUSIN,
+    FOCUSOUT,
+    SUBMIT,
+    RESET,
+    SCROLL,
+    LOAD,
+    COUNT
+};
+
+constexpr EventTypeId ToEventTypeId(EventType type) { return static_cast<EventTypeId>(type); }
+
+EventTypeId InternEventType(std::string_view name);
+std::string_view EventTypeName(EventTypeId type);
+bool EventBubbles(EventTypeId type);
+
+enum class EventPhase : uint8_t { NONE, CAPTURING, AT_TARGET, BUBBLING };
+
+struct DOMEvent {
+    EventTypeId type = 0;
+    NodeIndex target = kInvalidNodeIndex;
+    NodeIndex current_target = kInvalidNodeIndex;
+    EventPhase phase = EventPhase::NONE;
+    bool bubbles = true;
+
+    bool propagation_stopped = false;
+    bool immediate_propagation_stopped = false;
+    bool default_prevented = false;
+
+    void StopPropagation() { propagation_stopped = true; }
+    void StopImmediatePropagation() { propagation_stopped = immediate_propagation_stopped = true; }
+    void PreventDefault() { default_prevented = true; }
+};
+
+// Plain function pointer plus context: registering a listener never
+// allocates a closure.
+using EventCallback = void (*)(DOMEvent& event, void* context);
+
+// Per-document listener storage and capture/bubble dispatch over the arena.
+// Each node's listeners live in a small inline array that only spills to
+// the heap past kInlineListeners. Dispatch for a type with no listeners
+// anywhere returns immediately without walking the tree.
+class EventDispatcher {
+    struct ListenerTable;
+
+public:
+    using ListenerId = uint32_t;
+    static constexpr size_t kInlineListeners = 2;
+
+    ListenerId AddListener(NodeIndex node, EventTypeId type, EventCallback callback, void* context,
+                           bool capture = false);
+    bool RemoveListener(NodeIndex node, ListenerId id);
+    size_t RemoveListeners(NodeIndex node, EventTypeId type);
+    void Clear();
+
+    // Every listener at one point, taken alongside a DOMTree snapshot. The
+    // table is shared until the dispatcher next changes a listener, which
+    // copies it once.
+    class ListenerSnapshot {
+    private:
+        friend class EventDispatcher;
+        std::shared_ptr<ListenerTable> table_;
+    };
+    ListenerSnapshot SnapshotListeners() const;
+
+    // Replaces every listener with those of `snapshot`. Listener ids keep
+    // counting from here, so none is handed out twice. Safe during dispatch.
+    void RestoreListeners(const ListenerSnapshot& snapshot);
+
+    // Runs capture, target and (for bubbling types) bubble phases along the
+    // target's ancestor chain. Returns false if a listener prevented default.
+    bool Dispatch(const DOMTree& tree, NodeIndex target, EventTypeId type);
+
+    size_t GetListenerCount(EventTypeId type) const;
+
+private:
+    struct Listener {
+        EventCallback callback = nullptr;  // nullptr once removed
+        void* context = nullptr;
+        ListenerId id = 0;
+        EventTypeId type = 0;
+        bool capture = false;
+    };
+
+    class ListenerList {
+    public:
+        size_t Size() const { return size_; }
+        Listener& operator[](size_t i) { return i < kInlineListeners ? inline_[i] : overflow_[i - kInlineListeners]; }
+        const Listener& operator[](size_t i) const {
+            return i < kInlineListeners ? inline_[i] : overflow_[i - kInlineListeners];
+        }
+        void PushBack(const Listener& listener);
+        void Compact();
+
+    private:
+        std::array<Listener, kInlineListeners> inline_{};
+        std::vector<Listener> overflow_;
+        size_t size_ = 0;
+    };
+
+    struct ListenerTable {
+        std::vector<ListenerList> lists;    // Indexed by NodeIndex
+        std::vector<uint32_t> type_counts;  // Live listeners per type
+    };
+
+    std::shared_ptr<ListenerTable> listeners_ = std::make_shared<ListenerTable>();
+    std::deque<std::vector<NodeIndex>> paths_;  // Scratch per dispatch depth; deque keeps references stable
+    std::vector<NodeIndex> pending_compaction_;
+    size_t dispatch_depth_ = 0;
+    ListenerId next_id_ = 1;
+
+    void Invoke(NodeIndex node, DOMEvent& event, bool capture_phase, bool bubble_phase);
+    ListenerTable& MutableListeners();
+    void MarkRemoved(ListenerTable& table, NodeIndex node, Listener& listener);
+};
+
+} // namespace chromium_playwright::dom
@@ -0,0 +1,194 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <functional>
+#include <memory>
+#include <limits>
+#include <cstdint>
+#include "blink_dom_agent.h"
+#include "attribute_index.h"
+#include "spatial_index.h"
+#include "condition_registry.h"
+#include "mutation_journal.h"
+
+namespace chromium_playwright::dom {
+
+// Index of a node inside a DOMTree arena
+using NodeIndex = uint32_t;
+constexpr NodeIndex kInvalidNodeIndex = std::numeric_limits<NodeIndex>::max();
+
+// DOM node stored in the document arena. `id` is the agent-level element id
+// used by BlinkDOMAgent calls, not the HTML id attribute.
+struct DOMNode {
+    std::string id;
+    std::string tag_name;
+    std::string text_content;
+    std::string value;
+    std::map<std::string, std::string, std::less<>> attributes;  // Transparent: string_view lookups
+    Rect bounding_box;
+    bool visible = true;
+    bool enabled = true;
+    bool checked = false;
+    bool focused = false;
+    bool hovered = false;
+    bool clicked = false;
+    uint64_t last_click_time = 0;
+
+    // Tree links (indices into the owning DOMTree)
+    NodeIndex parent = kInvalidNodeIndex;
+    NodeIndex first_child = kInvalidNodeIndex;
+    NodeIndex last_child = kInvalidNodeIndex;
+    NodeIndex prev_sibling = kInvalidNodeIndex;
+    NodeIndex next_sibling = kInvalidNodeIndex;
+};
+
+class DOMTree;
+
+using IdIndex = std::unordered_map<std::string, NodeIndex>;
+
+// Point-in-time copy of a DOMTree. Node pages and the lookup indexes are
+// shared with the live tree, so taking or restoring a snapshot costs one
+// pointer per page. A page is copied when one side first writes to it;
+// an index is copied whole on its first write.
+class DOMSnapshot {
+public:
+    size_t Size() const { return size_; }
+
+private:
+    friend class DOMTree;
+
+    std::vector<std::shared_ptr<std::vector<DOMNode>>> pages_;
+    size_t size_ = 0;
+    std::shared_ptr<IdIndex> id_index_;
+    NodeIndex document_element_ = kInvalidNodeIndex;
+    std::shared_ptr<AttributeIndex> attribute_index_;
+    std::shared_ptr<SpatialIndex> spatial_index_;
+};
+
+// Arena-backed DOM tree. Nodes are addressed by index and stored in
+// fixed-size, copy-on-write pages; indices stay valid across inserts and
+// detaches. Pointers from GetMutableNode must not be held across
+// Snapshot(), since the next write may move the node to a private page.
+// The first node created becomes the document element.
+// All structural, attribute, geometry and form state mutations go through
+// this class.
+class DOMTree {
+public:
+    // Node creation and structure
+    NodeIndex CreateNode(const std::string& id, const std::string& tag_name, const std::string& text_content = "");
+    bool AppendChild(NodeIndex parent, NodeIndex child);
+    bool Detach(NodeIndex node);
+    void Clear();
+
+    // Node mutation
+    bool SetAttribute(NodeIndex node, const std::string& name, const std::string& value);
+    bool RemoveAttribute(NodeIndex node, const std::string& name);
+    bool SetTextContent(NodeIndex node, const std::string& text);
+    bool SetBoundingBox(NodeIndex node, const Rect& rect);
+
+    // Form control state; journaled as VALUE, and only when it changes
+    bool SetValue(NodeIndex node, const std::string& value);
+    bool SetChecked(NodeIndex node, bool checked);
+
+    // Node access. Only GetMutableNode un-shares the node's page.
+    DOMNode* GetMutableNode(NodeIndex index);
+    const DOMNode* GetNode(NodeIndex index) const;
+    NodeIndex FindById(const std::string& id) const;
+    NodeIndex GetDocumentElement() const { return document_element_; }
+    size_t Size() const { return size_; }
+
+    // Compact handles. The generation changes on Clear() and Restore(),
+    // so handles never resolve to a node they were not taken from.
+    NodeHandle GetHandle(NodeIndex node) const { return NodeHandle::Make(generation_, node); }
+    NodeIndex Resolve(NodeHandle handle) const;
+    uint32_t GetGeneration() const { return generation_; }
+
+    // Copy-on-write snapshots. Restore replaces the document but keeps
+    // the journal running (recorded as CLEAR) and the mutation observer.
+    DOMSnapshot Snapshot() const;
+    void Restore(const DOMSnapshot& snapshot);
+
+    // Indexed lookups: attached nodes in document order
+    std::vector<NodeIndex> FindByAttribute(IndexedAttribute attribute, const std::string& value) const;
+    const AttributeIndex& GetAttributeIndex() const { return *attribute_index_; }
+
+    // Geometry lookups: attached nodes in document order, so the topmost
+    // box at a point comes last
+    std::vector<NodeIndex> FindInRect(const Rect& rect) const;
+    std::vector<NodeIndex> FindAtPoint(double x, double y) const;
+    const SpatialIndex& GetSpatialIndex() const { return *spatial_index_; }
+
+    // Traversal
+    bool IsAttached(NodeIndex node) const;
+    void ForEachNode(const std::function<void(NodeIndex, const DOMNode&)>& visitor) const;
+    NodeIndex NextInDocumentOrder(NodeIndex node, NodeIndex scope = kInvalidNodeIndex) const;
+    uint32_t DocumentOrder(NodeIndex node) const;
+
+    // Bumped whenever text content or tree structure changes
+    uint64_t GetTextVersion() const { return text_version_; }
+
+    // Content mutations (structure, attributes, text, control values) are
+    // journaled with sequence numbers so readers can ask what changed since
+    // a point
+    const MutationJournal& GetJournal() const { return journal_; }
+    void SetJournalCapacity(size_t capacity) { journal_.SetCapacity(capacity); }
+
+    // Minimal set of attached subtree roots covering every change after
+    // `sequence`, in document order. Returns false (with the document
+    // element as the only root) when the journal no longer reaches back
+    // that far.
+    bool DirtySubtreesSince(uint64_t sequence, std::vector<NodeIndex>& roots) const;
+
+    // Called after every mutation made through this class
+    using MutationObserver = std::function<void(DOMSignal, NodeIndex)>;
+    void SetMutationObserver(MutationObserver observer) { mutation_observer_ = std::move(observer); }
+
+private:
+    static constexpr size_t kNodePageSize = 64;
+    using NodePage = std::vector<DOMNode>;
+
+    std::vector<std::shared_ptr<NodePage>> pages_;
+    size_t size_ = 0;
+    std::shared_ptr<IdIndex> id_index_ = std::make_shared<IdIndex>();
+    NodeIndex document_element_ = kInvalidNodeIndex;
+    std::shared_ptr<AttributeIndex> attribute_index_ = std::make_shared<AttributeIndex>();
+    std::shared_ptr<SpatialIndex> spatial_index_ = std::make_shared<SpatialIndex>();
+    uint32_t generation_ = 1;
+    uint64_t text_version_ = 0;
+    MutationObserver mutation_observer_;
+    MutationJournal journal_;
+
+    // Pre-order ranks, rebuilt lazily after structural changes
+    mutable std::vector<uint32_t> document_order_;
+    mutable bool document_order_dirty_ = true;
+
+    void InvalidateDocumentOrder() {
+        document_order_dirty_ = true;
+        ++text_version_;
+    }
+    void RebuildDocumentOrder() const;
+    void NextGeneration() {
+        // Generation 0 is reserved so that the null handle never resolves
+        if (++generation_ == 0) generation_ = 1;
+    }
+    const DOMNode& Node(NodeIndex index) const { return (*pages_[index / kNodePageSize])[index % kNodePageSize]; }
+    DOMNode& MutableNode(NodeIndex index) { return MutablePage(index)[index % kNodePageSize]; }
+    NodePage& MutablePage(NodeIndex index);
+
+    // Copy on first write to an index still shared with a snapshot
+    template <typename Index>
+    static Index& MutableIndex(std::shared_ptr<Index>& index) {
+        if (index.use_count() > 1) index = std::make_shared<Index>(*index);
+        return *index;
+    }
+
+    void NotifyMutation(DOMSignal signal, NodeIndex node) const {
+        if (mutation_observer_) mutation_observer_(signal, node);
+    }
+    std::vector<NodeIndex> AttachedInDocumentOrder(const std::vector<NodeIndex>& candidates) const;
+};
+
+} // namespace chromium_playwright::dom
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include "dom_tree.h"
+
+namespace chromium_playwright::dom {
+
+// Serializes the arena DOM straight into caller-owned storage. Measuring
+// and writing share one traversal, so MeasureHTML is exact and the string
+// overload grows its target once instead of appending piecewise.
+//
+// Markup is generated from the tree (tag, attributes, own text, children);
+// text and attribute values are escaped, script/style text is emitted raw
+// and void elements get no end tag.
+
+// Bytes SerializeHTML will produce for `root`'s subtree
+size_t MeasureHTML(const DOMTree& tree, NodeIndex root);
+
+// Writes into `buffer` if it can hold the result; always returns the
+// required size, so a short buffer can be retried at the right size.
+size_t SerializeHTML(const DOMTree& tree, NodeIndex root, char* buffer, size_t capacity);
+
+// Appends to `out`, reallocating at most once
+void SerializeHTML(const DOMTree& tree, NodeIndex root, std::string& out);
+
+// Streams through a fixed-size staging buffer; returns bytes written
+size_t SerializeHTML(const DOMTree& tree, NodeIndex root, std::ostream& out);
+
+// Visible text of `root`'s subtree: each node's own text in document
+// order, separated by single spaces, skipping script and style subtrees.
+size_t MeasureText(const DOMTree& tree, NodeIndex root);
+void ExtractText(const DOMTree& tree, NodeIndex root, std::string& out);
+size_t ExtractText(const DOMTree& tree, NodeIndex root, std::ostream& out);
+
+} // namespace chromium_playwright::dom
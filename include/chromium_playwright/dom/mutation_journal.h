@@ -0,0 +1,52 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <cstddef>
+#include <cstdint>
+#include "blink_dom_agent.h"
+
+namespace chromium_playwright::dom {
+
+using NodeIndex = uint32_t;
+
+struct MutationRecord {
+    uint64_t sequence = 0;
+    DOMMutationType type = DOMMutationType::INSERT;
+    NodeIndex node = UINT32_MAX;
+    NodeIndex parent = UINT32_MAX;  // INSERT / REMOVE: the (former) parent
+    std::string attribute_name;     // ATTRIBUTE only
+};
+
+// Append-only, bounded log of document mutations. Sequence numbers start
+// at 1 and are never reused, even across Clear(); once more than
+// `capacity` records accumulate the oldest are dropped, and Since()
+// reports the gap so callers can fall back to a full rescan.
+class MutationJournal {
+public:
+    static constexpr size_t kDefaultCapacity = 4096;
+
+    explicit MutationJournal(size_t capacity = kDefaultCapacity) : capacity_(capacity) {}
+
+    uint64_t Append(DOMMutationType type, NodeIndex node, NodeIndex parent = UINT32_MAX,
+                    const std::string& attribute_name = "");
+
+    // Appends every record newer than `sequence`; false if some were dropped
+    bool Since(uint64_t sequence, std::vector<MutationRecord>& records) const;
+
+    // Last sequence number handed out (0 before the first mutation)
+    uint64_t GetSequence() const { return next_sequence_ - 1; }
+    uint64_t GetOldestRetainedSequence() const;
+
+    void SetCapacity(size_t capacity);
+    size_t GetCapacity() const { return capacity_; }
+    size_t Size() const { return records_.size(); }
+
+private:
+    std::deque<MutationRecord> records_;
+    size_t capacity_;
+    uint64_t next_sequence_ = 1;
+};
+
+} // namespace chromium_playwright::dom
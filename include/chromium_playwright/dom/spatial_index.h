@@ -0,0 +1,58 @@
+#pragma once
+
+#include <vector>
+#include <unordered_map>
+#include <cstddef>
+#include <cstdint>
+#include "blink_dom_agent.h"
+
+namespace chromium_playwright::dom {
+
+using NodeIndex = uint32_t;
+
+// Uniform grid over laid-out bounding boxes. Each box is bucketed into the
+// cells it covers; boxes spanning more than kMaxCellsPerEntry cells (page
+// wrappers, full-height containers) go on a short overflow list instead, so
+// large elements never flood the grid. Query results are unordered and
+// free of duplicates; empty rects are not indexed.
+class SpatialIndex {
+public:
+    static constexpr double kDefaultCellSize = 256.0;
+    static constexpr size_t kMaxCellsPerEntry = 64;
+
+    explicit SpatialIndex(double cell_size = kDefaultCellSize);
+
+    // Replaces any previous box for the node
+    void Insert(NodeIndex node, const Rect& rect);
+    void Remove(NodeIndex node);
+    void Clear();
+
+    // Nodes whose box intersects the rect / contains the point
+    std::vector<NodeIndex> QueryRect(const Rect& rect) const;
+    std::vector<NodeIndex> QueryPoint(double x, double y) const;
+
+    size_t Size() const { return size_; }
+    double GetCellSize() const { return cell_size_; }
+
+    static bool Intersects(const Rect& a, const Rect& b);
+
+private:
+    struct Entry {
+        Rect rect;
+        int32_t min_cx = 0, min_cy = 0, max_cx = 0, max_cy = 0;
+        bool present = false;
+        bool overflow = false;
+    };
+
+    double cell_size_;
+    size_t size_ = 0;
+    std::vector<Entry> entries_;  // Indexed by NodeIndex
+    std::unordered_map<uint64_t, std::vector<NodeIndex>> cells_;
+    std::vector<NodeIndex> overflow_;
+
+    int32_t CellCoordinate(double value) const;
+    static uint64_t CellKey(int32_t cx, int32_t cy);
+    static void EraseFrom(std::vector<NodeIndex>& list, NodeIndex node);
+};
+
+} // namespace chromium_playwright::dom
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include "dom_tree.h"
+
+namespace chromium_playwright::dom {
+
+// Trigram index over the normalized text of a document.
+//
+// Built lazily on the first query and rebuilt only after the tree's text
+// version changes. Trigrams are taken over lower-cased text, so one index
+// serves both case modes; candidates are always verified against the
+// normalized text before they are returned.
+class TextIndex {
+public:
+    // Matching nodes in document order
+    std::vector<NodeIndex> Find(const DOMTree& tree, const std::string& text, const TextMatchOptions& options = {});
+
+    bool IsBuilt() const { return built_; }
+    void Invalidate() { built_ = false; }
+
+    // Whitespace-collapsed, trimmed text as used for matching
+    static std::string Normalize(const std::string& text);
+
+private:
+    struct Entry {
+        NodeIndex node;
+        std::string text;       // Normalized
+        std::string lower_text; // Normalized, lower-cased
+    };
+
+    bool built_ = false;
+    const DOMTree* tree_ = nullptr;
+    uint64_t built_version_ = 0;
+
+    // Entries are stored in document order; postings hold entry ordinals
+    std::vector<Entry> entries_;
+    std::unordered_map<uint32_t, std::vector<uint32_t>> postings_;
+    std::unordered_map<std::string, std::vector<uint32_t>> exact_;
+
+    void Build(const DOMTree& tree);
+    std::vector<uint32_t> Candidates(const std::string& lower_pattern) const;
+    static uint32_t Trigram(const std::string& text, size_t pos);
+};
+
+} // namespace chromium_playwright::dom
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <list>
+#include <unordered_map>
+#include <cstddef>
+#include "dom_tree.h"
+
+namespace chromium_playwright::dom::xpath {
+
+// Compiled XPath 1.0 expression.
+//
+// Expressions are parsed once into an evaluation plan and can then be run
+// against any DOMTree. Location paths are evaluated step by step, depth
+// first, so intermediate node-sets are only built for steps that need them
+// (positional predicates, last(), filter expressions). The arena stores one
+// text run per element, so text() and the string-value of an element both
+// read DOMNode::text_content.
+class CompiledXPath {
+public:
+    ~CompiledXPath();
+
+    // Returns nullptr and fills `error` if the expression is invalid
+    static std::shared_ptr<const CompiledXPath> Compile(const std::string& expression, std::string* error = nullptr);
+
+    // Matching elements in document order. Attribute and text() results are
+    // reported as their owning element.
+    std::vector<NodeIndex> Evaluate(const DOMTree& tree) const;
+    std::vector<NodeIndex> Evaluate(const DOMTree& tree, NodeIndex context) const;
+
+    // String values of the result: one entry per node for node-sets
+    // (attribute values, text runs), or a single entry for scalar results
+    // such as count(//a) or string(//title)
+    std::vector<std::string> EvaluateStrings(const DOMTree& tree) const;
+
+    const std::string& GetExpression() const { return expression_; }
+
+    struct Plan;
+
+private:
+    CompiledXPath(std::string expression, std::unique_ptr<Plan> plan);
+
+    std::string expression_;
+    std::unique_ptr<Plan> plan_;
+};
+
+// Thread-safe LRU cache of compiled expressions. Invalid expressions are
+// cached too, so a broken rule is only parsed once.
+class XPathCache {
+public:
+    explicit XPathCache(size_t capacity = 256);
+
+    std::shared_ptr<const CompiledXPath> Get(const std::string& expression);
+
+    void SetCapacity(size_t capacity);
+    size_t GetCapacity() const;
+    size_t Size() const;
+    void Clear();
+
+    // Statistics
+    size_t GetHits() const;
+    size_t GetMisses() const;
+
+private:
+    struct Entry {
+        std::shared_ptr<const CompiledXPath> compiled;
+        std::list<std::string>::iterator lru_position;
+    };
+
+    mutable std::mutex mutex_;
+    size_t capacity_;
+    std::list<std::string> lru_;
+    std::unordered_map<std::string, Entry> entries_;
+    size_t hits_ = 0;
+    size_t misses_ = 0;
+
+    void EvictLocked();
+};
+
+} // namespace chromium_playwright::dom::xpath
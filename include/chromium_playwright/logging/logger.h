@@ -0,0 +1,185 @@
+#pragma once
+
+#include <atomic>
+#include <array>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace chromium_playwright::logging {
+
+enum class LogLevel : uint8_t {
+    DEBUG = 0,
+    INFO = 1,
+    WARN = 2,
+    ERROR = 3
+};
+
+// Records below this level (0 = DEBUG ... 3 = ERROR) are compiled out entirely
+#ifndef CHROMIUM_PLAYWRIGHT_MIN_LOG_LEVEL
+#define CHROMIUM_PLAYWRIGHT_MIN_LOG_LEVEL 1
+#endif
+
+// A captured log call: arguments are stored in binary form and only
+// formatted ("{}" placeholders, in order) on the background writer.
+// `component` and `format` must be string literals.
+struct LogRecord {
+    static constexpr size_t kPayloadSize = 200;
+
+    uint64_t timestamp_us = 0;
+    const char* component = nullptr;
+    const char* format = nullptr;
+    LogLevel level = LogLevel::INFO;
+    uint8_t arg_count = 0;
+    uint16_t payload_size = 0;
+    bool truncated = false;
+    std::array<uint8_t, kPayloadSize> payload{};
+};
+
+// Single-producer/single-consumer ring owned by one logging thread and
+// drained by the writer. Full rings drop records rather than block.
+class LogRing {
+public:
+    static constexpr size_t kCapacity = 512;  // Power of two
+
+    LogRecord* BeginWrite();
+    void CommitWrite();
+    bool Read(LogRecord& record);
+    bool Empty() const;
+
+    std::atomic<bool> owner_exited{false};
+
+private:
+    std::array<LogRecord, kCapacity> records_;
+    alignas(64) std::atomic<size_t> head_{0};  // Next to read
+    alignas(64) std::atomic<size_t> tail_{0};  // Next to write
+};
+
+// Asynchronous structured logger. Log calls encode into the calling
+// thread's ring without locks, syscalls or heap allocation; a background
+// thread formats records and hands whole lines to the sink.
+class Logger {
+public:
+    using Sink = std::function<void(LogLevel level, std::string_view line)>;
+
+    static Logger& Instance();
+    ~Logger();
+
+    template <typename... Args>
+    void Log(LogLevel level, const char* component, const char* format, const Args&... args);
+
+    // Blocks until everything logged before the call has reached the sink
+    void Flush();
+
+    void SetSink(Sink sink);          // Default: stdout, stderr for ERROR
+    void SetLevel(LogLevel level) { level_.store(level, std::memory_order_relaxed); }
+    LogLevel GetLevel() const { return level_.load(std::memory_order_relaxed); }
+    uint64_t GetDroppedCount() const { return dropped_.load(std::memory_order_relaxed); }
+
+    static std::string FormatRecord(const LogRecord& record);
+
+private:
+    Logger();
+
+    enum class ArgTag : uint8_t { INT, UINT, DOUBLE, BOOL, STRING };
+
+    struct Encoder {
+        LogRecord* record;
+
+        bool Fits(size_t size);
+        void Put(const void* data, size_t size);
+        void EncodeInt(int64_t value);
+        void EncodeUint(uint64_t value);
+        void Encode(bool value);
+        void Encode(double value);
+        void Encode(std::string_view value);
+        void Encode(const char* value) { Encode(std::string_view(value ? value : "(null)")); }
+        void Encode(const std::string& value) { Encode(std::string_view(value)); }
+
+        template <typename T>
+        std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>> Encode(T value) {
+            if constexpr (std::is_signed_v<T>) {
+                EncodeInt(value);
+            } else {
+                EncodeUint(value);
+            }
+        }
+
+        template <typename T>
+        std::enable_if_t<std::is_floating_point_v<T>> Encode(T value) { Encode(static_cast<double>(value)); }
+
+        template <typename T>
+        std::enable_if_t<std::is_enum_v<T>> Encode(T value) { Encode(static_cast<std::underlying_type_t<T>>(value)); }
+    };
+
+    LogRing* ThreadRing();
+    void WriterLoop();
+    bool DrainOnce();
+    static uint64_t NowMicros();
+
+    std::atomic<LogLevel> level_{LogLevel::DEBUG};
+    std::atomic<uint64_t> dropped_{0};
+
+    std::mutex rings_mutex_;
+    std::vector<std::shared_ptr<LogRing>> rings_;
+
+    std::mutex sink_mutex_;
+    Sink sink_;
+
+    std::mutex writer_mutex_;
+    std::condition_variable writer_cv_;
+    std::condition_variable flushed_cv_;
+    uint64_t flush_requests_ = 0;
+    uint64_t flushes_done_ = 0;
+    bool stopping_ = false;
+    std::thread writer_;
+};
+
+template <typename... Args>
+void Logger::Log(LogLevel level, const char* component, const char* format, const Args&... args) {
+    if (level < GetLevel()) return;
+
+    LogRing* ring = ThreadRing();
+    LogRecord* record = ring->BeginWrite();
+    if (!record) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    record->timestamp_us = NowMicros();
+    record->component = component;
+    record->format = format;
+    record->level = level;
+    record->arg_count = static_cast<uint8_t>(sizeof...(Args));
+    record->payload_size = 0;
+    record->truncated = false;
+
+    [[maybe_unused]] Encoder encoder{record};
+    (encoder.Encode(args), ...);
+    ring->CommitWrite();
+}
+
+} // namespace chromium_playwright::logging
+
+// Levels are passed as numbers so call sites survive platform headers that
+// define ERROR (wingdi.h) or DEBUG as macros.
+#define CP_LOG(level, component, ...)                                                                   \
+    do {                                                                                                \
+        if constexpr ((level) >= CHROMIUM_PLAYWRIGHT_MIN_LOG_LEVEL) {                                   \
+            ::chromium_playwright::logging::Logger::Instance().Log(                                     \
+                static_cast<::chromium_playwright::logging::LogLevel>(level), component, __VA_ARGS__);  \
+        }                                                                                               \
+    } while (0)
+
+#define CP_LOG_DEBUG(component, ...) CP_LOG(0, component, __VA_ARGS__)
+#define CP_LOG_INFO(component, ...) CP_LOG(1, component, __VA_ARGS__)
+#define CP_LOG_WARN(component, ...) CP_LOG(2, component, __VA_ARGS__)
+#define CP_LOG_ERROR(component, ...) CP_LOG(3, component, __VA_ARGS__)
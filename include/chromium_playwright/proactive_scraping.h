@@ -10,6 +10,7 @@
 #include "browser_control.h"
 #include "dom_interaction.h"
 #include "screenshot_capture.h"
+#include "crawl/result_stream.h"
 
 namespace chromium_playwright {
 
@@ -22,6 +23,8 @@ class ChangeDetector;
 struct ScrapingConfig {
     std::string start_url;
     int max_depth = 5;
+    // Rules as for crawl::DomainMatcher: example.com, *.example.com or
+    // example.com/path; compiled once per session into a crawl::DomainFilter
     std::vector<std::string> allowed_domains;
     std::vector<std::string> blocked_domains;
     std::vector<std::string> screenshot_selectors;
@@ -36,7 +39,12 @@ struct ScrapingConfig {
     int max_pages = 100;
     int max_actions_per_page = 50;
     std::string output_directory = "./scraped_data";
+    // Also carries the crawl.* discovery flags, see crawl/discovery.h
     std::map<std::string, std::string> custom_settings;
+    std::string checkpoint_path;  // Empty: no checkpoints
+    std::chrono::seconds checkpoint_interval{60};
+    size_t result_buffer = 64;  // Streamed results waiting unconsumed before the crawl pauses
+    std::string recrawl_state_path;  // Per-URL change history kept across runs; empty: none
 };
 
 // Scraped page data
@@ -114,12 +122,32 @@ public:
     virtual bool ResumeScraping(int session_id) = 0;
     virtual bool IsScraping(int session_id) const = 0;
 
+    // Starts a session from a checkpoint written for checkpoint_path;
+    // pages completed before it are not fetched again. Returns -1 if the
+    // file is missing or corrupt.
+    virtual int ResumeFromCheckpoint(const std::string& checkpoint_path) = 0;
+
+    // Starts a session that refetches only the `fetch_budget` pages most
+    // likely to have changed, ranked from the history at
+    // config.recrawl_state_path (see crawl/recrawl_scheduler.h) and fed by
+    // ChangeDetector content hashes. Returns -1 if no history exists.
+    virtual int StartRecrawl(const ScrapingConfig& config, size_t fetch_budget) = 0;
+
     // Session information
     virtual std::vector<int> GetActiveSessions() const = 0;
     virtual std::optional<ScrapingSession> GetSession(int session_id) const = 0;
     virtual std::vector<ScrapedPageData> GetScrapingResults(int session_id) = 0;
     virtual std::vector<ScrapedPageData> GetScrapingResults(int session_id, int limit, int offset = 0) = 0;
 
+    // Delivers results as they are produced instead of retaining them in
+    // the session. The crawl pauses while config.result_buffer results
+    // wait unconsumed; cancelling the stream stops the session.
+    virtual std::shared_ptr<crawl::ResultStream<ScrapedPageData>> OpenResultStream(int session_id) = 0;
+
+    // Frees up to `count` of the oldest retained results, e.g. once the
+    // caller has persisted them; returns how many were released
+    virtual size_t ReleaseResults(int session_id, size_t count) = 0;
+
     // Progress monitoring
     virtual void SetProgressCallback(ScrapingProgressCallback callback) = 0;
     virtual void SetErrorCallback(ScrapingErrorCallback callback) = 0;
@@ -169,6 +197,7 @@ public:
     // Configuration
     virtual void SetMaxDepth(int max_depth) = 0;
     virtual int GetMaxDepth() const = 0;
+    // Same rule syntax as ScrapingConfig::allowed_domains/blocked_domains
     virtual void SetAllowedDomains(const std::vector<std::string>& domains) = 0;
     virtual std::vector<std::string> GetAllowedDomains() const = 0;
     virtual void SetBlockedDomains(const std::vector<std::string>& domains) = 0;
@@ -209,6 +238,13 @@ public:
     virtual std::string ComputeContentHash(const std::string& content) = 0;
     virtual std::string ComputeImageHash(const std::vector<uint8_t>& image_data) = 0;
 
+    // Near-duplicate detection: a SimHash fingerprint (see
+    // crawl/near_duplicate.h) changes by only a few bits when a small part
+    // of the text does, where the hashes above change completely
+    virtual uint64_t ComputeContentSimHash(const std::string& content) = 0;
+    virtual bool IsNearDuplicate(const std::string& current_content, const std::string& previous_content,
+                                 int max_distance = 3) = 0;
+
     // Configuration
     virtual void SetChangeThreshold(double threshold) = 0;
     virtual double GetChangeThreshold() const = 0;
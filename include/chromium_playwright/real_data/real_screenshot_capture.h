@@ -7,6 +7,9 @@
 #include <chrono>
 #include <set>
 #include "screenshot_capture.h"
+#include "chromium_playwright/crawl/discovery.h"
+#include "chromium_playwright/crawl/recrawl_scheduler.h"
+#include "chromium_playwright/crawl/result_stream.h"
 
 namespace chromium_playwright::real_data {
 
@@ -37,10 +40,27 @@ public:
     };
     
     virtual std::vector<ScrapingResult> ScrapeWebsite(const std::string& start_url, int max_depth = 3) = 0;
+    
+    // Streams pages as they are stored instead of collecting them; the
+    // crawl pauses while the consumer is behind and stops if it cancels
+    virtual size_t StreamWebsite(const std::string& start_url, int max_depth,
+                                 crawl::ResultStream<ScrapingResult>& stream) = 0;
+    
+    // Sitemap seeding and robots.txt for later crawls, from the crawl.*
+    // keys of ScrapingConfig::custom_settings (see crawl/discovery.h)
+    virtual void SetDiscoverySettings(const std::map<std::string, std::string>& custom_settings) = 0;
+    
+    // Every page fetched from now on is recorded in `scheduler` (content
+    // hash and visit time); null stops recording
+    virtual void SetRecrawlScheduler(std::shared_ptr<crawl::RecrawlScheduler> scheduler) = 0;
+    
+    // Refetches the `budget` recorded pages the scheduler ranks highest,
+    // without following their links
+    virtual std::vector<ScrapingResult> Recrawl(size_t budget) = 0;
 };
 
 // Factory functions
 std::unique_ptr<ScreenshotCapture> CreateRealScreenshotCapture();
-std::unique_ptr<RealWebScraper> CreateRealWebScraper();
+std::unique_ptr<RealWebScraper> CreateRealWebScraper(size_t worker_count = 0);  // 0: one worker per core
 
 } // namespace chromium_playwright::real_data
@@ -0,0 +1,251 @@
+#include "chromium_playwright/crawl/checkpoint.h"
+#include "chromium_playwright/crawl/record_file.h"
+#include "chromium_playwright/crawl/spill_queue.h"
+#include "chromium_playwright/crawl/varint.h"
+#include "chromium_playwright/logging/logger.h"
+#include <algorithm>
+#include <deque>
+#include <functional>
+#include <iterator>
+
+namespace chromium_playwright::crawl {
+
+namespace {
+
+constexpr char kCheckpointMagic[4] = {'C', 'P', 'C', 'K'};
+constexpr uint64_t kCheckpointVersion = 5;  // 2: domain rules, 3: trap detection, 4: segmented frontier,
+                                            // 5: trap template caps
+
+constexpr size_t kFrontierSegmentTasks = 4096;
+constexpr size_t kWriteChunkBytes = 64 * 1024;
+
+using FingerprintVisitor = std::function<void(uint64_t)>;
+using TaskVisitor = std::function<void(const CrawlTask&)>;
+
+void PutStrings(std::string& out, const std::vector<std::string>& values) {
+    PutVarint(out, values.size());
+    for (const auto& value : values) {
+        PutString(out, value);
+    }
+}
+
+bool GetStrings(const char*& cursor, const char* end, std::vector<std::string>& values) {
+    uint64_t count = 0;
+    // Every string takes at least one byte, which bounds the reserve
+    if (!GetVarint(cursor, end, count) || count > static_cast<uint64_t>(end - cursor)) return false;
+    values.reserve(static_cast<size_t>(count));
+    for (uint64_t i = 0; i < count; ++i) {
+        std::string value;
+        if (!GetString(cursor, end, value)) return false;
+        values.push_back(std::move(value));
+    }
+    return true;
+}
+
+void PutOptions(std::string& out, const CrawlOptions& options) {
+    PutVarint(out, options.worker_count);
+    PutVarint(out, static_cast<uint64_t>(std::max(options.max_depth, 0)));
+    PutVarint(out, options.max_pages);
+    PutVarint(out, static_cast<uint64_t>(options.frontier_policy));
+    PutVarint(out, static_cast<uint64_t>(options.politeness_delay.count()));
+    PutDouble(out, options.score_weights.depth);
+    PutDouble(out, options.score_weights.links);
+    PutDouble(out, options.score_weights.freshness);
+    PutVarint(out, options.frontier_memory_limit);
+    PutString(out, options.spill_directory.string());
+    PutString(out, options.checkpoint_path.string());
+    PutVarint(out, static_cast<uint64_t>(options.checkpoint_interval.count()));
+    PutStrings(out, options.allowed_domains);
+    PutStrings(out, options.blocked_domains);
+
+    const TrapOptions& traps = options.trap_options;
+    PutVarint(out, options.detect_traps ? 1 : 0);
+    PutVarint(out, traps.min_samples);
+    PutDouble(out, traps.throttle_below);
+    PutDouble(out, traps.prune_below);
+    PutVarint(out, traps.throttle_keep);
+    PutVarint(out, traps.max_template_urls);
+    PutVarint(out, traps.max_segment_repeats);
+    PutVarint(out, traps.max_segment_values);
+    PutVarint(out, traps.max_host_templates);
+}
+
+bool GetOptions(const char*& cursor, const char* end, uint64_t version, CrawlOptions& options) {
+    uint64_t policy = 0;
+    uint64_t politeness_ms = 0;
+    uint64_t interval_s = 0;
+    std::string spill_directory;
+    std::string checkpoint_path;
+    if (!GetInteger(cursor, end, options.worker_count) || !GetInteger(cursor, end, options.max_depth) ||
+        !GetInteger(cursor, end, options.max_pages) || !GetVarint(cursor, end, policy) ||
+        !GetVarint(cursor, end, politeness_ms) || !GetDouble(cursor, end, options.score_weights.depth) ||
+        !GetDouble(cursor, end, options.score_weights.links) ||
+        !GetDouble(cursor, end, options.score_weights.freshness) ||
+        !GetInteger(cursor, end, options.frontier_memory_limit) || !GetString(cursor, end, spill_directory) ||
+        !GetString(cursor, end, checkpoint_path) || !GetVarint(cursor, end, interval_s)) {
+        return false;
+    }
+    if (policy > static_cast<uint64_t>(FrontierPolicy::HOST_PRIORITY)) return false;
+
+    options.frontier_policy = static_cast<FrontierPolicy>(policy);
+    options.politeness_delay = std::chrono::milliseconds(politeness_ms);
+    options.spill_directory = spill_directory;
+    options.checkpoint_path = checkpoint_path;
+    options.checkpoint_interval = std::chrono::seconds(interval_s);
+    options.allowed_domains.clear();
+    options.blocked_domains.clear();
+    if (version < 2) return true;
+    if (!GetStrings(cursor, end, options.allowed_domains) || !GetStrings(cursor, end, options.blocked_domains)) {
+        return false;
+    }
+
+    if (version < 3) return true;
+    TrapOptions& traps = options.trap_options;
+    if (!GetInteger(cursor, end, options.detect_traps) || !GetInteger(cursor, end, traps.min_samples) ||
+        !GetDouble(cursor, end, traps.throttle_below) || !GetDouble(cursor, end, traps.prune_below) ||
+        !GetInteger(cursor, end, traps.throttle_keep) || !GetInteger(cursor, end, traps.max_template_urls) ||
+        !GetInteger(cursor, end, traps.max_segment_repeats)) {
+        return false;
+    }
+
+    if (version < 5) return true;
+    return GetInteger(cursor, end, traps.max_segment_values) && GetInteger(cursor, end, traps.max_host_templates);
+}
+
+// Builds the record in kWriteChunkBytes pieces. `visited_count` must match
+// what `for_each_visited` produces, which must be in ascending order.
+bool StreamCheckpoint(const std::filesystem::path& path, const CrawlCheckpoint& header, size_t visited_count,
+                      const std::function<void(const FingerprintVisitor&)>& for_each_visited,
+                      const std::function<bool(const TaskVisitor&)>& for_each_task) {
+    RecordFileWriter writer(path, kCheckpointMagic);
+    std::string out;
+    auto flush = [&](bool force) {
+        if (force || out.size() >= kWriteChunkBytes) {
+            writer.Append(out);
+            out.clear();
+        }
+    };
+
+    PutVarint(out, kCheckpointVersion);
+    const auto saved_ms =
+        std::chrono::duration_cast<std::chrono::milliseconds>(header.saved_at.time_since_epoch()).count();
+    PutVarint(out, static_cast<uint64_t>(std::max<int64_t>(saved_ms, 0)));
+    PutOptions(out, header.options);
+
+    PutVarint(out, header.metadata.size());
+    for (const auto& [key, value] : header.metadata) {
+        PutString(out, key);
+        PutString(out, value);
+    }
+    PutVarint(out, header.total_pages);
+
+    // Sorted fingerprints are dense, so their deltas are short varints
+    PutVarint(out, visited_count);
+    size_t written = 0;
+    uint64_t previous = 0;
+    for_each_visited([&](uint64_t fingerprint) {
+        PutVarint(out, fingerprint - previous);
+        previous = fingerprint;
+        ++written;
+        flush(false);
+    });
+    if (written != visited_count) {
+        CP_LOG_ERROR("crawl", "Visited set changed while writing {}", path.string());
+        return false;
+    }
+
+    std::vector<CrawlTask> segment;
+    segment.reserve(kFrontierSegmentTasks);
+    auto put_segment = [&] {
+        PutString(out, SpillQueue::EncodeSegment(segment));
+        segment.clear();
+        flush(false);
+    };
+    const bool complete = for_each_task([&](const CrawlTask& task) {
+        segment.push_back(task);
+        if (segment.size() == kFrontierSegmentTasks) put_segment();
+    });
+    if (!segment.empty()) put_segment();
+    PutString(out, std::string());
+    flush(true);
+
+    // A checkpoint missing queued tasks would silently lose them on resume
+    return complete && writer.Commit();
+}
+
+} // namespace
+
+bool WriteCheckpoint(const std::filesystem::path& path, const CrawlCheckpoint& checkpoint) {
+    std::vector<uint64_t> visited = checkpoint.visited;
+    std::sort(visited.begin(), visited.end());
+    return StreamCheckpoint(
+        path, checkpoint, visited.size(),
+        [&](const FingerprintVisitor& visit) {
+            for (uint64_t fingerprint : visited) visit(fingerprint);
+        },
+        [&](const TaskVisitor& visit) {
+            for (const CrawlTask& task : checkpoint.frontier) visit(task);
+            return true;
+        });
+}
+
+bool WriteCheckpoint(const std::filesystem::path& path, const CrawlCheckpoint& header, const VisitedUrlSet& visited,
+                     const CrawlFrontier& frontier) {
+    return StreamCheckpoint(
+        path, header, visited.Size(), [&](const FingerprintVisitor& visit) { visited.ForEachSorted(visit); },
+        [&](const TaskVisitor& visit) { return frontier.ForEachQueued(visit); });
+}
+
+bool ReadCheckpoint(const std::filesystem::path& path, CrawlCheckpoint& checkpoint) {
+    std::string data;
+    if (!ReadRecordFile(path, kCheckpointMagic, data)) return false;
+
+    const char* cursor = data.data();
+    const char* end = data.data() + data.size();
+    uint64_t version = 0;
+    uint64_t saved_ms = 0;
+    if (!GetVarint(cursor, end, version) || version == 0 || version > kCheckpointVersion ||
+        !GetVarint(cursor, end, saved_ms) || !GetOptions(cursor, end, version, checkpoint.options)) {
+        return false;
+    }
+    checkpoint.saved_at = std::chrono::system_clock::time_point(
+        std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::milliseconds(saved_ms)));
+
+    uint64_t count = 0;
+    if (!GetVarint(cursor, end, count)) return false;
+    checkpoint.metadata.clear();
+    for (uint64_t i = 0; i < count; ++i) {
+        std::string key;
+        std::string value;
+        if (!GetString(cursor, end, key) || !GetString(cursor, end, value)) return false;
+        checkpoint.metadata.emplace(std::move(key), std::move(value));
+    }
+    if (!GetInteger(cursor, end, checkpoint.total_pages) || !GetVarint(cursor, end, count)) return false;
+
+    // Every fingerprint takes at least one byte, which bounds the reserve
+    if (count > static_cast<uint64_t>(end - cursor)) return false;
+    checkpoint.visited.clear();
+    checkpoint.visited.reserve(static_cast<size_t>(count));
+    uint64_t fingerprint = 0;
+    for (uint64_t i = 0; i < count; ++i) {
+        uint64_t delta = 0;
+        if (!GetVarint(cursor, end, delta)) return false;
+        fingerprint += delta;
+        checkpoint.visited.push_back(fingerprint);
+    }
+
+    // Before version 4 the frontier was one segment with no terminator
+    std::string segment;
+    std::deque<CrawlTask> frontier;
+    while (true) {
+        if (!GetString(cursor, end, segment)) return false;
+        if (segment.empty()) break;
+        if (!SpillQueue::DecodeSegment(segment, frontier)) return false;
+        if (version < 4) break;
+    }
+    if (cursor != end) return false;
+    checkpoint.frontier.assign(std::make_move_iterator(frontier.begin()), std::make_move_iterator(frontier.end()));
+    return true;
+}
+
+} // namespace chromium_playwright::crawl
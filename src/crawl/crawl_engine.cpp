@@ -0,0 +1,306 @@
+#include "chromium_playwright/crawl/crawl_engine.h"
+#include "chromium_playwright/logging/logger.h"
+#include <algorithm>
+#include <exception>
+#include <thread>
+
+namespace chromium_playwright::crawl {
+
+CrawlEngine::CrawlEngine(CrawlOptions options) : options_(options) {
+    if (options_.worker_count == 0) {
+        options_.worker_count = std::max<size_t>(1, std::thread::hardware_concurrency());
+    }
+}
+
+std::shared_ptr<CrawlFrontier> CrawlEngine::BeginRun() {
+    std::shared_ptr<CrawlFrontier> frontier;
+    if (options_.frontier_policy == FrontierPolicy::HOST_PRIORITY) {
+        HostFrontierOptions host_options;
+        host_options.politeness_delay = options_.politeness_delay;
+        host_options.weights = options_.score_weights;
+        host_options.memory_limit = options_.frontier_memory_limit;
+        host_options.spill_directory = options_.spill_directory;
+        frontier = std::make_shared<HostPriorityFrontier>(host_options);
+    } else {
+        FrontierOptions frontier_options;
+        frontier_options.memory_limit = options_.frontier_memory_limit;
+        frontier_options.spill_directory = options_.spill_directory;
+        frontier = std::make_shared<WorkStealingFrontier>(options_.worker_count, std::move(frontier_options));
+    }
+
+    DomainFilter domain_filter(options_.allowed_domains, options_.blocked_domains);
+    std::unique_ptr<TrapDetector> trap_detector;
+    if (options_.detect_traps) {
+        trap_detector = std::make_unique<TrapDetector>(options_.trap_options);
+        trap_detector->SetReportCallback(trap_callback_);
+    }
+
+    std::lock_guard<std::mutex> lock(run_mutex_);
+    frontier_ = frontier;
+    domain_filter_ = std::move(domain_filter);
+    trap_detector_ = std::move(trap_detector);
+    worker_pages_.clear();
+    for (size_t i = 0; i < options_.worker_count; ++i) {
+        worker_pages_.push_back(std::make_unique<WorkerCounter>());
+    }
+    visited_.Clear();
+    claimed_pages_ = 0;
+    total_pages_ = 0;
+    filtered_links_ = 0;
+    robots_blocked_ = 0;
+    stop_requested_ = false;
+    running_ = true;
+
+    parked_workers_ = 0;
+    exited_workers_ = 0;
+    checkpoints_written_ = 0;
+    next_checkpoint_ = (std::chrono::steady_clock::now() + options_.checkpoint_interval).time_since_epoch().count();
+    return frontier;
+}
+
+size_t CrawlEngine::Run(const std::vector<std::string>& seeds, const PageHandler& handler) {
+    std::shared_ptr<CrawlFrontier> frontier = BeginRun();
+
+    if (options_.max_depth > 0) {
+        size_t next_worker = 0;
+        for (const auto& url : seeds) {
+            if (!domain_filter_.IsAllowed(url)) {
+                ++filtered_links_;
+            } else if (!RobotsAllow(*frontier, url)) {
+                ++robots_blocked_;
+            } else if (visited_.Insert(url)) {
+                frontier->Push(next_worker++, CrawlTask{url, 0, ""});
+            }
+        }
+    }
+
+    CP_LOG_INFO("crawl", "Crawl started: {} seeds, {} workers, max depth {}", seeds.size(), options_.worker_count,
+                options_.max_depth);
+    return RunWorkers(frontier, handler);
+}
+
+size_t CrawlEngine::ResumeFromCheckpoint(const std::filesystem::path& path, const PageHandler& handler) {
+    CrawlCheckpoint checkpoint;
+    if (!ReadCheckpoint(path, checkpoint)) {
+        CP_LOG_ERROR("crawl", "Cannot resume: {} is missing or corrupt", path.string());
+        return 0;
+    }
+
+    // Thread count belongs to this machine, not the saved session
+    const size_t worker_count = options_.worker_count;
+    options_ = checkpoint.options;
+    options_.worker_count = worker_count;
+    options_.checkpoint_path = path;
+    metadata_ = std::move(checkpoint.metadata);
+
+    std::shared_ptr<CrawlFrontier> frontier = BeginRun();
+    for (uint64_t fingerprint : checkpoint.visited) {
+        visited_.InsertFingerprint(fingerprint);
+    }
+    claimed_pages_ = checkpoint.total_pages;
+    total_pages_ = checkpoint.total_pages;
+
+    size_t next_worker = 0;
+    for (auto& task : checkpoint.frontier) {
+        frontier->Push(next_worker++, std::move(task));
+    }
+
+    CP_LOG_INFO("crawl", "Crawl resumed from {}: {} pages done, {} URLs seen, {} queued, {} workers", path.string(),
+                checkpoint.total_pages, checkpoint.visited.size(), checkpoint.frontier.size(),
+                options_.worker_count);
+    return RunWorkers(frontier, handler);
+}
+
+size_t CrawlEngine::RunWorkers(const std::shared_ptr<CrawlFrontier>& frontier, const PageHandler& handler) {
+    std::vector<std::thread> workers;
+    workers.reserve(options_.worker_count);
+    for (size_t worker = 0; worker < options_.worker_count; ++worker) {
+        workers.emplace_back([this, worker, &frontier, &handler] { WorkerLoop(worker, *frontier, handler); });
+    }
+    for (auto& thread : workers) {
+        thread.join();
+    }
+
+    // Final state, so a resumed crawl neither repeats nor loses pages
+    if (!options_.checkpoint_path.empty()) {
+        std::lock_guard<std::mutex> lock(checkpoint_mutex_);
+        WriteEngineCheckpoint(*frontier);
+    }
+
+    running_ = false;
+    const size_t pages = total_pages_.load();
+    const VisitedSetStats visited = visited_.GetStats();
+    CP_LOG_INFO("crawl", "Crawl finished: {} pages{}; {} URLs seen in {} KiB ({} bytes/URL)", pages,
+                stop_requested_.load() ? " (stopped)" : "", visited.urls, visited.TotalBytes() / 1024,
+                visited.BytesPerUrl());
+    const size_t filtered = filtered_links_.load();
+    if (filtered > 0) {
+        CP_LOG_INFO("crawl", "Domain rules dropped {} links", filtered);
+    }
+    const size_t robots_blocked = robots_blocked_.load();
+    if (robots_blocked > 0) {
+        CP_LOG_INFO("crawl", "robots.txt disallowed {} links", robots_blocked);
+    }
+    if (trap_detector_) {
+        const TrapStats traps = trap_detector_->GetStats();
+        if (traps.throttled + traps.pruned > 0) {
+            CP_LOG_INFO("crawl", "Trap detection: {} templates, {} links throttled, {} pruned", traps.templates,
+                        traps.throttled, traps.pruned);
+        }
+    }
+    const SpillQueueStats spill = frontier->GetSpillStats();
+    if (spill.segments_written > 0) {
+        CP_LOG_INFO("crawl", "Frontier spilled {} segments, {} KiB of URLs encoded in {} KiB", spill.segments_written,
+                    spill.raw_bytes / 1024, spill.encoded_bytes / 1024);
+    }
+    return pages;
+}
+
+void CrawlEngine::WorkerLoop(size_t worker, CrawlFrontier& frontier, const PageHandler& handler) {
+    WorkerCounter& counter = *worker_pages_[worker];
+    CrawlTask task;
+
+    while (true) {
+        if (checkpoint_requested_.load(std::memory_order_acquire)) ParkForCheckpoint();
+        if (!frontier.Pop(worker, task)) break;
+
+        if (options_.max_pages > 0 && claimed_pages_.fetch_add(1) >= options_.max_pages) {
+            // Requeued so a checkpoint still holds it
+            frontier.Push(worker, std::move(task));
+            frontier.TaskDone();
+            frontier.Close();
+            break;
+        }
+
+        std::vector<std::string> links;
+        try {
+            links = handler(task, worker);
+        } catch (const std::exception& e) {
+            CP_LOG_ERROR("crawl", "Worker {} failed on {}: {}", worker, task.url, e.what());
+        }
+
+        // Children are queued before TaskDone so the frontier cannot drain early
+        if (task.depth + 1 < options_.max_depth) {
+            const size_t link_count = links.size();
+            for (auto& link : links) {
+                // Robots goes before the visited set: an origin that was
+                // unreachable may allow the link when it is found again
+                if (!domain_filter_.IsAllowed(link)) {
+                    filtered_links_.fetch_add(1, std::memory_order_relaxed);
+                } else if (!RobotsAllow(frontier, link)) {
+                    robots_blocked_.fetch_add(1, std::memory_order_relaxed);
+                } else if (visited_.Insert(link) && (!trap_detector_ || trap_detector_->Admit(link))) {
+                    frontier.Push(worker, CrawlTask{std::move(link), task.depth + 1, task.url, link_count});
+                }
+            }
+        }
+
+        const size_t worker_pages = counter.pages.fetch_add(1, std::memory_order_relaxed) + 1;
+        const size_t total_pages = total_pages_.fetch_add(1, std::memory_order_relaxed) + 1;
+        if (progress_callback_) {
+            CrawlProgress progress;
+            progress.worker = worker;
+            progress.task = &task;
+            progress.worker_pages = worker_pages;
+            progress.total_pages = total_pages;
+            progress.queued = frontier.Size();
+            progress_callback_(progress);
+        }
+
+        frontier.TaskDone();
+        MaybeCheckpoint(frontier);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(checkpoint_mutex_);
+        ++exited_workers_;
+    }
+    checkpoint_cv_.notify_all();
+}
+
+// Passes the origin's Crawl-delay on to the frontier before the URL is pushed
+bool CrawlEngine::RobotsAllow(CrawlFrontier& frontier, const std::string& url) {
+    if (!robots_) return true;
+    const std::shared_ptr<const RobotsRules> rules = robots_->GetRules(url);
+    if (!rules) return true;
+    if (!rules->IsAllowed(UrlPath(url))) return false;
+    if (rules->GetCrawlDelay().count() > 0) frontier.SetHostDelay(UrlHost(url), rules->GetCrawlDelay());
+    return true;
+}
+
+void CrawlEngine::RecordContentNovelty(const CrawlTask& task, bool novel) {
+    if (trap_detector_) trap_detector_->RecordContent(task.url, novel);
+}
+
+void CrawlEngine::ParkForCheckpoint() {
+    std::unique_lock<std::mutex> lock(checkpoint_mutex_);
+    if (!checkpoint_requested_) return;
+
+    ++parked_workers_;
+    checkpoint_cv_.notify_all();
+    checkpoint_cv_.wait(lock, [this] { return !checkpoint_requested_; });
+    --parked_workers_;
+}
+
+void CrawlEngine::MaybeCheckpoint(CrawlFrontier& frontier) {
+    if (options_.checkpoint_path.empty() ||
+        std::chrono::steady_clock::now().time_since_epoch().count() < next_checkpoint_.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(checkpoint_mutex_);
+    if (checkpoint_requested_ ||
+        std::chrono::steady_clock::now().time_since_epoch().count() < next_checkpoint_.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    // Workers blocked in Pop either get a task and park after it, or
+    // return once the frontier drains, so this wait always ends
+    checkpoint_requested_ = true;
+    checkpoint_cv_.wait(lock, [this] { return parked_workers_ + exited_workers_ + 1 >= options_.worker_count; });
+
+    WriteEngineCheckpoint(frontier);
+    next_checkpoint_ = (std::chrono::steady_clock::now() + options_.checkpoint_interval).time_since_epoch().count();
+    checkpoint_requested_ = false;
+    lock.unlock();
+    checkpoint_cv_.notify_all();
+}
+
+bool CrawlEngine::WriteEngineCheckpoint(const CrawlFrontier& frontier) {
+    CrawlCheckpoint header;
+    header.options = options_;
+    header.metadata = metadata_;
+    header.saved_at = std::chrono::system_clock::now();
+    header.total_pages = total_pages_.load();
+
+    if (!WriteCheckpoint(options_.checkpoint_path, header, visited_, frontier)) return false;
+    ++checkpoints_written_;
+    CP_LOG_DEBUG("crawl", "Checkpoint {}: {} pages, {} URLs seen, {} queued", options_.checkpoint_path.string(),
+                 header.total_pages, visited_.Size(), frontier.Size());
+    return true;
+}
+
+void CrawlEngine::Stop() {
+    std::lock_guard<std::mutex> lock(run_mutex_);
+    stop_requested_ = true;
+    if (frontier_) frontier_->Close();
+}
+
+CrawlStats CrawlEngine::GetStats() const {
+    std::lock_guard<std::mutex> lock(run_mutex_);
+    CrawlStats stats;
+    stats.total_pages = total_pages_.load();
+    for (size_t worker = 0; worker < worker_pages_.size(); ++worker) {
+        stats.pages_per_worker.push_back(worker_pages_[worker]->pages.load());
+        stats.steals_per_worker.push_back(frontier_ ? frontier_->GetStealCount(worker) : 0);
+    }
+    stats.visited = visited_.GetStats();
+    if (frontier_) stats.spill = frontier_->GetSpillStats();
+    stats.checkpoints = checkpoints_written_;
+    stats.filtered_links = filtered_links_.load();
+    stats.robots_blocked = robots_blocked_.load();
+    if (trap_detector_) stats.traps = trap_detector_->GetStats();
+    return stats;
+}
+
+} // namespace chromium_playwright::crawl
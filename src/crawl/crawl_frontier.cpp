@@ -0,0 +1,186 @@
+#include "chromium_playwright/crawl/crawl_frontier.h"
+#include "chromium_playwright/logging/logger.h"
+#include <algorithm>
+
+namespace chromium_playwright::crawl {
+
+namespace {
+
+constexpr size_t kMaxRefillBatch = 1024;
+
+} // namespace
+
+WorkStealingFrontier::WorkStealingFrontier(size_t worker_count, FrontierOptions options)
+    : options_(std::move(options)) {
+    queues_.reserve(worker_count > 0 ? worker_count : 1);
+    for (size_t i = 0; i < queues_.capacity(); ++i) {
+        queues_.push_back(std::make_unique<WorkerQueue>());
+    }
+}
+
+void WorkStealingFrontier::Push(size_t worker, CrawlTask task) {
+    WorkerQueue& queue = *queues_[worker % queues_.size()];
+    outstanding_.fetch_add(1, std::memory_order_acq_rel);
+    // Counters go up before the task becomes poppable, so a concurrent
+    // TryPop can never decrement them below zero
+    queued_.fetch_add(1, std::memory_order_acq_rel);
+    if (options_.memory_limit > 0 && in_memory_.load(std::memory_order_acquire) >= options_.memory_limit) {
+        {
+            std::lock_guard<std::mutex> lock(spill_mutex_);
+            if (!spill_) {
+                spill_ = std::make_unique<SpillQueue>(options_.spill_directory, options_.segment_tasks);
+                CP_LOG_INFO("crawl", "Frontier over {} tasks, spilling to {}", options_.memory_limit,
+                            spill_->GetDirectory().string());
+            }
+            spilled_.fetch_add(1, std::memory_order_acq_rel);
+            spill_->Push(std::move(task));
+        }
+    } else {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        in_memory_.fetch_add(1, std::memory_order_acq_rel);
+        queue.tasks.push_back(std::move(task));
+    }
+    WakeIdle(false);
+}
+
+bool WorkStealingFrontier::TryPop(size_t worker, CrawlTask& task) {
+    const size_t count = queues_.size();
+    worker %= count;
+
+    // Own deque first, newest task
+    {
+        WorkerQueue& own = *queues_[worker];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            in_memory_.fetch_sub(1, std::memory_order_acq_rel);
+            queued_.fetch_sub(1, std::memory_order_acq_rel);
+            return true;
+        }
+    }
+
+    // Then steal the oldest task from the next non-empty victim
+    for (size_t offset = 1; offset < count; ++offset) {
+        WorkerQueue& victim = *queues_[(worker + offset) % count];
+        std::unique_lock<std::mutex> lock(victim.mutex);
+        if (victim.tasks.empty()) continue;
+
+        task = std::move(victim.tasks.front());
+        victim.tasks.pop_front();
+        lock.unlock();
+        in_memory_.fetch_sub(1, std::memory_order_acq_rel);
+        queued_.fetch_sub(1, std::memory_order_acq_rel);
+
+        std::lock_guard<std::mutex> own_lock(queues_[worker]->mutex);
+        ++queues_[worker]->steals;
+        return true;
+    }
+
+    // Every deque is empty: bring back the oldest spilled tasks
+    return Refill(worker, task);
+}
+
+bool WorkStealingFrontier::Refill(size_t worker, CrawlTask& task) {
+    if (spilled_.load(std::memory_order_acquire) == 0) return false;
+
+    std::vector<CrawlTask> batch;
+    size_t lost = 0;
+    {
+        std::lock_guard<std::mutex> lock(spill_mutex_);
+        if (!spill_ || spill_->Empty()) return false;
+
+        const size_t limit = std::min(kMaxRefillBatch, std::max<size_t>(1, options_.memory_limit / 2));
+        const size_t before = spill_->Size();
+        batch.reserve(limit);
+        CrawlTask next;
+        while (batch.size() < limit && spill_->Pop(next)) {
+            batch.push_back(std::move(next));
+        }
+        // Tasks in unreadable segments are gone; stop counting them as work
+        lost = before - spill_->Size() - batch.size();
+        spilled_.fetch_sub(batch.size() + lost, std::memory_order_acq_rel);
+    }
+
+    if (lost > 0) {
+        queued_.fetch_sub(lost, std::memory_order_acq_rel);
+        if (outstanding_.fetch_sub(lost, std::memory_order_acq_rel) == lost) WakeIdle(true);
+    }
+    if (batch.empty()) return false;
+
+    task = std::move(batch.front());
+    queued_.fetch_sub(1, std::memory_order_acq_rel);
+    if (batch.size() > 1) {
+        WorkerQueue& own = *queues_[worker];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        in_memory_.fetch_add(batch.size() - 1, std::memory_order_acq_rel);
+        // Reversed so the owner's LIFO pops keep the spilled order
+        own.tasks.insert(own.tasks.end(), std::make_move_iterator(batch.rbegin()),
+                         std::make_move_iterator(batch.rend() - 1));
+    }
+    return true;
+}
+
+bool WorkStealingFrontier::Pop(size_t worker, CrawlTask& task) {
+    while (true) {
+        if (IsClosed()) return false;
+        if (TryPop(worker, task)) return true;
+
+        std::unique_lock<std::mutex> lock(idle_mutex_);
+        idle_cv_.wait(lock, [&] {
+            return IsClosed() || queued_.load(std::memory_order_acquire) > 0 ||
+                   outstanding_.load(std::memory_order_acquire) == 0;
+        });
+        if (outstanding_.load(std::memory_order_acquire) == 0) return false;
+    }
+}
+
+void WorkStealingFrontier::TaskDone() {
+    if (outstanding_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        WakeIdle(true);
+    }
+}
+
+void WorkStealingFrontier::Close() {
+    closed_.store(true, std::memory_order_release);
+    WakeIdle(true);
+}
+
+size_t WorkStealingFrontier::GetStealCount(size_t worker) const {
+    const WorkerQueue& queue = *queues_[worker % queues_.size()];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    return queue.steals;
+}
+
+bool WorkStealingFrontier::ForEachQueued(const std::function<void(const CrawlTask&)>& visit) const {
+    for (const auto& queue : queues_) {
+        std::lock_guard<std::mutex> lock(queue->mutex);
+        for (const CrawlTask& task : queue->tasks) {
+            visit(task);
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(spill_mutex_);
+    if (spill_ && !spill_->ForEach(visit)) {
+        CP_LOG_ERROR("crawl", "Frontier is missing tasks from unreadable segments");
+        return false;
+    }
+    return true;
+}
+
+SpillQueueStats WorkStealingFrontier::GetSpillStats() const {
+    std::lock_guard<std::mutex> lock(spill_mutex_);
+    return spill_ ? spill_->GetStats() : SpillQueueStats{};
+}
+
+void WorkStealingFrontier::WakeIdle(bool all) {
+    // Taking the lock orders this wake-up after any waiter's predicate check
+    { std::lock_guard<std::mutex> lock(idle_mutex_); }
+    if (all) {
+        idle_cv_.notify_all();
+    } else {
+        idle_cv_.notify_one();
+    }
+}
+
+} // namespace chromium_playwright::crawl
@@ -0,0 +1,71 @@
+#include "chromium_playwright/crawl/discovery.h"
+#include "chromium_playwright/logging/logger.h"
+#include <cctype>
+#include <cstdlib>
+#include <deque>
+#include <unordered_set>
+
+namespace chromium_playwright::crawl {
+
+namespace {
+
+bool IsTrue(const std::string& value) {
+    std::string lowered;
+    for (char c : value) lowered += static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    return lowered == "true" || lowered == "1" || lowered == "yes" || lowered == "on";
+}
+
+} // namespace
+
+DiscoveryOptions ParseDiscoverySettings(const std::map<std::string, std::string>& settings) {
+    DiscoveryOptions options;
+    if (auto it = settings.find("crawl.sitemaps"); it != settings.end()) {
+        options.use_sitemaps = IsTrue(it->second);
+    }
+    if (auto it = settings.find("crawl.sitemap_max_urls"); it != settings.end()) {
+        char* end = nullptr;
+        const unsigned long long max_urls = std::strtoull(it->second.c_str(), &end, 10);
+        if (!it->second.empty() && *end == '\0') options.sitemap_max_urls = static_cast<size_t>(max_urls);
+    }
+    if (auto it = settings.find("crawl.robots"); it != settings.end()) {
+        options.respect_robots = IsTrue(it->second);
+    }
+    if (auto it = settings.find("crawl.user_agent"); it != settings.end() && !it->second.empty()) {
+        options.user_agent = it->second;
+    }
+    return options;
+}
+
+size_t CollectSitemapUrls(const std::vector<std::string>& sitemap_urls, const ChunkFetcher& fetch, size_t max_urls,
+                          const std::function<void(const SitemapEntry& entry)>& emit) {
+    std::deque<std::string> pending(sitemap_urls.begin(), sitemap_urls.end());
+    std::unordered_set<std::string> seen(sitemap_urls.begin(), sitemap_urls.end());
+    size_t emitted = 0;
+    size_t files = 0;
+
+    while (!pending.empty() && emitted < max_urls && files < kMaxSitemapFiles) {
+        const std::string url = std::move(pending.front());
+        pending.pop_front();
+        ++files;
+
+        SitemapParser parser([&](const SitemapEntry& entry) {
+            if (entry.is_sitemap) {
+                if (seen.size() < kMaxSitemapFiles && seen.insert(entry.url).second) pending.push_back(entry.url);
+                return true;
+            }
+            emit(entry);
+            return ++emitted < max_urls;
+        });
+        const bool fetched = fetch(url, [&](std::string_view chunk) { return parser.Feed(chunk); });
+        const bool complete = parser.Finish();
+        if (!fetched && parser.GetEntryCount() == 0) {
+            CP_LOG_DEBUG("crawl", "No sitemap at {}", url);
+        } else {
+            CP_LOG_INFO("crawl", "Sitemap {}: {} entries{}", url, parser.GetEntryCount(),
+                        complete || emitted >= max_urls ? "" : " (truncated)");
+        }
+    }
+    return emitted;
+}
+
+} // namespace chromium_playwright::crawl
@@ -0,0 +1,137 @@
+#include "chromium_playwright/crawl/domain_matcher.h"
+#include <cctype>
+#include <functional>
+
+namespace chromium_playwright::crawl {
+
+namespace {
+
+struct HostAndPath {
+    std::string host;
+    std::string_view path;
+};
+
+HostAndPath SplitUrl(std::string_view url) {
+    url = url.substr(0, url.find('#'));
+    const size_t scheme_end = url.find("://");
+    if (scheme_end != std::string_view::npos) url.remove_prefix(scheme_end + 3);
+
+    const size_t authority_end = url.find_first_of("/?");
+    std::string_view authority = url.substr(0, authority_end);
+    HostAndPath result;
+    result.path = authority_end == std::string_view::npos ? std::string_view("/") : url.substr(authority_end);
+
+    const size_t at = authority.rfind('@');
+    if (at != std::string_view::npos) authority.remove_prefix(at + 1);
+    // IPv6 literals keep the colons inside their brackets
+    if (!authority.empty() && authority.front() == '[') {
+        const size_t close = authority.find(']');
+        if (close != std::string_view::npos) authority = authority.substr(0, close + 1);
+    } else {
+        authority = authority.substr(0, authority.find(':'));
+    }
+    while (!authority.empty() && authority.back() == '.') authority.remove_suffix(1);
+
+    result.host.reserve(authority.size());
+    for (char c : authority) {
+        result.host += static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+    return result;
+}
+
+} // namespace
+
+size_t DomainMatcher::EdgeHash::operator()(const EdgeView& edge) const {
+    return std::hash<std::string_view>{}(edge.label) ^ (static_cast<size_t>(edge.parent) * 0x9e3779b97f4a7c15ULL);
+}
+
+DomainMatcher::DomainMatcher() : nodes_(1) {}
+
+bool DomainMatcher::Applies(uint8_t scope, bool at_host) {
+    return (scope & (at_host ? kSelf : kSubdomains)) != 0;
+}
+
+bool DomainMatcher::Add(std::string_view rule) {
+    uint8_t scope = kSelf | kSubdomains;
+    if (rule.substr(0, 2) == "*.") {
+        rule.remove_prefix(2);
+        scope = kSubdomains;
+    }
+    const HostAndPath target = SplitUrl(rule);
+    if (target.host.empty()) return false;
+
+    // Top-level label first
+    uint32_t node = 0;
+    size_t end = target.host.size();
+    while (true) {
+        const size_t dot = end == 0 ? std::string::npos : target.host.rfind('.', end - 1);
+        const size_t start = dot == std::string::npos ? 0 : dot + 1;
+        const std::string_view label = std::string_view(target.host).substr(start, end - start);
+
+        auto it = edges_.find(EdgeView{node, label});
+        if (it == edges_.end()) {
+            const auto child = static_cast<uint32_t>(nodes_.size());
+            nodes_.emplace_back();
+            it = edges_.emplace(EdgeKey{node, std::string(label)}, child).first;
+        }
+        node = it->second;
+
+        if (dot == std::string::npos) break;
+        end = dot;
+    }
+
+    if (target.path == "/") {
+        nodes_[node].scope |= scope;
+    } else {
+        nodes_[node].paths.push_back(PathRule{std::string(target.path), scope});
+    }
+    ++rule_count_;
+    return true;
+}
+
+void DomainMatcher::Add(const std::vector<std::string>& rules) {
+    for (const auto& rule : rules) {
+        Add(rule);
+    }
+}
+
+bool DomainMatcher::Matches(std::string_view url) const {
+    if (rule_count_ == 0) return false;
+    const HostAndPath target = SplitUrl(url);
+    if (target.host.empty()) return false;
+
+    // One edge lookup per label; a rule on any ancestor domain covers it
+    uint32_t node = 0;
+    size_t end = target.host.size();
+    while (true) {
+        const size_t dot = end == 0 ? std::string::npos : target.host.rfind('.', end - 1);
+        const size_t start = dot == std::string::npos ? 0 : dot + 1;
+        const std::string_view label = std::string_view(target.host).substr(start, end - start);
+
+        auto it = edges_.find(EdgeView{node, label});
+        if (it == edges_.end()) return false;
+        node = it->second;
+
+        const bool at_host = dot == std::string::npos;
+        const Node& current = nodes_[node];
+        if (Applies(current.scope, at_host)) return true;
+        for (const PathRule& rule : current.paths) {
+            if (Applies(rule.scope, at_host) && target.path.substr(0, rule.prefix.size()) == rule.prefix) return true;
+        }
+
+        if (at_host) return false;
+        end = dot;
+    }
+}
+
+DomainFilter::DomainFilter(const std::vector<std::string>& allowed, const std::vector<std::string>& blocked) {
+    allowed_.Add(allowed);
+    blocked_.Add(blocked);
+}
+
+bool DomainFilter::IsAllowed(std::string_view url) const {
+    if (blocked_.Matches(url)) return false;
+    return allowed_.Empty() || allowed_.Matches(url);
+}
+
+} // namespace chromium_playwright::crawl
@@ -0,0 +1,200 @@
+#include "chromium_playwright/crawl/host_frontier.h"
+#include "chromium_playwright/logging/logger.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+
+namespace chromium_playwright::crawl {
+
+std::string UrlHost(std::string_view url) {
+    const size_t scheme_end = url.find("://");
+    if (scheme_end == std::string_view::npos) return {};
+
+    std::string_view authority = url.substr(scheme_end + 3);
+    authority = authority.substr(0, authority.find_first_of("/?#"));
+    const size_t at = authority.rfind('@');
+    if (at != std::string_view::npos) authority.remove_prefix(at + 1);
+
+    std::string host;
+    host.reserve(authority.size());
+    for (char c : authority) {
+        host += static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+    return host;
+}
+
+double ScoreCrawlTask(const CrawlTask& task, const ScoreWeights& weights) {
+    const double depth = weights.depth / (1.0 + std::max(task.depth, 0));
+    const double links = weights.links / (1.0 + std::log2(1.0 + static_cast<double>(task.link_count)));
+    const double freshness = weights.freshness * std::clamp(task.freshness, 0.0, 1.0);
+    return depth + links + freshness;
+}
+
+HostPriorityFrontier::HostPriorityFrontier(HostFrontierOptions options) : options_(options) {}
+
+bool HostPriorityFrontier::ScoresLower(const Entry& a, const Entry& b) {
+    return a.score < b.score || (a.score == b.score && a.sequence > b.sequence);
+}
+
+bool HostPriorityFrontier::FetchesLater(const ReadyHost& a, const ReadyHost& b) {
+    return a.next_fetch > b.next_fetch;
+}
+
+void HostPriorityFrontier::Push(size_t, CrawlTask task) {
+    const double score = ScoreCrawlTask(task, options_.weights);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (options_.memory_limit > 0 && in_memory_ >= options_.memory_limit) {
+            if (!spill_) {
+                spill_ = std::make_unique<SpillQueue>(options_.spill_directory, options_.segment_tasks);
+                CP_LOG_INFO("crawl", "Host frontier over {} tasks, spilling to {}", options_.memory_limit,
+                            spill_->GetDirectory().string());
+            }
+            spill_->Push(std::move(task));
+        } else {
+            if (hosts_.size() >= sweep_threshold_) SweepIdleHosts(Clock::now());
+            QueueLocked(std::move(task), score);
+        }
+        ++queued_;
+        ++outstanding_;
+    }
+    cv_.notify_one();
+}
+
+void HostPriorityFrontier::QueueLocked(CrawlTask task, double score) {
+    Host& host = hosts_[UrlHost(task.url)];
+    host.tasks.push_back(Entry{score, sequence_++, std::move(task)});
+    std::push_heap(host.tasks.begin(), host.tasks.end(), ScoresLower);
+    if (!host.ready) {
+        host.ready = true;
+        ready_.push_back(ReadyHost{host.next_fetch, &host});
+        std::push_heap(ready_.begin(), ready_.end(), FetchesLater);
+    }
+    ++in_memory_;
+}
+
+// Brings the oldest spilled tasks back until the host queues are full
+// again. Runs under the lock, so a segment load stalls other workers once
+// per segment_tasks tasks.
+void HostPriorityFrontier::RefillLocked() {
+    const size_t before = spill_->Size();
+    size_t refilled = 0;
+    CrawlTask task;
+    while (in_memory_ < options_.memory_limit && spill_->Pop(task)) {
+        const double score = ScoreCrawlTask(task, options_.weights);
+        QueueLocked(std::move(task), score);
+        ++refilled;
+    }
+
+    // Tasks in unreadable segments are gone; stop counting them as work
+    const size_t lost = before - spill_->Size() - refilled;
+    if (lost > 0) {
+        queued_ -= lost;
+        outstanding_ -= lost;
+        if (outstanding_ == 0) cv_.notify_all();
+    }
+}
+
+bool HostPriorityFrontier::Pop(size_t, CrawlTask& task) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        if (IsClosed()) return false;
+        if (spill_ && !spill_->Empty() && in_memory_ <= options_.memory_limit / 2) RefillLocked();
+        if (ready_.empty()) {
+            if (outstanding_ == 0) return false;
+            cv_.wait(lock);
+            continue;
+        }
+
+        // Earliest host still cooling down: sleep until it may be fetched,
+        // or until a push brings a host that is ready sooner
+        const Clock::time_point now = Clock::now();
+        const Clock::time_point next_fetch = ready_.front().next_fetch;
+        if (next_fetch > now) {
+            cv_.wait_until(lock, next_fetch);
+            continue;
+        }
+
+        std::pop_heap(ready_.begin(), ready_.end(), FetchesLater);
+        Host& host = *ready_.back().host;
+        ready_.pop_back();
+
+        std::pop_heap(host.tasks.begin(), host.tasks.end(), ScoresLower);
+        task = std::move(host.tasks.back().task);
+        host.tasks.pop_back();
+        --queued_;
+        --in_memory_;
+
+        host.next_fetch = now + std::max(options_.politeness_delay, host.delay);
+        if (host.tasks.empty()) {
+            host.ready = false;
+        } else {
+            ready_.push_back(ReadyHost{host.next_fetch, &host});
+            std::push_heap(ready_.begin(), ready_.end(), FetchesLater);
+        }
+        return true;
+    }
+}
+
+void HostPriorityFrontier::TaskDone() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (--outstanding_ == 0) cv_.notify_all();
+}
+
+void HostPriorityFrontier::Close() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_.store(true, std::memory_order_release);
+    }
+    cv_.notify_all();
+}
+
+size_t HostPriorityFrontier::Size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return queued_;
+}
+
+bool HostPriorityFrontier::ForEachQueued(const std::function<void(const CrawlTask&)>& visit) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& [name, host] : hosts_) {
+        for (const Entry& entry : host.tasks) {
+            visit(entry.task);
+        }
+    }
+    if (spill_ && !spill_->ForEach(visit)) {
+        CP_LOG_ERROR("crawl", "Host frontier is missing tasks from unreadable segments");
+        return false;
+    }
+    return true;
+}
+
+SpillQueueStats HostPriorityFrontier::GetSpillStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return spill_ ? spill_->GetStats() : SpillQueueStats{};
+}
+
+void HostPriorityFrontier::SetHostDelay(const std::string& host, std::chrono::milliseconds delay) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    hosts_[host].delay = std::min(delay, options_.max_host_delay);
+}
+
+size_t HostPriorityFrontier::GetHostCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return ready_.size();
+}
+
+// Drops hosts with nothing queued whose delay has passed; a later push
+// recreates them with no pending delay, which is what they would have had.
+// Hosts given a delay by SetHostDelay are kept so they do not lose it.
+void HostPriorityFrontier::SweepIdleHosts(Clock::time_point now) {
+    for (auto it = hosts_.begin(); it != hosts_.end();) {
+        if (!it->second.ready && it->second.next_fetch <= now && it->second.delay.count() == 0) {
+            it = hosts_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    sweep_threshold_ = std::max<size_t>(1024, hosts_.size() * 2);
+}
+
+} // namespace chromium_playwright::crawl
@@ -0,0 +1,103 @@
+#include "chromium_playwright/crawl/near_duplicate.h"
+#include "chromium_playwright/crawl/visited_set.h"
+#include <algorithm>
+#include <bitset>
+#include <cctype>
+
+namespace chromium_playwright::crawl {
+
+uint64_t SimHash(std::string_view text, size_t shingle_words) {
+    shingle_words = std::max<size_t>(1, shingle_words);
+
+    std::vector<std::string> words;
+    std::string word;
+    for (char c : text) {
+        const auto byte = static_cast<unsigned char>(c);
+        if (std::isalnum(byte)) {
+            word += static_cast<char>(std::tolower(byte));
+        } else if (!word.empty()) {
+            words.push_back(std::move(word));
+            word.clear();
+        }
+    }
+    if (!word.empty()) words.push_back(std::move(word));
+    if (words.empty()) return 0;
+
+    // Short texts hash as a single shingle
+    const size_t shingles = words.size() >= shingle_words ? words.size() - shingle_words + 1 : 1;
+    int counts[64] = {};
+    std::string shingle;
+    for (size_t i = 0; i < shingles; ++i) {
+        shingle.clear();
+        for (size_t j = i; j < std::min(words.size(), i + shingle_words); ++j) {
+            shingle += words[j];
+            shingle += ' ';
+        }
+        const uint64_t hash = HashBytes(shingle);
+        for (int bit = 0; bit < 64; ++bit) {
+            counts[bit] += (hash >> bit) & 1 ? 1 : -1;
+        }
+    }
+
+    uint64_t fingerprint = 0;
+    for (int bit = 0; bit < 64; ++bit) {
+        if (counts[bit] > 0) fingerprint |= 1ULL << bit;
+    }
+    return fingerprint;
+}
+
+int HammingDistance(uint64_t a, uint64_t b) {
+    return static_cast<int>(std::bitset<64>(a ^ b).count());
+}
+
+NearDuplicateIndex::NearDuplicateIndex(int max_distance)
+    : max_distance_(std::clamp(max_distance, 0, kMaxDistanceLimit)),
+      band_bits_(64 / (max_distance_ + 1)),
+      bands_(static_cast<size_t>(max_distance_ + 1)) {}
+
+// The last band also takes the bits left over by the division
+uint64_t NearDuplicateIndex::BandValue(uint64_t fingerprint, size_t band) const {
+    const int shift = static_cast<int>(band) * band_bits_;
+    const bool last = band + 1 == bands_.size();
+    const int bits = last ? 64 - shift : band_bits_;
+    const uint64_t mask = bits >= 64 ? ~0ULL : (1ULL << bits) - 1;
+    return (fingerprint >> shift) & mask;
+}
+
+std::optional<size_t> NearDuplicateIndex::FindLocked(uint64_t fingerprint) const {
+    for (size_t band = 0; band < bands_.size(); ++band) {
+        auto it = bands_[band].find(BandValue(fingerprint, band));
+        if (it == bands_[band].end()) continue;
+        for (uint32_t index : it->second) {
+            if (HammingDistance(pages_[index].fingerprint, fingerprint) <= max_distance_) return index;
+        }
+    }
+    return std::nullopt;
+}
+
+std::optional<std::string> NearDuplicateIndex::Find(uint64_t fingerprint) const {
+    if (fingerprint == 0) return std::nullopt;
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (auto index = FindLocked(fingerprint)) return pages_[*index].url;
+    return std::nullopt;
+}
+
+std::optional<std::string> NearDuplicateIndex::InsertOrFind(std::string_view url, uint64_t fingerprint) {
+    if (fingerprint == 0) return std::nullopt;
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (auto index = FindLocked(fingerprint)) return pages_[*index].url;
+
+    const auto index = static_cast<uint32_t>(pages_.size());
+    pages_.push_back(Page{fingerprint, std::string(url)});
+    for (size_t band = 0; band < bands_.size(); ++band) {
+        bands_[band][BandValue(fingerprint, band)].push_back(index);
+    }
+    return std::nullopt;
+}
+
+size_t NearDuplicateIndex::Size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pages_.size();
+}
+
+} // namespace chromium_playwright::crawl
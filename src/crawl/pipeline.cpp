@@ -0,0 +1,18 @@
+#include "chromium_playwright/crawl/pipeline.h"
+#include "chromium_playwright/logging/logger.h"
+
+namespace chromium_playwright::crawl {
+
+void LogStageMetrics(const std::vector<StageMetrics>& metrics) {
+    for (const StageMetrics& stage : metrics) {
+        CP_LOG_INFO("crawl", "Stage {} x{}: {} ok, {} dropped, {} ms mean, {} ms max, queue {} (max {}), {} full waits",
+                    stage.name, stage.threads, stage.processed, stage.dropped, stage.mean_latency_ms,
+                    stage.max_latency_ms, stage.queue_depth, stage.max_queue_depth, stage.full_waits);
+    }
+}
+
+void LogStageFailure(const std::string& stage, const char* what) {
+    CP_LOG_ERROR("crawl", "Pipeline stage {} failed: {}", stage, what);
+}
+
+} // namespace chromium_playwright::crawl
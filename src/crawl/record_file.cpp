@@ -0,0 +1,142 @@
+#include "chromium_playwright/crawl/record_file.h"
+#include "chromium_playwright/crawl/varint.h"
+#include "chromium_playwright/logging/logger.h"
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <system_error>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace chromium_playwright::crawl {
+
+namespace {
+
+constexpr size_t kMagicBytes = 4;
+constexpr size_t kChecksumBytes = 8;
+constexpr uint64_t kChecksumSeed = 0xcbf29ce484222325ULL;
+
+uint64_t Checksum(const char* data, size_t size, uint64_t hash = kChecksumSeed) {
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+bool SyncFile(std::FILE* file) {
+    if (std::fflush(file) != 0) return false;
+#ifdef _WIN32
+    return _commit(_fileno(file)) == 0;
+#else
+    return fsync(fileno(file)) == 0;
+#endif
+}
+
+// Makes a rename durable; Windows has no directory handles to sync
+bool SyncDirectory(const std::filesystem::path& directory) {
+#ifdef _WIN32
+    (void)directory;
+    return true;
+#else
+    const int fd = open(directory.empty() ? "." : directory.c_str(), O_RDONLY | O_DIRECTORY);
+    if (fd < 0) return false;
+    const bool synced = fsync(fd) == 0;
+    close(fd);
+    return synced;
+#endif
+}
+
+} // namespace
+
+RecordFileWriter::RecordFileWriter(std::filesystem::path path, const char (&magic)[4])
+    : path_(std::move(path)), temp_path_(path_), checksum_(kChecksumSeed) {
+    temp_path_ += ".tmp";
+    file_ = std::fopen(temp_path_.string().c_str(), "wb");
+    if (!file_) {
+        failed_ = true;
+        return;
+    }
+    Append(std::string_view(magic, kMagicBytes));
+}
+
+RecordFileWriter::~RecordFileWriter() {
+    if (file_) {
+        std::fclose(file_);
+        std::error_code error;
+        std::filesystem::remove(temp_path_, error);
+    }
+}
+
+void RecordFileWriter::Append(std::string_view data) {
+    if (failed_) return;
+    checksum_ = Checksum(data.data(), data.size(), checksum_);
+    if (std::fwrite(data.data(), 1, data.size(), file_) != data.size()) failed_ = true;
+}
+
+bool RecordFileWriter::Commit() {
+    if (!failed_) {
+        std::string trailer;
+        PutFixed64(trailer, checksum_);
+        if (std::fwrite(trailer.data(), 1, trailer.size(), file_) != trailer.size() || !SyncFile(file_)) {
+            failed_ = true;
+        }
+    }
+    const bool closed = file_ && std::fclose(file_) == 0;
+    file_ = nullptr;
+
+    std::error_code error;
+    if (failed_ || !closed) {
+        CP_LOG_ERROR("crawl", "Failed to write {}", temp_path_.string());
+        std::filesystem::remove(temp_path_, error);
+        return false;
+    }
+
+    std::filesystem::rename(temp_path_, path_, error);
+    if (error) {
+        CP_LOG_ERROR("crawl", "Failed to replace {}: {}", path_.string(), error.message());
+        std::filesystem::remove(temp_path_, error);
+        return false;
+    }
+    if (!SyncDirectory(path_.parent_path())) {
+        CP_LOG_WARN("crawl", "Could not sync the directory of {}; the rename may not survive a crash",
+                    path_.string());
+    }
+    return true;
+}
+
+bool WriteRecordFile(const std::filesystem::path& path, const char (&magic)[4], const std::string& payload) {
+    RecordFileWriter writer(path, magic);
+    writer.Append(payload);
+    return writer.Commit();
+}
+
+bool ReadRecordFile(const std::filesystem::path& path, const char (&magic)[4], std::string& payload) {
+    std::string data;
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) return false;
+        data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    if (data.size() < kMagicBytes + kChecksumBytes || !std::equal(magic, magic + kMagicBytes, data.begin())) {
+        return false;
+    }
+    const size_t body = data.size() - kChecksumBytes;
+    const char* trailer = data.data() + body;
+    uint64_t stored_checksum = 0;
+    if (!GetFixed64(trailer, data.data() + data.size(), stored_checksum) ||
+        stored_checksum != Checksum(data.data(), body)) {
+        return false;
+    }
+
+    payload.assign(data, kMagicBytes, body - kMagicBytes);
+    return true;
+}
+
+} // namespace chromium_playwright::crawl
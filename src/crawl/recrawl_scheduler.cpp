@@ -0,0 +1,174 @@
+#include "chromium_playwright/crawl/recrawl_scheduler.h"
+#include "chromium_playwright/crawl/record_file.h"
+#include "chromium_playwright/crawl/varint.h"
+#include "chromium_playwright/crawl/visited_set.h"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace chromium_playwright::crawl {
+
+namespace {
+
+constexpr char kRecrawlMagic[4] = {'C', 'P', 'R', 'C'};
+constexpr uint64_t kRecrawlVersion = 1;
+
+double Seconds(RecrawlScheduler::Clock::duration duration) {
+    return std::chrono::duration<double>(duration).count();
+}
+
+int64_t ToMilliseconds(RecrawlScheduler::Clock::time_point at) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(at.time_since_epoch()).count();
+}
+
+} // namespace
+
+RecrawlScheduler::RecrawlScheduler(RecrawlOptions options) : options_(options) {
+    options_.revisit_horizon = std::max(options_.revisit_horizon, std::chrono::seconds(1));
+}
+
+void RecrawlScheduler::RecordLocked(UrlChangeHistory& history, bool changed, Clock::time_point at) {
+    if (history.visits > 0) {
+        // Clock steps backwards count as an immediate revisit
+        history.observed_seconds += std::max(0.0, Seconds(at - history.last_visit));
+        if (changed) ++history.changes;
+    }
+    ++history.visits;
+    history.last_visit = std::max(history.last_visit, at);
+}
+
+void RecrawlScheduler::RecordVisit(const std::string& url, bool changed, Clock::time_point at) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    RecordLocked(history_[url], changed, at);
+}
+
+bool RecrawlScheduler::RecordContent(const std::string& url, std::string_view content_hash, Clock::time_point at) {
+    const uint64_t hash = HashBytes(content_hash);
+    std::lock_guard<std::mutex> lock(mutex_);
+    UrlChangeHistory& history = history_[url];
+    const bool changed = history.visits > 0 && history.content_hash != hash;
+    RecordLocked(history, changed, at);
+    history.content_hash = hash;
+    return changed;
+}
+
+double RecrawlScheduler::RateLocked(const UrlChangeHistory& history) const {
+    const double revisits = history.visits > 0 ? history.visits - 1 : 0;
+    if (revisits == 0 || history.observed_seconds <= 0.0) return options_.initial_change_rate;
+
+    const double mean_interval = history.observed_seconds / revisits;
+    return -std::log((revisits - history.changes + 0.5) / (revisits + 0.5)) / mean_interval;
+}
+
+double RecrawlScheduler::GainLocked(const UrlChangeHistory& history, Clock::time_point now) const {
+    const double rate = RateLocked(history);
+    if (rate <= 0.0) return 0.0;
+
+    const double elapsed = std::max(0.0, Seconds(now - history.last_visit));
+    const double horizon = static_cast<double>(options_.revisit_horizon.count());
+    // expm1 keeps precision for pages that almost never change
+    return -std::expm1(-rate * elapsed) * -std::expm1(-rate * horizon) / (rate * horizon);
+}
+
+double RecrawlScheduler::EstimateChangeRate(const std::string& url) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = history_.find(url);
+    return it == history_.end() ? options_.initial_change_rate : RateLocked(it->second);
+}
+
+double RecrawlScheduler::RevisitGain(const std::string& url, Clock::time_point now) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = history_.find(url);
+    return it == history_.end() ? 0.0 : GainLocked(it->second, now);
+}
+
+std::vector<std::string> RecrawlScheduler::Schedule(size_t budget, Clock::time_point now) const {
+    std::vector<std::pair<double, const std::string*>> ranked;
+    std::vector<std::string> urls;
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    ranked.reserve(history_.size());
+    for (const auto& [url, history] : history_) {
+        const double gain = GainLocked(history, now);
+        if (gain > 0.0) ranked.emplace_back(gain, &url);
+    }
+
+    budget = std::min(budget, ranked.size());
+    std::partial_sort(ranked.begin(), ranked.begin() + static_cast<std::ptrdiff_t>(budget), ranked.end(),
+                      [](const auto& a, const auto& b) {
+                          return a.first != b.first ? a.first > b.first : *a.second < *b.second;
+                      });
+    urls.reserve(budget);
+    for (size_t i = 0; i < budget; ++i) {
+        urls.push_back(*ranked[i].second);
+    }
+    return urls;
+}
+
+bool RecrawlScheduler::Save(const std::filesystem::path& path) const {
+    std::string out;
+    PutVarint(out, kRecrawlVersion);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        PutVarint(out, history_.size());
+        for (const auto& [url, history] : history_) {
+            PutString(out, url);
+            PutVarint(out, static_cast<uint64_t>(std::max<int64_t>(ToMilliseconds(history.last_visit), 0)));
+            PutVarint(out, history.visits);
+            PutVarint(out, history.changes);
+            PutDouble(out, history.observed_seconds);
+            PutFixed64(out, history.content_hash);
+        }
+    }
+    return WriteRecordFile(path, kRecrawlMagic, out);
+}
+
+bool RecrawlScheduler::Load(const std::filesystem::path& path) {
+    std::string data;
+    if (!ReadRecordFile(path, kRecrawlMagic, data)) return false;
+
+    const char* cursor = data.data();
+    const char* end = data.data() + data.size();
+    uint64_t version = 0;
+    uint64_t count = 0;
+    if (!GetVarint(cursor, end, version) || version != kRecrawlVersion || !GetVarint(cursor, end, count)) {
+        return false;
+    }
+
+    std::unordered_map<std::string, UrlChangeHistory> loaded;
+    loaded.reserve(static_cast<size_t>(std::min<uint64_t>(count, data.size())));
+    for (uint64_t i = 0; i < count; ++i) {
+        std::string url;
+        uint64_t last_visit_ms = 0;
+        UrlChangeHistory history;
+        if (!GetString(cursor, end, url) || !GetVarint(cursor, end, last_visit_ms) ||
+            !GetInteger(cursor, end, history.visits) || !GetInteger(cursor, end, history.changes) ||
+            !GetDouble(cursor, end, history.observed_seconds) || !GetFixed64(cursor, end, history.content_hash)) {
+            return false;
+        }
+        if (history.visits == 0 || history.changes >= history.visits) return false;
+        history.last_visit = Clock::time_point(
+            std::chrono::duration_cast<Clock::duration>(std::chrono::milliseconds(last_visit_ms)));
+        loaded.emplace(std::move(url), history);
+    }
+    if (cursor != end) return false;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    history_ = std::move(loaded);
+    return true;
+}
+
+bool RecrawlScheduler::GetHistory(const std::string& url, UrlChangeHistory& history) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = history_.find(url);
+    if (it == history_.end()) return false;
+    history = it->second;
+    return true;
+}
+
+size_t RecrawlScheduler::Size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return history_.size();
+}
+
+} // namespace chromium_playwright::crawl
@@ -0,0 +1,293 @@
+#include "chromium_playwright/crawl/robots.h"
+#include "chromium_playwright/crawl/host_frontier.h"
+#include "chromium_playwright/logging/logger.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <exception>
+#include <iterator>
+
+namespace chromium_playwright::crawl {
+
+namespace {
+
+std::string ToLower(std::string_view text) {
+    std::string lowered;
+    lowered.reserve(text.size());
+    for (char c : text) lowered += static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    return lowered;
+}
+
+std::string_view Trim(std::string_view text) {
+    while (!text.empty() && std::isspace(static_cast<unsigned char>(text.front()))) text.remove_prefix(1);
+    while (!text.empty() && std::isspace(static_cast<unsigned char>(text.back()))) text.remove_suffix(1);
+    return text;
+}
+
+uint64_t EdgeKey(uint32_t node, char byte) {
+    return (static_cast<uint64_t>(node) << 8) | static_cast<unsigned char>(byte);
+}
+
+} // namespace
+
+std::string_view UrlPath(std::string_view url) {
+    url = url.substr(0, url.find('#'));
+    const size_t scheme_end = url.find("://");
+    if (scheme_end != std::string_view::npos) {
+        url.remove_prefix(scheme_end + 3);
+        url.remove_prefix(std::min(url.size(), url.find_first_of("/?")));
+    }
+    return url.empty() ? std::string_view("/") : url;
+}
+
+std::string UrlOrigin(std::string_view url) {
+    const size_t scheme_end = url.find("://");
+    const std::string host = UrlHost(url);
+    if (scheme_end == std::string_view::npos || host.empty()) return {};
+    return ToLower(url.substr(0, scheme_end)) + "://" + host;
+}
+
+RobotsRules RobotsRules::DisallowAll() {
+    RobotsRules rules;
+    rules.AddRule("/", false);
+    return rules;
+}
+
+RobotsRules RobotsRules::Parse(std::string_view robots_txt, std::string_view user_agent) {
+    struct Collected {
+        std::vector<std::pair<std::string_view, bool>> rules;
+        double crawl_delay = 0.0;
+    };
+    Collected specific;
+    Collected generic;
+    bool specific_found = false;
+
+    // Groups name the product token only: "bot/2.1 (+url)" matches "bot"
+    const std::string agent = ToLower(Trim(user_agent.substr(0, user_agent.find_first_of("/ "))));
+    bool in_agent_lines = false;
+    bool group_specific = false;
+    bool group_generic = false;
+
+    RobotsRules result;
+    while (!robots_txt.empty()) {
+        const size_t newline = robots_txt.find_first_of("\r\n");
+        std::string_view line = robots_txt.substr(0, newline);
+        robots_txt.remove_prefix(newline == std::string_view::npos ? robots_txt.size() : newline + 1);
+
+        line = Trim(line.substr(0, line.find('#')));
+        const size_t colon = line.find(':');
+        if (colon == std::string_view::npos) continue;
+        const std::string key = ToLower(Trim(line.substr(0, colon)));
+        const std::string_view value = Trim(line.substr(colon + 1));
+
+        if (key == "user-agent") {
+            // Consecutive user-agent lines share the group that follows
+            if (!in_agent_lines) group_specific = group_generic = false;
+            in_agent_lines = true;
+            const std::string name = ToLower(value);
+            if (name == "*") {
+                group_generic = true;
+            } else if (!name.empty() && name == agent) {
+                group_specific = true;
+                specific_found = true;
+            }
+            continue;
+        }
+        in_agent_lines = false;
+
+        if (key == "sitemap") {
+            if (!value.empty()) result.sitemaps_.emplace_back(value);
+        } else if (key == "allow" || key == "disallow") {
+            if (value.empty()) continue;  // "Disallow:" alone restricts nothing
+            if (group_specific) specific.rules.emplace_back(value, key == "allow");
+            if (group_generic) generic.rules.emplace_back(value, key == "allow");
+        } else if (key == "crawl-delay") {
+            char* end = nullptr;
+            const std::string number(value);
+            const double seconds = std::strtod(number.c_str(), &end);
+            if (number.empty() || *end != '\0' || !(seconds >= 0.0)) continue;
+            if (group_specific) specific.crawl_delay = seconds;
+            if (group_generic) generic.crawl_delay = seconds;
+        }
+    }
+
+    const Collected& chosen = specific_found ? specific : generic;
+    for (const auto& [pattern, allow] : chosen.rules) {
+        result.AddRule(pattern, allow);
+    }
+    std::stable_sort(result.wildcard_rules_.begin(), result.wildcard_rules_.end(),
+                     [](const WildcardRule& a, const WildcardRule& b) {
+                         return a.pattern.size() != b.pattern.size() ? a.pattern.size() > b.pattern.size()
+                                                                     : a.allow && !b.allow;
+                     });
+    result.crawl_delay_ = std::chrono::milliseconds(static_cast<int64_t>(std::min(chosen.crawl_delay, 86400.0) * 1000));
+    return result;
+}
+
+void RobotsRules::AddRule(std::string_view pattern, bool allow) {
+    if (pattern.empty()) return;
+    ++rule_count_;
+    if (pattern.find('*') != std::string_view::npos || pattern.back() == '$') {
+        wildcard_rules_.push_back(WildcardRule{std::string(pattern), allow});
+        return;
+    }
+
+    uint32_t node = 0;
+    for (char c : pattern) {
+        auto [it, inserted] = edges_.try_emplace(EdgeKey(node, c), static_cast<uint32_t>(verdicts_.size()));
+        if (inserted) verdicts_.push_back(kNoRule);
+        node = it->second;
+    }
+    // The same pattern allowed and disallowed: Allow wins
+    if (verdicts_[node] != 1) verdicts_[node] = allow ? 1 : 0;
+}
+
+bool RobotsRules::WildcardMatches(std::string_view pattern, std::string_view path) {
+    const bool anchored = !pattern.empty() && pattern.back() == '$';
+    if (anchored) pattern.remove_suffix(1);
+
+    // Glob with backtracking to the last *; unanchored patterns match prefixes
+    size_t p = 0;
+    size_t s = 0;
+    size_t star = std::string_view::npos;
+    size_t resume = 0;
+    while (s < path.size()) {
+        if (p < pattern.size() && pattern[p] == '*') {
+            star = p++;
+            resume = s;
+        } else if (p < pattern.size() && pattern[p] == path[s]) {
+            ++p;
+            ++s;
+        } else if (p == pattern.size() && !anchored) {
+            return true;
+        } else if (star != std::string_view::npos) {
+            p = star + 1;
+            s = ++resume;
+        } else {
+            return false;
+        }
+    }
+    while (p < pattern.size() && pattern[p] == '*') ++p;
+    return p == pattern.size();
+}
+
+bool RobotsRules::IsAllowed(std::string_view path) const {
+    if (path == "/robots.txt") return true;
+
+    size_t best_length = 0;
+    bool allowed = true;
+    uint32_t node = 0;
+    for (size_t i = 0; i < path.size(); ++i) {
+        auto it = edges_.find(EdgeKey(node, path[i]));
+        if (it == edges_.end()) break;
+        node = it->second;
+        if (verdicts_[node] != kNoRule) {
+            best_length = i + 1;
+            allowed = verdicts_[node] == 1;
+        }
+    }
+
+    for (const WildcardRule& rule : wildcard_rules_) {
+        if (rule.pattern.size() < best_length) break;
+        if (rule.pattern.size() == best_length && (allowed || !rule.allow)) continue;
+        if (WildcardMatches(rule.pattern, path)) return rule.allow;
+    }
+    return allowed;
+}
+
+RobotsFetchStatus RobotsFetchStatusForHttp(int status_code) {
+    if (status_code >= 200 && status_code < 300) return RobotsFetchStatus::OK;
+    // A 3xx here means the redirect limit was hit, which RFC 9309 treats like a 4xx
+    if (status_code >= 300 && status_code < 500 && status_code != 429) return RobotsFetchStatus::UNAVAILABLE;
+    return RobotsFetchStatus::UNREACHABLE;
+}
+
+RobotsCache::RobotsCache(Fetcher fetcher, std::string user_agent, RobotsCacheOptions options)
+    : fetcher_(std::move(fetcher)), user_agent_(std::move(user_agent)), options_(options) {
+    options_.max_hosts = std::max<size_t>(1, options_.max_hosts);
+}
+
+bool RobotsCache::IsAllowed(std::string_view url) {
+    const std::shared_ptr<const RobotsRules> rules = GetRules(url);
+    return !rules || rules->IsAllowed(UrlPath(url));
+}
+
+std::shared_ptr<const RobotsRules> RobotsCache::GetRules(std::string_view url) {
+    const std::string origin = UrlOrigin(url);
+    if (origin.empty()) return nullptr;
+
+    std::shared_future<std::shared_ptr<const RobotsRules>> cached;
+    std::promise<std::shared_ptr<const RobotsRules>> promise;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const Clock::time_point now = Clock::now();
+        auto it = entries_.find(origin);
+        if (it != entries_.end() && now < it->second.expires_at) {
+            cached = it->second.rules;
+        } else {
+            if (it == entries_.end() && entries_.size() >= options_.max_hosts) EvictLocked(now);
+            entries_[origin] = Entry{promise.get_future().share(), now + options_.ttl};
+            ++fetches_;
+        }
+    }
+    // Waits if another thread is still fetching
+    if (cached.valid()) return cached.get();
+
+    bool reachable = true;
+    std::shared_ptr<const RobotsRules> rules = Fetch(origin, reachable);
+    if (!reachable) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = entries_.find(origin);
+        if (it != entries_.end()) it->second.expires_at = Clock::now() + options_.unreachable_ttl;
+    }
+    promise.set_value(rules);
+    return rules;
+}
+
+std::shared_ptr<const RobotsRules> RobotsCache::Fetch(const std::string& origin, bool& reachable) {
+    const std::string robots_url = origin + "/robots.txt";
+    std::string body;
+    RobotsFetchStatus status = RobotsFetchStatus::UNREACHABLE;
+    try {
+        if (fetcher_) status = fetcher_(robots_url, body);
+    } catch (const std::exception& e) {
+        CP_LOG_WARN("crawl", "Fetching {} failed: {}", robots_url, e.what());
+    }
+
+    switch (status) {
+        case RobotsFetchStatus::OK: {
+            auto rules = std::make_shared<const RobotsRules>(RobotsRules::Parse(body, user_agent_));
+            CP_LOG_DEBUG("crawl", "Loaded {}: {} rules, crawl delay {} ms", robots_url, rules->GetRuleCount(),
+                         rules->GetCrawlDelay().count());
+            return rules;
+        }
+        case RobotsFetchStatus::UNAVAILABLE:
+            return std::make_shared<const RobotsRules>();
+        case RobotsFetchStatus::UNREACHABLE:
+            break;
+    }
+    CP_LOG_WARN("crawl", "{} is unreachable; disallowing {} for now", robots_url, origin);
+    reachable = false;
+    return std::make_shared<const RobotsRules>(RobotsRules::DisallowAll());
+}
+
+// Expired origins go first; failing that, an arbitrary one
+void RobotsCache::EvictLocked(Clock::time_point now) {
+    for (auto it = entries_.begin(); it != entries_.end();) {
+        it = now >= it->second.expires_at ? entries_.erase(it) : std::next(it);
+    }
+    if (entries_.size() >= options_.max_hosts) entries_.erase(entries_.begin());
+}
+
+size_t RobotsCache::Size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size();
+}
+
+size_t RobotsCache::GetFetchCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return fetches_;
+}
+
+} // namespace chromium_playwright::crawl
@@ -0,0 +1,307 @@
+#include "chromium_playwright/crawl/sitemap_parser.h"
+#include "chromium_playwright/logging/logger.h"
+#include <cctype>
+#include <cstdlib>
+#include <zlib.h>
+
+namespace chromium_playwright::crawl {
+
+namespace {
+
+constexpr size_t kMaxTagBytes = 64;  // Enough for any element name the parser looks at
+
+bool IsSpace(char c) {
+    return std::isspace(static_cast<unsigned char>(c)) != 0;
+}
+
+std::string_view Trim(std::string_view text) {
+    while (!text.empty() && IsSpace(text.front())) text.remove_prefix(1);
+    while (!text.empty() && IsSpace(text.back())) text.remove_suffix(1);
+    return text;
+}
+
+void AppendUtf8(std::string& out, unsigned long code) {
+    if (code < 0x80) {
+        out += static_cast<char>(code);
+    } else if (code < 0x800) {
+        out += static_cast<char>(0xc0 | (code >> 6));
+        out += static_cast<char>(0x80 | (code & 0x3f));
+    } else if (code < 0x10000) {
+        out += static_cast<char>(0xe0 | (code >> 12));
+        out += static_cast<char>(0x80 | ((code >> 6) & 0x3f));
+        out += static_cast<char>(0x80 | (code & 0x3f));
+    } else {
+        out += static_cast<char>(0xf0 | (code >> 18));
+        out += static_cast<char>(0x80 | ((code >> 12) & 0x3f));
+        out += static_cast<char>(0x80 | ((code >> 6) & 0x3f));
+        out += static_cast<char>(0x80 | (code & 0x3f));
+    }
+}
+
+} // namespace
+
+std::string DecodeXmlEntities(std::string_view text) {
+    std::string out;
+    out.reserve(text.size());
+    while (!text.empty()) {
+        const size_t amp = text.find('&');
+        out.append(text.substr(0, amp));
+        if (amp == std::string_view::npos) break;
+        text.remove_prefix(amp);
+
+        const size_t semicolon = text.find(';');
+        const std::string_view name = semicolon == std::string_view::npos ? std::string_view()
+                                                                          : text.substr(1, semicolon - 1);
+        unsigned long code = 0;
+        if (name == "amp") {
+            out += '&';
+        } else if (name == "lt") {
+            out += '<';
+        } else if (name == "gt") {
+            out += '>';
+        } else if (name == "quot") {
+            out += '"';
+        } else if (name == "apos") {
+            out += '\'';
+        } else if (name.size() > 1 && name[0] == '#') {
+            const bool hex = name[1] == 'x' || name[1] == 'X';
+            const std::string digits(name.substr(hex ? 2 : 1));
+            char* end = nullptr;
+            code = std::strtoul(digits.c_str(), &end, hex ? 16 : 10);
+            if (digits.empty() || *end != '\0' || code == 0 || code > 0x10ffff) {
+                out += '&';
+                text.remove_prefix(1);
+                continue;
+            }
+            AppendUtf8(out, code);
+        } else {
+            // Not a reference: keep the ampersand as written
+            out += '&';
+            text.remove_prefix(1);
+            continue;
+        }
+        text.remove_prefix(semicolon + 1);
+    }
+    return out;
+}
+
+struct SitemapParser::Inflater {
+    z_stream stream{};
+    bool ready = false;
+    bool ended = false;  // The current gzip member is complete
+    char buffer[16 * 1024];
+
+    // 16 + MAX_WBITS: expect a gzip header
+    Inflater() { ready = inflateInit2(&stream, 16 + MAX_WBITS) == Z_OK; }
+    ~Inflater() {
+        if (ready) inflateEnd(&stream);
+    }
+};
+
+SitemapParser::SitemapParser(EntryCallback callback) : callback_(std::move(callback)) {
+    tag_.reserve(kMaxTagBytes);
+}
+
+SitemapParser::~SitemapParser() = default;
+
+bool SitemapParser::Feed(std::string_view chunk) {
+    if (stopped_) return false;
+    if (chunk.empty()) return true;
+
+    if (!started_) {
+        started_ = true;
+        // No XML document starts with 0x1f, the first gzip magic byte
+        if (static_cast<unsigned char>(chunk.front()) == 0x1f) {
+            inflater_ = std::make_unique<Inflater>();
+            if (!inflater_->ready) {
+                CP_LOG_ERROR("crawl", "Cannot initialise gzip decoder for sitemap");
+                stopped_ = true;
+                return false;
+            }
+        }
+    }
+    if (!inflater_) return ParseXml(chunk);
+
+    z_stream& stream = inflater_->stream;
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(chunk.data()));
+    stream.avail_in = static_cast<uInt>(chunk.size());
+    while (true) {
+        if (inflater_->ended) {
+            // Concatenated members continue the document; trailing padding does not
+            if (stream.avail_in == 0 || *stream.next_in != 0x1f) return true;
+            if (inflateReset(&stream) != Z_OK) break;
+            inflater_->ended = false;
+        }
+
+        stream.next_out = reinterpret_cast<Bytef*>(inflater_->buffer);
+        stream.avail_out = sizeof(inflater_->buffer);
+        const int status = inflate(&stream, Z_NO_FLUSH);
+        if (status != Z_OK && status != Z_STREAM_END && status != Z_BUF_ERROR) break;
+
+        const size_t produced = sizeof(inflater_->buffer) - stream.avail_out;
+        if (produced > 0 && !ParseXml(std::string_view(inflater_->buffer, produced))) return false;
+        if (status == Z_STREAM_END) {
+            inflater_->ended = true;
+        } else if (stream.avail_in == 0 && produced < sizeof(inflater_->buffer)) {
+            return true;
+        }
+    }
+
+    CP_LOG_WARN("crawl", "Corrupt gzip data in sitemap: {}", stream.msg ? stream.msg : "unknown error");
+    stopped_ = true;
+    return false;
+}
+
+bool SitemapParser::Finish() {
+    if (stopped_) return false;
+    if (inflater_ && !inflater_->ended) {
+        CP_LOG_WARN("crawl", "Gzipped sitemap ended early after {} entries", entries_);
+        return false;
+    }
+    return true;
+}
+
+bool SitemapParser::ParseXml(std::string_view data) {
+    for (char c : data) {
+        switch (state_) {
+            case State::TEXT:
+                if (c == '<') {
+                    state_ = State::TAG;
+                    tag_.clear();
+                    tag_size_ = 0;
+                } else if (field_ != Field::NONE) {
+                    AppendText(c);
+                }
+                break;
+
+            case State::TAG:
+                if (c == '>') {
+                    state_ = State::TEXT;
+                    OnTag();
+                    if (stopped_) return false;
+                    break;
+                }
+                if (tag_.size() < kMaxTagBytes) tag_ += c;
+                ++tag_size_;
+                if (tag_size_ == 3 && tag_ == "!--") {
+                    state_ = State::COMMENT;
+                    marker_.clear();
+                } else if (tag_size_ == 8 && tag_ == "![CDATA[") {
+                    state_ = State::CDATA;
+                    marker_.clear();
+                }
+                break;
+
+            // Both end on a three-character marker; CDATA text before it is kept
+            case State::COMMENT:
+            case State::CDATA: {
+                const std::string_view end = state_ == State::COMMENT ? "-->" : "]]>";
+                marker_ += c;
+                if (marker_.size() < 3) break;
+                if (marker_ == end) {
+                    state_ = State::TEXT;
+                    marker_.clear();
+                    break;
+                }
+                if (state_ == State::CDATA && field_ != Field::NONE) AppendText(marker_.front());
+                marker_.erase(0, 1);
+                break;
+            }
+        }
+    }
+    return true;
+}
+
+void SitemapParser::OnTag() {
+    std::string_view tag = tag_;
+    if (tag.empty() || tag.front() == '?' || tag.front() == '!') return;
+
+    const bool closing = tag.front() == '/';
+    if (closing) tag.remove_prefix(1);
+    const bool self_closing = !tag.empty() && tag.back() == '/';
+    std::string_view name = tag.substr(0, tag.find_first_of(" \t\r\n/"));
+    std::string_view prefix;
+    const size_t colon = name.find(':');
+    if (colon != std::string_view::npos) {
+        prefix = name.substr(0, colon);
+        name.remove_prefix(colon + 1);
+    }
+
+    std::string lowered;
+    for (char c : name) lowered += static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    const bool entry_tag = lowered == "url" || lowered == "sitemap";
+
+    if (!in_entry_) {
+        if (entry_tag && !closing && !self_closing) {
+            in_entry_ = true;
+            entry_depth_ = 0;
+            entry_prefix_ = std::string(prefix);
+            entry_ = SitemapEntry{};
+            entry_.is_sitemap = lowered == "sitemap";
+        }
+        return;
+    }
+
+    // Only the entry's own children, in its namespace, are fields
+    Field field = Field::NONE;
+    if (prefix == entry_prefix_) {
+        if (lowered == "loc") {
+            field = Field::LOC;
+        } else if (lowered == "lastmod") {
+            field = Field::LASTMOD;
+        } else if (lowered == "priority") {
+            field = Field::PRIORITY;
+        }
+    }
+
+    if (!closing) {
+        if (self_closing) return;
+        if (field != Field::NONE && entry_depth_ == 0) {
+            field_ = field;
+            text_.clear();
+            text_overflow_ = false;
+        }
+        ++entry_depth_;
+        return;
+    }
+
+    if (entry_depth_ == 0) {
+        if (entry_tag && prefix == entry_prefix_) CloseEntry();
+        return;
+    }
+    --entry_depth_;
+    if (entry_depth_ != 0 || field == Field::NONE || field != field_) return;
+
+    field_ = Field::NONE;
+    if (text_overflow_) return;
+    std::string value = DecodeXmlEntities(Trim(text_));
+    if (field == Field::LOC) {
+        entry_.url = std::move(value);
+    } else if (field == Field::LASTMOD) {
+        entry_.lastmod = std::move(value);
+    } else {
+        char* end = nullptr;
+        const double priority = std::strtod(value.c_str(), &end);
+        if (!value.empty() && *end == '\0' && priority >= 0.0 && priority <= 1.0) entry_.priority = priority;
+    }
+}
+
+void SitemapParser::AppendText(char c) {
+    if (text_.size() < kMaxFieldBytes) {
+        text_ += c;
+    } else {
+        text_overflow_ = true;
+    }
+}
+
+void SitemapParser::CloseEntry() {
+    const bool complete = in_entry_ && !entry_.url.empty();
+    in_entry_ = false;
+    field_ = Field::NONE;
+    if (!complete) return;
+
+    ++entries_;
+    if (callback_ && !callback_(entry_)) stopped_ = true;
+}
+
+} // namespace chromium_playwright::crawl
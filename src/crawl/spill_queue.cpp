@@ -0,0 +1,226 @@
+#include "chromium_playwright/crawl/spill_queue.h"
+#include "chromium_playwright/crawl/varint.h"
+#include "chromium_playwright/logging/logger.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <system_error>
+
+namespace chromium_playwright::crawl {
+
+namespace {
+
+constexpr char kSegmentMagic[4] = {'C', 'P', 'F', '2'};
+constexpr double kFreshnessScale = 65535.0;  // Freshness is stored as 16-bit fixed point
+
+// Shared-prefix length, then the differing suffix
+void PutFrontCoded(std::string& out, const std::string& previous, const std::string& value) {
+    const size_t limit = std::min(previous.size(), value.size());
+    size_t shared = 0;
+    while (shared < limit && previous[shared] == value[shared]) ++shared;
+
+    PutVarint(out, shared);
+    PutVarint(out, value.size() - shared);
+    out.append(value, shared, std::string::npos);
+}
+
+bool GetFrontCoded(const char*& cursor, const char* end, const std::string& previous, std::string& value) {
+    uint64_t shared = 0;
+    uint64_t suffix = 0;
+    if (!GetVarint(cursor, end, shared) || !GetVarint(cursor, end, suffix)) return false;
+    if (shared > previous.size() || suffix > static_cast<uint64_t>(end - cursor)) return false;
+
+    value.assign(previous, 0, static_cast<size_t>(shared));
+    value.append(cursor, static_cast<size_t>(suffix));
+    cursor += suffix;
+    return true;
+}
+
+std::filesystem::path MakeSpillDirectory() {
+    static std::atomic<uint64_t> counter{0};
+    const auto stamp = std::chrono::steady_clock::now().time_since_epoch().count();
+    return std::filesystem::temp_directory_path() /
+           ("crawl_frontier_" + std::to_string(stamp) + "_" + std::to_string(counter++));
+}
+
+} // namespace
+
+SpillQueue::SpillQueue(std::filesystem::path directory, size_t segment_tasks)
+    : directory_(std::move(directory)), segment_tasks_(std::max<size_t>(1, segment_tasks)) {
+    if (directory_.empty()) {
+        directory_ = MakeSpillDirectory();
+        owns_directory_ = true;
+    }
+    std::error_code error;
+    std::filesystem::create_directories(directory_, error);
+    if (error) {
+        CP_LOG_ERROR("crawl", "Cannot create spill directory {}: {}", directory_.string(), error.message());
+    }
+}
+
+SpillQueue::~SpillQueue() {
+    std::error_code error;
+    for (const Segment& segment : segments_) {
+        std::filesystem::remove(segment.path, error);
+    }
+    if (owns_directory_) {
+        std::filesystem::remove(directory_, error);
+    }
+}
+
+void SpillQueue::Push(CrawlTask task) {
+    stats_.raw_bytes += task.url.size() + task.parent_url.size();
+    write_buffer_.push_back(std::move(task));
+    ++size_;
+
+    if (write_buffer_.size() >= segment_tasks_ && !WriteSegment()) {
+        // Keep going in memory; retry once another segment's worth accumulates
+        segment_tasks_ *= 2;
+    }
+}
+
+bool SpillQueue::Pop(CrawlTask& task) {
+    if (read_buffer_.empty() && !LoadOldestSegment()) {
+        // Nothing on disk: the write buffer holds the oldest remaining tasks
+        if (write_buffer_.empty()) return false;
+        read_buffer_.assign(std::make_move_iterator(write_buffer_.begin()),
+                            std::make_move_iterator(write_buffer_.end()));
+        write_buffer_.clear();
+    }
+
+    task = std::move(read_buffer_.front());
+    read_buffer_.pop_front();
+    --size_;
+    return true;
+}
+
+bool SpillQueue::ForEach(const std::function<void(const CrawlTask&)>& visit) const {
+    for (const CrawlTask& task : read_buffer_) {
+        visit(task);
+    }
+
+    bool complete = true;
+    for (const Segment& segment : segments_) {
+        std::deque<CrawlTask> decoded;
+        {
+            std::ifstream file(segment.path, std::ios::binary);
+            const std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+            if (!DecodeSegment(data, decoded)) {
+                complete = false;
+                continue;
+            }
+        }
+        for (const CrawlTask& task : decoded) {
+            visit(task);
+        }
+    }
+
+    for (const CrawlTask& task : write_buffer_) {
+        visit(task);
+    }
+    return complete;
+}
+
+bool SpillQueue::WriteSegment() {
+    const std::string data = EncodeSegment(write_buffer_);
+    char name[32];
+    std::snprintf(name, sizeof(name), "segment-%08zu.bin", next_segment_);
+    const std::filesystem::path path = directory_ / name;
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(data.data(), static_cast<std::streamsize>(data.size()));
+    file.close();
+    if (!file) {
+        CP_LOG_ERROR("crawl", "Failed to write frontier segment {}", path.string());
+        std::error_code error;
+        std::filesystem::remove(path, error);
+        return false;
+    }
+
+    ++next_segment_;
+    segments_.push_back(Segment{path, write_buffer_.size()});
+    stats_.tasks_on_disk += write_buffer_.size();
+    stats_.encoded_bytes += data.size();
+    ++stats_.segments_written;
+    write_buffer_.clear();
+    return true;
+}
+
+bool SpillQueue::LoadOldestSegment() {
+    while (!segments_.empty()) {
+        Segment segment = std::move(segments_.front());
+        segments_.pop_front();
+        stats_.tasks_on_disk -= segment.tasks;
+
+        std::string data;
+        {
+            std::ifstream file(segment.path, std::ios::binary);
+            data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        }
+        std::error_code error;
+        std::filesystem::remove(segment.path, error);
+
+        if (DecodeSegment(data, read_buffer_) && !read_buffer_.empty()) {
+            ++stats_.segments_read;
+            return true;
+        }
+        CP_LOG_ERROR("crawl", "Dropping unreadable frontier segment {} ({} tasks)", segment.path.string(),
+                     segment.tasks);
+        read_buffer_.clear();
+        size_ -= segment.tasks;
+    }
+    return false;
+}
+
+std::string SpillQueue::EncodeSegment(const std::vector<CrawlTask>& tasks) {
+    std::string out(kSegmentMagic, sizeof(kSegmentMagic));
+    PutVarint(out, tasks.size());
+
+    static const std::string kEmpty;
+    const CrawlTask* previous = nullptr;
+    for (const CrawlTask& task : tasks) {
+        PutFrontCoded(out, previous ? previous->url : kEmpty, task.url);
+        PutFrontCoded(out, previous ? previous->parent_url : kEmpty, task.parent_url);
+        PutVarint(out, static_cast<uint64_t>(std::max(task.depth, 0)));
+        PutVarint(out, task.link_count);
+        PutVarint(out, static_cast<uint64_t>(std::clamp(task.freshness, 0.0, 1.0) * kFreshnessScale + 0.5));
+        previous = &task;
+    }
+    return out;
+}
+
+bool SpillQueue::DecodeSegment(const std::string& data, std::deque<CrawlTask>& tasks) {
+    if (data.size() < sizeof(kSegmentMagic) || !std::equal(kSegmentMagic, kSegmentMagic + 4, data.begin())) {
+        return false;
+    }
+
+    const char* cursor = data.data() + sizeof(kSegmentMagic);
+    const char* end = data.data() + data.size();
+    uint64_t count = 0;
+    if (!GetVarint(cursor, end, count)) return false;
+
+    std::string url;
+    std::string parent_url;
+    for (uint64_t i = 0; i < count; ++i) {
+        uint64_t depth = 0;
+        uint64_t link_count = 0;
+        uint64_t freshness = 0;
+        if (!GetFrontCoded(cursor, end, url, url) || !GetFrontCoded(cursor, end, parent_url, parent_url) ||
+            !GetVarint(cursor, end, depth) || !GetVarint(cursor, end, link_count) ||
+            !GetVarint(cursor, end, freshness)) {
+            return false;
+        }
+        tasks.push_back(CrawlTask{url, static_cast<int>(depth), parent_url, static_cast<size_t>(link_count),
+                                  static_cast<double>(freshness) / kFreshnessScale});
+    }
+    return cursor == end;
+}
+
+SpillQueueStats SpillQueue::GetStats() const {
+    return stats_;
+}
+
+} // namespace chromium_playwright::crawl
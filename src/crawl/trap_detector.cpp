@@ -0,0 +1,309 @@
+#include "chromium_playwright/crawl/trap_detector.h"
+#include "chromium_playwright/crawl/host_frontier.h"
+#include "chromium_playwright/logging/logger.h"
+#include <algorithm>
+#include <cctype>
+#include <vector>
+
+namespace chromium_playwright::crawl {
+
+namespace {
+
+constexpr std::string_view kLoopingTemplate = "{looping path}";
+constexpr std::string_view kOverflowTemplate = "{other}";
+constexpr std::string_view kCollapsedSegment = "{*}";
+
+bool IsDigit(char c) {
+    return std::isdigit(static_cast<unsigned char>(c)) != 0;
+}
+
+std::string SegmentTemplate(std::string_view segment) {
+    const bool hex_id = segment.size() >= 16 && std::any_of(segment.begin(), segment.end(), IsDigit) &&
+                        std::all_of(segment.begin(), segment.end(), [](char c) {
+                            return c == '-' || std::isxdigit(static_cast<unsigned char>(c));
+                        });
+    if (hex_id) return "{id}";
+
+    std::string out;
+    for (size_t i = 0; i < segment.size(); ++i) {
+        if (!IsDigit(segment[i])) {
+            out += segment[i];
+        } else if (i == 0 || !IsDigit(segment[i - 1])) {
+            out += "{n}";
+        }
+    }
+    return out;
+}
+
+// Path of an absolute URL, or of a bare path
+std::string_view UrlPathAndQuery(std::string_view url) {
+    url = url.substr(0, url.find('#'));
+    const size_t scheme_end = url.find("://");
+    if (scheme_end == std::string_view::npos) return url;
+    url.remove_prefix(scheme_end + 3);
+    const size_t path_start = url.find_first_of("/?");
+    return path_start == std::string_view::npos ? std::string_view() : url.substr(path_start);
+}
+
+size_t MaxSegmentRepeats(std::string_view path) {
+    std::unordered_map<std::string_view, size_t> counts;
+    size_t max_repeats = 0;
+    while (!path.empty()) {
+        const size_t slash = path.find('/');
+        const std::string_view segment = path.substr(0, slash);
+        if (!segment.empty()) max_repeats = std::max(max_repeats, ++counts[segment]);
+        if (slash == std::string_view::npos) break;
+        path.remove_prefix(slash + 1);
+    }
+    return max_repeats;
+}
+
+// Templated path segments (split on '/', so an absolute path starts with
+// an empty one) and the "?a&b" shape of the query
+struct UrlShape {
+    std::vector<std::string> segments;
+    std::string query;
+};
+
+UrlShape ShapeOf(std::string_view url) {
+    const std::string_view path_and_query = UrlPathAndQuery(url);
+    const size_t query_start = path_and_query.find('?');
+    std::string_view path = path_and_query.substr(0, query_start);
+    std::string_view query =
+        query_start == std::string_view::npos ? std::string_view() : path_and_query.substr(query_start + 1);
+
+    UrlShape shape;
+    while (!path.empty()) {
+        const size_t slash = path.find('/');
+        shape.segments.push_back(SegmentTemplate(path.substr(0, slash)));
+        if (slash == std::string_view::npos) break;
+        path.remove_prefix(slash + 1);
+        if (path.empty()) shape.segments.emplace_back();
+    }
+
+    std::vector<std::string_view> names;
+    while (!query.empty()) {
+        const size_t amp = query.find('&');
+        const std::string_view parameter = query.substr(0, amp);
+        const std::string_view name = parameter.substr(0, parameter.find('='));
+        if (!name.empty()) names.push_back(name);
+        if (amp == std::string_view::npos) break;
+        query.remove_prefix(amp + 1);
+    }
+    std::sort(names.begin(), names.end());
+    names.erase(std::unique(names.begin(), names.end()), names.end());
+    for (size_t i = 0; i < names.size(); ++i) {
+        shape.query += i == 0 ? '?' : '&';
+        shape.query.append(names[i]);
+    }
+    return shape;
+}
+
+const char* ActionName(TrapAction action) {
+    switch (action) {
+        case TrapAction::ADMIT: return "admitted";
+        case TrapAction::THROTTLE: return "throttled";
+        case TrapAction::PRUNE: return "pruned";
+    }
+    return "unknown";
+}
+
+} // namespace
+
+std::string UrlTemplate(std::string_view url) {
+    const UrlShape shape = ShapeOf(url);
+    if (shape.segments.empty()) return "/" + shape.query;
+
+    std::string result;
+    for (size_t i = 0; i < shape.segments.size(); ++i) {
+        if (i > 0) result += '/';
+        result += shape.segments[i];
+    }
+    return result + shape.query;
+}
+
+TrapDetector::TrapDetector(TrapOptions options) : options_(options) {
+    options_.throttle_keep = std::max<size_t>(1, options_.throttle_keep);
+    options_.min_samples = std::max<size_t>(1, options_.min_samples);
+}
+
+// Counts the distinct segments after each generalized prefix of the URL's
+// path, collapsing a position once it has more than max_segment_values
+void TrapDetector::LearnSegments(Host& host, std::string_view url) const {
+    const UrlShape shape = ShapeOf(url);
+    std::string prefix;
+    for (const std::string& segment : shape.segments) {
+        std::string_view token = segment;
+        if (!segment.empty()) {
+            auto it = host.segments.find(prefix);
+            if (it == host.segments.end() && host.segments.size() < options_.max_host_templates) {
+                it = host.segments.try_emplace(prefix).first;
+            }
+            if (it == host.segments.end()) {
+                token = kCollapsedSegment;
+            } else if (!it->second.collapsed) {
+                it->second.values.insert(segment);
+                if (it->second.values.size() > options_.max_segment_values) {
+                    it->second.collapsed = true;
+                    it->second.values = {};
+                }
+            }
+            if (it != host.segments.end() && it->second.collapsed) token = kCollapsedSegment;
+        }
+        prefix.append(token);
+        prefix += '/';
+    }
+}
+
+// Looping paths grow a new template per level, so they share one
+std::string TrapDetector::TemplateFor(const Host& host, std::string_view url) const {
+    const std::string_view path_and_query = UrlPathAndQuery(url);
+    if (options_.max_segment_repeats > 0 &&
+        MaxSegmentRepeats(path_and_query.substr(0, path_and_query.find('?'))) >= options_.max_segment_repeats) {
+        return std::string(kLoopingTemplate);
+    }
+
+    const UrlShape shape = ShapeOf(url);
+    if (shape.segments.empty()) return "/" + shape.query;
+
+    std::string result;
+    for (size_t i = 0; i < shape.segments.size(); ++i) {
+        const std::string& segment = shape.segments[i];
+        if (i > 0) result += '/';
+        const auto it = segment.empty() ? host.segments.end() : host.segments.find(result);
+        const bool untracked = it == host.segments.end() && host.segments.size() >= options_.max_host_templates;
+        if (!segment.empty() && (untracked || (it != host.segments.end() && it->second.collapsed))) {
+            result += kCollapsedSegment;
+        } else {
+            result += segment;
+        }
+    }
+    result += shape.query;
+
+    // Past the cap, unseen templates share one pattern
+    if (host.patterns.size() >= options_.max_host_templates && host.patterns.count(result) == 0) {
+        return std::string(kOverflowTemplate);
+    }
+    return result;
+}
+
+TrapDetector::Pattern& TrapDetector::PatternFor(std::string_view url, std::string& host, std::string& url_template) {
+    host = UrlHost(url);
+    Host& state = hosts_[host];
+    LearnSegments(state, url);
+    url_template = TemplateFor(state, url);
+    auto [it, inserted] = state.patterns.try_emplace(url_template);
+    if (inserted) ++stats_.templates;
+    return it->second;
+}
+
+bool TrapDetector::Escalate(Pattern& pattern, TrapAction action, const std::string& host,
+                            const std::string& url_template, std::string reason, TrapReport& report) {
+    if (pattern.action >= action) return false;
+    pattern.action = action;
+
+    report.host = host;
+    report.url_template = url_template;
+    report.action = action;
+    report.reason = std::move(reason);
+    report.discovered = pattern.discovered;
+    report.judged = pattern.judged;
+    report.novel = pattern.novel;
+    reports_.push_back(report);
+    return true;
+}
+
+void TrapDetector::Publish(const TrapReport& report) {
+    CP_LOG_WARN("crawl", "Crawl trap {} {} {}: {} ({} URLs found, {}/{} fetched pages novel)", ActionName(report.action),
+                report.host, report.url_template, report.reason, report.discovered, report.novel, report.judged);
+    if (report_callback_) report_callback_(report);
+}
+
+bool TrapDetector::Admit(std::string_view url) {
+    TrapReport report;
+    bool escalated = false;
+    bool admit = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::string host;
+        std::string url_template;
+        Pattern& pattern = PatternFor(url, host, url_template);
+        ++pattern.discovered;
+
+        if (url_template == kLoopingTemplate) {
+            escalated = Escalate(pattern, TrapAction::PRUNE, host, url_template,
+                                 "path repeats a segment " + std::to_string(options_.max_segment_repeats) + "+ times",
+                                 report);
+        } else if (pattern.action == TrapAction::ADMIT && pattern.admitted >= options_.max_template_urls) {
+            escalated = Escalate(pattern, TrapAction::THROTTLE, host, url_template,
+                                 std::to_string(pattern.admitted) + " URLs queued under one template", report);
+        }
+
+        switch (pattern.action) {
+            case TrapAction::ADMIT:
+                admit = true;
+                break;
+            case TrapAction::THROTTLE:
+                admit = pattern.discovered % options_.throttle_keep == 0;
+                if (!admit) ++stats_.throttled;
+                break;
+            case TrapAction::PRUNE:
+                ++stats_.pruned;
+                break;
+        }
+        if (admit) {
+            ++pattern.admitted;
+            ++stats_.admitted;
+        }
+    }
+
+    if (escalated) Publish(report);
+    return admit;
+}
+
+void TrapDetector::RecordContent(std::string_view url, bool novel) {
+    TrapReport report;
+    bool escalated = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::string host;
+        std::string url_template;
+        Pattern& pattern = PatternFor(url, host, url_template);
+        ++pattern.judged;
+        if (novel) ++pattern.novel;
+        if (pattern.judged < options_.min_samples) return;
+
+        const double novel_share = static_cast<double>(pattern.novel) / static_cast<double>(pattern.judged);
+        const TrapAction action = novel_share < options_.prune_below      ? TrapAction::PRUNE
+                                  : novel_share < options_.throttle_below ? TrapAction::THROTTLE
+                                                                          : TrapAction::ADMIT;
+        if (action > pattern.action) {
+            escalated = Escalate(pattern, action, host, url_template,
+                                 "only " + std::to_string(static_cast<int>(novel_share * 100)) +
+                                     "% of fetched pages had new content",
+                                 report);
+        }
+    }
+
+    if (escalated) Publish(report);
+}
+
+TrapAction TrapDetector::GetAction(std::string_view url) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto host = hosts_.find(UrlHost(url));
+    if (host == hosts_.end()) return TrapAction::ADMIT;
+    auto pattern = host->second.patterns.find(TemplateFor(host->second, url));
+    return pattern == host->second.patterns.end() ? TrapAction::ADMIT : pattern->second.action;
+}
+
+std::vector<TrapReport> TrapDetector::GetReports() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return reports_;
+}
+
+TrapStats TrapDetector::GetStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+} // namespace chromium_playwright::crawl
@@ -0,0 +1,224 @@
+#include "chromium_playwright/crawl/visited_set.h"
+#include <algorithm>
+#include <cctype>
+
+namespace chromium_playwright::crawl {
+
+namespace {
+
+char ToLower(char c) {
+    return static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+}
+
+size_t RoundUpPowerOfTwo(size_t value) {
+    size_t result = 1;
+    while (result < value) result <<= 1;
+    return result;
+}
+
+} // namespace
+
+// The finalizer makes every output bit depend on every input byte
+uint64_t HashBytes(std::string_view data) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (char c : data) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 0x100000001b3ULL;
+    }
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+std::string CanonicalizeUrl(std::string_view url) {
+    std::string canonical;
+    canonical.reserve(url.size() + 1);
+
+    // Fragments never change the fetched document
+    url = url.substr(0, url.find('#'));
+
+    size_t scheme_end = url.find("://");
+    if (scheme_end == std::string_view::npos) {
+        canonical.assign(url);
+        return canonical;
+    }
+
+    std::string_view scheme = url.substr(0, scheme_end);
+    std::string_view rest = url.substr(scheme_end + 3);
+    size_t authority_end = rest.find_first_of("/?");
+    std::string_view authority = rest.substr(0, authority_end);
+    std::string_view path = authority_end == std::string_view::npos ? std::string_view() : rest.substr(authority_end);
+
+    for (char c : scheme) canonical += ToLower(c);
+    canonical += "://";
+
+    std::string host;
+    for (char c : authority) host += ToLower(c);
+    if ((canonical == "http://" && host.size() > 3 && host.compare(host.size() - 3, 3, ":80") == 0) ||
+        (canonical == "https://" && host.size() > 4 && host.compare(host.size() - 4, 4, ":443") == 0)) {
+        host.erase(host.rfind(':'));
+    }
+    canonical += host;
+
+    if (path.empty() || path.front() == '?') canonical += '/';
+    canonical.append(path);
+    return canonical;
+}
+
+uint64_t UrlFingerprint(std::string_view url) {
+    uint64_t fingerprint = HashBytes(CanonicalizeUrl(url));
+    return fingerprint != 0 ? fingerprint : 1;  // 0 marks empty slots
+}
+
+FingerprintSet::FingerprintSet(size_t expected) {
+    Rehash(std::max(kMinCapacity, RoundUpPowerOfTwo(expected * 100 / kMaxLoadPercent + 1)));
+}
+
+// The slot index uses the low bits and VisitedUrlSet the top four; the
+// filter word comes from the middle bits and the bits within it from a
+// remix, so none of them are correlated
+size_t FingerprintSet::BloomWord(uint64_t fingerprint) const {
+    return static_cast<size_t>(fingerprint >> 24) & (bloom_.size() - 1);
+}
+
+uint64_t FingerprintSet::BloomMask(uint64_t fingerprint) const {
+    const uint64_t mixed = fingerprint * 0x9e3779b97f4a7c15ULL;
+    return (1ULL << (mixed >> 58)) | (1ULL << ((mixed >> 52) & 63)) | (1ULL << ((mixed >> 46) & 63));
+}
+
+bool FingerprintSet::Contains(uint64_t fingerprint) const {
+    const uint64_t mask = BloomMask(fingerprint);
+    if ((bloom_[BloomWord(fingerprint)] & mask) != mask) {
+        ++bloom_rejections_;
+        return false;
+    }
+
+    const size_t slot_mask = slots_.size() - 1;
+    for (size_t slot = fingerprint & slot_mask;; slot = (slot + 1) & slot_mask) {
+        if (slots_[slot] == fingerprint) return true;
+        if (slots_[slot] == 0) return false;
+    }
+}
+
+bool FingerprintSet::Insert(uint64_t fingerprint) {
+    if (fingerprint == 0) fingerprint = 1;
+    if (Contains(fingerprint)) return false;
+
+    if ((size_ + 1) * 100 > slots_.size() * kMaxLoadPercent) {
+        Rehash(slots_.size() * 2);
+    }
+    InsertUnchecked(fingerprint);
+    ++size_;
+    return true;
+}
+
+void FingerprintSet::InsertUnchecked(uint64_t fingerprint) {
+    const size_t slot_mask = slots_.size() - 1;
+    size_t slot = fingerprint & slot_mask;
+    while (slots_[slot] != 0) {
+        slot = (slot + 1) & slot_mask;
+    }
+    slots_[slot] = fingerprint;
+    bloom_[BloomWord(fingerprint)] |= BloomMask(fingerprint);
+}
+
+void FingerprintSet::Rehash(size_t capacity) {
+    std::vector<uint64_t> old_slots = std::move(slots_);
+    slots_.assign(capacity, 0);
+    bloom_.assign(capacity / 8, 0);  // 8 filter bits per slot
+
+    // Fingerprints are the keys, so the filter is rebuilt without the URLs
+    for (uint64_t fingerprint : old_slots) {
+        if (fingerprint != 0) InsertUnchecked(fingerprint);
+    }
+}
+
+void FingerprintSet::Clear() {
+    size_ = 0;
+    bloom_rejections_ = 0;
+    std::vector<uint64_t>().swap(slots_);
+    Rehash(kMinCapacity);
+}
+
+void FingerprintSet::CopyTo(std::vector<uint64_t>& fingerprints) const {
+    fingerprints.reserve(fingerprints.size() + size_);
+    for (uint64_t fingerprint : slots_) {
+        if (fingerprint != 0) fingerprints.push_back(fingerprint);
+    }
+}
+
+VisitedSetStats FingerprintSet::GetStats() const {
+    VisitedSetStats stats;
+    stats.urls = size_;
+    stats.table_bytes = slots_.capacity() * sizeof(uint64_t);
+    stats.bloom_bytes = bloom_.capacity() * sizeof(uint64_t);
+    stats.bloom_rejections = bloom_rejections_;
+    return stats;
+}
+
+bool VisitedUrlSet::Insert(std::string_view url) {
+    return InsertFingerprint(UrlFingerprint(url));
+}
+
+bool VisitedUrlSet::InsertFingerprint(uint64_t fingerprint) {
+    if (fingerprint == 0) fingerprint = 1;
+    Shard& shard = ShardFor(fingerprint);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    return shard.fingerprints.Insert(fingerprint);
+}
+
+bool VisitedUrlSet::Contains(std::string_view url) const {
+    const uint64_t fingerprint = UrlFingerprint(url);
+    const Shard& shard = ShardFor(fingerprint);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    return shard.fingerprints.Contains(fingerprint);
+}
+
+void VisitedUrlSet::Clear() {
+    for (Shard& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.fingerprints.Clear();
+    }
+}
+
+void VisitedUrlSet::ForEachSorted(const std::function<void(uint64_t)>& visit) const {
+    std::vector<uint64_t> fingerprints;
+    for (const Shard& shard : shards_) {
+        fingerprints.clear();
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            shard.fingerprints.CopyTo(fingerprints);
+        }
+        std::sort(fingerprints.begin(), fingerprints.end());
+        for (uint64_t fingerprint : fingerprints) {
+            visit(fingerprint);
+        }
+    }
+}
+
+size_t VisitedUrlSet::Size() const {
+    size_t size = 0;
+    for (const Shard& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        size += shard.fingerprints.Size();
+    }
+    return size;
+}
+
+VisitedSetStats VisitedUrlSet::GetStats() const {
+    VisitedSetStats total;
+    for (const Shard& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        VisitedSetStats stats = shard.fingerprints.GetStats();
+        total.urls += stats.urls;
+        total.table_bytes += stats.table_bytes;
+        total.bloom_bytes += stats.bloom_bytes;
+        total.bloom_rejections += stats.bloom_rejections;
+    }
+    return total;
+}
+
+} // namespace chromium_playwright::crawl
@@ -0,0 +1,159 @@
+#include "chromium_playwright/dom/attribute_index.h"
+#include "chromium_playwright/dom/dom_tree.h"
+#include <algorithm>
+#include <cctype>
+
+namespace chromium_playwright::dom {
+
+namespace {
+
+std::string ToLower(const std::string& text) {
+    std::string result = text;
+    std::transform(result.begin(), result.end(), result.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return result;
+}
+
+std::string GetAttribute(const DOMNode& node, const std::string& name) {
+    auto it = node.attributes.find(name);
+    return (it != node.attributes.end()) ? it->second : "";
+}
+
+const std::vector<NodeIndex> kNoNodes;
+
+} // namespace
+
+template <typename Callback>
+void AttributeIndex::ForEachEntry(const DOMNode& node, Callback&& callback) {
+    callback(IndexedAttribute::TAG, ToLower(node.tag_name));
+
+    static const std::pair<const char*, IndexedAttribute> kPlainAttributes[] = {
+        {"id", IndexedAttribute::ID},
+        {"data-testid", IndexedAttribute::TEST_ID},
+        {"title", IndexedAttribute::TITLE},
+        {"placeholder", IndexedAttribute::PLACEHOLDER},
+        {"alt", IndexedAttribute::ALT},
+    };
+    for (const auto& entry : kPlainAttributes) {
+        auto it = node.attributes.find(entry.first);
+        if (it != node.attributes.end()) {
+            callback(entry.second, it->second);
+        }
+    }
+
+    // Class tokens, skipping duplicates within the attribute
+    auto class_it = node.attributes.find("class");
+    if (class_it != node.attributes.end()) {
+        std::vector<std::string> seen;
+        const std::string& classes = class_it->second;
+        size_t pos = 0;
+        while (pos < classes.size()) {
+            while (pos < classes.size() && std::isspace(static_cast<unsigned char>(classes[pos]))) ++pos;
+            size_t end = pos;
+            while (end < classes.size() && !std::isspace(static_cast<unsigned char>(classes[end]))) ++end;
+            if (end > pos) {
+                std::string token = classes.substr(pos, end - pos);
+                if (std::find(seen.begin(), seen.end(), token) == seen.end()) {
+                    callback(IndexedAttribute::CLASS, token);
+                    seen.push_back(std::move(token));
+                }
+            }
+            pos = end;
+        }
+    }
+
+    std::string role = ComputeRole(node);
+    if (!role.empty()) {
+        callback(IndexedAttribute::ROLE, role);
+    }
+}
+
+void AttributeIndex::AddNode(NodeIndex index, const DOMNode& node) {
+    ForEachEntry(node, [&](IndexedAttribute attribute, const std::string& value) {
+        IndexFor(attribute)[value].push_back(index);
+    });
+}
+
+void AttributeIndex::RemoveNode(NodeIndex index, const DOMNode& node) {
+    ForEachEntry(node, [&](IndexedAttribute attribute, const std::string& value) {
+        ValueMap& map = IndexFor(attribute);
+        auto it = map.find(value);
+        if (it == map.end()) return;
+
+        auto& nodes = it->second;
+        auto found = std::find(nodes.begin(), nodes.end(), index);
+        if (found != nodes.end()) {
+            *found = nodes.back();
+            nodes.pop_back();
+        }
+        if (nodes.empty()) {
+            map.erase(it);
+        }
+    });
+}
+
+void AttributeIndex::Clear() {
+    for (auto& map : indexes_) {
+        map.clear();
+    }
+}
+
+const std::vector<NodeIndex>& AttributeIndex::Lookup(IndexedAttribute attribute, const std::string& value) const {
+    const ValueMap& map = IndexFor(attribute);
+    auto it = map.find(attribute == IndexedAttribute::TAG ? ToLower(value) : value);
+    return (it != map.end()) ? it->second : kNoNodes;
+}
+
+size_t AttributeIndex::Count(IndexedAttribute attribute, const std::string& value) const {
+    return Lookup(attribute, value).size();
+}
+
+bool AttributeIndex::AffectsIndex(const std::string& attribute_name) {
+    // "type" and "href" feed the implicit role of inputs and links
+    return attribute_name == "id" || attribute_name == "class" || attribute_name == "data-testid" ||
+           attribute_name == "role" || attribute_name == "title" || attribute_name == "placeholder" ||
+           attribute_name == "alt" || attribute_name == "type" || attribute_name == "href" ||
+           attribute_name == "multiple";
+}
+
+std::string AttributeIndex::ComputeRole(const DOMNode& node) {
+    std::string explicit_role = GetAttribute(node, "role");
+    if (!explicit_role.empty()) {
+        // First token of a role list is the one user agents honour
+        size_t space = explicit_role.find(' ');
+        return explicit_role.substr(0, space);
+    }
+
+    const std::string tag = ToLower(node.tag_name);
+    if (tag == "button") return "button";
+    if (tag == "a" || tag == "area") return node.attributes.count("href") ? "link" : "";
+    if (tag == "img") return GetAttribute(node, "alt").empty() && node.attributes.count("alt") ? "presentation" : "img";
+    if (tag == "textarea") return "textbox";
+    if (tag == "select") return node.attributes.count("multiple") ? "listbox" : "combobox";
+    if (tag == "option") return "option";
+    if (tag == "h1" || tag == "h2" || tag == "h3" || tag == "h4" || tag == "h5" || tag == "h6") return "heading";
+    if (tag == "ul" || tag == "ol") return "list";
+    if (tag == "li") return "listitem";
+    if (tag == "nav") return "navigation";
+    if (tag == "main") return "main";
+    if (tag == "header") return "banner";
+    if (tag == "footer") return "contentinfo";
+    if (tag == "aside") return "complementary";
+    if (tag == "form") return "form";
+    if (tag == "table") return "table";
+    if (tag == "dialog") return "dialog";
+
+    if (tag == "input") {
+        const std::string type = ToLower(GetAttribute(node, "type"));
+        if (type.empty() || type == "text" || type == "email" || type == "tel" || type == "url") return "textbox";
+        if (type == "search") return "searchbox";
+        if (type == "checkbox") return "checkbox";
+        if (type == "radio") return "radio";
+        if (type == "range") return "slider";
+        if (type == "number") return "spinbutton";
+        if (type == "button" || type == "submit" || type == "reset" || type == "image") return "button";
+    }
+    return "";
+}
+
+} // namespace chromium_playwright::dom
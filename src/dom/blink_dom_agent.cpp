@@ -1,134 +1,301 @@
-#include "blink_dom_agent.h"
-#include <iostream>
+#include "chromium_playwright/dom/blink_dom_agent.h"
+#include "chromium_playwright/dom/dom_tree.h"
+#include "chromium_playwright/dom/xpath_evaluator.h"
+#include "chromium_playwright/dom/text_index.h"
+#include "chromium_playwright/dom/dom_events.h"
+#include "chromium_playwright/dom/html_serializer.h"
+#include "chromium_playwright/logging/logger.h"
 #include <regex>
 #include <algorithm>
 #include <sstream>
+#include <iterator>
+#include <optional>
+#include <cctype>
+#include <atomic>
+#include <chrono>
+#include <mutex>
 
 namespace chromium_playwright::dom {
 
-// Blink DOM Agent Implementation
+// Blink DOM Agent Implementation. Every call holds the agent's lock, so
+// listeners may call back into the agent; Wait* calls release it while
+// blocked and take it only to evaluate their predicates.
 class BlinkDOMAgentImpl : public BlinkDOMAgent {
 public:
     BlinkDOMAgentImpl() {
+        // Every tree mutation wakes the waiters subscribed to it
+        document_.SetMutationObserver([this](DOMSignal signal, NodeIndex node) {
+            conditions_.Notify(signal, node);
+        });
+        
         // Initialize mock DOM
         InitializeMockDOM();
     }
     
     // Element finding
     std::vector<ElementHandle> FindElements(const std::string& selector, ElementSearchType type) override {
-        std::vector<ElementHandle> elements;
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        return ToElementHandles(FindNodes(selector, type));
+    }
+    
+    std::vector<NodeHandle> FindElementHandles(const std::string& selector, ElementSearchType type) override {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        auto nodes = FindNodes(selector, type);
         
-        switch (type) {
-            case ElementSearchType::CSS_SELECTOR:
-                elements = FindByCSSSelector(selector);
-                break;
-            case ElementSearchType::XPATH:
-                elements = FindByXPath(selector);
-                break;
-            case ElementSearchType::TEXT_CONTENT:
-                elements = FindByText(selector);
-                break;
-            case ElementSearchType::ROLE:
-                elements = FindByRole(selector);
-                break;
-            case ElementSearchType::PLACEHOLDER:
-                elements = FindByPlaceholder(selector);
-                break;
-            case ElementSearchType::ALT_TEXT:
-                elements = FindByAltText(selector);
-                break;
-            case ElementSearchType::TITLE:
-                elements = FindByTitle(selector);
-                break;
-            case ElementSearchType::TEST_ID:
-                elements = FindByTestId(selector);
-                break;
+        std::vector<NodeHandle> handles;
+        handles.reserve(nodes.size());
+        for (NodeIndex node : nodes) {
+            handles.push_back(document_.GetHandle(node));
         }
+        return handles;
+    }
+    
+    std::vector<ElementHandle> FindElementsByText(const std::string& text, const TextMatchOptions& options) override {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        return ToElementHandles(FindByText(text, options));
+    }
+    
+    std::vector<std::vector<ElementHandle>> FindElementsBatch(
+        const std::vector<std::pair<std::string, ElementSearchType>>& queries) override {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        std::vector<std::vector<ElementHandle>> results(queries.size());
+        std::vector<std::vector<NodeIndex>> matches(queries.size());
+        std::vector<bool> collected(queries.size(), false);  // Answered from `matches`
         
-        return elements;
+        // Repeated queries are evaluated once and copied afterwards
+        std::map<std::pair<std::string, ElementSearchType>, size_t> first_seen;
+        std::vector<size_t> duplicates;
+        
+        // Selectors without an indexed key share a single document walk
+        std::vector<std::pair<size_t, SimpleSelector>> scanned;
+        auto collect = [&](size_t query, SimpleSelector parsed) {
+            if (!HasIndexedKey(parsed)) {
+                scanned.emplace_back(query, std::move(parsed));
+                return;
+            }
+            for (NodeIndex node : SelectCandidates(parsed)) {
+                if (MatchesSelector(*document_.GetNode(node), parsed)) {
+                    matches[query].push_back(node);
+                }
+            }
+        };
+        
+        for (size_t i = 0; i < queries.size(); ++i) {
+            const auto& [selector, type] = queries[i];
+            if (!first_seen.emplace(queries[i], i).second) {
+                duplicates.push_back(i);
+                continue;
+            }
+            
+            if (type == ElementSearchType::XPATH) {
+                // "//tag[@attr='value']" is a selector in disguise; anything
+                // richer needs the full evaluator
+                SimpleSelector parsed;
+                if (!ParseSimpleXPath(selector, parsed)) {
+                    results[i] = FindElements(selector, type);
+                    continue;
+                }
+                collected[i] = true;
+                collect(i, std::move(parsed));
+                continue;
+            }
+            if (type != ElementSearchType::CSS_SELECTOR) {
+                // Index-backed lookups need no shared walk
+                results[i] = FindElements(selector, type);
+                continue;
+            }
+            
+            collected[i] = true;
+            std::stringstream groups(selector);
+            std::string group;
+            while (std::getline(groups, group, ',')) {
+                SimpleSelector parsed;
+                if (!ParseSimpleSelector(group, parsed)) {
+                    CP_LOG_WARN("dom", "Unsupported CSS selector: {}", group);
+                    continue;
+                }
+                collect(i, std::move(parsed));
+            }
+        }
+        
+        if (!scanned.empty()) {
+            document_.ForEachNode([&](NodeIndex node, const DOMNode& dom_node) {
+                for (const auto& [query, parsed] : scanned) {
+                    if (MatchesSelector(dom_node, parsed)) {
+                        matches[query].push_back(node);
+                    }
+                }
+            });
+        }
+        
+        for (size_t i = 0; i < queries.size(); ++i) {
+            if (!collected[i]) continue;
+            results[i] = ToElementHandles(SortDocumentOrder(std::move(matches[i])));
+        }
+        for (size_t i : duplicates) {
+            results[i] = results[first_seen[queries[i]]];
+        }
+        
+        return results;
     }
     
     // Element actions
     bool ClickElement(const std::string& element_id) override {
-        auto element = GetElement(element_id);
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        auto element = GetMutableElement(element_id);
         if (!element) return false;
         
-        std::cout << "🖱️  Clicked element: " << element_id << " (" << element->tag_name << ")" << std::endl;
+        CP_LOG_INFO("dom", "Clicked element: {} ({})", element_id, element->tag_name);
         
         // Simulate click event
         element->clicked = true;
         element->last_click_time = GetCurrentTime();
+        conditions_.Notify(DOMSignal::STATE, document_.FindById(element_id));
         
         // Trigger click handlers
-        TriggerEvent(element_id, "click");
+        DispatchEvent(element_id, EventType::CLICK);
         
         return true;
     }
     
     bool TypeText(const std::string& element_id, const std::string& text) override {
-        auto element = GetElement(element_id);
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        NodeIndex node = document_.FindById(element_id);
+        const DOMNode* element = document_.GetNode(node);
         if (!element) return false;
         
-        std::cout << "⌨️  Typed text into element: " << element_id << " (" << element->tag_name << ")" << std::endl;
-        std::cout << "   Text: \"" << text << "\"" << std::endl;
+        CP_LOG_INFO("dom", "Typed text into element: {} ({}): \"{}\"", element_id, element->tag_name, text);
         
         // Update element value
-        element->value = text;
-        element->text_content = text;
+        document_.SetValue(node, text);
+        document_.SetTextContent(node, text);
         
         // Trigger input event
-        TriggerEvent(element_id, "input");
+        DispatchEvent(element_id, EventType::INPUT);
         
         return true;
     }
     
     bool HoverElement(const std::string& element_id) override {
-        auto element = GetElement(element_id);
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        auto element = GetMutableElement(element_id);
         if (!element) return false;
         
-        std::cout << "🖱️  Hovered over element: " << element_id << " (" << element->tag_name << ")" << std::endl;
+        CP_LOG_INFO("dom", "Hovered over element: {} ({})", element_id, element->tag_name);
         
         // Simulate hover
         element->hovered = true;
+        conditions_.Notify(DOMSignal::STATE, document_.FindById(element_id));
         
         // Trigger hover events
-        TriggerEvent(element_id, "mouseover");
-        TriggerEvent(element_id, "mouseenter");
+        DispatchEvent(element_id, EventType::MOUSEOVER);
+        DispatchEvent(element_id, EventType::MOUSEENTER);
         
         return true;
     }
     
     bool FocusElement(const std::string& element_id) override {
-        auto element = GetElement(element_id);
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        auto element = GetMutableElement(element_id);
         if (!element) return false;
         
-        std::cout << "🎯  Focused element: " << element_id << " (" << element->tag_name << ")" << std::endl;
+        CP_LOG_INFO("dom", "Focused element: {} ({})", element_id, element->tag_name);
         
         // Update focus
-        if (focused_element_) {
-            focused_element_->focused = false;
+        if (auto previous = document_.GetMutableNode(focused_node_)) {
+            previous->focused = false;
         }
         element->focused = true;
-        focused_element_ = element;
+        focused_node_ = document_.FindById(element_id);
+        conditions_.Notify(DOMSignal::STATE, focused_node_);
         
         // Trigger focus event
-        TriggerEvent(element_id, "focus");
+        DispatchEvent(element_id, EventType::FOCUS);
+        
+        return true;
+    }
+    
+    bool BlurElement(const std::string& element_id) override {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        NodeIndex node = document_.FindById(element_id);
+        const DOMNode* element = document_.GetNode(node);
+        if (!element) return false;
+        if (!element->focused) return true;
+        
+        CP_LOG_INFO("dom", "Blurred element: {} ({})", element_id, element->tag_name);
+        
+        document_.GetMutableNode(node)->focused = false;
+        if (focused_node_ == node) focused_node_ = kInvalidNodeIndex;
+        conditions_.Notify(DOMSignal::STATE, node);
+        
+        DispatchEvent(element_id, EventType::BLUR);
+        
+        return true;
+    }
+    
+    bool CheckElement(const std::string& element_id) override {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        return SetCheckedState(element_id, true);
+    }
+    
+    bool UncheckElement(const std::string& element_id) override {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        return SetCheckedState(element_id, false);
+    }
+    
+    bool SelectOption(const std::string& element_id, const std::string& value) override {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        NodeIndex node = document_.FindById(element_id);
+        const DOMNode* element = document_.GetNode(node);
+        if (!element || !EqualsIgnoreCase(element->tag_name, "select")) return false;
+        
+        CP_LOG_INFO("dom", "Selected option \"{}\" in element {}", value, element_id);
+        
+        if (ApplyControlValue(node, value)) {
+            DispatchEvent(element_id, EventType::INPUT);
+            DispatchEvent(element_id, EventType::CHANGE);
+        }
+        
+        return true;
+    }
+    
+    bool DragElement(const std::string& element_id, double x, double y) override {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        NodeIndex node = document_.FindById(element_id);
+        const DOMNode* element = document_.GetNode(node);
+        if (!element) return false;
+        
+        CP_LOG_INFO("dom", "Dragged element: {} to ({}, {})", element_id, x, y);
+        
+        // The box moves with the pointer, keeping its size
+        DispatchEvent(element_id, EventType::MOUSEDOWN);
+        Rect box = element->bounding_box;
+        box.x = x;
+        box.y = y;
+        document_.SetBoundingBox(node, box);
+        DispatchEvent(element_id, EventType::MOUSEMOVE);
+        DispatchEvent(element_id, EventType::MOUSEUP);
         
         return true;
     }
     
     // Element properties
     std::string GetElementText(const std::string& element_id) override {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
         auto element = GetElement(element_id);
         return element ? element->text_content : "";
     }
     
     std::string GetElementHTML(const std::string& element_id) override {
-        auto element = GetElement(element_id);
-        return element ? element->outer_html : "";
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        std::string html;
+        NodeIndex node = document_.FindById(element_id);
+        if (node != kInvalidNodeIndex) SerializeHTML(document_, node, html);
+        return html;
     }
     
     std::string GetElementAttribute(const std::string& element_id, const std::string& attribute_name) override {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
         auto element = GetElement(element_id);
         if (!element) return "";
         
@@ -137,40 +304,151 @@ public:
     }
     
     bool SetElementAttribute(const std::string& element_id, const std::string& attribute_name, const std::string& value) override {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
         auto element = GetElement(element_id);
         if (!element) return false;
         
-        element->attributes[attribute_name] = value;
-        std::cout << "🔧 Set attribute " << attribute_name << "=\"" << value << "\" on element " << element_id << std::endl;
+        document_.SetAttribute(document_.FindById(element_id), attribute_name, value);
+        CP_LOG_INFO("dom", "Set attribute {}=\"{}\" on element {}", attribute_name, value, element_id);
         
         return true;
     }
     
+    bool RemoveElementAttribute(const std::string& element_id, const std::string& attribute_name) override {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        NodeIndex node = document_.FindById(element_id);
+        if (node == kInvalidNodeIndex) return false;
+        
+        document_.RemoveAttribute(node, attribute_name);
+        CP_LOG_INFO("dom", "Removed attribute {} from element {}", attribute_name, element_id);
+        
+        return true;
+    }
+    
+    // Handle accessors: no id lookup, and views instead of copies
+    std::string GetElementId(NodeHandle handle) override {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        const DOMNode* node = document_.GetNode(document_.Resolve(handle));
+        return node ? node->id : "";
+    }
+    
+    std::string_view GetElementTextView(NodeHandle handle) override {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        const DOMNode* node = document_.GetNode(document_.Resolve(handle));
+        return node ? std::string_view(node->text_content) : std::string_view();
+    }
+    
+    std::string_view GetElementTagName(NodeHandle handle) override {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        const DOMNode* node = document_.GetNode(document_.Resolve(handle));
+        return node ? std::string_view(node->tag_name) : std::string_view();
+    }
+    
+    std::optional<std::string_view> GetElementAttributeView(NodeHandle handle, std::string_view attribute_name) override {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        const DOMNode* node = document_.GetNode(document_.Resolve(handle));
+        if (!node) return std::nullopt;
+        
+        auto it = node->attributes.find(attribute_name);
+        if (it == node->attributes.end()) return std::nullopt;
+        return std::string_view(it->second);
+    }
+    
+    Rect GetElementBoundingBox(NodeHandle handle) override {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        const DOMNode* node = document_.GetNode(document_.Resolve(handle));
+        return node ? node->bounding_box : Rect{0, 0, 0, 0};
+    }
+    
     // Element state
     bool IsElementVisible(const std::string& element_id) override {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
         auto element = GetElement(element_id);
         return element ? element->visible : false;
     }
     
     bool IsElementEnabled(const std::string& element_id) override {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
         auto element = GetElement(element_id);
         return element ? element->enabled : false;
     }
     
     bool IsElementChecked(const std::string& element_id) override {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
         auto element = GetElement(element_id);
         return element ? element->checked : false;
     }
     
+    bool IsElementFocused(const std::string& element_id) override {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        auto element = GetElement(element_id);
+        return element ? element->focused : false;
+    }
+    
+    bool IsElementHovered(const std::string& element_id) override {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        auto element = GetElement(element_id);
+        return element ? element->hovered : false;
+    }
+    
     // Element geometry
     Rect GetElementBoundingBox(const std::string& element_id) override {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
         auto element = GetElement(element_id);
         return element ? element->bounding_box : Rect{0, 0, 0, 0};
     }
     
+    // No inline layout here: every element has exactly one box
+    std::vector<Rect> GetElementAllBoundingBoxes(const std::string& element_id) override {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        auto element = GetElement(element_id);
+        if (!element) return {};
+        return {element->bounding_box};
+    }
+    
+    bool IsElementInViewport(const std::string& element_id) override {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        auto element = GetElement(element_id);
+        return element && element->visible && !element->bounding_box.IsEmpty() &&
+               SpatialIndex::Intersects(element->bounding_box, viewport_);
+    }
+    
+    void SetViewport(const Rect& viewport) override {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        viewport_ = viewport;
+    }
+    
+    std::vector<ElementHandle> GetElementsInViewport() override {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        return GetElementsInRect(viewport_);
+    }
+    
+    std::vector<ElementHandle> GetElementsInRect(const Rect& rect) override {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        std::vector<ElementHandle> elements;
+        for (NodeIndex node : document_.FindInRect(rect)) {
+            if (document_.GetNode(node)->visible) {
+                elements.push_back(CreateElementHandle(node));
+            }
+        }
+        return elements;
+    }
+    
+    std::string GetElementAtPoint(double x, double y) override {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        // Later boxes in document order paint on top
+        auto hits = document_.FindAtPoint(x, y);
+        for (auto it = hits.rbegin(); it != hits.rend(); ++it) {
+            const DOMNode* node = document_.GetNode(*it);
+            if (node->visible) return node->id;
+        }
+        return "";
+    }
+    
     // JavaScript execution
     std::string ExecuteJavaScript(const std::string& script) override {
-        std::cout << "🔧 Executing JavaScript: " << script << std::endl;
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        CP_LOG_INFO("dom", "Executing JavaScript: {}", script);
         
         // Simple JavaScript simulation
         if (script.find("document.title") != std::string::npos) {
@@ -186,237 +464,834 @@ public:
         return "\"undefined\"";
     }
     
-    // Page navigation
+    std::string ExecuteJavaScriptInElement(const std::string& element_id, const std::string& script) override {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        if (document_.FindById(element_id) == kInvalidNodeIndex) return "\"undefined\"";
+        return ExecuteJavaScript(script);
+    }
+    
+    // Page navigation. Navigating drops any forward history.
     bool NavigateTo(const std::string& url) override {
-        current_url_ = url;
-        std::cout << "🌐 Navigated to: " << url << std::endl;
-        
-        // Simulate page load
-        LoadPageContent(url);
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        if (!history_.empty()) history_.resize(history_index_ + 1);
+        history_.push_back(url);
+        history_index_ = history_.size() - 1;
         
+        LoadURL(url);
+        return true;
+    }
+    
+    bool GoBack() override {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        if (history_.empty() || history_index_ == 0) return false;
+        LoadURL(history_[--history_index_]);
+        return true;
+    }
+    
+    bool GoForward() override {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        if (history_index_ + 1 >= history_.size()) return false;
+        LoadURL(history_[++history_index_]);
+        return true;
+    }
+    
+    bool Reload() override {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        if (history_.empty()) return false;
+        LoadURL(history_[history_index_]);
         return true;
     }
     
     std::string GetCurrentURL() override {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
         return current_url_;
     }
     
     std::string GetPageTitle() override {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
         return "Mock Page Title";
     }
     
+    // Page content
+    std::string GetPageHTML() override {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        std::string html;
+        SerializeHTML(document_, document_.GetDocumentElement(), html);
+        return html;
+    }
+    
+    std::string GetPageText() override {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        std::string text;
+        ExtractText(document_, document_.GetDocumentElement(), text);
+        return text;
+    }
+    
+    size_t WritePageHTML(std::ostream& out) override {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        return SerializeHTML(document_, document_.GetDocumentElement(), out);
+    }
+    
+    size_t WritePageText(std::ostream& out) override {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        return ExtractText(document_, document_.GetDocumentElement(), out);
+    }
+    
+    size_t WriteElementHTML(const std::string& element_id, std::ostream& out) override {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        NodeIndex node = document_.FindById(element_id);
+        return node != kInvalidNodeIndex ? SerializeHTML(document_, node, out) : 0;
+    }
+    
+    std::vector<std::string> GetPageLinks() override {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        return CollectAttribute("a", "href");
+    }
+    
+    std::vector<std::string> GetPageImages() override {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        return CollectAttribute("img", "src");
+    }
+    
     // Event handling
     void AddEventListener(const std::string& element_id, const std::string& event_type, 
                          std::function<void()> callback) override {
-        auto element = GetElement(element_id);
-        if (!element) return;
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        NodeIndex node = document_.FindById(element_id);
+        if (node == kInvalidNodeIndex) return;
         
-        element->event_listeners[event_type].push_back(callback);
-        std::cout << "👂 Added event listener for " << event_type << " on element " << element_id << std::endl;
+        // Closures live here, shared with snapshots; the dispatcher only
+        // holds a pointer to each
+        EventTypeId type = InternEventType(event_type);
+        auto closure = std::make_shared<std::function<void()>>(std::move(callback));
+        events_.AddListener(node, type, &InvokeScriptListener, closure.get());
+        MutableScriptListeners()[{node, type}].push_back(std::move(closure));
+        CP_LOG_INFO("dom", "Added event listener for {} on element {}", event_type, element_id);
     }
     
     void RemoveEventListener(const std::string& element_id, const std::string& event_type) override {
-        auto element = GetElement(element_id);
-        if (!element) return;
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        NodeIndex node = document_.FindById(element_id);
+        if (node == kInvalidNodeIndex) return;
+        
+        EventTypeId type = InternEventType(event_type);
+        events_.RemoveListeners(node, type);
+        if (script_listeners_->count({node, type}) > 0) MutableScriptListeners().erase({node, type});
+        CP_LOG_INFO("dom", "Removed event listener for {} on element {}", event_type, element_id);
+    }
+    
+    void TriggerEvent(const std::string& element_id, const std::string& event_type) override {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        events_.Dispatch(document_, document_.FindById(element_id), InternEventType(event_type));
+    }
+    
+    uint32_t AddEventListener(NodeHandle element, const std::string& event_type, DOMEventCallback callback,
+                              void* context, bool capture) override {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        return events_.AddListener(document_.Resolve(element), InternEventType(event_type), callback, context, capture);
+    }
+    
+    bool RemoveEventListener(NodeHandle element, uint32_t listener_id) override {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        return events_.RemoveListener(document_.Resolve(element), listener_id);
+    }
+    
+    // Wait conditions: predicates are re-checked only when a relevant signal fires
+    bool WaitForElement(const std::string& selector, ElementSearchType type, int timeout_ms) override {
+        return conditions_.WaitFor(DOMSignal::STRUCTURE | DOMSignal::ATTRIBUTE | DOMSignal::TEXT | DOMSignal::LIFECYCLE,
+                                   ConditionRegistry::kAnyNode,
+                                   [&] {
+                                       std::lock_guard<std::recursive_mutex> lock(mutex_);
+                                       return !FindNodes(selector, type).empty();
+                                   },
+                                   std::chrono::milliseconds(timeout_ms));
+    }
+    
+    bool WaitForElementVisible(const std::string& element_id, int timeout_ms) override {
+        return WaitForElementState(element_id, timeout_ms, [](const DOMNode* node) { return node && node->visible; });
+    }
+    
+    bool WaitForElementHidden(const std::string& element_id, int timeout_ms) override {
+        return WaitForElementState(element_id, timeout_ms, [](const DOMNode* node) { return !node || !node->visible; });
+    }
+    
+    bool WaitForElementEnabled(const std::string& element_id, int timeout_ms) override {
+        return WaitForElementState(element_id, timeout_ms, [](const DOMNode* node) { return node && node->enabled; });
+    }
+    
+    bool WaitForNavigation(int timeout_ms) override {
+        const uint64_t start = navigation_count_;
+        return conditions_.WaitFor(static_cast<DOMSignalMask>(DOMSignal::LIFECYCLE), ConditionRegistry::kAnyNode,
+                                   [&] { return navigation_count_ != start && load_state_ >= LoadState::LOAD; },
+                                   std::chrono::milliseconds(timeout_ms));
+    }
+    
+    bool WaitForLoadState(const std::string& state, int timeout_ms) override {
+        LoadState target;
+        if (state == "domcontentloaded") {
+            target = LoadState::DOM_CONTENT_LOADED;
+        } else if (state == "load") {
+            target = LoadState::LOAD;
+        } else if (state == "networkidle") {
+            target = LoadState::NETWORK_IDLE;
+        } else {
+            CP_LOG_WARN("dom", "Unknown load state: {}", state);
+            return false;
+        }
+        
+        return conditions_.WaitFor(static_cast<DOMSignalMask>(DOMSignal::LIFECYCLE), ConditionRegistry::kAnyNode,
+                                   [&] { return load_state_ >= target; },
+                                   std::chrono::milliseconds(timeout_ms));
+    }
+    
+    // Form handling. FillForm resolves every field before changing anything,
+    // applies all values in one pass (each journaled as a VALUE mutation),
+    // then fires input/change once per field whose value actually changed.
+    bool FillForm(const std::map<std::string, std::string>& form_data) override {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        std::vector<std::pair<NodeIndex, const std::string*>> fields;
+        std::map<std::string_view, std::pair<const std::string*, bool>> by_name;  // Value, matched
+        for (const auto& [key, value] : form_data) {
+            NodeIndex node = document_.FindById(key);
+            if (node != kInvalidNodeIndex) {
+                fields.emplace_back(node, &value);
+            } else {
+                by_name.emplace(key, std::make_pair(&value, false));
+            }
+        }
+        
+        // Keys that are not element ids name controls; one traversal resolves them all
+        if (!by_name.empty()) {
+            size_t matched_names = 0;
+            for (NodeIndex node = document_.GetDocumentElement(); node != kInvalidNodeIndex;
+                 node = document_.NextInDocumentOrder(node)) {
+                const DOMNode& control = *document_.GetNode(node);
+                if (!IsFormControl(control)) continue;
+                auto name = control.attributes.find("name");
+                if (name == control.attributes.end()) continue;
+                auto it = by_name.find(name->second);
+                if (it == by_name.end()) continue;
+                
+                auto& [value, matched] = it->second;
+                fields.emplace_back(node, value);
+                if (!matched) {
+                    matched = true;
+                    ++matched_names;
+                }
+            }
+            if (matched_names < by_name.size()) return false;
+        }
+        
+        std::vector<NodeIndex> changed;
+        for (const auto& [node, value] : fields) {
+            if (ApplyControlValue(node, *value)) changed.push_back(node);
+        }
+        
+        // Commit: events run after every value is in place, in document order
+        changed = SortDocumentOrder(std::move(changed));
+        for (NodeIndex node : changed) {
+            events_.Dispatch(document_, node, ToEventTypeId(EventType::INPUT));
+            events_.Dispatch(document_, node, ToEventTypeId(EventType::CHANGE));
+        }
+        
+        CP_LOG_INFO("dom", "Filled form: {} fields, {} changed", fields.size(), changed.size());
+        return true;
+    }
+    
+    bool SubmitForm(const std::string& form_id) override {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        NodeIndex form = document_.FindById(form_id);
+        if (form == kInvalidNodeIndex) return false;
+        
+        CP_LOG_INFO("dom", "Submitted form: {}", form_id);
+        return events_.Dispatch(document_, form, ToEventTypeId(EventType::SUBMIT));
+    }
+    
+    // Successful controls of the form's subtree, keyed by name (else id)
+    std::map<std::string, std::string> GetFormData(const std::string& form_id) override {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        std::map<std::string, std::string> data;
+        NodeIndex form = document_.FindById(form_id);
+        if (form == kInvalidNodeIndex) return data;
+        
+        for (NodeIndex node = form; node != kInvalidNodeIndex; node = document_.NextInDocumentOrder(node, form)) {
+            const DOMNode& control = *document_.GetNode(node);
+            if (!IsFormControl(control) || !control.enabled) continue;
+            
+            auto name = control.attributes.find("name");
+            const std::string& key = name != control.attributes.end() ? name->second : control.id;
+            if (key.empty()) continue;
+            
+            if (IsCheckable(control)) {
+                if (control.checked) data[key] = CheckableValue(control);
+            } else {
+                data[key] = control.value;
+            }
+        }
+        return data;
+    }
+    
+    // DOM state snapshots
+    uint64_t Snapshot() override {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        AgentSnapshot snapshot;
+        snapshot.document = document_.Snapshot();
+        snapshot.events = events_.SnapshotListeners();
+        snapshot.script_listeners = script_listeners_;
+        snapshot.focused_node = focused_node_;
+        snapshot.current_url = current_url_;
+        snapshot.load_state = load_state_;
+        
+        uint64_t snapshot_id = next_snapshot_id_++;
+        snapshots_.emplace(snapshot_id, std::move(snapshot));
+        CP_LOG_INFO("dom", "Took DOM snapshot {}", snapshot_id);
+        return snapshot_id;
+    }
+    
+    bool Restore(uint64_t snapshot_id) override {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        auto it = snapshots_.find(snapshot_id);
+        if (it == snapshots_.end()) return false;
         
-        element->event_listeners.erase(event_type);
-        std::cout << "👂 Removed event listener for " << event_type << " on element " << element_id << std::endl;
+        // Listeners are keyed by node index, which the restored tree may
+        // reuse for other nodes: they go back to their snapshot state too
+        document_.Restore(it->second.document);
+        events_.RestoreListeners(it->second.events);
+        script_listeners_ = it->second.script_listeners;
+        focused_node_ = it->second.focused_node;
+        current_url_ = it->second.current_url;
+        SetLoadState(it->second.load_state);
+        CP_LOG_INFO("dom", "Restored DOM snapshot {}", snapshot_id);
+        return true;
+    }
+    
+    void ReleaseSnapshot(uint64_t snapshot_id) override {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        snapshots_.erase(snapshot_id);
+    }
+    
+    // Mutation journal
+    uint64_t GetMutationSequence() override {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        return document_.GetJournal().GetSequence();
+    }
+    
+    bool GetMutationsSince(uint64_t sequence, std::vector<DOMMutation>& mutations) override {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        std::vector<MutationRecord> records;
+        bool complete = document_.GetJournal().Since(sequence, records);
+        
+        mutations.reserve(mutations.size() + records.size());
+        for (const auto& record : records) {
+            DOMMutation mutation;
+            mutation.sequence = record.sequence;
+            mutation.type = record.type;
+            mutation.element_id = NodeId(record.node);
+            mutation.parent_id = NodeId(record.parent);
+            mutation.attribute_name = record.attribute_name;
+            mutations.push_back(std::move(mutation));
+        }
+        return complete;
+    }
+    
+    bool GetDirtySubtreesSince(uint64_t sequence, std::vector<std::string>& element_ids) override {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        std::vector<NodeIndex> roots;
+        bool complete = document_.DirtySubtreesSince(sequence, roots);
+        for (NodeIndex node : roots) {
+            element_ids.push_back(NodeId(node));
+        }
+        return complete;
+    }
+    
+    // Screenshot
+    std::vector<uint8_t> CaptureElementScreenshot(const std::string& element_id) override {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        if (document_.FindById(element_id) == kInvalidNodeIndex) return {};
+        CP_LOG_INFO("dom", "Captured screenshot of element: {}", element_id);
+        return {0x89, 0x50, 0x4E, 0x47}; // Mock PNG header
+    }
+    
+    std::vector<uint8_t> CapturePageScreenshot() override {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        CP_LOG_INFO("dom", "Captured page screenshot");
+        return {0x89, 0x50, 0x4E, 0x47}; // Mock PNG header
+    }
+    
+    // Cookie management. Cookies are keyed by name only.
+    bool SetCookie(const std::string& name, const std::string& value, const std::string& domain,
+                   const std::string& path) override {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        if (name.empty()) return false;
+        cookies_[name] = value;
+        CP_LOG_INFO("dom", "Set cookie {} for {}{}", name, domain.empty() ? current_url_ : domain, path);
+        return true;
+    }
+    
+    std::string GetCookie(const std::string& name) override {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        auto it = cookies_.find(name);
+        return it != cookies_.end() ? it->second : "";
+    }
+    
+    bool DeleteCookie(const std::string& name) override {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        return cookies_.erase(name) > 0;
+    }
+    
+    void ClearCookies() override {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        cookies_.clear();
+    }
+    
+    // Local storage
+    bool SetLocalStorage(const std::string& key, const std::string& value) override {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        local_storage_[key] = value;
+        return true;
+    }
+    
+    std::string GetLocalStorage(const std::string& key) override {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        auto it = local_storage_.find(key);
+        return it != local_storage_.end() ? it->second : "";
+    }
+    
+    bool RemoveLocalStorage(const std::string& key) override {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        return local_storage_.erase(key) > 0;
+    }
+    
+    void ClearLocalStorage() override {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        local_storage_.clear();
+    }
+    
+    // Session storage
+    bool SetSessionStorage(const std::string& key, const std::string& value) override {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        session_storage_[key] = value;
+        return true;
+    }
+    
+    std::string GetSessionStorage(const std::string& key) override {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        auto it = session_storage_.find(key);
+        return it != session_storage_.end() ? it->second : "";
+    }
+    
+    bool RemoveSessionStorage(const std::string& key) override {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        return session_storage_.erase(key) > 0;
+    }
+    
+    void ClearSessionStorage() override {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        session_storage_.clear();
     }
 
 private:
-    struct MockElement {
-        std::string id;
-        std::string tag_name;
-        std::string text_content;
-        std::string inner_html;
-        std::string outer_html;
-        std::string value;
-        std::map<std::string, std::string> attributes;
-        Rect bounding_box;
-        bool visible = true;
-        bool enabled = true;
-        bool checked = false;
-        bool focused = false;
-        bool hovered = false;
-        bool clicked = false;
-        uint64_t last_click_time = 0;
-        std::map<std::string, std::vector<std::function<void()>>> event_listeners;
+    enum class LoadState { NONE, DOM_CONTENT_LOADED, LOAD, NETWORK_IDLE };
+    
+    using ScriptListeners =
+        std::map<std::pair<NodeIndex, EventTypeId>, std::vector<std::shared_ptr<std::function<void()>>>>;
+    
+    struct AgentSnapshot {
+        DOMSnapshot document;
+        EventDispatcher::ListenerSnapshot events;
+        std::shared_ptr<ScriptListeners> script_listeners;
+        NodeIndex focused_node = kInvalidNodeIndex;
+        std::string current_url;
+        LoadState load_state = LoadState::NONE;
     };
     
-    std::map<std::string, std::unique_ptr<MockElement>> elements_;
+    std::recursive_mutex mutex_;  // Guards everything below except conditions_ and the atomics
+    DOMTree document_;
+    ConditionRegistry conditions_;
+    EventDispatcher events_;
+    std::shared_ptr<ScriptListeners> script_listeners_ = std::make_shared<ScriptListeners>();  // Shared with snapshots
+    std::atomic<LoadState> load_state_{LoadState::NONE};
+    std::atomic<uint64_t> navigation_count_{0};
+    xpath::XPathCache xpath_cache_;
+    TextIndex text_index_;  // Built on the first text query
+    Rect viewport_{0, 0, 1280, 720};
     std::string current_url_;
-    MockElement* focused_element_ = nullptr;
-    int next_element_id_ = 1;
+    NodeIndex focused_node_ = kInvalidNodeIndex;
+    std::map<uint64_t, AgentSnapshot> snapshots_;
+    uint64_t next_snapshot_id_ = 1;
+    std::vector<std::string> history_;
+    size_t history_index_ = 0;
+    std::map<std::string, std::string> cookies_;
+    std::map<std::string, std::string> local_storage_;
+    std::map<std::string, std::string> session_storage_;
     
     void InitializeMockDOM() {
         // Create mock elements
-        CreateElement("html", "html", "Mock HTML Content");
-        CreateElement("head", "head", "");
-        CreateElement("body", "body", "Mock Body Content");
-        CreateElement("h1", "h1", "Welcome to Mock Page");
-        CreateElement("p", "p", "This is a mock paragraph with some text.");
-        CreateElement("button", "button", "Click Me");
-        CreateElement("input", "input", "");
-        CreateElement("img", "img", "");
+        CreateElement("html", "html", "Mock HTML Content", "");
+        CreateElement("head", "head", "", "html");
+        CreateElement("body", "body", "Mock Body Content", "html");
+        CreateElement("h1", "h1", "Welcome to Mock Page", "body");
+        CreateElement("p", "p", "This is a mock paragraph with some text.", "body");
+        CreateElement("button", "button", "Click Me", "body");
+        CreateElement("input", "input", "", "body");
+        CreateElement("img", "img", "", "body");
         
         // Set up element properties
-        auto button = GetElement("button");
-        if (button) {
-            button->attributes["id"] = "submit-btn";
-            button->attributes["class"] = "btn btn-primary";
-            button->bounding_box = {100, 200, 120, 40};
-        }
+        NodeIndex button = document_.FindById("button");
+        document_.SetAttribute(button, "id", "submit-btn");
+        document_.SetAttribute(button, "class", "btn btn-primary");
+        document_.SetBoundingBox(button, {100, 200, 120, 40});
         
-        auto input = GetElement("input");
-        if (input) {
-            input->attributes["id"] = "search-input";
-            input->attributes["type"] = "text";
-            input->attributes["placeholder"] = "Enter search term";
-            input->bounding_box = {50, 150, 200, 30};
-        }
+        NodeIndex input = document_.FindById("input");
+        document_.SetAttribute(input, "id", "search-input");
+        document_.SetAttribute(input, "type", "text");
+        document_.SetAttribute(input, "placeholder", "Enter search term");
+        document_.SetBoundingBox(input, {50, 150, 200, 30});
+        
+        NodeIndex img = document_.FindById("img");
+        document_.SetAttribute(img, "id", "logo");
+        document_.SetAttribute(img, "src", "logo.png");
+        document_.SetAttribute(img, "alt", "Company Logo");
+        document_.SetBoundingBox(img, {10, 10, 100, 50});
         
-        auto img = GetElement("img");
-        if (img) {
-            img->attributes["id"] = "logo";
-            img->attributes["src"] = "logo.png";
-            img->attributes["alt"] = "Company Logo";
-            img->bounding_box = {10, 10, 100, 50};
+        // Login form: text fields, a checkbox, a radio group and a select
+        CreateElement("login-form", "form", "", "body");
+        CreateFormControl("login-user", "input", "username", "", "");
+        CreateFormControl("login-password", "input", "password", "password", "");
+        CreateFormControl("login-remember", "input", "remember", "checkbox", "");
+        CreateFormControl("plan-free", "input", "plan", "radio", "free");
+        CreateFormControl("plan-pro", "input", "plan", "radio", "pro");
+        CreateFormControl("login-country", "select", "country", "", "");
+        document_.SetChecked(document_.FindById("plan-free"), true);
+    }
+    
+    void CreateFormControl(const std::string& id, const std::string& tag_name, const std::string& name,
+                           const std::string& type, const std::string& value) {
+        CreateElement(id, tag_name, "", "login-form");
+        NodeIndex node = document_.FindById(id);
+        document_.SetAttribute(node, "name", name);
+        if (!type.empty()) document_.SetAttribute(node, "type", type);
+        if (!value.empty()) document_.SetAttribute(node, "value", value);
+    }
+    
+    void CreateElement(const std::string& id, const std::string& tag_name, const std::string& text_content,
+                       const std::string& parent_id) {
+        NodeIndex node = document_.CreateNode(id, tag_name, text_content);
+        document_.SetBoundingBox(node, {10, 10, 100, 30});
+        
+        if (!parent_id.empty()) {
+            document_.AppendChild(document_.FindById(parent_id), node);
         }
     }
     
-    void CreateElement(const std::string& id, const std::string& tag_name, const std::string& text_content) {
-        auto element = std::make_unique<MockElement>();
-        element->id = id;
-        element->tag_name = tag_name;
-        element->text_content = text_content;
-        element->inner_html = text_content;
-        element->outer_html = "<" + tag_name + ">" + text_content + "</" + tag_name + ">";
-        element->bounding_box = {10, 10, 100, 30};
+    void LoadURL(const std::string& url) {
+        current_url_ = url;
+        CP_LOG_INFO("dom", "Navigated to: {}", url);
         
-        elements_[id] = std::move(element);
+        ++navigation_count_;
+        SetLoadState(LoadState::DOM_CONTENT_LOADED);
+        
+        // Simulate page load
+        LoadPageContent(url);
+        
+        SetLoadState(LoadState::LOAD);
+        SetLoadState(LoadState::NETWORK_IDLE);
     }
     
-    MockElement* GetElement(const std::string& element_id) {
-        auto it = elements_.find(element_id);
-        return (it != elements_.end()) ? it->second.get() : nullptr;
+    void SetLoadState(LoadState state) {
+        load_state_ = state;
+        conditions_.Notify(DOMSignal::LIFECYCLE);
     }
     
-    std::vector<ElementHandle> FindByCSSSelector(const std::string& selector) {
-        std::vector<ElementHandle> elements;
-        
-        // Simple CSS selector simulation
-        if (selector == "button" || selector == ".btn") {
-            elements.push_back(CreateElementHandle("button"));
-        } else if (selector == "input" || selector == "input[type='text']") {
-            elements.push_back(CreateElementHandle("input"));
-        } else if (selector == "img" || selector == "img[alt]") {
-            elements.push_back(CreateElementHandle("img"));
-        } else if (selector == "h1") {
-            elements.push_back(CreateElementHandle("h1"));
-        } else if (selector == "p") {
-            elements.push_back(CreateElementHandle("p"));
+    // Copy on first write while a snapshot still shares the map
+    ScriptListeners& MutableScriptListeners() {
+        if (script_listeners_.use_count() > 1) {
+            script_listeners_ = std::make_shared<ScriptListeners>(*script_listeners_);
         }
-        
-        return elements;
+        return *script_listeners_;
     }
     
-    std::vector<ElementHandle> FindByXPath(const std::string& xpath) {
-        std::vector<ElementHandle> elements;
-        
-        // Simple XPath simulation
-        if (xpath == "//button" || xpath == "//*[@id='submit-btn']") {
-            elements.push_back(CreateElementHandle("button"));
-        } else if (xpath == "//input" || xpath == "//*[@id='search-input']") {
-            elements.push_back(CreateElementHandle("input"));
+    template <typename Predicate>
+    bool WaitForElementState(const std::string& element_id, int timeout_ms, Predicate predicate) {
+        // Scoped to the element once it exists; structural signals still wake us
+        NodeIndex node;
+        {
+            std::lock_guard<std::recursive_mutex> lock(mutex_);
+            node = document_.FindById(element_id);
         }
-        
-        return elements;
+        return conditions_.WaitFor(DOMSignal::STATE | DOMSignal::STRUCTURE, node,
+                                   [&] {
+                                       std::lock_guard<std::recursive_mutex> lock(mutex_);
+                                       return predicate(GetElement(element_id));
+                                   },
+                                   std::chrono::milliseconds(timeout_ms));
     }
     
-    std::vector<ElementHandle> FindByText(const std::string& text) {
-        std::vector<ElementHandle> elements;
+    std::string NodeId(NodeIndex node) const {
+        const DOMNode* dom_node = document_.GetNode(node);
+        return dom_node ? dom_node->id : "";
+    }
+    
+    const DOMNode* GetElement(const std::string& element_id) const {
+        return document_.GetNode(document_.FindById(element_id));
+    }
+    
+    // Writers only: un-shares the node's page if a snapshot still holds it
+    DOMNode* GetMutableElement(const std::string& element_id) {
+        return document_.GetMutableNode(document_.FindById(element_id));
+    }
+    
+    // Compound selector: tag, #id, .class and [attr] / [attr='value'] parts
+    struct SimpleSelector {
+        std::string tag;
+        std::string id;
+        std::vector<std::string> classes;
+        std::vector<std::pair<std::string, std::optional<std::string>>> attributes;
+    };
+    
+    std::vector<NodeIndex> FindNodes(const std::string& selector, ElementSearchType type) {
+        switch (type) {
+            case ElementSearchType::CSS_SELECTOR:
+                return FindByCSSSelector(selector);
+            case ElementSearchType::XPATH:
+                return FindByXPath(selector);
+            case ElementSearchType::TEXT_CONTENT:
+                return FindByText(selector);
+            case ElementSearchType::ROLE:
+                // Explicit role attribute or implicit ARIA role
+                return document_.FindByAttribute(IndexedAttribute::ROLE, selector);
+            case ElementSearchType::PLACEHOLDER:
+                return document_.FindByAttribute(IndexedAttribute::PLACEHOLDER, selector);
+            case ElementSearchType::ALT_TEXT:
+                return document_.FindByAttribute(IndexedAttribute::ALT, selector);
+            case ElementSearchType::TITLE:
+                return document_.FindByAttribute(IndexedAttribute::TITLE, selector);
+            case ElementSearchType::TEST_ID:
+                return document_.FindByAttribute(IndexedAttribute::TEST_ID, selector);
+        }
+        return {};
+    }
+    
+    std::vector<NodeIndex> FindByCSSSelector(const std::string& selector) {
+        std::vector<NodeIndex> matches;
         
-        // Find elements containing text
-        for (const auto& pair : elements_) {
-            if (pair.second->text_content.find(text) != std::string::npos) {
-                elements.push_back(CreateElementHandle(pair.first));
+        // Selector groups ("a, button") are unioned in document order
+        std::stringstream groups(selector);
+        std::string group;
+        while (std::getline(groups, group, ',')) {
+            SimpleSelector parsed;
+            if (!ParseSimpleSelector(group, parsed)) {
+                CP_LOG_WARN("dom", "Unsupported CSS selector: {}", group);
+                continue;
+            }
+            for (NodeIndex node : SelectCandidates(parsed)) {
+                if (MatchesSelector(*document_.GetNode(node), parsed)) {
+                    matches.push_back(node);
+                }
             }
         }
         
-        return elements;
+        return SortDocumentOrder(std::move(matches));
+    }
+    
+    // Sorts into document order and drops duplicates from unioned groups
+    std::vector<NodeIndex> SortDocumentOrder(std::vector<NodeIndex> nodes) {
+        std::sort(nodes.begin(), nodes.end(), [this](NodeIndex a, NodeIndex b) {
+            return document_.DocumentOrder(a) < document_.DocumentOrder(b);
+        });
+        nodes.erase(std::unique(nodes.begin(), nodes.end()), nodes.end());
+        return nodes;
     }
     
-    std::vector<ElementHandle> FindByRole(const std::string& role) {
+    std::vector<ElementHandle> ToElementHandles(const std::vector<NodeIndex>& nodes) {
         std::vector<ElementHandle> elements;
-        
-        // Role-based finding
-        if (role == "button") {
-            elements.push_back(CreateElementHandle("button"));
-        } else if (role == "textbox") {
-            elements.push_back(CreateElementHandle("input"));
-        } else if (role == "img") {
-            elements.push_back(CreateElementHandle("img"));
+        elements.reserve(nodes.size());
+        for (NodeIndex node : nodes) {
+            elements.push_back(CreateElementHandle(node));
         }
-        
         return elements;
     }
     
-    std::vector<ElementHandle> FindByPlaceholder(const std::string& placeholder) {
-        std::vector<ElementHandle> elements;
+    static bool ParseSimpleSelector(const std::string& text, SimpleSelector& selector) {
+        auto is_name_char = [](char c) {
+            return std::isalnum(static_cast<unsigned char>(c)) || c == '-' || c == '_';
+        };
+        
+        size_t begin = text.find_first_not_of(" \t\n");
+        size_t end = text.find_last_not_of(" \t\n");
+        if (begin == std::string::npos) return false;
+        
+        size_t pos = begin;
+        auto read_name = [&]() {
+            size_t start = pos;
+            while (pos <= end && is_name_char(text[pos])) ++pos;
+            return text.substr(start, pos - start);
+        };
         
-        auto input = GetElement("input");
-        if (input && input->attributes["placeholder"] == placeholder) {
-            elements.push_back(CreateElementHandle("input"));
+        if (text[pos] == '*') {
+            ++pos;
+        } else if (is_name_char(text[pos])) {
+            selector.tag = read_name();
         }
         
-        return elements;
+        while (pos <= end) {
+            char c = text[pos++];
+            if (c == '#') {
+                selector.id = read_name();
+                if (selector.id.empty()) return false;
+            } else if (c == '.') {
+                std::string class_name = read_name();
+                if (class_name.empty()) return false;
+                selector.classes.push_back(class_name);
+            } else if (c == '[') {
+                size_t close = text.find(']', pos);
+                if (close == std::string::npos || close > end) return false;
+                std::string body = text.substr(pos, close - pos);
+                pos = close + 1;
+                
+                size_t equals = body.find('=');
+                if (equals == std::string::npos) {
+                    selector.attributes.emplace_back(body, std::nullopt);
+                    continue;
+                }
+                std::string value = body.substr(equals + 1);
+                if (value.size() >= 2 && (value.front() == '\'' || value.front() == '"') && value.back() == value.front()) {
+                    value = value.substr(1, value.size() - 2);
+                }
+                selector.attributes.emplace_back(body.substr(0, equals), value);
+            } else {
+                // Combinators and pseudo-classes are not supported
+                return false;
+            }
+        }
+        return true;
     }
     
-    std::vector<ElementHandle> FindByAltText(const std::string& alt_text) {
-        std::vector<ElementHandle> elements;
+    // "//tag", "//*" and either followed by [@attr] / [@attr='value']
+    // predicates; false for any other expression
+    static bool ParseSimpleXPath(const std::string& xpath, SimpleSelector& selector) {
+        auto is_name_char = [](char c) {
+            return std::isalnum(static_cast<unsigned char>(c)) || c == '-' || c == '_';
+        };
+        if (xpath.compare(0, 2, "//") != 0) return false;
+        
+        size_t pos = 2;
+        auto read_name = [&]() {
+            size_t start = pos;
+            while (pos < xpath.size() && is_name_char(xpath[pos])) ++pos;
+            return xpath.substr(start, pos - start);
+        };
         
-        auto img = GetElement("img");
-        if (img && img->attributes["alt"] == alt_text) {
-            elements.push_back(CreateElementHandle("img"));
+        if (pos < xpath.size() && xpath[pos] == '*') {
+            ++pos;
+        } else {
+            selector.tag = read_name();
+            if (selector.tag.empty()) return false;
         }
         
-        return elements;
+        while (pos < xpath.size()) {
+            if (xpath.compare(pos, 2, "[@") != 0) return false;
+            pos += 2;
+            std::string name = read_name();
+            if (name.empty() || pos >= xpath.size()) return false;
+            
+            if (xpath[pos] == ']') {
+                selector.attributes.emplace_back(name, std::nullopt);
+                ++pos;
+                continue;
+            }
+            if (xpath[pos] != '=' || pos + 1 >= xpath.size()) return false;
+            const char quote = xpath[pos + 1];
+            if (quote != '\'' && quote != '"') return false;
+            size_t close = xpath.find(quote, pos + 2);
+            if (close == std::string::npos || close + 1 >= xpath.size() || xpath[close + 1] != ']') return false;
+            selector.attributes.emplace_back(name, xpath.substr(pos + 2, close - pos - 2));
+            pos = close + 2;
+        }
+        return true;
     }
     
-    std::vector<ElementHandle> FindByTitle(const std::string& title) {
-        std::vector<ElementHandle> elements;
-        
-        // Find elements with title attribute
-        for (const auto& pair : elements_) {
-            auto it = pair.second->attributes.find("title");
-            if (it != pair.second->attributes.end() && it->second == title) {
-                elements.push_back(CreateElementHandle(pair.first));
-            }
+    static bool HasIndexedKey(const SimpleSelector& selector) {
+        return !selector.id.empty() || !selector.classes.empty() || !selector.tag.empty();
+    }
+    
+    // Candidate nodes from the most selective index available
+    std::vector<NodeIndex> SelectCandidates(const SimpleSelector& selector) {
+        if (!selector.id.empty()) {
+            return document_.FindByAttribute(IndexedAttribute::ID, selector.id);
+        }
+        if (!selector.classes.empty()) {
+            return document_.FindByAttribute(IndexedAttribute::CLASS, selector.classes.front());
+        }
+        if (!selector.tag.empty()) {
+            return document_.FindByAttribute(IndexedAttribute::TAG, selector.tag);
         }
         
-        return elements;
+        std::vector<NodeIndex> nodes;
+        document_.ForEachNode([&](NodeIndex node, const DOMNode&) { nodes.push_back(node); });
+        return nodes;
     }
     
-    std::vector<ElementHandle> FindByTestId(const std::string& test_id) {
-        std::vector<ElementHandle> elements;
+    static bool MatchesSelector(const DOMNode& node, const SimpleSelector& selector) {
+        if (!selector.tag.empty() && !EqualsIgnoreCase(node.tag_name, selector.tag)) {
+            return false;
+        }
+        
+        auto attribute = [&node](const std::string& name) -> const std::string* {
+            auto it = node.attributes.find(name);
+            return (it != node.attributes.end()) ? &it->second : nullptr;
+        };
+        
+        if (!selector.id.empty()) {
+            const std::string* id = attribute("id");
+            if (!id || *id != selector.id) return false;
+        }
         
-        // Find elements with data-testid attribute
-        for (const auto& pair : elements_) {
-            auto it = pair.second->attributes.find("data-testid");
-            if (it != pair.second->attributes.end() && it->second == test_id) {
-                elements.push_back(CreateElementHandle(pair.first));
+        if (!selector.classes.empty()) {
+            const std::string* classes = attribute("class");
+            if (!classes) return false;
+            std::stringstream tokens(*classes);
+            std::vector<std::string> present{std::istream_iterator<std::string>(tokens), std::istream_iterator<std::string>()};
+            for (const auto& class_name : selector.classes) {
+                if (std::find(present.begin(), present.end(), class_name) == present.end()) return false;
             }
         }
         
-        return elements;
+        for (const auto& [name, value] : selector.attributes) {
+            const std::string* actual = attribute(name);
+            if (!actual || (value && *actual != *value)) return false;
+        }
+        return true;
+    }
+    
+    std::vector<NodeIndex> FindByXPath(const std::string& xpath) {
+        // Compiled once per expression, then reused from the cache
+        auto compiled = xpath_cache_.Get(xpath);
+        if (!compiled) {
+            CP_LOG_WARN("dom", "Invalid XPath: {}", xpath);
+            return {};
+        }
+        return compiled->Evaluate(document_);
+    }
+    
+    std::vector<NodeIndex> FindByText(const std::string& text, const TextMatchOptions& options = {}) {
+        // Trigram-narrowed candidates, verified against normalized text
+        return text_index_.Find(document_, text, options);
     }
     
     ElementHandle CreateElementHandle(const std::string& element_id) {
+        return CreateElementHandle(document_.FindById(element_id));
+    }
+    
+    ElementHandle CreateElementHandle(NodeIndex node) {
+        const DOMNode* dom_node = document_.GetNode(node);
+        
         ElementHandle handle;
-        handle.element_id = element_id;
-        handle.tag_name = GetElement(element_id)->tag_name;
-        handle.text_content = GetElement(element_id)->text_content;
-        handle.bounding_box = GetElement(element_id)->bounding_box;
+        handle.handle = document_.GetHandle(node);
+        handle.element_id = dom_node->id;
+        handle.tag_name = dom_node->tag_name;
+        handle.text_content = dom_node->text_content;
+        handle.bounding_box = dom_node->bounding_box;
         return handle;
     }
     
@@ -431,16 +1306,81 @@ private:
         }
     }
     
-    void TriggerEvent(const std::string& element_id, const std::string& event_type) {
-        auto element = GetElement(element_id);
-        if (!element) return;
+    void DispatchEvent(const std::string& element_id, EventType type) {
+        events_.Dispatch(document_, document_.FindById(element_id), ToEventTypeId(type));
+    }
+    
+    // Values of `attribute` on attached `tag` elements, in document order
+    std::vector<std::string> CollectAttribute(const std::string& tag, std::string_view attribute) {
+        std::vector<std::string> values;
+        for (NodeIndex node : document_.FindByAttribute(IndexedAttribute::TAG, tag)) {
+            const DOMNode* element = document_.GetNode(node);
+            auto it = element->attributes.find(attribute);
+            if (it != element->attributes.end() && !it->second.empty()) values.push_back(it->second);
+        }
+        return values;
+    }
+    
+    bool SetCheckedState(const std::string& element_id, bool checked) {
+        NodeIndex node = document_.FindById(element_id);
+        const DOMNode* element = document_.GetNode(node);
+        if (!element || !IsCheckable(*element)) return false;
+        if (element->checked == checked) return true;
         
-        auto it = element->event_listeners.find(event_type);
-        if (it != element->event_listeners.end()) {
-            for (const auto& callback : it->second) {
-                callback();
-            }
+        CP_LOG_INFO("dom", "{} element: {}", checked ? "Checked" : "Unchecked", element_id);
+        
+        document_.SetChecked(node, checked);
+        DispatchEvent(element_id, EventType::INPUT);
+        DispatchEvent(element_id, EventType::CHANGE);
+        
+        return true;
+    }
+    
+    static void InvokeScriptListener(DOMEvent&, void* context) {
+        (*static_cast<std::function<void()>*>(context))();
+    }
+    
+    static bool IsFormControl(const DOMNode& node) {
+        return EqualsIgnoreCase(node.tag_name, "input") || EqualsIgnoreCase(node.tag_name, "textarea") ||
+               EqualsIgnoreCase(node.tag_name, "select");
+    }
+    
+    static std::string InputType(const DOMNode& node) {
+        auto type = node.attributes.find("type");
+        return type != node.attributes.end() ? type->second : "";
+    }
+    
+    static bool IsCheckable(const DOMNode& node) {
+        if (!EqualsIgnoreCase(node.tag_name, "input")) return false;
+        std::string type = InputType(node);
+        return EqualsIgnoreCase(type, "checkbox") || EqualsIgnoreCase(type, "radio");
+    }
+    
+    static std::string CheckableValue(const DOMNode& node) {
+        auto value = node.attributes.find("value");
+        return value != node.attributes.end() ? value->second : "on";
+    }
+    
+    // Radios are checked when the value names them; checkboxes take a flag.
+    // Returns whether the control changed.
+    bool ApplyControlValue(NodeIndex node, const std::string& value) {
+        const DOMNode& control = *document_.GetNode(node);
+        if (IsCheckable(control)) {
+            bool checked = EqualsIgnoreCase(InputType(control), "radio")
+                ? value == CheckableValue(control)
+                : !(value.empty() || value == "false" || value == "off" || value == "0");
+            if (control.checked == checked) return false;
+            return document_.SetChecked(node, checked);
         }
+        
+        if (control.value == value) return false;
+        return document_.SetValue(node, value);
+    }
+    
+    static bool EqualsIgnoreCase(const std::string& a, const std::string& b) {
+        return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) {
+            return std::tolower(static_cast<unsigned char>(x)) == std::tolower(static_cast<unsigned char>(y));
+        });
     }
     
     uint64_t GetCurrentTime() {
@@ -1,7 +1,8 @@
 #include "chromium_playwright/dom/blink_dom_agent.h"
-#include <iostream>
+#include "chromium_playwright/logging/logger.h"
 #include <map>
 #include <memory>
+#include <ostream>
 
 namespace chromium_playwright::dom {
 
@@ -33,49 +34,73 @@ public:
         return elements;
     }
     
+    std::vector<NodeHandle> FindElementHandles(const std::string& selector, ElementSearchType type) override {
+        // Mock implementation: one handle per mock element
+        size_t count = FindElements(selector, type).size();
+        std::vector<NodeHandle> handles;
+        for (size_t i = 0; i < count; ++i) {
+            handles.push_back(NodeHandle::Make(1, static_cast<uint32_t>(i)));
+        }
+        return handles;
+    }
+    
+    std::vector<ElementHandle> FindElementsByText(const std::string& text, const TextMatchOptions& /*options*/) override {
+        return FindElements(text, ElementSearchType::TEXT_CONTENT);
+    }
+    
+    std::vector<std::vector<ElementHandle>> FindElementsBatch(
+        const std::vector<std::pair<std::string, ElementSearchType>>& queries) override {
+        std::vector<std::vector<ElementHandle>> results;
+        results.reserve(queries.size());
+        for (const auto& [selector, type] : queries) {
+            results.push_back(FindElements(selector, type));
+        }
+        return results;
+    }
+    
     // Element actions
     bool ClickElement(const std::string& element_id) override {
-        std::cout << "   🖱️  Clicked element: " << element_id << std::endl;
+        CP_LOG_INFO("dom", "Clicked element: {}", element_id);
         return true;
     }
     
     bool TypeText(const std::string& element_id, const std::string& text) override {
-        std::cout << "   ⌨️  Typed text into element: " << element_id << " -> \"" << text << "\"" << std::endl;
+        CP_LOG_INFO("dom", "Typed text into element: {} -> \"{}\"", element_id, text);
         return true;
     }
     
     bool HoverElement(const std::string& element_id) override {
-        std::cout << "   🖱️  Hovered over element: " << element_id << std::endl;
+        CP_LOG_INFO("dom", "Hovered over element: {}", element_id);
         return true;
     }
     
     bool FocusElement(const std::string& element_id) override {
-        std::cout << "   🎯  Focused element: " << element_id << std::endl;
+        CP_LOG_INFO("dom", "Focused element: {}", element_id);
         return true;
     }
     
     bool BlurElement(const std::string& element_id) override {
-        std::cout << "   🎯  Blurred element: " << element_id << std::endl;
+        CP_LOG_INFO("dom", "Blurred element: {}", element_id);
         return true;
     }
     
     bool CheckElement(const std::string& element_id) override {
-        std::cout << "   ☑️  Checked element: " << element_id << std::endl;
+        CP_LOG_INFO("dom", "Checked element: {}", element_id);
         return true;
     }
     
     bool UncheckElement(const std::string& element_id) override {
-        std::cout << "   ☐  Unchecked element: " << element_id << std::endl;
+        CP_LOG_INFO("dom", "Unchecked element: {}", element_id);
         return true;
     }
     
     bool SelectOption(const std::string& element_id, const std::string& value) override {
-        std::cout << "   📋  Selected option in element: " << element_id << " -> " << value << std::endl;
+        CP_LOG_INFO("dom", "Selected option in element: {} -> {}", element_id, value);
         return true;
     }
     
     bool DragElement(const std::string& element_id, double x, double y) override {
-        std::cout << "   🖱️  Dragged element: " << element_id << " to (" << x << ", " << y << ")" << std::endl;
+        CP_LOG_INFO("dom", "Dragged element: {} to ({}, {})", element_id, x, y);
         return true;
     }
     
@@ -93,12 +118,12 @@ public:
     }
     
     bool SetElementAttribute(const std::string& element_id, const std::string& attribute_name, const std::string& value) override {
-        std::cout << "   🔧 Set attribute " << attribute_name << "=\"" << value << "\" on element " << element_id << std::endl;
+        CP_LOG_INFO("dom", "Set attribute {}=\"{}\" on element {}", attribute_name, value, element_id);
         return true;
     }
     
     bool RemoveElementAttribute(const std::string& element_id, const std::string& attribute_name) override {
-        std::cout << "   🔧 Removed attribute " << attribute_name << " from element " << element_id << std::endl;
+        CP_LOG_INFO("dom", "Removed attribute {} from element {}", attribute_name, element_id);
         return true;
     }
     
@@ -123,6 +148,27 @@ public:
         return false; // Mock implementation
     }
     
+    // Handle accessors
+    std::string GetElementId(NodeHandle handle) override {
+        return handle.IsNull() ? "" : "element" + std::to_string(handle.Index());
+    }
+    
+    std::string_view GetElementTextView(NodeHandle /*handle*/) override {
+        return "Mock text content";
+    }
+    
+    std::string_view GetElementTagName(NodeHandle /*handle*/) override {
+        return "div";
+    }
+    
+    std::optional<std::string_view> GetElementAttributeView(NodeHandle /*handle*/, std::string_view /*attribute_name*/) override {
+        return std::nullopt;
+    }
+    
+    Rect GetElementBoundingBox(NodeHandle /*handle*/) override {
+        return {10, 10, 100, 30}; // Mock implementation
+    }
+    
     // Element geometry
     Rect GetElementBoundingBox(const std::string& element_id) override {
         return {10, 10, 100, 30}; // Mock implementation
@@ -136,9 +182,25 @@ public:
         return true; // Mock implementation
     }
     
+    void SetViewport(const Rect& viewport) override {
+        CP_LOG_INFO("dom", "Set viewport: {}x{}", viewport.width, viewport.height);
+    }
+    
+    std::vector<ElementHandle> GetElementsInViewport() override {
+        return {CreateElementHandle("h1"), CreateElementHandle("button1")}; // Mock implementation
+    }
+    
+    std::vector<ElementHandle> GetElementsInRect(const Rect& /*rect*/) override {
+        return GetElementsInViewport(); // Mock implementation
+    }
+    
+    std::string GetElementAtPoint(double /*x*/, double /*y*/) override {
+        return "button1"; // Mock implementation
+    }
+    
     // JavaScript execution
     std::string ExecuteJavaScript(const std::string& script) override {
-        std::cout << "   🔧 Executing JavaScript: " << script << std::endl;
+        CP_LOG_INFO("dom", "Executing JavaScript: {}", script);
         
         // Simple JavaScript simulation
         if (script.find("document.title") != std::string::npos) {
@@ -161,22 +223,22 @@ public:
     // Page navigation
     bool NavigateTo(const std::string& url) override {
         current_url_ = url;
-        std::cout << "   🌐 Navigated to: " << url << std::endl;
+        CP_LOG_INFO("dom", "Navigated to: {}", url);
         return true;
     }
     
     bool GoBack() override {
-        std::cout << "   ⬅️  Went back" << std::endl;
+        CP_LOG_INFO("dom", "Went back");
         return true;
     }
     
     bool GoForward() override {
-        std::cout << "   ➡️  Went forward" << std::endl;
+        CP_LOG_INFO("dom", "Went forward");
         return true;
     }
     
     bool Reload() override {
-        std::cout << "   🔄  Reloaded page" << std::endl;
+        CP_LOG_INFO("dom", "Reloaded page");
         return true;
     }
     
@@ -197,6 +259,24 @@ public:
         return "Mock page text content";
     }
     
+    size_t WritePageHTML(std::ostream& out) override {
+        std::string html = GetPageHTML();
+        out.write(html.data(), static_cast<std::streamsize>(html.size()));
+        return html.size();
+    }
+    
+    size_t WritePageText(std::ostream& out) override {
+        std::string text = GetPageText();
+        out.write(text.data(), static_cast<std::streamsize>(text.size()));
+        return text.size();
+    }
+    
+    size_t WriteElementHTML(const std::string& element_id, std::ostream& out) override {
+        std::string html = GetElementHTML(element_id);
+        out.write(html.data(), static_cast<std::streamsize>(html.size()));
+        return html.size();
+    }
+    
     std::vector<std::string> GetPageLinks() override {
         return {"https://example.com", "https://test.com"};
     }
@@ -208,15 +288,25 @@ public:
     // Event handling
     void AddEventListener(const std::string& element_id, const std::string& event_type, 
                          std::function<void()> callback) override {
-        std::cout << "   👂 Added event listener for " << event_type << " on element " << element_id << std::endl;
+        CP_LOG_INFO("dom", "Added event listener for {} on element {}", event_type, element_id);
     }
     
     void RemoveEventListener(const std::string& element_id, const std::string& event_type) override {
-        std::cout << "   👂 Removed event listener for " << event_type << " on element " << element_id << std::endl;
+        CP_LOG_INFO("dom", "Removed event listener for {} on element {}", event_type, element_id);
     }
     
     void TriggerEvent(const std::string& element_id, const std::string& event_type) override {
-        std::cout << "   🎯 Triggered event " << event_type << " on element " << element_id << std::endl;
+        CP_LOG_INFO("dom", "Triggered event {} on element {}", event_type, element_id);
+    }
+    
+    uint32_t AddEventListener(NodeHandle /*element*/, const std::string& event_type, DOMEventCallback /*callback*/,
+                              void* /*context*/, bool /*capture*/) override {
+        CP_LOG_INFO("dom", "Added event listener for {}", event_type);
+        return 1; // Mock implementation
+    }
+    
+    bool RemoveEventListener(NodeHandle /*element*/, uint32_t /*listener_id*/) override {
+        return true;
     }
     
     // Wait conditions (mock implementations)
@@ -244,25 +334,52 @@ public:
         return true;
     }
     
+    // Mutation journal
+    uint64_t GetMutationSequence() override {
+        return 0; // Mock implementation: the mock DOM never changes
+    }
+    
+    bool GetMutationsSince(uint64_t /*sequence*/, std::vector<DOMMutation>& /*mutations*/) override {
+        return true;
+    }
+    
+    bool GetDirtySubtreesSince(uint64_t /*sequence*/, std::vector<std::string>& /*element_ids*/) override {
+        return true;
+    }
+    
+    // DOM state snapshots
+    uint64_t Snapshot() override {
+        CP_LOG_INFO("dom", "Took DOM snapshot");
+        return 1; // Mock implementation
+    }
+    
+    bool Restore(uint64_t snapshot_id) override {
+        CP_LOG_INFO("dom", "Restored DOM snapshot {}", snapshot_id);
+        return true;
+    }
+    
+    void ReleaseSnapshot(uint64_t /*snapshot_id*/) override {
+    }
+    
     // Screenshot
     std::vector<uint8_t> CaptureElementScreenshot(const std::string& element_id) override {
-        std::cout << "   📸 Captured element screenshot: " << element_id << std::endl;
+        CP_LOG_INFO("dom", "Captured element screenshot: {}", element_id);
         return {0x89, 0x50, 0x4E, 0x47}; // Mock PNG header
     }
     
     std::vector<uint8_t> CapturePageScreenshot() override {
-        std::cout << "   📸 Captured page screenshot" << std::endl;
+        CP_LOG_INFO("dom", "Captured page screenshot");
         return {0x89, 0x50, 0x4E, 0x47}; // Mock PNG header
     }
     
     // Form handling
     bool FillForm(const std::map<std::string, std::string>& form_data) override {
-        std::cout << "   📝 Filled form with " << form_data.size() << " fields" << std::endl;
+        CP_LOG_INFO("dom", "Filled form with {} fields", form_data.size());
         return true;
     }
     
     bool SubmitForm(const std::string& form_id) override {
-        std::cout << "   📤 Submitted form: " << form_id << std::endl;
+        CP_LOG_INFO("dom", "Submitted form: {}", form_id);
         return true;
     }
     
@@ -273,7 +390,7 @@ public:
     // Cookie management
     bool SetCookie(const std::string& name, const std::string& value, 
                   const std::string& domain, const std::string& path) override {
-        std::cout << "   🍪 Set cookie: " << name << "=" << value << std::endl;
+        CP_LOG_INFO("dom", "Set cookie: {}={}", name, value);
         return true;
     }
     
@@ -282,17 +399,17 @@ public:
     }
     
     bool DeleteCookie(const std::string& name) override {
-        std::cout << "   🍪 Deleted cookie: " << name << std::endl;
+        CP_LOG_INFO("dom", "Deleted cookie: {}", name);
         return true;
     }
     
     void ClearCookies() override {
-        std::cout << "   🍪 Cleared all cookies" << std::endl;
+        CP_LOG_INFO("dom", "Cleared all cookies");
     }
     
     // Local storage
     bool SetLocalStorage(const std::string& key, const std::string& value) override {
-        std::cout << "   💾 Set localStorage: " << key << "=" << value << std::endl;
+        CP_LOG_INFO("dom", "Set localStorage: {}={}", key, value);
         return true;
     }
     
@@ -301,17 +418,17 @@ public:
     }
     
     bool RemoveLocalStorage(const std::string& key) override {
-        std::cout << "   💾 Removed localStorage: " << key << std::endl;
+        CP_LOG_INFO("dom", "Removed localStorage: {}", key);
         return true;
     }
     
     void ClearLocalStorage() override {
-        std::cout << "   💾 Cleared localStorage" << std::endl;
+        CP_LOG_INFO("dom", "Cleared localStorage");
     }
     
     // Session storage
     bool SetSessionStorage(const std::string& key, const std::string& value) override {
-        std::cout << "   💾 Set sessionStorage: " << key << "=" << value << std::endl;
+        CP_LOG_INFO("dom", "Set sessionStorage: {}={}", key, value);
         return true;
     }
     
@@ -320,12 +437,12 @@ public:
     }
     
     bool RemoveSessionStorage(const std::string& key) override {
-        std::cout << "   💾 Removed sessionStorage: " << key << std::endl;
+        CP_LOG_INFO("dom", "Removed sessionStorage: {}", key);
         return true;
     }
     
     void ClearSessionStorage() override {
-        std::cout << "   💾 Cleared sessionStorage" << std::endl;
+        CP_LOG_INFO("dom", "Cleared sessionStorage");
     }
 
 private:
@@ -333,7 +450,7 @@ private:
     
     void InitializeMockDOM() {
         // Mock DOM initialization
-        std::cout << "   🏗️  Initialized mock DOM" << std::endl;
+        CP_LOG_INFO("dom", "Initialized mock DOM");
     }
     
     ElementHandle CreateElementHandle(const std::string& element_id) {
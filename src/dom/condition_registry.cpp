@@ -0,0 +1,61 @@
+#include "chromium_playwright/dom/condition_registry.h"
+#include <algorithm>
+
+namespace chromium_playwright::dom {
+
+bool ConditionRegistry::WaitFor(DOMSignalMask signals, NodeIndex node, const std::function<bool()>& predicate,
+                                std::chrono::milliseconds timeout) {
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+
+    Waiter waiter;
+    waiter.signals = signals;
+    waiter.node = node;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        waiters_.push_back(&waiter);
+    }
+
+    bool satisfied = predicate();
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!satisfied) {
+        if (!waiter.cv.wait_until(lock, deadline, [&waiter] { return waiter.signaled; })) {
+            break;
+        }
+        waiter.signaled = false;
+        ++wakeups_;
+
+        lock.unlock();
+        satisfied = predicate();
+        lock.lock();
+    }
+
+    waiters_.erase(std::find(waiters_.begin(), waiters_.end(), &waiter));
+    return satisfied;
+}
+
+void ConditionRegistry::Notify(DOMSignal signal, NodeIndex node) {
+    const auto bit = static_cast<DOMSignalMask>(signal);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (Waiter* waiter : waiters_) {
+        if ((waiter->signals & bit) == 0) continue;
+        if (signal != DOMSignal::STRUCTURE && waiter->node != kAnyNode && node != kAnyNode && waiter->node != node) {
+            continue;
+        }
+        waiter->signaled = true;
+        waiter->cv.notify_one();
+    }
+}
+
+size_t ConditionRegistry::GetWaiterCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return waiters_.size();
+}
+
+uint64_t ConditionRegistry::GetWakeupCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return wakeups_;
+}
+
+} // namespace chromium_playwright::dom
@@ -0,0 +1,248 @@
+#include "chromium_playwright/dom/dom_events.h"
+#include <algorithm>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace chromium_playwright::dom {
+
+namespace {
+
+constexpr std::string_view kBuiltinNames[] = {
+    "click",    "dblclick", "mousedown", "mouseup", "mousemove", "mouseover", "mouseout", "mouseenter",
+    "mouseleave", "keydown", "keyup",    "keypress", "input",     "change",    "focus",    "blur",
+    "focusin",  "focusout", "submit",    "reset",   "scroll",    "load"};
+static_assert(std::size(kBuiltinNames) == static_cast<size_t>(EventType::COUNT));
+
+// Names interned at runtime; deque keeps the strings (and their views) stable
+struct CustomEventTypes {
+    std::mutex mutex;
+    std::deque<std::string> names;
+    std::unordered_map<std::string_view, EventTypeId> ids;
+};
+
+CustomEventTypes& GetCustomEventTypes() {
+    static CustomEventTypes types;
+    return types;
+}
+
+} // namespace
+
+EventTypeId InternEventType(std::string_view name) {
+    for (size_t i = 0; i < std::size(kBuiltinNames); ++i) {
+        if (kBuiltinNames[i] == name) return static_cast<EventTypeId>(i);
+    }
+
+    auto& types = GetCustomEventTypes();
+    std::lock_guard<std::mutex> lock(types.mutex);
+    auto it = types.ids.find(name);
+    if (it != types.ids.end()) return it->second;
+
+    auto id = static_cast<EventTypeId>(ToEventTypeId(EventType::COUNT) + types.names.size());
+    types.names.emplace_back(name);
+    types.ids.emplace(types.names.back(), id);
+    return id;
+}
+
+std::string_view EventTypeName(EventTypeId type) {
+    if (type < ToEventTypeId(EventType::COUNT)) return kBuiltinNames[type];
+
+    auto& types = GetCustomEventTypes();
+    std::lock_guard<std::mutex> lock(types.mutex);
+    size_t index = type - ToEventTypeId(EventType::COUNT);
+    return index < types.names.size() ? std::string_view(types.names[index]) : std::string_view();
+}
+
+bool EventBubbles(EventTypeId type) {
+    switch (static_cast<EventType>(type)) {
+        case EventType::FOCUS:
+        case EventType::BLUR:
+        case EventType::MOUSEENTER:
+        case EventType::MOUSELEAVE:
+        case EventType::LOAD:
+        case EventType::SCROLL:
+            return false;
+        default:
+            return true;
+    }
+}
+
+void EventDispatcher::ListenerList::PushBack(const Listener& listener) {
+    if (size_ < kInlineListeners) {
+        inline_[size_] = listener;
+    } else {
+        overflow_.push_back(listener);
+    }
+    ++size_;
+}
+
+void EventDispatcher::ListenerList::Compact() {
+    size_t kept = 0;
+    for (size_t i = 0; i < size_; ++i) {
+        if ((*this)[i].callback) {
+            if (kept != i) (*this)[kept] = (*this)[i];
+            ++kept;
+        }
+    }
+    size_ = kept;
+    overflow_.resize(kept > kInlineListeners ? kept - kInlineListeners : 0);
+}
+
+EventDispatcher::ListenerId EventDispatcher::AddListener(NodeIndex node, EventTypeId type, EventCallback callback,
+                                                         void* context, bool capture) {
+    if (node == kInvalidNodeIndex || !callback) return 0;
+
+    ListenerTable& table = MutableListeners();
+    if (node >= table.lists.size()) table.lists.resize(static_cast<size_t>(node) + 1);
+    if (type >= table.type_counts.size()) table.type_counts.resize(static_cast<size_t>(type) + 1, 0);
+
+    Listener listener;
+    listener.callback = callback;
+    listener.context = context;
+    listener.id = next_id_++;
+    listener.type = type;
+    listener.capture = capture;
+    table.lists[node].PushBack(listener);
+    ++table.type_counts[type];
+    return listener.id;
+}
+
+// Copy on first change to a table still shared with a snapshot. Dispatch
+// re-reads listeners_ on every step, so swapping it mid-dispatch is safe.
+EventDispatcher::ListenerTable& EventDispatcher::MutableListeners() {
+    if (listeners_.use_count() > 1) listeners_ = std::make_shared<ListenerTable>(*listeners_);
+    return *listeners_;
+}
+
+void EventDispatcher::MarkRemoved(ListenerTable& table, NodeIndex node, Listener& listener) {
+    --table.type_counts[listener.type];
+    listener.callback = nullptr;
+    // Lists are compacted only outside dispatch so iteration indices hold
+    if (dispatch_depth_ == 0) {
+        table.lists[node].Compact();
+    } else {
+        pending_compaction_.push_back(node);
+    }
+}
+
+bool EventDispatcher::RemoveListener(NodeIndex node, ListenerId id) {
+    if (node >= listeners_->lists.size()) return false;
+
+    const ListenerList& list = listeners_->lists[node];
+    for (size_t i = 0; i < list.Size(); ++i) {
+        if (list[i].callback && list[i].id == id) {
+            ListenerTable& table = MutableListeners();
+            MarkRemoved(table, node, table.lists[node][i]);
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t EventDispatcher::RemoveListeners(NodeIndex node, EventTypeId type) {
+    if (node >= listeners_->lists.size()) return 0;
+
+    size_t removed = 0;
+    ListenerTable* table = nullptr;
+    for (size_t i = 0; i < listeners_->lists[node].Size(); ++i) {
+        const Listener& listener = listeners_->lists[node][i];
+        if (!listener.callback || listener.type != type) continue;
+        if (!table) table = &MutableListeners();
+        --table->type_counts[type];
+        table->lists[node][i].callback = nullptr;
+        ++removed;
+    }
+    if (removed > 0) {
+        if (dispatch_depth_ == 0) {
+            table->lists[node].Compact();
+        } else {
+            pending_compaction_.push_back(node);
+        }
+    }
+    return removed;
+}
+
+void EventDispatcher::Clear() {
+    listeners_ = std::make_shared<ListenerTable>();
+    pending_compaction_.clear();
+}
+
+EventDispatcher::ListenerSnapshot EventDispatcher::SnapshotListeners() const {
+    ListenerSnapshot snapshot;
+    snapshot.table_ = listeners_;
+    return snapshot;
+}
+
+void EventDispatcher::RestoreListeners(const ListenerSnapshot& snapshot) {
+    // Entries removed during a dispatch still running when the snapshot
+    // was taken stay behind as inert slots until their list is compacted
+    listeners_ = snapshot.table_ ? snapshot.table_ : std::make_shared<ListenerTable>();
+    pending_compaction_.clear();
+}
+
+size_t EventDispatcher::GetListenerCount(EventTypeId type) const {
+    return type < listeners_->type_counts.size() ? listeners_->type_counts[type] : 0;
+}
+
+void EventDispatcher::Invoke(NodeIndex node, DOMEvent& event, bool capture_phase, bool bubble_phase) {
+    // Listeners added during dispatch do not run for this event. Callbacks
+    // may add listeners or swap the table, so re-index on every iteration.
+    const size_t count = listeners_->lists[node].Size();
+    for (size_t i = 0; i < count && !event.immediate_propagation_stopped; ++i) {
+        // A listener may have cleared the dispatcher
+        if (node >= listeners_->lists.size() || i >= listeners_->lists[node].Size()) break;
+        const Listener listener = listeners_->lists[node][i];
+        if (!listener.callback || listener.type != event.type) continue;
+        if ((listener.capture && !capture_phase) || (!listener.capture && !bubble_phase)) continue;
+        listener.callback(event, listener.context);
+    }
+}
+
+bool EventDispatcher::Dispatch(const DOMTree& tree, NodeIndex target, EventTypeId type) {
+    if (GetListenerCount(type) == 0 || !tree.GetNode(target)) return true;
+
+    // Reuse one path buffer per nesting level: listeners may dispatch too
+    if (paths_.size() <= dispatch_depth_) paths_.resize(dispatch_depth_ + 1);
+    std::vector<NodeIndex>& path = paths_[dispatch_depth_];
+    path.clear();
+    for (NodeIndex node = tree.GetNode(target)->parent; node != kInvalidNodeIndex; node = tree.GetNode(node)->parent) {
+        path.push_back(node);
+    }
+
+    ++dispatch_depth_;
+
+    DOMEvent event;
+    event.type = type;
+    event.target = target;
+    event.bubbles = EventBubbles(type);
+
+    auto visit = [&](NodeIndex node, EventPhase phase) {
+        if (node >= listeners_->lists.size() || listeners_->lists[node].Size() == 0) return;
+        event.current_target = node;
+        event.phase = phase;
+        Invoke(node, event, phase != EventPhase::BUBBLING, phase != EventPhase::CAPTURING);
+    };
+
+    // Path is target's ancestors, nearest first: capture walks it backwards
+    for (size_t i = path.size(); i-- > 0 && !event.propagation_stopped;) {
+        visit(path[i], EventPhase::CAPTURING);
+    }
+    if (!event.propagation_stopped) {
+        visit(target, EventPhase::AT_TARGET);
+    }
+    for (size_t i = 0; event.bubbles && i < path.size() && !event.propagation_stopped; ++i) {
+        visit(path[i], EventPhase::BUBBLING);
+    }
+
+    if (--dispatch_depth_ == 0 && !pending_compaction_.empty()) {
+        ListenerTable& table = MutableListeners();
+        for (NodeIndex node : pending_compaction_) {
+            if (node < table.lists.size()) table.lists[node].Compact();
+        }
+        pending_compaction_.clear();
+    }
+    return !event.default_prevented;
+}
+
+} // namespace chromium_playwright::dom
@@ -0,0 +1,337 @@
+#include "chromium_playwright/dom/dom_tree.h"
+#include <algorithm>
+#include <unordered_set>
+
+namespace chromium_playwright::dom {
+
+NodeIndex DOMTree::CreateNode(const std::string& id, const std::string& tag_name, const std::string& text_content) {
+    NodeIndex index = static_cast<NodeIndex>(size_);
+
+    DOMNode node;
+    node.id = id;
+    node.tag_name = tag_name;
+    node.text_content = text_content;
+    if (index % kNodePageSize == 0) {
+        pages_.push_back(std::make_shared<NodePage>());
+        pages_.back()->reserve(kNodePageSize);
+    }
+    MutablePage(index).push_back(std::move(node));
+    ++size_;
+    MutableIndex(attribute_index_).AddNode(index, Node(index));
+
+    if (!id.empty()) {
+        MutableIndex(id_index_)[id] = index;
+    }
+    if (document_element_ == kInvalidNodeIndex) {
+        document_element_ = index;
+    }
+
+    InvalidateDocumentOrder();
+    NotifyMutation(DOMSignal::STRUCTURE, index);
+    return index;
+}
+
+bool DOMTree::AppendChild(NodeIndex parent, NodeIndex child) {
+    if (parent >= size_ || child >= size_ || parent == child) {
+        return false;
+    }
+
+    // Refuse to create cycles
+    for (NodeIndex ancestor = parent; ancestor != kInvalidNodeIndex; ancestor = Node(ancestor).parent) {
+        if (ancestor == child) return false;
+    }
+
+    Detach(child);
+
+    DOMNode& parent_node = MutableNode(parent);
+    DOMNode& child_node = MutableNode(child);
+    child_node.parent = parent;
+    child_node.prev_sibling = parent_node.last_child;
+    child_node.next_sibling = kInvalidNodeIndex;
+
+    if (parent_node.last_child != kInvalidNodeIndex) {
+        MutableNode(parent_node.last_child).next_sibling = child;
+    } else {
+        parent_node.first_child = child;
+    }
+    parent_node.last_child = child;
+
+    journal_.Append(DOMMutationType::INSERT, child, parent);
+    InvalidateDocumentOrder();
+    NotifyMutation(DOMSignal::STRUCTURE, child);
+    return true;
+}
+
+bool DOMTree::Detach(NodeIndex node) {
+    if (node >= size_) return false;
+    if (Node(node).parent == kInvalidNodeIndex) return true;
+
+    DOMNode& target = MutableNode(node);
+    DOMNode& parent_node = MutableNode(target.parent);
+    if (target.prev_sibling != kInvalidNodeIndex) {
+        MutableNode(target.prev_sibling).next_sibling = target.next_sibling;
+    } else {
+        parent_node.first_child = target.next_sibling;
+    }
+    if (target.next_sibling != kInvalidNodeIndex) {
+        MutableNode(target.next_sibling).prev_sibling = target.prev_sibling;
+    } else {
+        parent_node.last_child = target.prev_sibling;
+    }
+
+    journal_.Append(DOMMutationType::REMOVE, node, target.parent);
+    target.parent = kInvalidNodeIndex;
+    target.prev_sibling = kInvalidNodeIndex;
+    target.next_sibling = kInvalidNodeIndex;
+
+    InvalidateDocumentOrder();
+    NotifyMutation(DOMSignal::STRUCTURE, node);
+    return true;
+}
+
+void DOMTree::Clear() {
+    pages_.clear();
+    size_ = 0;
+    NextGeneration();
+    id_index_ = std::make_shared<IdIndex>();
+    attribute_index_ = std::make_shared<AttributeIndex>();
+    spatial_index_ = std::make_shared<SpatialIndex>();
+    document_element_ = kInvalidNodeIndex;
+    document_order_.clear();
+    journal_.Append(DOMMutationType::CLEAR, kInvalidNodeIndex);
+    InvalidateDocumentOrder();
+    NotifyMutation(DOMSignal::STRUCTURE, kInvalidNodeIndex);
+}
+
+bool DOMTree::SetAttribute(NodeIndex node, const std::string& name, const std::string& value) {
+    if (node >= size_) return false;
+
+    const bool indexed = AttributeIndex::AffectsIndex(name);
+    if (indexed) MutableIndex(attribute_index_).RemoveNode(node, Node(node));
+    MutableNode(node).attributes[name] = value;
+    if (indexed) MutableIndex(attribute_index_).AddNode(node, Node(node));
+    journal_.Append(DOMMutationType::ATTRIBUTE, node, kInvalidNodeIndex, name);
+    NotifyMutation(DOMSignal::ATTRIBUTE, node);
+    return true;
+}
+
+bool DOMTree::RemoveAttribute(NodeIndex node, const std::string& name) {
+    if (node >= size_) return false;
+    if (Node(node).attributes.count(name) == 0) return false;
+
+    const bool indexed = AttributeIndex::AffectsIndex(name);
+    if (indexed) MutableIndex(attribute_index_).RemoveNode(node, Node(node));
+    MutableNode(node).attributes.erase(name);
+    if (indexed) MutableIndex(attribute_index_).AddNode(node, Node(node));
+    journal_.Append(DOMMutationType::ATTRIBUTE, node, kInvalidNodeIndex, name);
+    NotifyMutation(DOMSignal::ATTRIBUTE, node);
+    return true;
+}
+
+bool DOMTree::SetTextContent(NodeIndex node, const std::string& text) {
+    if (node >= size_) return false;
+    MutableNode(node).text_content = text;
+    ++text_version_;
+    journal_.Append(DOMMutationType::TEXT, node);
+    NotifyMutation(DOMSignal::TEXT, node);
+    return true;
+}
+
+bool DOMTree::SetBoundingBox(NodeIndex node, const Rect& rect) {
+    if (node >= size_) return false;
+    MutableNode(node).bounding_box = rect;
+    MutableIndex(spatial_index_).Insert(node, rect);
+    NotifyMutation(DOMSignal::STATE, node);
+    return true;
+}
+
+bool DOMTree::SetValue(NodeIndex node, const std::string& value) {
+    if (node >= size_) return false;
+    if (Node(node).value == value) return true;
+    MutableNode(node).value = value;
+    journal_.Append(DOMMutationType::VALUE, node);
+    NotifyMutation(DOMSignal::STATE, node);
+    return true;
+}
+
+bool DOMTree::SetChecked(NodeIndex node, bool checked) {
+    if (node >= size_) return false;
+    if (Node(node).checked == checked) return true;
+    MutableNode(node).checked = checked;
+    journal_.Append(DOMMutationType::VALUE, node);
+    NotifyMutation(DOMSignal::STATE, node);
+    return true;
+}
+
+DOMNode* DOMTree::GetMutableNode(NodeIndex index) {
+    return index < size_ ? &MutableNode(index) : nullptr;
+}
+
+const DOMNode* DOMTree::GetNode(NodeIndex index) const {
+    return index < size_ ? &Node(index) : nullptr;
+}
+
+NodeIndex DOMTree::Resolve(NodeHandle handle) const {
+    if (handle.Generation() != generation_ || handle.Index() >= size_) {
+        return kInvalidNodeIndex;
+    }
+    return handle.Index();
+}
+
+DOMSnapshot DOMTree::Snapshot() const {
+    DOMSnapshot snapshot;
+    snapshot.pages_ = pages_;
+    snapshot.size_ = size_;
+    snapshot.id_index_ = id_index_;
+    snapshot.document_element_ = document_element_;
+    snapshot.attribute_index_ = attribute_index_;
+    snapshot.spatial_index_ = spatial_index_;
+    return snapshot;
+}
+
+void DOMTree::Restore(const DOMSnapshot& snapshot) {
+    pages_ = snapshot.pages_;
+    size_ = snapshot.size_;
+    id_index_ = snapshot.id_index_;
+    document_element_ = snapshot.document_element_;
+    attribute_index_ = snapshot.attribute_index_;
+    spatial_index_ = snapshot.spatial_index_;
+    NextGeneration();
+
+    // The journal keeps running: readers see the restore as a full change
+    journal_.Append(DOMMutationType::CLEAR, kInvalidNodeIndex);
+    InvalidateDocumentOrder();
+    NotifyMutation(DOMSignal::STRUCTURE, kInvalidNodeIndex);
+}
+
+DOMTree::NodePage& DOMTree::MutablePage(NodeIndex index) {
+    auto& page = pages_[index / kNodePageSize];
+    // Copy on first write to a page still shared with a snapshot
+    if (page.use_count() > 1) {
+        page = std::make_shared<NodePage>(*page);
+        page->reserve(kNodePageSize);
+    }
+    return *page;
+}
+
+NodeIndex DOMTree::FindById(const std::string& id) const {
+    auto it = id_index_->find(id);
+    return (it != id_index_->end()) ? it->second : kInvalidNodeIndex;
+}
+
+std::vector<NodeIndex> DOMTree::FindByAttribute(IndexedAttribute attribute, const std::string& value) const {
+    return AttachedInDocumentOrder(attribute_index_->Lookup(attribute, value));
+}
+
+std::vector<NodeIndex> DOMTree::FindInRect(const Rect& rect) const {
+    return AttachedInDocumentOrder(spatial_index_->QueryRect(rect));
+}
+
+std::vector<NodeIndex> DOMTree::FindAtPoint(double x, double y) const {
+    return AttachedInDocumentOrder(spatial_index_->QueryPoint(x, y));
+}
+
+std::vector<NodeIndex> DOMTree::AttachedInDocumentOrder(const std::vector<NodeIndex>& candidates) const {
+    std::vector<NodeIndex> nodes;
+    nodes.reserve(candidates.size());
+    for (NodeIndex node : candidates) {
+        // Detached nodes have no document order
+        if (DocumentOrder(node) != std::numeric_limits<uint32_t>::max()) {
+            nodes.push_back(node);
+        }
+    }
+    if (nodes.size() > 1) {
+        std::sort(nodes.begin(), nodes.end(),
+                  [this](NodeIndex a, NodeIndex b) { return DocumentOrder(a) < DocumentOrder(b); });
+    }
+    return nodes;
+}
+
+bool DOMTree::DirtySubtreesSince(uint64_t sequence, std::vector<NodeIndex>& roots) const {
+    roots.clear();
+
+    std::vector<MutationRecord> records;
+    bool complete = journal_.Since(sequence, records);
+    for (const auto& record : records) {
+        if (record.type == DOMMutationType::CLEAR) {
+            complete = false;
+            break;
+        }
+    }
+    if (!complete) {
+        if (document_element_ != kInvalidNodeIndex) roots.push_back(document_element_);
+        return false;
+    }
+
+    // Structural changes dirty the parent; content changes the node itself
+    std::unordered_set<NodeIndex> dirty;
+    for (const auto& record : records) {
+        NodeIndex node = (record.type == DOMMutationType::INSERT || record.type == DOMMutationType::REMOVE)
+                             ? record.parent
+                             : record.node;
+        if (IsAttached(node)) dirty.insert(node);
+    }
+
+    // Keep only the topmost dirty nodes
+    for (NodeIndex node : dirty) {
+        bool covered = false;
+        for (NodeIndex ancestor = Node(node).parent; ancestor != kInvalidNodeIndex && !covered;
+             ancestor = Node(ancestor).parent) {
+            covered = dirty.count(ancestor) != 0;
+        }
+        if (!covered) roots.push_back(node);
+    }
+    roots = AttachedInDocumentOrder(roots);
+    return true;
+}
+
+bool DOMTree::IsAttached(NodeIndex node) const {
+    if (node >= size_) return false;
+
+    while (Node(node).parent != kInvalidNodeIndex) {
+        node = Node(node).parent;
+    }
+    return node == document_element_;
+}
+
+void DOMTree::ForEachNode(const std::function<void(NodeIndex, const DOMNode&)>& visitor) const {
+    for (NodeIndex node = document_element_; node != kInvalidNodeIndex; node = NextInDocumentOrder(node)) {
+        visitor(node, Node(node));
+    }
+}
+
+NodeIndex DOMTree::NextInDocumentOrder(NodeIndex node, NodeIndex scope) const {
+    if (node >= size_) return kInvalidNodeIndex;
+
+    // Pre-order successor, never leaving the subtree rooted at scope
+    if (Node(node).first_child != kInvalidNodeIndex) {
+        return Node(node).first_child;
+    }
+    while (node != kInvalidNodeIndex && node != scope) {
+        if (Node(node).next_sibling != kInvalidNodeIndex) {
+            return Node(node).next_sibling;
+        }
+        node = Node(node).parent;
+    }
+    return kInvalidNodeIndex;
+}
+
+uint32_t DOMTree::DocumentOrder(NodeIndex node) const {
+    if (document_order_dirty_) {
+        RebuildDocumentOrder();
+    }
+    return node < document_order_.size() ? document_order_[node] : std::numeric_limits<uint32_t>::max();
+}
+
+void DOMTree::RebuildDocumentOrder() const {
+    // Detached nodes sort after everything that is attached
+    document_order_.assign(size_, std::numeric_limits<uint32_t>::max());
+
+    uint32_t rank = 0;
+    for (NodeIndex node = document_element_; node != kInvalidNodeIndex; node = NextInDocumentOrder(node)) {
+        document_order_[node] = rank++;
+    }
+    document_order_dirty_ = false;
+}
+
+} // namespace chromium_playwright::dom
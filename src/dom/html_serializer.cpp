@@ -0,0 +1,244 @@
+#include "chromium_playwright/dom/html_serializer.h"
+#include <array>
+#include <cstring>
+#include <string_view>
+
+namespace chromium_playwright::dom {
+
+namespace {
+
+bool TagEquals(std::string_view tag, std::string_view lower) {
+    if (tag.size() != lower.size()) return false;
+    for (size_t i = 0; i < tag.size(); ++i) {
+        char c = tag[i];
+        if (c >= 'A' && c <= 'Z') c = static_cast<char>(c - 'A' + 'a');
+        if (c != lower[i]) return false;
+    }
+    return true;
+}
+
+bool IsVoidElement(std::string_view tag) {
+    static constexpr std::string_view kVoidElements[] = {"area", "base", "br",   "col",   "embed",  "hr",    "img",
+                                                          "input", "link", "meta", "param", "source", "track", "wbr"};
+    for (std::string_view name : kVoidElements) {
+        if (TagEquals(tag, name)) return true;
+    }
+    return false;
+}
+
+// Elements whose text is script/style source rather than document text
+bool IsRawTextElement(std::string_view tag) {
+    return TagEquals(tag, "script") || TagEquals(tag, "style");
+}
+
+// Writers: the traversal only ever calls Put, so counting and copying
+// cannot disagree about the output size.
+struct CountingWriter {
+    size_t size = 0;
+    void Put(const char*, size_t length) { size += length; }
+};
+
+struct BufferWriter {
+    char* cursor;
+    void Put(const char* data, size_t length) {
+        if (length == 0) return;
+        std::memcpy(cursor, data, length);
+        cursor += length;
+    }
+};
+
+class StreamWriter {
+public:
+    explicit StreamWriter(std::ostream& out) : out_(out) {}
+    ~StreamWriter() { Flush(); }
+
+    void Put(const char* data, size_t length) {
+        if (length == 0) return;
+        written_ += length;
+        if (used_ + length > buffer_.size()) {
+            Flush();
+            if (length > buffer_.size()) {
+                out_.write(data, static_cast<std::streamsize>(length));
+                return;
+            }
+        }
+        std::memcpy(buffer_.data() + used_, data, length);
+        used_ += length;
+    }
+
+    void Flush() {
+        if (used_ > 0) out_.write(buffer_.data(), static_cast<std::streamsize>(used_));
+        used_ = 0;
+    }
+
+    size_t Written() const { return written_; }
+
+private:
+    std::ostream& out_;
+    std::array<char, 16 * 1024> buffer_;
+    size_t used_ = 0;
+    size_t written_ = 0;
+};
+
+template <typename Writer>
+void Put(Writer& writer, std::string_view text) {
+    writer.Put(text.data(), text.size());
+}
+
+// Copies runs of ordinary characters in one Put and only breaks them up
+// at characters that need an entity
+template <typename Writer>
+void PutEscaped(Writer& writer, std::string_view text, bool attribute) {
+    size_t run_start = 0;
+    for (size_t i = 0; i < text.size(); ++i) {
+        std::string_view entity;
+        switch (text[i]) {
+            case '&': entity = "&amp;"; break;
+            case '<': entity = "&lt;"; break;
+            case '>': entity = "&gt;"; break;
+            case '"':
+                if (attribute) entity = "&quot;";
+                break;
+            default: break;
+        }
+        if (entity.empty()) continue;
+
+        writer.Put(text.data() + run_start, i - run_start);
+        Put(writer, entity);
+        run_start = i + 1;
+    }
+    writer.Put(text.data() + run_start, text.size() - run_start);
+}
+
+template <typename Writer>
+void PutStartTag(Writer& writer, const DOMNode& node) {
+    Put(writer, "<");
+    Put(writer, node.tag_name);
+    for (const auto& [name, value] : node.attributes) {
+        Put(writer, " ");
+        Put(writer, name);
+        Put(writer, "=\"");
+        PutEscaped(writer, value, true);
+        Put(writer, "\"");
+    }
+    Put(writer, ">");
+}
+
+// Iterative pre-order walk so deep documents cannot exhaust the stack
+template <typename Writer>
+void WriteHTML(const DOMTree& tree, NodeIndex root, Writer& writer) {
+    if (!tree.GetNode(root)) return;
+
+    NodeIndex current = root;
+    while (true) {
+        const DOMNode* node = tree.GetNode(current);
+        PutStartTag(writer, *node);
+
+        if (!IsVoidElement(node->tag_name)) {
+            if (IsRawTextElement(node->tag_name)) {
+                Put(writer, node->text_content);
+            } else {
+                PutEscaped(writer, node->text_content, false);
+            }
+            if (node->first_child != kInvalidNodeIndex) {
+                current = node->first_child;
+                continue;
+            }
+        }
+
+        // Close finished elements until one has a next sibling
+        while (true) {
+            node = tree.GetNode(current);
+            if (!IsVoidElement(node->tag_name)) {
+                Put(writer, "</");
+                Put(writer, node->tag_name);
+                Put(writer, ">");
+            }
+            if (current == root) return;
+            if (node->next_sibling != kInvalidNodeIndex) {
+                current = node->next_sibling;
+                break;
+            }
+            current = node->parent;
+        }
+    }
+}
+
+template <typename Writer>
+void WriteText(const DOMTree& tree, NodeIndex root, Writer& writer) {
+    if (!tree.GetNode(root)) return;
+
+    bool need_separator = false;
+    NodeIndex current = root;
+    while (true) {
+        const DOMNode* node = tree.GetNode(current);
+        const bool skip = IsRawTextElement(node->tag_name);
+
+        if (!skip && !node->text_content.empty()) {
+            if (need_separator) Put(writer, " ");
+            Put(writer, node->text_content);
+            need_separator = true;
+        }
+        if (!skip && node->first_child != kInvalidNodeIndex) {
+            current = node->first_child;
+            continue;
+        }
+
+        while (current != root && tree.GetNode(current)->next_sibling == kInvalidNodeIndex) {
+            current = tree.GetNode(current)->parent;
+        }
+        if (current == root) return;
+        current = tree.GetNode(current)->next_sibling;
+    }
+}
+
+} // namespace
+
+size_t MeasureHTML(const DOMTree& tree, NodeIndex root) {
+    CountingWriter counter;
+    WriteHTML(tree, root, counter);
+    return counter.size;
+}
+
+size_t SerializeHTML(const DOMTree& tree, NodeIndex root, char* buffer, size_t capacity) {
+    const size_t size = MeasureHTML(tree, root);
+    if (size <= capacity && buffer) {
+        BufferWriter writer{buffer};
+        WriteHTML(tree, root, writer);
+    }
+    return size;
+}
+
+void SerializeHTML(const DOMTree& tree, NodeIndex root, std::string& out) {
+    const size_t offset = out.size();
+    out.resize(offset + MeasureHTML(tree, root));
+    BufferWriter writer{out.data() + offset};
+    WriteHTML(tree, root, writer);
+}
+
+size_t SerializeHTML(const DOMTree& tree, NodeIndex root, std::ostream& out) {
+    StreamWriter writer(out);
+    WriteHTML(tree, root, writer);
+    return writer.Written();
+}
+
+size_t MeasureText(const DOMTree& tree, NodeIndex root) {
+    CountingWriter counter;
+    WriteText(tree, root, counter);
+    return counter.size;
+}
+
+void ExtractText(const DOMTree& tree, NodeIndex root, std::string& out) {
+    const size_t offset = out.size();
+    out.resize(offset + MeasureText(tree, root));
+    BufferWriter writer{out.data() + offset};
+    WriteText(tree, root, writer);
+}
+
+size_t ExtractText(const DOMTree& tree, NodeIndex root, std::ostream& out) {
+    StreamWriter writer(out);
+    WriteText(tree, root, writer);
+    return writer.Written();
+}
+
+} // namespace chromium_playwright::dom
@@ -0,0 +1,45 @@
+#include "chromium_playwright/dom/mutation_journal.h"
+
+namespace chromium_playwright::dom {
+
+uint64_t MutationJournal::Append(DOMMutationType type, NodeIndex node, NodeIndex parent,
+                                 const std::string& attribute_name) {
+    MutationRecord record;
+    record.sequence = next_sequence_++;
+    record.type = type;
+    record.node = node;
+    record.parent = parent;
+    record.attribute_name = attribute_name;
+    records_.push_back(std::move(record));
+
+    while (records_.size() > capacity_) {
+        records_.pop_front();
+    }
+    return next_sequence_ - 1;
+}
+
+uint64_t MutationJournal::GetOldestRetainedSequence() const {
+    // With nothing retained, the next record is the oldest one a reader can see
+    return records_.empty() ? next_sequence_ : records_.front().sequence;
+}
+
+bool MutationJournal::Since(uint64_t sequence, std::vector<MutationRecord>& records) const {
+    if (sequence >= GetSequence()) return true;
+
+    // Records are contiguous, so the first newer one sits at a fixed offset
+    const uint64_t oldest = GetOldestRetainedSequence();
+    const bool complete = sequence + 1 >= oldest;
+    const size_t offset = complete ? static_cast<size_t>(sequence + 1 - oldest) : 0;
+
+    records.insert(records.end(), records_.begin() + static_cast<std::ptrdiff_t>(offset), records_.end());
+    return complete;
+}
+
+void MutationJournal::SetCapacity(size_t capacity) {
+    capacity_ = capacity;
+    while (records_.size() > capacity_) {
+        records_.pop_front();
+    }
+}
+
+} // namespace chromium_playwright::dom
@@ -0,0 +1,144 @@
+#include "chromium_playwright/dom/spatial_index.h"
+#include <algorithm>
+#include <cmath>
+
+namespace chromium_playwright::dom {
+
+SpatialIndex::SpatialIndex(double cell_size)
+    : cell_size_(cell_size > 0.0 ? cell_size : kDefaultCellSize) {}
+
+bool SpatialIndex::Intersects(const Rect& a, const Rect& b) {
+    return a.x <= b.x + b.width && b.x <= a.x + a.width &&
+           a.y <= b.y + b.height && b.y <= a.y + a.height;
+}
+
+int32_t SpatialIndex::CellCoordinate(double value) const {
+    // Clamp so pathological coordinates cannot overflow the cell key
+    double cell = std::floor(value / cell_size_);
+    cell = std::clamp(cell, -1e9, 1e9);
+    return static_cast<int32_t>(cell);
+}
+
+uint64_t SpatialIndex::CellKey(int32_t cx, int32_t cy) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(cx)) << 32) | static_cast<uint32_t>(cy);
+}
+
+void SpatialIndex::EraseFrom(std::vector<NodeIndex>& list, NodeIndex node) {
+    auto it = std::find(list.begin(), list.end(), node);
+    if (it != list.end()) {
+        *it = list.back();
+        list.pop_back();
+    }
+}
+
+void SpatialIndex::Insert(NodeIndex node, const Rect& rect) {
+    Remove(node);
+    if (rect.IsEmpty()) return;
+
+    if (node >= entries_.size()) {
+        entries_.resize(static_cast<size_t>(node) + 1);
+    }
+
+    Entry& entry = entries_[node];
+    entry.rect = rect;
+    entry.min_cx = CellCoordinate(rect.x);
+    entry.min_cy = CellCoordinate(rect.y);
+    entry.max_cx = CellCoordinate(rect.x + rect.width);
+    entry.max_cy = CellCoordinate(rect.y + rect.height);
+    entry.present = true;
+
+    const uint64_t cells = static_cast<uint64_t>(entry.max_cx - entry.min_cx + 1) *
+                           static_cast<uint64_t>(entry.max_cy - entry.min_cy + 1);
+    entry.overflow = cells > kMaxCellsPerEntry;
+
+    if (entry.overflow) {
+        overflow_.push_back(node);
+    } else {
+        for (int32_t cx = entry.min_cx; cx <= entry.max_cx; ++cx) {
+            for (int32_t cy = entry.min_cy; cy <= entry.max_cy; ++cy) {
+                cells_[CellKey(cx, cy)].push_back(node);
+            }
+        }
+    }
+    ++size_;
+}
+
+void SpatialIndex::Remove(NodeIndex node) {
+    if (node >= entries_.size() || !entries_[node].present) return;
+
+    Entry& entry = entries_[node];
+    if (entry.overflow) {
+        EraseFrom(overflow_, node);
+    } else {
+        for (int32_t cx = entry.min_cx; cx <= entry.max_cx; ++cx) {
+            for (int32_t cy = entry.min_cy; cy <= entry.max_cy; ++cy) {
+                auto it = cells_.find(CellKey(cx, cy));
+                if (it == cells_.end()) continue;
+                EraseFrom(it->second, node);
+                if (it->second.empty()) cells_.erase(it);
+            }
+        }
+    }
+    entry = Entry{};
+    --size_;
+}
+
+void SpatialIndex::Clear() {
+    entries_.clear();
+    cells_.clear();
+    overflow_.clear();
+    size_ = 0;
+}
+
+std::vector<NodeIndex> SpatialIndex::QueryRect(const Rect& rect) const {
+    std::vector<NodeIndex> nodes;
+    if (size_ == 0) return nodes;
+
+    for (NodeIndex node : overflow_) {
+        if (Intersects(entries_[node].rect, rect)) nodes.push_back(node);
+    }
+
+    const int32_t min_cx = CellCoordinate(rect.x);
+    const int32_t min_cy = CellCoordinate(rect.y);
+    const int32_t max_cx = CellCoordinate(rect.x + rect.width);
+    const int32_t max_cy = CellCoordinate(rect.y + rect.height);
+    const uint64_t query_cells = static_cast<uint64_t>(max_cx - min_cx + 1) *
+                                 static_cast<uint64_t>(max_cy - min_cy + 1);
+
+    auto visit = [&](int32_t cx, int32_t cy, const std::vector<NodeIndex>& list) {
+        for (NodeIndex node : list) {
+            const Entry& entry = entries_[node];
+            // Report each box once: from the first query cell it shares
+            if (cx != std::max(entry.min_cx, min_cx) || cy != std::max(entry.min_cy, min_cy)) continue;
+            if (Intersects(entry.rect, rect)) nodes.push_back(node);
+        }
+    };
+
+    if (query_cells > cells_.size()) {
+        // Query larger than the populated grid: walk occupied cells instead
+        for (const auto& [key, list] : cells_) {
+            const int32_t cx = static_cast<int32_t>(static_cast<uint32_t>(key >> 32));
+            const int32_t cy = static_cast<int32_t>(static_cast<uint32_t>(key));
+            if (cx < min_cx || cx > max_cx || cy < min_cy || cy > max_cy) continue;
+            visit(cx, cy, list);
+        }
+    } else {
+        for (int32_t cx = min_cx; cx <= max_cx; ++cx) {
+            for (int32_t cy = min_cy; cy <= max_cy; ++cy) {
+                auto it = cells_.find(CellKey(cx, cy));
+                if (it != cells_.end()) visit(cx, cy, it->second);
+            }
+        }
+    }
+    return nodes;
+}
+
+std::vector<NodeIndex> SpatialIndex::QueryPoint(double x, double y) const {
+    std::vector<NodeIndex> nodes;
+    for (NodeIndex node : QueryRect(Rect{x, y, 0.0, 0.0})) {
+        if (entries_[node].rect.Contains(x, y)) nodes.push_back(node);
+    }
+    return nodes;
+}
+
+} // namespace chromium_playwright::dom
@@ -0,0 +1,128 @@
+#include "chromium_playwright/dom/text_index.h"
+#include <algorithm>
+#include <cctype>
+
+namespace chromium_playwright::dom {
+
+namespace {
+
+std::string ToLower(const std::string& text) {
+    std::string result = text;
+    std::transform(result.begin(), result.end(), result.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return result;
+}
+
+} // namespace
+
+std::string TextIndex::Normalize(const std::string& text) {
+    std::string result;
+    result.reserve(text.size());
+    bool pending_space = false;
+    for (char c : text) {
+        if (std::isspace(static_cast<unsigned char>(c))) {
+            pending_space = !result.empty();
+        } else {
+            if (pending_space) result.push_back(' ');
+            pending_space = false;
+            result.push_back(c);
+        }
+    }
+    return result;
+}
+
+uint32_t TextIndex::Trigram(const std::string& text, size_t pos) {
+    return (static_cast<uint32_t>(static_cast<unsigned char>(text[pos])) << 16) |
+           (static_cast<uint32_t>(static_cast<unsigned char>(text[pos + 1])) << 8) |
+           static_cast<uint32_t>(static_cast<unsigned char>(text[pos + 2]));
+}
+
+void TextIndex::Build(const DOMTree& tree) {
+    entries_.clear();
+    postings_.clear();
+    exact_.clear();
+
+    tree.ForEachNode([&](NodeIndex node, const DOMNode& dom_node) {
+        if (dom_node.text_content.empty()) return;
+
+        Entry entry;
+        entry.node = node;
+        entry.text = Normalize(dom_node.text_content);
+        if (entry.text.empty()) return;
+        entry.lower_text = ToLower(entry.text);
+
+        const uint32_t ordinal = static_cast<uint32_t>(entries_.size());
+        exact_[entry.lower_text].push_back(ordinal);
+        for (size_t pos = 0; pos + 3 <= entry.lower_text.size(); ++pos) {
+            auto& list = postings_[Trigram(entry.lower_text, pos)];
+            // Ordinals arrive in increasing order, so a repeat is always last
+            if (list.empty() || list.back() != ordinal) list.push_back(ordinal);
+        }
+        entries_.push_back(std::move(entry));
+    });
+
+    tree_ = &tree;
+    built_version_ = tree.GetTextVersion();
+    built_ = true;
+}
+
+std::vector<uint32_t> TextIndex::Candidates(const std::string& lower_pattern) const {
+    std::vector<uint32_t> candidates;
+
+    // Patterns shorter than a trigram can only skip nodes without text
+    if (lower_pattern.size() < 3) {
+        candidates.resize(entries_.size());
+        for (uint32_t i = 0; i < candidates.size(); ++i) candidates[i] = i;
+        return candidates;
+    }
+
+    std::vector<const std::vector<uint32_t>*> lists;
+    for (size_t pos = 0; pos + 3 <= lower_pattern.size(); ++pos) {
+        auto it = postings_.find(Trigram(lower_pattern, pos));
+        if (it == postings_.end()) return candidates;
+        lists.push_back(&it->second);
+    }
+
+    // Intersect from the shortest posting list outwards
+    std::sort(lists.begin(), lists.end(), [](const auto* a, const auto* b) { return a->size() < b->size(); });
+    lists.erase(std::unique(lists.begin(), lists.end()), lists.end());
+
+    candidates = *lists.front();
+    for (size_t i = 1; i < lists.size() && !candidates.empty(); ++i) {
+        std::vector<uint32_t> kept;
+        std::set_intersection(candidates.begin(), candidates.end(), lists[i]->begin(), lists[i]->end(),
+                              std::back_inserter(kept));
+        candidates.swap(kept);
+    }
+    return candidates;
+}
+
+std::vector<NodeIndex> TextIndex::Find(const DOMTree& tree, const std::string& text, const TextMatchOptions& options) {
+    if (!built_ || tree_ != &tree || built_version_ != tree.GetTextVersion()) {
+        Build(tree);
+    }
+
+    std::vector<NodeIndex> nodes;
+    const std::string pattern = Normalize(text);
+    const std::string lower_pattern = ToLower(pattern);
+
+    if (options.exact) {
+        auto it = exact_.find(lower_pattern);
+        if (it == exact_.end()) return nodes;
+        for (uint32_t ordinal : it->second) {
+            const Entry& entry = entries_[ordinal];
+            if (options.ignore_case || entry.text == pattern) nodes.push_back(entry.node);
+        }
+        return nodes;
+    }
+
+    for (uint32_t ordinal : Candidates(lower_pattern)) {
+        const Entry& entry = entries_[ordinal];
+        const bool match = options.ignore_case ? entry.lower_text.find(lower_pattern) != std::string::npos
+                                               : entry.text.find(pattern) != std::string::npos;
+        if (match) nodes.push_back(entry.node);
+    }
+    return nodes;
+}
+
+} // namespace chromium_playwright::dom
@@ -0,0 +1,1800 @@
+#include "chromium_playwright/dom/xpath_evaluator.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace chromium_playwright::dom::xpath {
+
+namespace {
+
+// Non-owning callable reference. Path walking passes visitors down every
+// step, so they must not allocate.
+template <typename Signature>
+class FunctionRef;
+
+template <typename R, typename... Args>
+class FunctionRef<R(Args...)> {
+public:
+    template <typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, FunctionRef>>>
+    FunctionRef(F&& callable)
+        : object_(const_cast<void*>(static_cast<const void*>(std::addressof(callable)))),
+          invoke_([](void* object, Args... args) -> R {
+              return (*static_cast<std::remove_reference_t<F>*>(object))(std::forward<Args>(args)...);
+          }) {}
+
+    R operator()(Args... args) const { return invoke_(object_, std::forward<Args>(args)...); }
+
+private:
+    void* object_;
+    R (*invoke_)(void*, Args...);
+};
+
+// ---------------------------------------------------------------------------
+// Data model
+// ---------------------------------------------------------------------------
+
+// XPath node. The document node and per-element text runs have no arena
+// slot of their own, so items carry a kind next to the node index.
+enum class ItemKind : uint8_t {
+    DOCUMENT,
+    ELEMENT,
+    TEXT,
+    ATTRIBUTE
+};
+
+struct Item {
+    ItemKind kind = ItemKind::DOCUMENT;
+    NodeIndex node = kInvalidNodeIndex;
+    const std::string* attribute = nullptr; // Key inside DOMNode::attributes
+
+    bool operator==(const Item& other) const {
+        return kind == other.kind && node == other.node && attribute == other.attribute;
+    }
+};
+
+using NodeSet = std::vector<Item>;
+using Visitor = FunctionRef<bool(const Item&)>;
+
+Item DocumentItem() { return Item{}; }
+Item ElementItem(NodeIndex node) { return Item{ItemKind::ELEMENT, node, nullptr}; }
+Item TextItem(NodeIndex node) { return Item{ItemKind::TEXT, node, nullptr}; }
+Item AttributeItem(NodeIndex node, const std::string* name) { return Item{ItemKind::ATTRIBUTE, node, name}; }
+
+enum class Axis {
+    CHILD,
+    DESCENDANT,
+    DESCENDANT_OR_SELF,
+    PARENT,
+    ANCESTOR,
+    ANCESTOR_OR_SELF,
+    SELF,
+    ATTRIBUTE,
+    FOLLOWING_SIBLING,
+    PRECEDING_SIBLING,
+    FOLLOWING,
+    PRECEDING
+};
+
+enum class NodeTest {
+    NAME,       // foo
+    ANY,        // *
+    NODE,       // node()
+    TEXT,       // text()
+    NEVER       // comment(), processing-instruction()
+};
+
+enum class ValueType {
+    NODESET,
+    BOOLEAN,
+    NUMBER,
+    STRING
+};
+
+enum class ExprKind {
+    OR, AND,
+    EQ, NE, LT, LE, GT, GE,
+    ADD, SUB, MUL, DIV, MOD, NEGATE,
+    UNION, PATH, FILTER,
+    LITERAL, NUMBER, FUNCTION
+};
+
+enum class Function {
+    LAST, POSITION, COUNT, NAME, LOCAL_NAME,
+    STRING, CONCAT, STARTS_WITH, ENDS_WITH, CONTAINS,
+    SUBSTRING_BEFORE, SUBSTRING_AFTER, SUBSTRING,
+    STRING_LENGTH, NORMALIZE_SPACE, TRANSLATE,
+    BOOLEAN, NOT, TRUE_VALUE, FALSE_VALUE,
+    NUMBER, SUM, FLOOR, CEILING, ROUND
+};
+
+// How a step applies its predicates
+enum class StepMode {
+    STREAM,      // No positional predicates: filter while walking the axis
+    NTH,         // Single [n] predicate: stop the axis walk at the n-th match
+    MATERIALIZE  // position()/last() or several positional predicates
+};
+
+struct Expr;
+
+struct Step {
+    Axis axis = Axis::CHILD;
+    NodeTest test = NodeTest::NODE;
+    std::string name;
+    std::vector<std::unique_ptr<Expr>> predicates;
+    StepMode mode = StepMode::STREAM;
+    size_t nth = 0;
+};
+
+struct LocationPath {
+    bool absolute = false;
+    std::vector<Step> steps;
+    bool ordered = true; // Walk already yields unique nodes in document order
+};
+
+struct Expr {
+    ExprKind kind = ExprKind::LITERAL;
+    ValueType type = ValueType::STRING;
+    std::unique_ptr<Expr> lhs;
+    std::unique_ptr<Expr> rhs;
+    std::vector<std::unique_ptr<Expr>> args;
+    std::vector<std::unique_ptr<Expr>> predicates; // FILTER only
+    LocationPath path;                             // PATH, or steps after a FILTER
+    Function function = Function::TRUE_VALUE;
+    std::string literal;
+    double number = 0.0;
+};
+
+struct Value {
+    ValueType type = ValueType::BOOLEAN;
+    NodeSet nodes;
+    bool boolean = false;
+    double number = 0.0;
+    std::string string;
+
+    static Value FromBoolean(bool b) { Value v; v.type = ValueType::BOOLEAN; v.boolean = b; return v; }
+    static Value FromNumber(double n) { Value v; v.type = ValueType::NUMBER; v.number = n; return v; }
+    static Value FromString(std::string s) { Value v; v.type = ValueType::STRING; v.string = std::move(s); return v; }
+    static Value FromNodes(NodeSet n) { Value v; v.type = ValueType::NODESET; v.nodes = std::move(n); return v; }
+};
+
+class ParseError : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+// ---------------------------------------------------------------------------
+// String helpers
+// ---------------------------------------------------------------------------
+
+bool EqualsIgnoreCase(const std::string& a, const std::string& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (std::tolower(static_cast<unsigned char>(a[i])) != std::tolower(static_cast<unsigned char>(b[i]))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool IsXPathSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+double StringToNumber(const std::string& text) {
+    size_t begin = 0;
+    size_t end = text.size();
+    while (begin < end && IsXPathSpace(text[begin])) ++begin;
+    while (end > begin && IsXPathSpace(text[end - 1])) --end;
+
+    // XPath numbers: optional minus, digits, optional fraction. Nothing else.
+    size_t i = begin;
+    if (i < end && text[i] == '-') ++i;
+    bool digits = false;
+    while (i < end && std::isdigit(static_cast<unsigned char>(text[i]))) { ++i; digits = true; }
+    if (i < end && text[i] == '.') {
+        ++i;
+        while (i < end && std::isdigit(static_cast<unsigned char>(text[i]))) { ++i; digits = true; }
+    }
+    if (!digits || i != end) {
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+    return std::strtod(text.substr(begin, end - begin).c_str(), nullptr);
+}
+
+std::string NumberToString(double number) {
+    if (std::isnan(number)) return "NaN";
+    if (std::isinf(number)) return number > 0 ? "Infinity" : "-Infinity";
+    if (number == 0.0) return "0";
+    if (number == std::floor(number) && std::fabs(number) < 1e15) {
+        return std::to_string(static_cast<long long>(number));
+    }
+
+    std::ostringstream stream;
+    stream << std::setprecision(15) << number;
+    return stream.str();
+}
+
+std::string NormalizeSpace(const std::string& text) {
+    std::string result;
+    result.reserve(text.size());
+    bool pending_space = false;
+    for (char c : text) {
+        if (IsXPathSpace(c)) {
+            pending_space = !result.empty();
+        } else {
+            if (pending_space) result.push_back(' ');
+            pending_space = false;
+            result.push_back(c);
+        }
+    }
+    return result;
+}
+
+// ---------------------------------------------------------------------------
+// Tokenizer
+// ---------------------------------------------------------------------------
+
+enum class TokenType {
+    NAME, NUMBER, LITERAL,
+    SLASH, DOUBLE_SLASH, PIPE, PLUS, MINUS,
+    EQ, NE, LT, LE, GT, GE,
+    LPAREN, RPAREN, LBRACKET, RBRACKET,
+    DOT, DOTDOT, AT, COMMA, DOUBLE_COLON,
+    STAR,                          // Name test wildcard
+    MULTIPLY, AND, OR, DIV, MOD,   // Operators
+    END
+};
+
+struct Token {
+    TokenType type = TokenType::END;
+    std::string text;
+    double number = 0.0;
+};
+
+bool IsNameStart(char c) {
+    return std::isalpha(static_cast<unsigned char>(c)) || c == '_';
+}
+
+bool IsNameChar(char c) {
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '-' || c == '.';
+}
+
+// Operator names and '*' are only operators when the previous token could
+// end an operand (XPath 1.0, section 3.7)
+bool PrecedesOperator(const std::vector<Token>& tokens) {
+    if (tokens.empty()) return false;
+    switch (tokens.back().type) {
+        case TokenType::NAME:
+        case TokenType::NUMBER:
+        case TokenType::LITERAL:
+        case TokenType::RPAREN:
+        case TokenType::RBRACKET:
+        case TokenType::DOT:
+        case TokenType::DOTDOT:
+        case TokenType::STAR:
+            return true;
+        default:
+            return false;
+    }
+}
+
+std::vector<Token> Tokenize(const std::string& expression) {
+    std::vector<Token> tokens;
+    size_t i = 0;
+    const size_t n = expression.size();
+
+    auto push = [&tokens](TokenType type, std::string text = "") {
+        Token token;
+        token.type = type;
+        token.text = std::move(text);
+        tokens.push_back(std::move(token));
+    };
+
+    while (i < n) {
+        char c = expression[i];
+        if (IsXPathSpace(c)) { ++i; continue; }
+
+        char next = (i + 1 < n) ? expression[i + 1] : '\0';
+        switch (c) {
+            case '/':
+                if (next == '/') { push(TokenType::DOUBLE_SLASH); i += 2; } else { push(TokenType::SLASH); ++i; }
+                continue;
+            case '|': push(TokenType::PIPE); ++i; continue;
+            case '+': push(TokenType::PLUS); ++i; continue;
+            case '-': push(TokenType::MINUS); ++i; continue;
+            case '=': push(TokenType::EQ); ++i; continue;
+            case '!':
+                if (next != '=') throw ParseError("unexpected '!'");
+                push(TokenType::NE); i += 2;
+                continue;
+            case '<':
+                if (next == '=') { push(TokenType::LE); i += 2; } else { push(TokenType::LT); ++i; }
+                continue;
+            case '>':
+                if (next == '=') { push(TokenType::GE); i += 2; } else { push(TokenType::GT); ++i; }
+                continue;
+            case '(': push(TokenType::LPAREN); ++i; continue;
+            case ')': push(TokenType::RPAREN); ++i; continue;
+            case '[': push(TokenType::LBRACKET); ++i; continue;
+            case ']': push(TokenType::RBRACKET); ++i; continue;
+            case '@': push(TokenType::AT); ++i; continue;
+            case ',': push(TokenType::COMMA); ++i; continue;
+            case ':':
+                if (next != ':') throw ParseError("unexpected ':'");
+                push(TokenType::DOUBLE_COLON); i += 2;
+                continue;
+            case '*':
+                push(PrecedesOperator(tokens) ? TokenType::MULTIPLY : TokenType::STAR); ++i;
+                continue;
+            case '$':
+                throw ParseError("variable references are not supported");
+            case '"':
+            case '\'': {
+                size_t end = expression.find(c, i + 1);
+                if (end == std::string::npos) throw ParseError("unterminated string literal");
+                push(TokenType::LITERAL, expression.substr(i + 1, end - i - 1));
+                i = end + 1;
+                continue;
+            }
+            default:
+                break;
+        }
+
+        if (c == '.' && !std::isdigit(static_cast<unsigned char>(next))) {
+            if (next == '.') { push(TokenType::DOTDOT); i += 2; } else { push(TokenType::DOT); ++i; }
+            continue;
+        }
+
+        if (std::isdigit(static_cast<unsigned char>(c)) || c == '.') {
+            size_t start = i;
+            while (i < n && std::isdigit(static_cast<unsigned char>(expression[i]))) ++i;
+            if (i < n && expression[i] == '.') {
+                ++i;
+                while (i < n && std::isdigit(static_cast<unsigned char>(expression[i]))) ++i;
+            }
+            Token token;
+            token.type = TokenType::NUMBER;
+            token.text = expression.substr(start, i - start);
+            token.number = std::strtod(token.text.c_str(), nullptr);
+            tokens.push_back(std::move(token));
+            continue;
+        }
+
+        if (IsNameStart(c)) {
+            size_t start = i;
+            while (i < n && IsNameChar(expression[i])) ++i;
+            // QName prefix (svg:rect), but not an axis separator
+            if (i + 1 < n && expression[i] == ':' && expression[i + 1] != ':' &&
+                (IsNameStart(expression[i + 1]) || expression[i + 1] == '*')) {
+                ++i;
+                if (expression[i] == '*') {
+                    ++i;
+                } else {
+                    while (i < n && IsNameChar(expression[i])) ++i;
+                }
+            }
+            std::string name = expression.substr(start, i - start);
+
+            if (PrecedesOperator(tokens)) {
+                if (name == "and") { push(TokenType::AND); continue; }
+                if (name == "or") { push(TokenType::OR); continue; }
+                if (name == "div") { push(TokenType::DIV); continue; }
+                if (name == "mod") { push(TokenType::MOD); continue; }
+            }
+            push(TokenType::NAME, std::move(name));
+            continue;
+        }
+
+        throw ParseError(std::string("unexpected character '") + c + "'");
+    }
+
+    push(TokenType::END);
+    return tokens;
+}
+
+// ---------------------------------------------------------------------------
+// Parser
+// ---------------------------------------------------------------------------
+
+struct FunctionInfo {
+    const char* name;
+    Function function;
+    ValueType result;
+    size_t min_args;
+    size_t max_args;
+};
+
+constexpr size_t kVariadic = std::numeric_limits<size_t>::max();
+
+const FunctionInfo kFunctions[] = {
+    {"last", Function::LAST, ValueType::NUMBER, 0, 0},
+    {"position", Function::POSITION, ValueType::NUMBER, 0, 0},
+    {"count", Function::COUNT, ValueType::NUMBER, 1, 1},
+    {"name", Function::NAME, ValueType::STRING, 0, 1},
+    {"local-name", Function::LOCAL_NAME, ValueType::STRING, 0, 1},
+    {"string", Function::STRING, ValueType::STRING, 0, 1},
+    {"concat", Function::CONCAT, ValueType::STRING, 2, kVariadic},
+    {"starts-with", Function::STARTS_WITH, ValueType::BOOLEAN, 2, 2},
+    {"ends-with", Function::ENDS_WITH, ValueType::BOOLEAN, 2, 2},
+    {"contains", Function::CONTAINS, ValueType::BOOLEAN, 2, 2},
+    {"substring-before", Function::SUBSTRING_BEFORE, ValueType::STRING, 2, 2},
+    {"substring-after", Function::SUBSTRING_AFTER, ValueType::STRING, 2, 2},
+    {"substring", Function::SUBSTRING, ValueType::STRING, 2, 3},
+    {"string-length", Function::STRING_LENGTH, ValueType::NUMBER, 0, 1},
+    {"normalize-space", Function::NORMALIZE_SPACE, ValueType::STRING, 0, 1},
+    {"translate", Function::TRANSLATE, ValueType::STRING, 3, 3},
+    {"boolean", Function::BOOLEAN, ValueType::BOOLEAN, 1, 1},
+    {"not", Function::NOT, ValueType::BOOLEAN, 1, 1},
+    {"true", Function::TRUE_VALUE, ValueType::BOOLEAN, 0, 0},
+    {"false", Function::FALSE_VALUE, ValueType::BOOLEAN, 0, 0},
+    {"number", Function::NUMBER, ValueType::NUMBER, 0, 1},
+    {"sum", Function::SUM, ValueType::NUMBER, 1, 1},
+    {"floor", Function::FLOOR, ValueType::NUMBER, 1, 1},
+    {"ceiling", Function::CEILING, ValueType::NUMBER, 1, 1},
+    {"round", Function::ROUND, ValueType::NUMBER, 1, 1},
+};
+
+const FunctionInfo* LookupFunction(const std::string& name) {
+    for (const auto& info : kFunctions) {
+        if (name == info.name) return &info;
+    }
+    return nullptr;
+}
+
+bool IsNodeTypeName(const std::string& name) {
+    return name == "node" || name == "text" || name == "comment" || name == "processing-instruction";
+}
+
+bool ParseAxisName(const std::string& name, Axis& axis) {
+    static const std::pair<const char*, Axis> kAxes[] = {
+        {"child", Axis::CHILD},
+        {"descendant", Axis::DESCENDANT},
+        {"descendant-or-self", Axis::DESCENDANT_OR_SELF},
+        {"parent", Axis::PARENT},
+        {"ancestor", Axis::ANCESTOR},
+        {"ancestor-or-self", Axis::ANCESTOR_OR_SELF},
+        {"self", Axis::SELF},
+        {"attribute", Axis::ATTRIBUTE},
+        {"following-sibling", Axis::FOLLOWING_SIBLING},
+        {"preceding-sibling", Axis::PRECEDING_SIBLING},
+        {"following", Axis::FOLLOWING},
+        {"preceding", Axis::PRECEDING},
+    };
+    for (const auto& entry : kAxes) {
+        if (name == entry.first) {
+            axis = entry.second;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool IsReverseAxis(Axis axis) {
+    return axis == Axis::PARENT || axis == Axis::ANCESTOR || axis == Axis::ANCESTOR_OR_SELF ||
+           axis == Axis::PRECEDING_SIBLING || axis == Axis::PRECEDING;
+}
+
+// True if the expression reads the context position or size. Predicates of
+// nested steps have their own context and are not inspected.
+bool UsesContextPosition(const Expr& expr) {
+    if (expr.kind == ExprKind::FUNCTION &&
+        (expr.function == Function::LAST || expr.function == Function::POSITION)) {
+        return true;
+    }
+    if (expr.lhs && UsesContextPosition(*expr.lhs)) return true;
+    if (expr.rhs && UsesContextPosition(*expr.rhs)) return true;
+    for (const auto& arg : expr.args) {
+        if (UsesContextPosition(*arg)) return true;
+    }
+    return false;
+}
+
+bool IsPositional(const Expr& predicate) {
+    return predicate.type == ValueType::NUMBER || UsesContextPosition(predicate);
+}
+
+class Parser {
+public:
+    explicit Parser(std::vector<Token> tokens) : tokens_(std::move(tokens)) {}
+
+    std::unique_ptr<Expr> ParseExpression() {
+        auto expr = ParseOr();
+        if (Peek().type != TokenType::END) {
+            throw ParseError("unexpected token after expression");
+        }
+        return expr;
+    }
+
+private:
+    std::vector<Token> tokens_;
+    size_t position_ = 0;
+
+    const Token& Peek(size_t offset = 0) const {
+        size_t index = std::min(position_ + offset, tokens_.size() - 1);
+        return tokens_[index];
+    }
+
+    bool Accept(TokenType type) {
+        if (Peek().type != type) return false;
+        ++position_;
+        return true;
+    }
+
+    void Expect(TokenType type, const char* what) {
+        if (!Accept(type)) throw ParseError(std::string("expected ") + what);
+    }
+
+    static std::unique_ptr<Expr> MakeBinary(ExprKind kind, ValueType type, std::unique_ptr<Expr> lhs, std::unique_ptr<Expr> rhs) {
+        auto expr = std::make_unique<Expr>();
+        expr->kind = kind;
+        expr->type = type;
+        expr->lhs = std::move(lhs);
+        expr->rhs = std::move(rhs);
+        return expr;
+    }
+
+    std::unique_ptr<Expr> ParseOr() {
+        auto expr = ParseAnd();
+        while (Accept(TokenType::OR)) {
+            expr = MakeBinary(ExprKind::OR, ValueType::BOOLEAN, std::move(expr), ParseAnd());
+        }
+        return expr;
+    }
+
+    std::unique_ptr<Expr> ParseAnd() {
+        auto expr = ParseEquality();
+        while (Accept(TokenType::AND)) {
+            expr = MakeBinary(ExprKind::AND, ValueType::BOOLEAN, std::move(expr), ParseEquality());
+        }
+        return expr;
+    }
+
+    std::unique_ptr<Expr> ParseEquality() {
+        auto expr = ParseRelational();
+        for (;;) {
+            if (Accept(TokenType::EQ)) {
+                expr = MakeBinary(ExprKind::EQ, ValueType::BOOLEAN, std::move(expr), ParseRelational());
+            } else if (Accept(TokenType::NE)) {
+                expr = MakeBinary(ExprKind::NE, ValueType::BOOLEAN, std::move(expr), ParseRelational());
+            } else {
+                return expr;
+            }
+        }
+    }
+
+    std::unique_ptr<Expr> ParseRelational() {
+        auto expr = ParseAdditive();
+        for (;;) {
+            ExprKind kind;
+            if (Accept(TokenType::LT)) kind = ExprKind::LT;
+            else if (Accept(TokenType::LE)) kind = ExprKind::LE;
+            else if (Accept(TokenType::GT)) kind = ExprKind::GT;
+            else if (Accept(TokenType::GE)) kind = ExprKind::GE;
+            else return expr;
+            expr = MakeBinary(kind, ValueType::BOOLEAN, std::move(expr), ParseAdditive());
+        }
+    }
+
+    std::unique_ptr<Expr> ParseAdditive() {
+        auto expr = ParseMultiplicative();
+        for (;;) {
+            if (Accept(TokenType::PLUS)) {
+                expr = MakeBinary(ExprKind::ADD, ValueType::NUMBER, std::move(expr), ParseMultiplicative());
+            } else if (Accept(TokenType::MINUS)) {
+                expr = MakeBinary(ExprKind::SUB, ValueType::NUMBER, std::move(expr), ParseMultiplicative());
+            } else {
+                return expr;
+            }
+        }
+    }
+
+    std::unique_ptr<Expr> ParseMultiplicative() {
+        auto expr = ParseUnary();
+        for (;;) {
+            ExprKind kind;
+            if (Accept(TokenType::MULTIPLY)) kind = ExprKind::MUL;
+            else if (Accept(TokenType::DIV)) kind = ExprKind::DIV;
+            else if (Accept(TokenType::MOD)) kind = ExprKind::MOD;
+            else return expr;
+            expr = MakeBinary(kind, ValueType::NUMBER, std::move(expr), ParseUnary());
+        }
+    }
+
+    std::unique_ptr<Expr> ParseUnary() {
+        if (Accept(TokenType::MINUS)) {
+            return MakeBinary(ExprKind::NEGATE, ValueType::NUMBER, ParseUnary(), nullptr);
+        }
+        return ParseUnion();
+    }
+
+    std::unique_ptr<Expr> ParseUnion() {
+        auto expr = ParsePathExpr();
+        while (Accept(TokenType::PIPE)) {
+            auto rhs = ParsePathExpr();
+            if (expr->type != ValueType::NODESET || rhs->type != ValueType::NODESET) {
+                throw ParseError("union operands must be node-sets");
+            }
+            expr = MakeBinary(ExprKind::UNION, ValueType::NODESET, std::move(expr), std::move(rhs));
+        }
+        return expr;
+    }
+
+    bool StartsFilterExpr() const {
+        const Token& token = Peek();
+        if (token.type == TokenType::LPAREN || token.type == TokenType::LITERAL || token.type == TokenType::NUMBER) {
+            return true;
+        }
+        return token.type == TokenType::NAME && Peek(1).type == TokenType::LPAREN && !IsNodeTypeName(token.text);
+    }
+
+    bool StartsStep() const {
+        switch (Peek().type) {
+            case TokenType::NAME:
+            case TokenType::STAR:
+            case TokenType::AT:
+            case TokenType::DOT:
+            case TokenType::DOTDOT:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    std::unique_ptr<Expr> ParsePathExpr() {
+        if (!StartsFilterExpr()) {
+            auto expr = std::make_unique<Expr>();
+            expr->kind = ExprKind::PATH;
+            expr->type = ValueType::NODESET;
+            ParseLocationPath(expr->path);
+            return expr;
+        }
+
+        auto primary = ParsePrimary();
+        if (Peek().type != TokenType::LBRACKET && Peek().type != TokenType::SLASH &&
+            Peek().type != TokenType::DOUBLE_SLASH) {
+            return primary;
+        }
+        if (primary->type != ValueType::NODESET) {
+            throw ParseError("predicates and steps require a node-set");
+        }
+
+        auto expr = std::make_unique<Expr>();
+        expr->kind = ExprKind::FILTER;
+        expr->type = ValueType::NODESET;
+        expr->lhs = std::move(primary);
+        while (Peek().type == TokenType::LBRACKET) {
+            expr->predicates.push_back(ParsePredicate());
+        }
+        if (Accept(TokenType::SLASH)) {
+            ParseRelativePath(expr->path);
+        } else if (Accept(TokenType::DOUBLE_SLASH)) {
+            expr->path.steps.push_back(DescendantOrSelfStep());
+            ParseRelativePath(expr->path);
+        }
+        return expr;
+    }
+
+    std::unique_ptr<Expr> ParsePrimary() {
+        const Token token = Peek();
+        if (Accept(TokenType::LPAREN)) {
+            auto expr = ParseOr();
+            Expect(TokenType::RPAREN, "')'");
+            return expr;
+        }
+        if (Accept(TokenType::LITERAL)) {
+            auto expr = std::make_unique<Expr>();
+            expr->kind = ExprKind::LITERAL;
+            expr->type = ValueType::STRING;
+            expr->literal = token.text;
+            return expr;
+        }
+        if (Accept(TokenType::NUMBER)) {
+            auto expr = std::make_unique<Expr>();
+            expr->kind = ExprKind::NUMBER;
+            expr->type = ValueType::NUMBER;
+            expr->number = token.number;
+            return expr;
+        }
+
+        Expect(TokenType::NAME, "function name");
+        const FunctionInfo* info = LookupFunction(token.text);
+        if (!info) throw ParseError("unknown function '" + token.text + "'");
+
+        auto expr = std::make_unique<Expr>();
+        expr->kind = ExprKind::FUNCTION;
+        expr->type = info->result;
+        expr->function = info->function;
+
+        Expect(TokenType::LPAREN, "'('");
+        if (!Accept(TokenType::RPAREN)) {
+            do {
+                expr->args.push_back(ParseOr());
+            } while (Accept(TokenType::COMMA));
+            Expect(TokenType::RPAREN, "')'");
+        }
+
+        if (expr->args.size() < info->min_args || expr->args.size() > info->max_args) {
+            throw ParseError("wrong number of arguments to '" + token.text + "'");
+        }
+        if ((info->function == Function::COUNT || info->function == Function::SUM) &&
+            expr->args[0]->type != ValueType::NODESET) {
+            throw ParseError("'" + token.text + "' requires a node-set");
+        }
+        return expr;
+    }
+
+    std::unique_ptr<Expr> ParsePredicate() {
+        Expect(TokenType::LBRACKET, "'['");
+        auto predicate = ParseOr();
+        Expect(TokenType::RBRACKET, "']'");
+        return predicate;
+    }
+
+    static Step DescendantOrSelfStep() {
+        Step step;
+        step.axis = Axis::DESCENDANT_OR_SELF;
+        step.test = NodeTest::NODE;
+        return step;
+    }
+
+    void ParseLocationPath(LocationPath& path) {
+        if (Accept(TokenType::SLASH)) {
+            path.absolute = true;
+            if (StartsStep()) ParseRelativePath(path);
+            return;
+        }
+        if (Accept(TokenType::DOUBLE_SLASH)) {
+            path.absolute = true;
+            path.steps.push_back(DescendantOrSelfStep());
+        }
+        ParseRelativePath(path);
+    }
+
+    void ParseRelativePath(LocationPath& path) {
+        path.steps.push_back(ParseStep());
+        for (;;) {
+            if (Accept(TokenType::SLASH)) {
+                path.steps.push_back(ParseStep());
+            } else if (Accept(TokenType::DOUBLE_SLASH)) {
+                path.steps.push_back(DescendantOrSelfStep());
+                path.steps.push_back(ParseStep());
+            } else {
+                return;
+            }
+        }
+    }
+
+    Step ParseStep() {
+        Step step;
+        if (Accept(TokenType::DOT)) {
+            step.axis = Axis::SELF;
+            step.test = NodeTest::NODE;
+            return step;
+        }
+        if (Accept(TokenType::DOTDOT)) {
+            step.axis = Axis::PARENT;
+            step.test = NodeTest::NODE;
+            return step;
+        }
+
+        if (Accept(TokenType::AT)) {
+            step.axis = Axis::ATTRIBUTE;
+        } else if (Peek().type == TokenType::NAME && Peek(1).type == TokenType::DOUBLE_COLON) {
+            if (!ParseAxisName(Peek().text, step.axis)) {
+                throw ParseError("unknown axis '" + Peek().text + "'");
+            }
+            position_ += 2;
+        }
+
+        const Token token = Peek();
+        if (Accept(TokenType::STAR)) {
+            step.test = NodeTest::ANY;
+        } else if (Accept(TokenType::NAME)) {
+            if (IsNodeTypeName(token.text) && Peek().type == TokenType::LPAREN) {
+                ++position_;
+                if (token.text == "processing-instruction") Accept(TokenType::LITERAL);
+                Expect(TokenType::RPAREN, "')'");
+                if (token.text == "node") step.test = NodeTest::NODE;
+                else if (token.text == "text") step.test = NodeTest::TEXT;
+                else step.test = NodeTest::NEVER;
+            } else {
+                step.test = NodeTest::NAME;
+                step.name = token.text;
+            }
+        } else {
+            throw ParseError("expected node test");
+        }
+
+        while (Peek().type == TokenType::LBRACKET) {
+            step.predicates.push_back(ParsePredicate());
+        }
+        return step;
+    }
+};
+
+// ---------------------------------------------------------------------------
+// Plan optimization
+// ---------------------------------------------------------------------------
+
+void PlanPath(LocationPath& path);
+
+void PlanExpr(Expr& expr) {
+    if (expr.lhs) PlanExpr(*expr.lhs);
+    if (expr.rhs) PlanExpr(*expr.rhs);
+    for (auto& arg : expr.args) PlanExpr(*arg);
+    for (auto& predicate : expr.predicates) PlanExpr(*predicate);
+    if (expr.kind == ExprKind::PATH || expr.kind == ExprKind::FILTER) PlanPath(expr.path);
+}
+
+void PlanStep(Step& step) {
+    for (auto& predicate : step.predicates) PlanExpr(*predicate);
+
+    size_t positional = 0;
+    for (const auto& predicate : step.predicates) {
+        if (IsPositional(*predicate)) ++positional;
+    }
+
+    if (positional == 0) {
+        step.mode = StepMode::STREAM;
+    } else if (step.predicates.size() == 1 && step.predicates[0]->kind == ExprKind::NUMBER) {
+        double n = step.predicates[0]->number;
+        step.mode = StepMode::NTH;
+        step.nth = (n >= 1.0 && n == std::floor(n)) ? static_cast<size_t>(n) : 0;
+    } else {
+        step.mode = StepMode::MATERIALIZE;
+    }
+}
+
+void PlanPath(LocationPath& path) {
+    // Fuse descendant-or-self::node()/child::x into descendant::x. Only
+    // valid when the child step has no positional predicates: //li[1] means
+    // "first li of each parent", not "first li in the document".
+    std::vector<Step> fused;
+    for (size_t i = 0; i < path.steps.size(); ++i) {
+        Step& step = path.steps[i];
+        bool is_descendant_or_self = step.axis == Axis::DESCENDANT_OR_SELF && step.test == NodeTest::NODE &&
+                                     step.predicates.empty();
+        if (is_descendant_or_self && i + 1 < path.steps.size()) {
+            Step& next = path.steps[i + 1];
+            bool positional = std::any_of(next.predicates.begin(), next.predicates.end(),
+                                          [](const auto& p) { return IsPositional(*p); });
+            if (next.axis == Axis::CHILD && !positional) {
+                next.axis = Axis::DESCENDANT;
+                continue;
+            }
+        }
+        fused.push_back(std::move(step));
+    }
+    path.steps = std::move(fused);
+
+    for (auto& step : path.steps) PlanStep(step);
+
+    // A single forward step, or a chain of child/attribute/self steps, walks
+    // the tree in document order without producing duplicates
+    bool single_forward = path.steps.size() == 1 && !IsReverseAxis(path.steps[0].axis);
+    bool child_chain = std::all_of(path.steps.begin(), path.steps.end(), [](const Step& step) {
+        return step.axis == Axis::CHILD || step.axis == Axis::ATTRIBUTE || step.axis == Axis::SELF;
+    });
+    path.ordered = single_forward || child_chain;
+}
+
+// ---------------------------------------------------------------------------
+// Evaluation
+// ---------------------------------------------------------------------------
+
+class Evaluator {
+public:
+    explicit Evaluator(const DOMTree& tree) : tree_(tree) {}
+
+    Value Eval(const Expr& expr, const Item& context, size_t position, size_t size);
+    bool EvalBoolean(const Expr& expr, const Item& context, size_t position, size_t size);
+    NodeSet EvalNodeSet(const Expr& expr, const Item& context, size_t position, size_t size);
+
+    // Streams the nodes selected by a node-set expression. Returns false if
+    // the visitor stopped the walk.
+    bool ForEachNode(const Expr& expr, const Item& context, size_t position, size_t size, Visitor visit);
+
+    std::string StringValue(const Item& item) const;
+    void SortAndDedupe(NodeSet& nodes) const;
+
+private:
+    const DOMTree& tree_;
+
+    bool WalkPath(const LocationPath& path, const Item& context, Visitor visit);
+    bool WalkSteps(const std::vector<Step>& steps, size_t index, const Item& context, Visitor visit);
+    bool ForEachOnAxis(Axis axis, bool include_text, const Item& context, Visitor visit) const;
+    bool ForEachInSubtree(NodeIndex root, bool include_root, bool include_text, Visitor visit) const;
+    bool ForEachInSubtreeReverse(NodeIndex root, bool include_text, Visitor visit) const;
+    bool MatchesNodeTest(const Step& step, const Item& item) const;
+    bool PredicateHolds(const Expr& predicate, const Item& item, size_t position, size_t size);
+
+    bool HasText(NodeIndex node) const {
+        const DOMNode* dom_node = tree_.GetNode(node);
+        return dom_node && !dom_node->text_content.empty();
+    }
+
+    Item ParentOf(const Item& item) const;
+
+    Value EvalFunction(const Expr& expr, const Item& context, size_t position, size_t size);
+    bool EvalComparison(const Expr& expr, const Item& context, size_t position, size_t size);
+
+    std::string ToString(const Value& value) const;
+    double ToNumber(const Value& value) const;
+    static bool ToBoolean(const Value& value);
+};
+
+Item Evaluator::ParentOf(const Item& item) const {
+    switch (item.kind) {
+        case ItemKind::DOCUMENT:
+            return Item{ItemKind::DOCUMENT, kInvalidNodeIndex, nullptr};
+        case ItemKind::TEXT:
+        case ItemKind::ATTRIBUTE:
+            return ElementItem(item.node);
+        case ItemKind::ELEMENT: {
+            const DOMNode* node = tree_.GetNode(item.node);
+            if (node && node->parent != kInvalidNodeIndex) return ElementItem(node->parent);
+            if (item.node == tree_.GetDocumentElement()) return DocumentItem();
+            return Item{ItemKind::ELEMENT, kInvalidNodeIndex, nullptr}; // Detached root
+        }
+    }
+    return DocumentItem();
+}
+
+bool Evaluator::ForEachInSubtree(NodeIndex root, bool include_root, bool include_text, Visitor visit) const {
+    if (include_root && !visit(ElementItem(root))) return false;
+    if (include_text && HasText(root) && !visit(TextItem(root))) return false;
+
+    for (NodeIndex node = tree_.NextInDocumentOrder(root, root); node != kInvalidNodeIndex;
+         node = tree_.NextInDocumentOrder(node, root)) {
+        if (!visit(ElementItem(node))) return false;
+        if (include_text && HasText(node) && !visit(TextItem(node))) return false;
+    }
+    return true;
+}
+
+bool Evaluator::ForEachInSubtreeReverse(NodeIndex root, bool include_text, Visitor visit) const {
+    const DOMNode* node = tree_.GetNode(root);
+    if (!node) return true;
+
+    for (NodeIndex child = node->last_child; child != kInvalidNodeIndex; child = tree_.GetNode(child)->prev_sibling) {
+        if (!ForEachInSubtreeReverse(child, include_text, visit)) return false;
+    }
+    if (include_text && HasText(root) && !visit(TextItem(root))) return false;
+    return visit(ElementItem(root));
+}
+
+bool Evaluator::ForEachOnAxis(Axis axis, bool include_text, const Item& context, Visitor visit) const {
+    const bool is_element = context.kind == ItemKind::ELEMENT && context.node != kInvalidNodeIndex;
+    const bool is_document = context.kind == ItemKind::DOCUMENT;
+    const NodeIndex document_element = tree_.GetDocumentElement();
+
+    switch (axis) {
+        case Axis::SELF:
+            return visit(context);
+
+        case Axis::CHILD:
+            if (is_document) {
+                return document_element == kInvalidNodeIndex || visit(ElementItem(document_element));
+            }
+            if (!is_element) return true;
+            if (include_text && HasText(context.node) && !visit(TextItem(context.node))) return false;
+            for (NodeIndex child = tree_.GetNode(context.node)->first_child; child != kInvalidNodeIndex;
+                 child = tree_.GetNode(child)->next_sibling) {
+                if (!visit(ElementItem(child))) return false;
+            }
+            return true;
+
+        case Axis::DESCENDANT_OR_SELF:
+            if (!visit(context)) return false;
+            [[fallthrough]];
+        case Axis::DESCENDANT:
+            if (is_document) {
+                return document_element == kInvalidNodeIndex ||
+                       ForEachInSubtree(document_element, true, include_text, visit);
+            }
+            if (!is_element) return true;
+            return ForEachInSubtree(context.node, false, include_text, visit);
+
+        case Axis::PARENT: {
+            Item parent = ParentOf(context);
+            if (is_document || (parent.kind == ItemKind::ELEMENT && parent.node == kInvalidNodeIndex)) return true;
+            return visit(parent);
+        }
+
+        case Axis::ANCESTOR_OR_SELF:
+            if (!visit(context)) return false;
+            [[fallthrough]];
+        case Axis::ANCESTOR: {
+            if (is_document) return true;
+            Item current = context;
+            for (;;) {
+                Item parent = ParentOf(current);
+                if (parent.kind == ItemKind::ELEMENT && parent.node == kInvalidNodeIndex) return true;
+                if (!visit(parent)) return false;
+                if (parent.kind == ItemKind::DOCUMENT) return true;
+                current = parent;
+            }
+        }
+
+        case Axis::ATTRIBUTE:
+            if (!is_element) return true;
+            for (const auto& attribute : tree_.GetNode(context.node)->attributes) {
+                if (!visit(AttributeItem(context.node, &attribute.first))) return false;
+            }
+            return true;
+
+        case Axis::FOLLOWING_SIBLING:
+            if (context.kind == ItemKind::TEXT) {
+                // The text run is the first child of its element
+                for (NodeIndex child = tree_.GetNode(context.node)->first_child; child != kInvalidNodeIndex;
+                     child = tree_.GetNode(child)->next_sibling) {
+                    if (!visit(ElementItem(child))) return false;
+                }
+                return true;
+            }
+            if (!is_element) return true;
+            for (NodeIndex sibling = tree_.GetNode(context.node)->next_sibling; sibling != kInvalidNodeIndex;
+                 sibling = tree_.GetNode(sibling)->next_sibling) {
+                if (!visit(ElementItem(sibling))) return false;
+            }
+            return true;
+
+        case Axis::PRECEDING_SIBLING: {
+            if (!is_element) return true;
+            const DOMNode* node = tree_.GetNode(context.node);
+            for (NodeIndex sibling = node->prev_sibling; sibling != kInvalidNodeIndex;
+                 sibling = tree_.GetNode(sibling)->prev_sibling) {
+                if (!visit(ElementItem(sibling))) return false;
+            }
+            if (include_text && node->parent != kInvalidNodeIndex && HasText(node->parent)) {
+                return visit(TextItem(node->parent));
+            }
+            return true;
+        }
+
+        case Axis::FOLLOWING: {
+            if (is_document || context.node == kInvalidNodeIndex) return true;
+            NodeIndex current = context.node;
+            if (context.kind != ItemKind::ELEMENT) {
+                // Everything inside the owner element comes after its text and attributes
+                bool with_text = include_text && context.kind == ItemKind::ATTRIBUTE;
+                if (!ForEachInSubtree(current, false, with_text, visit)) return false;
+            }
+            for (; current != kInvalidNodeIndex; current = tree_.GetNode(current)->parent) {
+                for (NodeIndex sibling = tree_.GetNode(current)->next_sibling; sibling != kInvalidNodeIndex;
+                     sibling = tree_.GetNode(sibling)->next_sibling) {
+                    if (!ForEachInSubtree(sibling, true, include_text, visit)) return false;
+                }
+            }
+            return true;
+        }
+
+        case Axis::PRECEDING: {
+            if (is_document || context.node == kInvalidNodeIndex) return true;
+            for (NodeIndex current = context.node; current != kInvalidNodeIndex;
+                 current = tree_.GetNode(current)->parent) {
+                const DOMNode* node = tree_.GetNode(current);
+                for (NodeIndex sibling = node->prev_sibling; sibling != kInvalidNodeIndex;
+                     sibling = tree_.GetNode(sibling)->prev_sibling) {
+                    if (!ForEachInSubtreeReverse(sibling, include_text, visit)) return false;
+                }
+                if (include_text && node->parent != kInvalidNodeIndex && HasText(node->parent) &&
+                    !visit(TextItem(node->parent))) {
+                    return false;
+                }
+            }
+            return true;
+        }
+    }
+    return true;
+}
+
+bool Evaluator::MatchesNodeTest(const Step& step, const Item& item) const {
+    const ItemKind principal = step.axis == Axis::ATTRIBUTE ? ItemKind::ATTRIBUTE : ItemKind::ELEMENT;
+
+    switch (step.test) {
+        case NodeTest::NODE:
+            return true;
+        case NodeTest::TEXT:
+            return item.kind == ItemKind::TEXT;
+        case NodeTest::NEVER:
+            return false;
+        case NodeTest::ANY:
+            return item.kind == principal;
+        case NodeTest::NAME:
+            if (item.kind != principal) return false;
+            if (principal == ItemKind::ATTRIBUTE) return *item.attribute == step.name;
+            return EqualsIgnoreCase(tree_.GetNode(item.node)->tag_name, step.name);
+    }
+    return false;
+}
+
+bool Evaluator::PredicateHolds(const Expr& predicate, const Item& item, size_t position, size_t size) {
+    if (predicate.type == ValueType::NUMBER) {
+        return Eval(predicate, item, position, size).number == static_cast<double>(position);
+    }
+    return EvalBoolean(predicate, item, position, size);
+}
+
+bool Evaluator::WalkPath(const LocationPath& path, const Item& context, Visitor visit) {
+    Item start = path.absolute ? DocumentItem() : context;
+    if (path.steps.empty()) return visit(start);
+    return WalkSteps(path.steps, 0, start, visit);
+}
+
+bool Evaluator::WalkSteps(const std::vector<Step>& steps, size_t index, const Item& context, Visitor visit) {
+    const Step& step = steps[index];
+    const bool last_step = index + 1 == steps.size();
+    const bool include_text = step.test == NodeTest::TEXT || step.test == NodeTest::NODE;
+
+    auto emit = [&](const Item& item) -> bool {
+        return last_step ? visit(item) : WalkSteps(steps, index + 1, item, visit);
+    };
+
+    switch (step.mode) {
+        case StepMode::STREAM:
+            return ForEachOnAxis(step.axis, include_text, context, [&](const Item& item) -> bool {
+                if (!MatchesNodeTest(step, item)) return true;
+                for (const auto& predicate : step.predicates) {
+                    if (!EvalBoolean(*predicate, item, 0, 0)) return true;
+                }
+                return emit(item);
+            });
+
+        case StepMode::NTH: {
+            if (step.nth == 0) return true;
+            size_t position = 0;
+            bool keep_going = true;
+            ForEachOnAxis(step.axis, include_text, context, [&](const Item& item) -> bool {
+                if (!MatchesNodeTest(step, item) || ++position < step.nth) return true;
+                keep_going = emit(item);
+                return false;
+            });
+            return keep_going;
+        }
+
+        case StepMode::MATERIALIZE: {
+            NodeSet candidates;
+            ForEachOnAxis(step.axis, include_text, context, [&](const Item& item) -> bool {
+                if (MatchesNodeTest(step, item)) candidates.push_back(item);
+                return true;
+            });
+
+            for (const auto& predicate : step.predicates) {
+                NodeSet kept;
+                const size_t size = candidates.size();
+                for (size_t i = 0; i < size; ++i) {
+                    if (PredicateHolds(*predicate, candidates[i], i + 1, size)) kept.push_back(candidates[i]);
+                }
+                candidates.swap(kept);
+            }
+
+            for (const auto& item : candidates) {
+                if (!emit(item)) return false;
+            }
+            return true;
+        }
+    }
+    return true;
+}
+
+bool Evaluator::ForEachNode(const Expr& expr, const Item& context, size_t position, size_t size, Visitor visit) {
+    if (expr.kind == ExprKind::PATH && expr.path.ordered) {
+        return WalkPath(expr.path, context, visit);
+    }
+    for (const auto& item : EvalNodeSet(expr, context, position, size)) {
+        if (!visit(item)) return false;
+    }
+    return true;
+}
+
+NodeSet Evaluator::EvalNodeSet(const Expr& expr, const Item& context, size_t position, size_t size) {
+    NodeSet result;
+
+    switch (expr.kind) {
+        case ExprKind::PATH:
+            WalkPath(expr.path, context, [&](const Item& item) -> bool {
+                result.push_back(item);
+                return true;
+            });
+            if (!expr.path.ordered) SortAndDedupe(result);
+            return result;
+
+        case ExprKind::UNION: {
+            result = EvalNodeSet(*expr.lhs, context, position, size);
+            NodeSet rhs = EvalNodeSet(*expr.rhs, context, position, size);
+            result.insert(result.end(), rhs.begin(), rhs.end());
+            SortAndDedupe(result);
+            return result;
+        }
+
+        case ExprKind::FILTER: {
+            NodeSet nodes = EvalNodeSet(*expr.lhs, context, position, size);
+            for (const auto& predicate : expr.predicates) {
+                NodeSet kept;
+                const size_t count = nodes.size();
+                for (size_t i = 0; i < count; ++i) {
+                    if (PredicateHolds(*predicate, nodes[i], i + 1, count)) kept.push_back(nodes[i]);
+                }
+                nodes.swap(kept);
+            }
+            if (expr.path.steps.empty()) return nodes;
+
+            for (const auto& item : nodes) {
+                WalkSteps(expr.path.steps, 0, item, [&](const Item& match) -> bool {
+                    result.push_back(match);
+                    return true;
+                });
+            }
+            SortAndDedupe(result);
+            return result;
+        }
+
+        default: {
+            Value value = Eval(expr, context, position, size);
+            return value.type == ValueType::NODESET ? std::move(value.nodes) : NodeSet{};
+        }
+    }
+}
+
+void Evaluator::SortAndDedupe(NodeSet& nodes) const {
+    auto kind_rank = [](ItemKind kind) {
+        switch (kind) {
+            case ItemKind::DOCUMENT: return 0;
+            case ItemKind::ELEMENT: return 1;
+            case ItemKind::ATTRIBUTE: return 2;
+            case ItemKind::TEXT: return 3;
+        }
+        return 0;
+    };
+
+    std::sort(nodes.begin(), nodes.end(), [&](const Item& a, const Item& b) {
+        if (a.kind == ItemKind::DOCUMENT || b.kind == ItemKind::DOCUMENT) {
+            return a.kind == ItemKind::DOCUMENT && b.kind != ItemKind::DOCUMENT;
+        }
+        uint32_t order_a = tree_.DocumentOrder(a.node);
+        uint32_t order_b = tree_.DocumentOrder(b.node);
+        if (order_a != order_b) return order_a < order_b;
+        if (a.node != b.node) return a.node < b.node;
+        if (a.kind != b.kind) return kind_rank(a.kind) < kind_rank(b.kind);
+        if (a.kind == ItemKind::ATTRIBUTE) return *a.attribute < *b.attribute;
+        return false;
+    });
+    nodes.erase(std::unique(nodes.begin(), nodes.end()), nodes.end());
+}
+
+std::string Evaluator::StringValue(const Item& item) const {
+    switch (item.kind) {
+        case ItemKind::DOCUMENT: {
+            const DOMNode* root = tree_.GetNode(tree_.GetDocumentElement());
+            return root ? root->text_content : "";
+        }
+        case ItemKind::ELEMENT:
+        case ItemKind::TEXT: {
+            const DOMNode* node = tree_.GetNode(item.node);
+            return node ? node->text_content : "";
+        }
+        case ItemKind::ATTRIBUTE: {
+            const DOMNode* node = tree_.GetNode(item.node);
+            if (!node) return "";
+            auto it = node->attributes.find(*item.attribute);
+            return it != node->attributes.end() ? it->second : "";
+        }
+    }
+    return "";
+}
+
+std::string Evaluator::ToString(const Value& value) const {
+    switch (value.type) {
+        case ValueType::NODESET: return value.nodes.empty() ? "" : StringValue(value.nodes.front());
+        case ValueType::BOOLEAN: return value.boolean ? "true" : "false";
+        case ValueType::NUMBER: return NumberToString(value.number);
+        case ValueType::STRING: return value.string;
+    }
+    return "";
+}
+
+double Evaluator::ToNumber(const Value& value) const {
+    switch (value.type) {
+        case ValueType::NUMBER: return value.number;
+        case ValueType::BOOLEAN: return value.boolean ? 1.0 : 0.0;
+        default: return StringToNumber(ToString(value));
+    }
+}
+
+bool Evaluator::ToBoolean(const Value& value) {
+    switch (value.type) {
+        case ValueType::NODESET: return !value.nodes.empty();
+        case ValueType::BOOLEAN: return value.boolean;
+        case ValueType::NUMBER: return value.number != 0.0 && !std::isnan(value.number);
+        case ValueType::STRING: return !value.string.empty();
+    }
+    return false;
+}
+
+bool Evaluator::EvalBoolean(const Expr& expr, const Item& context, size_t position, size_t size) {
+    switch (expr.kind) {
+        case ExprKind::OR:
+            return EvalBoolean(*expr.lhs, context, position, size) || EvalBoolean(*expr.rhs, context, position, size);
+        case ExprKind::AND:
+            return EvalBoolean(*expr.lhs, context, position, size) && EvalBoolean(*expr.rhs, context, position, size);
+        case ExprKind::EQ:
+        case ExprKind::NE:
+        case ExprKind::LT:
+        case ExprKind::LE:
+        case ExprKind::GT:
+        case ExprKind::GE:
+            return EvalComparison(expr, context, position, size);
+        case ExprKind::PATH:
+        case ExprKind::UNION:
+        case ExprKind::FILTER: {
+            // Existence test: stop at the first node
+            bool found = false;
+            ForEachNode(expr, context, position, size, [&](const Item&) -> bool {
+                found = true;
+                return false;
+            });
+            return found;
+        }
+        case ExprKind::FUNCTION:
+            if (expr.function == Function::NOT) return !EvalBoolean(*expr.args[0], context, position, size);
+            if (expr.function == Function::BOOLEAN) return EvalBoolean(*expr.args[0], context, position, size);
+            [[fallthrough]];
+        default:
+            return ToBoolean(Eval(expr, context, position, size));
+    }
+}
+
+ExprKind SwapComparison(ExprKind kind) {
+    switch (kind) {
+        case ExprKind::LT: return ExprKind::GT;
+        case ExprKind::LE: return ExprKind::GE;
+        case ExprKind::GT: return ExprKind::LT;
+        case ExprKind::GE: return ExprKind::LE;
+        default: return kind;
+    }
+}
+
+bool CompareNumbers(ExprKind kind, double a, double b) {
+    switch (kind) {
+        case ExprKind::EQ: return a == b;
+        case ExprKind::NE: return a != b;
+        case ExprKind::LT: return a < b;
+        case ExprKind::LE: return a <= b;
+        case ExprKind::GT: return a > b;
+        case ExprKind::GE: return a >= b;
+        default: return false;
+    }
+}
+
+bool Evaluator::EvalComparison(const Expr& expr, const Item& context, size_t position, size_t size) {
+    const ExprKind kind = expr.kind;
+    const bool equality = kind == ExprKind::EQ || kind == ExprKind::NE;
+    const bool lhs_nodes = expr.lhs->type == ValueType::NODESET;
+    const bool rhs_nodes = expr.rhs->type == ValueType::NODESET;
+
+    // Compares one node's string-value against a scalar
+    auto compare_item = [&](const std::string& item_value, const Value& scalar, ExprKind op) {
+        if (scalar.type == ValueType::NUMBER || (!equality)) {
+            return CompareNumbers(op, StringToNumber(item_value), ToNumber(scalar));
+        }
+        const std::string scalar_value = ToString(scalar);
+        return op == ExprKind::EQ ? item_value == scalar_value : item_value != scalar_value;
+    };
+
+    if (lhs_nodes && rhs_nodes) {
+        NodeSet rhs = EvalNodeSet(*expr.rhs, context, position, size);
+        std::vector<std::string> rhs_values;
+        rhs_values.reserve(rhs.size());
+        for (const auto& item : rhs) rhs_values.push_back(StringValue(item));
+
+        bool result = false;
+        ForEachNode(*expr.lhs, context, position, size, [&](const Item& item) -> bool {
+            const std::string lhs_value = StringValue(item);
+            for (const auto& rhs_value : rhs_values) {
+                bool match = equality ? ((lhs_value == rhs_value) == (kind == ExprKind::EQ))
+                                      : CompareNumbers(kind, StringToNumber(lhs_value), StringToNumber(rhs_value));
+                if (match) {
+                    result = true;
+                    return false;
+                }
+            }
+            return true;
+        });
+        return result;
+    }
+
+    if (lhs_nodes || rhs_nodes) {
+        const Expr& nodes_expr = lhs_nodes ? *expr.lhs : *expr.rhs;
+        const Expr& scalar_expr = lhs_nodes ? *expr.rhs : *expr.lhs;
+        const ExprKind op = lhs_nodes ? kind : SwapComparison(kind);
+
+        if (scalar_expr.type == ValueType::BOOLEAN) {
+            bool nodes_bool = EvalBoolean(nodes_expr, context, position, size);
+            bool scalar_bool = EvalBoolean(scalar_expr, context, position, size);
+            return CompareNumbers(op, nodes_bool ? 1.0 : 0.0, scalar_bool ? 1.0 : 0.0);
+        }
+
+        Value scalar = Eval(scalar_expr, context, position, size);
+        bool result = false;
+        ForEachNode(nodes_expr, context, position, size, [&](const Item& item) -> bool {
+            if (compare_item(StringValue(item), scalar, op)) {
+                result = true;
+                return false;
+            }
+            return true;
+        });
+        return result;
+    }
+
+    Value lhs = Eval(*expr.lhs, context, position, size);
+    Value rhs = Eval(*expr.rhs, context, position, size);
+    if (equality) {
+        if (lhs.type == ValueType::BOOLEAN || rhs.type == ValueType::BOOLEAN) {
+            return (ToBoolean(lhs) == ToBoolean(rhs)) == (kind == ExprKind::EQ);
+        }
+        if (lhs.type == ValueType::NUMBER || rhs.type == ValueType::NUMBER) {
+            return CompareNumbers(kind, ToNumber(lhs), ToNumber(rhs));
+        }
+        return (ToString(lhs) == ToString(rhs)) == (kind == ExprKind::EQ);
+    }
+    return CompareNumbers(kind, ToNumber(lhs), ToNumber(rhs));
+}
+
+Value Evaluator::Eval(const Expr& expr, const Item& context, size_t position, size_t size) {
+    switch (expr.kind) {
+        case ExprKind::OR:
+        case ExprKind::AND:
+        case ExprKind::EQ:
+        case ExprKind::NE:
+        case ExprKind::LT:
+        case ExprKind::LE:
+        case ExprKind::GT:
+        case ExprKind::GE:
+            return Value::FromBoolean(EvalBoolean(expr, context, position, size));
+
+        case ExprKind::ADD:
+        case ExprKind::SUB:
+        case ExprKind::MUL:
+        case ExprKind::DIV:
+        case ExprKind::MOD: {
+            double a = ToNumber(Eval(*expr.lhs, context, position, size));
+            double b = ToNumber(Eval(*expr.rhs, context, position, size));
+            switch (expr.kind) {
+                case ExprKind::ADD: return Value::FromNumber(a + b);
+                case ExprKind::SUB: return Value::FromNumber(a - b);
+                case ExprKind::MUL: return Value::FromNumber(a * b);
+                case ExprKind::DIV: return Value::FromNumber(a / b);
+                default: return Value::FromNumber(std::fmod(a, b));
+            }
+        }
+
+        case ExprKind::NEGATE:
+            return Value::FromNumber(-ToNumber(Eval(*expr.lhs, context, position, size)));
+
+        case ExprKind::UNION:
+        case ExprKind::PATH:
+        case ExprKind::FILTER:
+            return Value::FromNodes(EvalNodeSet(expr, context, position, size));
+
+        case ExprKind::LITERAL:
+            return Value::FromString(expr.literal);
+
+        case ExprKind::NUMBER:
+            return Value::FromNumber(expr.number);
+
+        case ExprKind::FUNCTION:
+            return EvalFunction(expr, context, position, size);
+    }
+    return Value{};
+}
+
+Value Evaluator::EvalFunction(const Expr& expr, const Item& context, size_t position, size_t size) {
+    auto arg_string = [&](size_t index) {
+        return ToString(Eval(*expr.args[index], context, position, size));
+    };
+    auto arg_number = [&](size_t index) {
+        return ToNumber(Eval(*expr.args[index], context, position, size));
+    };
+    auto string_or_context = [&]() {
+        return expr.args.empty() ? StringValue(context) : arg_string(0);
+    };
+
+    switch (expr.function) {
+        case Function::LAST:
+            return Value::FromNumber(static_cast<double>(size));
+        case Function::POSITION:
+            return Value::FromNumber(static_cast<double>(position));
+
+        case Function::COUNT: {
+            const Expr& arg = *expr.args[0];
+            size_t count = 0;
+            if (arg.kind == ExprKind::PATH && arg.path.ordered) {
+                WalkPath(arg.path, context, [&](const Item&) -> bool {
+                    ++count;
+                    return true;
+                });
+            } else {
+                count = EvalNodeSet(arg, context, position, size).size();
+            }
+            return Value::FromNumber(static_cast<double>(count));
+        }
+
+        case Function::NAME:
+        case Function::LOCAL_NAME: {
+            Item item = context;
+            if (!expr.args.empty()) {
+                NodeSet nodes = EvalNodeSet(*expr.args[0], context, position, size);
+                if (nodes.empty()) return Value::FromString("");
+                item = nodes.front();
+            }
+            std::string name;
+            if (item.kind == ItemKind::ELEMENT) name = tree_.GetNode(item.node)->tag_name;
+            else if (item.kind == ItemKind::ATTRIBUTE) name = *item.attribute;
+            if (expr.function == Function::LOCAL_NAME) {
+                size_t colon = name.find(':');
+                if (colon != std::string::npos) name = name.substr(colon + 1);
+            }
+            return Value::FromString(name);
+        }
+
+        case Function::STRING:
+            return Value::FromString(string_or_context());
+
+        case Function::CONCAT: {
+            std::string result;
+            for (size_t i = 0; i < expr.args.size(); ++i) result += arg_string(i);
+            return Value::FromString(result);
+        }
+
+        case Function::STARTS_WITH: {
+            std::string haystack = arg_string(0);
+            std::string needle = arg_string(1);
+            return Value::FromBoolean(haystack.compare(0, needle.size(), needle) == 0);
+        }
+
+        case Function::ENDS_WITH: {
+            std::string haystack = arg_string(0);
+            std::string needle = arg_string(1);
+            return Value::FromBoolean(haystack.size() >= needle.size() &&
+                                      haystack.compare(haystack.size() - needle.size(), needle.size(), needle) == 0);
+        }
+
+        case Function::CONTAINS:
+            return Value::FromBoolean(arg_string(0).find(arg_string(1)) != std::string::npos);
+
+        case Function::SUBSTRING_BEFORE: {
+            std::string haystack = arg_string(0);
+            size_t found = haystack.find(arg_string(1));
+            return Value::FromString(found == std::string::npos ? "" : haystack.substr(0, found));
+        }
+
+        case Function::SUBSTRING_AFTER: {
+            std::string haystack = arg_string(0);
+            std::string needle = arg_string(1);
+            size_t found = haystack.find(needle);
+            return Value::FromString(found == std::string::npos ? "" : haystack.substr(found + needle.size()));
+        }
+
+        case Function::SUBSTRING: {
+            // Characters at positions p with round(start) <= p < round(start) + round(length)
+            std::string text = arg_string(0);
+            double start = std::floor(arg_number(1) + 0.5);
+            double end = expr.args.size() > 2 ? start + std::floor(arg_number(2) + 0.5)
+                                              : std::numeric_limits<double>::infinity();
+            std::string result;
+            for (size_t i = 0; i < text.size(); ++i) {
+                double p = static_cast<double>(i + 1);
+                if (p >= start && p < end) result.push_back(text[i]);
+            }
+            return Value::FromString(result);
+        }
+
+        case Function::STRING_LENGTH:
+            return Value::FromNumber(static_cast<double>(string_or_context().size()));
+
+        case Function::NORMALIZE_SPACE:
+            return Value::FromString(NormalizeSpace(string_or_context()));
+
+        case Function::TRANSLATE: {
+            std::string text = arg_string(0);
+            std::string from = arg_string(1);
+            std::string to = arg_string(2);
+            std::string result;
+            result.reserve(text.size());
+            for (char c : text) {
+                size_t index = from.find(c);
+                if (index == std::string::npos) result.push_back(c);
+                else if (index < to.size()) result.push_back(to[index]);
+            }
+            return Value::FromString(result);
+        }
+
+        case Function::BOOLEAN:
+            return Value::FromBoolean(EvalBoolean(*expr.args[0], context, position, size));
+        case Function::NOT:
+            return Value::FromBoolean(!EvalBoolean(*expr.args[0], context, position, size));
+        case Function::TRUE_VALUE:
+            return Value::FromBoolean(true);
+        case Function::FALSE_VALUE:
+            return Value::FromBoolean(false);
+
+        case Function::NUMBER:
+            return Value::FromNumber(expr.args.empty() ? StringToNumber(StringValue(context)) : arg_number(0));
+
+        case Function::SUM: {
+            double total = 0.0;
+            for (const auto& item : EvalNodeSet(*expr.args[0], context, position, size)) {
+                total += StringToNumber(StringValue(item));
+            }
+            return Value::FromNumber(total);
+        }
+
+        case Function::FLOOR:
+            return Value::FromNumber(std::floor(arg_number(0)));
+        case Function::CEILING:
+            return Value::FromNumber(std::ceil(arg_number(0)));
+        case Function::ROUND: {
+            double value = arg_number(0);
+            return Value::FromNumber(std::isnan(value) || std::isinf(value) ? value : std::floor(value + 0.5));
+        }
+    }
+    return Value{};
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// CompiledXPath
+// ---------------------------------------------------------------------------
+
+struct CompiledXPath::Plan {
+    std::unique_ptr<Expr> root;
+};
+
+CompiledXPath::CompiledXPath(std::string expression, std::unique_ptr<Plan> plan)
+    : expression_(std::move(expression)), plan_(std::move(plan)) {}
+
+CompiledXPath::~CompiledXPath() = default;
+
+std::shared_ptr<const CompiledXPath> CompiledXPath::Compile(const std::string& expression, std::string* error) {
+    try {
+        Parser parser(Tokenize(expression));
+        auto plan = std::make_unique<Plan>();
+        plan->root = parser.ParseExpression();
+        PlanExpr(*plan->root);
+        return std::shared_ptr<const CompiledXPath>(new CompiledXPath(expression, std::move(plan)));
+    } catch (const ParseError& e) {
+        if (error) *error = "Invalid XPath '" + expression + "': " + e.what();
+        return nullptr;
+    }
+}
+
+std::vector<NodeIndex> CompiledXPath::Evaluate(const DOMTree& tree) const {
+    return Evaluate(tree, kInvalidNodeIndex);
+}
+
+std::vector<NodeIndex> CompiledXPath::Evaluate(const DOMTree& tree, NodeIndex context) const {
+    std::vector<NodeIndex> elements;
+    const Expr& root = *plan_->root;
+    if (root.type != ValueType::NODESET) return elements;
+
+    Evaluator evaluator(tree);
+    Item context_item = context == kInvalidNodeIndex ? DocumentItem() : ElementItem(context);
+
+    // Results are unique and in document order, so an attribute or text hit
+    // can only repeat the element reported just before it
+    auto add = [&elements](const Item& item) -> bool {
+        if (item.kind != ItemKind::DOCUMENT && (elements.empty() || elements.back() != item.node)) {
+            elements.push_back(item.node);
+        }
+        return true;
+    };
+    evaluator.ForEachNode(root, context_item, 1, 1, add);
+    return elements;
+}
+
+std::vector<std::string> CompiledXPath::EvaluateStrings(const DOMTree& tree) const {
+    std::vector<std::string> values;
+    const Expr& root = *plan_->root;
+
+    Evaluator evaluator(tree);
+    if (root.type != ValueType::NODESET) {
+        Value value = evaluator.Eval(root, DocumentItem(), 1, 1);
+        switch (value.type) {
+            case ValueType::BOOLEAN: values.push_back(value.boolean ? "true" : "false"); break;
+            case ValueType::NUMBER: values.push_back(NumberToString(value.number)); break;
+            default: values.push_back(value.string); break;
+        }
+        return values;
+    }
+
+    evaluator.ForEachNode(root, DocumentItem(), 1, 1, [&](const Item& item) -> bool {
+        values.push_back(evaluator.StringValue(item));
+        return true;
+    });
+    return values;
+}
+
+// ---------------------------------------------------------------------------
+// XPathCache
+// ---------------------------------------------------------------------------
+
+XPathCache::XPathCache(size_t capacity) : capacity_(capacity) {}
+
+std::shared_ptr<const CompiledXPath> XPathCache::Get(const std::string& expression) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = entries_.find(expression);
+        if (it != entries_.end()) {
+            ++hits_;
+            lru_.splice(lru_.begin(), lru_, it->second.lru_position);
+            return it->second.compiled;
+        }
+        ++misses_;
+    }
+
+    // Compile outside the lock; a concurrent miss on the same expression
+    // just compiles it twice
+    auto compiled = CompiledXPath::Compile(expression);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (capacity_ == 0) return compiled;
+
+    auto it = entries_.find(expression);
+    if (it != entries_.end()) return it->second.compiled;
+
+    lru_.push_front(expression);
+    entries_[expression] = Entry{compiled, lru_.begin()};
+    EvictLocked();
+    return compiled;
+}
+
+void XPathCache::SetCapacity(size_t capacity) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    capacity_ = capacity;
+    EvictLocked();
+}
+
+size_t XPathCache::GetCapacity() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return capacity_;
+}
+
+size_t XPathCache::Size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size();
+}
+
+void XPathCache::Clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.clear();
+    lru_.clear();
+}
+
+size_t XPathCache::GetHits() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return hits_;
+}
+
+size_t XPathCache::GetMisses() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return misses_;
+}
+
+void XPathCache::EvictLocked() {
+    while (entries_.size() > capacity_ && !lru_.empty()) {
+        entries_.erase(lru_.back());
+        lru_.pop_back();
+    }
+}
+
+} // namespace chromium_playwright::dom::xpath
@@ -0,0 +1,295 @@
+#include "chromium_playwright/logging/logger.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+namespace chromium_playwright::logging {
+
+namespace {
+
+constexpr size_t kRingMask = LogRing::kCapacity - 1;
+static_assert((LogRing::kCapacity & kRingMask) == 0, "ring capacity must be a power of two");
+
+constexpr auto kWriterInterval = std::chrono::milliseconds(20);
+
+const char* LevelName(LogLevel level) {
+    switch (level) {
+        case LogLevel::DEBUG: return "DEBUG";
+        case LogLevel::INFO:  return "INFO";
+        case LogLevel::WARN:  return "WARN";
+        case LogLevel::ERROR: return "ERROR";
+    }
+    return "?";
+}
+
+// Keeps the calling thread's ring registered while the thread lives
+struct ThreadRingHolder {
+    std::shared_ptr<LogRing> ring;
+
+    ~ThreadRingHolder() {
+        if (ring) ring->owner_exited.store(true, std::memory_order_release);
+    }
+};
+
+} // namespace
+
+LogRecord* LogRing::BeginWrite() {
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - head_.load(std::memory_order_acquire) >= kCapacity) return nullptr;
+    return &records_[tail & kRingMask];
+}
+
+void LogRing::CommitWrite() {
+    tail_.store(tail_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+bool LogRing::Read(LogRecord& record) {
+    const size_t head = head_.load(std::memory_order_relaxed);
+    if (head == tail_.load(std::memory_order_acquire)) return false;
+
+    const LogRecord& slot = records_[head & kRingMask];
+    record.timestamp_us = slot.timestamp_us;
+    record.component = slot.component;
+    record.format = slot.format;
+    record.level = slot.level;
+    record.arg_count = slot.arg_count;
+    record.payload_size = slot.payload_size;
+    record.truncated = slot.truncated;
+    std::memcpy(record.payload.data(), slot.payload.data(), slot.payload_size);
+
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+bool LogRing::Empty() const {
+    return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+}
+
+bool Logger::Encoder::Fits(size_t size) {
+    if (record->payload_size + size <= LogRecord::kPayloadSize) return true;
+    record->truncated = true;
+    return false;
+}
+
+void Logger::Encoder::Put(const void* data, size_t size) {
+    std::memcpy(record->payload.data() + record->payload_size, data, size);
+    record->payload_size = static_cast<uint16_t>(record->payload_size + size);
+}
+
+void Logger::Encoder::EncodeInt(int64_t value) {
+    if (!Fits(1 + sizeof(value))) return;
+    const auto tag = ArgTag::INT;
+    Put(&tag, 1);
+    Put(&value, sizeof(value));
+}
+
+void Logger::Encoder::EncodeUint(uint64_t value) {
+    if (!Fits(1 + sizeof(value))) return;
+    const auto tag = ArgTag::UINT;
+    Put(&tag, 1);
+    Put(&value, sizeof(value));
+}
+
+void Logger::Encoder::Encode(bool value) {
+    if (!Fits(2)) return;
+    const auto tag = ArgTag::BOOL;
+    const uint8_t byte = value ? 1 : 0;
+    Put(&tag, 1);
+    Put(&byte, 1);
+}
+
+void Logger::Encoder::Encode(double value) {
+    if (!Fits(1 + sizeof(value))) return;
+    const auto tag = ArgTag::DOUBLE;
+    Put(&tag, 1);
+    Put(&value, sizeof(value));
+}
+
+void Logger::Encoder::Encode(std::string_view value) {
+    if (!Fits(1 + sizeof(uint16_t))) return;
+
+    // Long strings keep their prefix rather than dropping the argument
+    const size_t room = LogRecord::kPayloadSize - record->payload_size - 1 - sizeof(uint16_t);
+    const auto length = static_cast<uint16_t>(std::min(value.size(), room));
+    if (length < value.size()) record->truncated = true;
+
+    const auto tag = ArgTag::STRING;
+    Put(&tag, 1);
+    Put(&length, sizeof(length));
+    Put(value.data(), length);
+}
+
+Logger& Logger::Instance() {
+    static Logger logger;
+    return logger;
+}
+
+Logger::Logger() {
+    sink_ = [](LogLevel level, std::string_view line) {
+        std::ostream& out = level == LogLevel::ERROR ? std::cerr : std::cout;
+        out << line << '\n';
+        if (level == LogLevel::ERROR) out.flush();
+    };
+    writer_ = std::thread([this] { WriterLoop(); });
+}
+
+Logger::~Logger() {
+    {
+        std::lock_guard<std::mutex> lock(writer_mutex_);
+        stopping_ = true;
+    }
+    writer_cv_.notify_all();
+    if (writer_.joinable()) writer_.join();
+    std::cout.flush();
+}
+
+LogRing* Logger::ThreadRing() {
+    thread_local ThreadRingHolder holder;
+    if (!holder.ring) {
+        holder.ring = std::make_shared<LogRing>();
+        std::lock_guard<std::mutex> lock(rings_mutex_);
+        rings_.push_back(holder.ring);
+    }
+    return holder.ring.get();
+}
+
+uint64_t Logger::NowMicros() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+}
+
+void Logger::SetSink(Sink sink) {
+    Flush();
+    std::lock_guard<std::mutex> lock(sink_mutex_);
+    sink_ = std::move(sink);
+}
+
+void Logger::Flush() {
+    std::unique_lock<std::mutex> lock(writer_mutex_);
+    if (stopping_) return;
+    const uint64_t ticket = ++flush_requests_;
+    writer_cv_.notify_all();
+    flushed_cv_.wait(lock, [&] { return flushes_done_ >= ticket || stopping_; });
+}
+
+void Logger::WriterLoop() {
+    std::unique_lock<std::mutex> lock(writer_mutex_);
+    while (true) {
+        writer_cv_.wait_for(lock, kWriterInterval, [&] { return stopping_ || flush_requests_ > flushes_done_; });
+        const bool stopping = stopping_;
+        const uint64_t requested = flush_requests_;
+
+        lock.unlock();
+        while (DrainOnce()) {}
+        lock.lock();
+
+        flushes_done_ = requested;
+        flushed_cv_.notify_all();
+        if (stopping) return;
+    }
+}
+
+bool Logger::DrainOnce() {
+    std::vector<std::shared_ptr<LogRing>> rings;
+    {
+        std::lock_guard<std::mutex> lock(rings_mutex_);
+        // Rings of exited threads are dropped once fully drained
+        rings_.erase(std::remove_if(rings_.begin(), rings_.end(),
+                                    [](const std::shared_ptr<LogRing>& ring) {
+                                        return ring->owner_exited.load(std::memory_order_acquire) && ring->Empty();
+                                    }),
+                     rings_.end());
+        rings = rings_;
+    }
+
+    std::vector<LogRecord> records;
+    LogRecord record;
+    for (const auto& ring : rings) {
+        while (ring->Read(record)) {
+            records.push_back(record);
+        }
+    }
+    if (records.empty()) return false;
+
+    // Interleave threads by capture time; per-thread order is preserved
+    std::stable_sort(records.begin(), records.end(),
+                     [](const LogRecord& a, const LogRecord& b) { return a.timestamp_us < b.timestamp_us; });
+
+    std::lock_guard<std::mutex> lock(sink_mutex_);
+    for (const auto& entry : records) {
+        if (sink_) sink_(entry.level, FormatRecord(entry));
+    }
+    return true;
+}
+
+std::string Logger::FormatRecord(const LogRecord& record) {
+    const uint64_t seconds_of_day = (record.timestamp_us / 1000000) % 86400;
+    char prefix[64];
+    std::snprintf(prefix, sizeof(prefix), "%02u:%02u:%02u.%06u [%s] [%s] ",
+                  static_cast<unsigned>(seconds_of_day / 3600), static_cast<unsigned>(seconds_of_day / 60 % 60),
+                  static_cast<unsigned>(seconds_of_day % 60), static_cast<unsigned>(record.timestamp_us % 1000000),
+                  LevelName(record.level), record.component ? record.component : "");
+
+    std::string line = prefix;
+    const uint8_t* data = record.payload.data();
+    size_t offset = 0;
+
+    auto append_next_arg = [&]() {
+        if (offset >= record.payload_size) {
+            line += "{?}";  // Argument did not fit in the record
+            return;
+        }
+        const auto tag = static_cast<ArgTag>(data[offset++]);
+        switch (tag) {
+            case ArgTag::INT: {
+                int64_t value;
+                std::memcpy(&value, data + offset, sizeof(value));
+                offset += sizeof(value);
+                line += std::to_string(value);
+                break;
+            }
+            case ArgTag::UINT: {
+                uint64_t value;
+                std::memcpy(&value, data + offset, sizeof(value));
+                offset += sizeof(value);
+                line += std::to_string(value);
+                break;
+            }
+            case ArgTag::DOUBLE: {
+                double value;
+                std::memcpy(&value, data + offset, sizeof(value));
+                offset += sizeof(value);
+                char buffer[32];
+                std::snprintf(buffer, sizeof(buffer), "%g", value);
+                line += buffer;
+                break;
+            }
+            case ArgTag::BOOL:
+                line += data[offset++] ? "true" : "false";
+                break;
+            case ArgTag::STRING: {
+                uint16_t length;
+                std::memcpy(&length, data + offset, sizeof(length));
+                offset += sizeof(length);
+                line.append(reinterpret_cast<const char*>(data + offset), length);
+                offset += length;
+                break;
+            }
+        }
+    };
+
+    for (const char* p = record.format ? record.format : ""; *p; ++p) {
+        if (p[0] == '{' && p[1] == '}') {
+            append_next_arg();
+            ++p;
+        } else {
+            line += *p;
+        }
+    }
+    if (record.truncated) line += " [truncated]";
+    return line;
+}
+
+} // namespace chromium_playwright::logging
@@ -1,5 +1,5 @@
 #include "chromium_playwright/network/http_client.h"
-#include <iostream>
+#include "chromium_playwright/logging/logger.h"
 #include <sstream>
 
 namespace chromium_playwright::network {
@@ -18,7 +18,7 @@ public:
         response.headers["Content-Length"] = std::to_string(response.body.length());
         response.response_time_ms = 100.0;
         
-        std::cout << "   📡 GET " << url << " -> " << response.status_code << std::endl;
+        CP_LOG_INFO("network", "GET {} -> {}", url, response.status_code);
         
         return response;
     }
@@ -34,7 +34,7 @@ public:
         response.headers["Content-Length"] = std::to_string(response.body.length());
         response.response_time_ms = 150.0;
         
-        std::cout << "   📡 POST " << url << " -> " << response.status_code << std::endl;
+        CP_LOG_INFO("network", "POST {} -> {}", url, response.status_code);
         
         return response;
     }
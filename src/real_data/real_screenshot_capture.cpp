@@ -1,34 +1,144 @@
 #include "real_screenshot_capture.h"
-#include <iostream>
+#include "chromium_playwright/logging/logger.h"
+#include "chromium_playwright/crawl/crawl_engine.h"
+#include "chromium_playwright/crawl/discovery.h"
+#include "chromium_playwright/crawl/near_duplicate.h"
+#include "chromium_playwright/crawl/pipeline.h"
+#include "chromium_playwright/crawl/recrawl_scheduler.h"
+#include "chromium_playwright/crawl/result_stream.h"
+#include "chromium_playwright/crawl/robots.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
 #include <fstream>
 #include <sstream>
+#include <set>
 #include <string>
+#include <string_view>
 #include <vector>
+#include <functional>
 #include <memory>
 #include <chrono>
 #include <thread>
+#include <mutex>
 #include <filesystem>
 
 #ifdef _WIN32
 #include <windows.h>
 #include <wingdi.h>
 #include <winuser.h>
+#include <shellapi.h>
 #else
 #include <X11/Xlib.h>
 #include <X11/Xutil.h>
+#include <cerrno>
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
 #endif
 
 namespace chromium_playwright::real_data {
 
+namespace {
+
+// Runs argv[0] with exactly these arguments and no shell in between, so
+// quotes or metacharacters in a crawled URL stay plain data. Stdout goes
+// to `sink` until it returns false; returns the exit status, or -1 if the
+// program could not be run.
+int RunProgram(const std::vector<std::string>& argv, const std::function<bool(std::string_view)>& sink) {
+    char buffer[16 * 1024];
+    
+#ifdef _WIN32
+    // _popen always goes through cmd.exe, so anything it could read as
+    // syntax is refused rather than quoted
+    std::string command;
+    for (const auto& arg : argv) {
+        const bool unsafe = std::any_of(arg.begin(), arg.end(), [](unsigned char c) {
+            return c < 0x20 || std::string_view("\"%^&|<>!").find(static_cast<char>(c)) != std::string_view::npos;
+        });
+        if (unsafe) {
+            CP_LOG_WARN("real_data", "Refusing to pass shell metacharacters to {}", argv.front());
+            return -1;
+        }
+        command += (command.empty() ? "\"" : " \"") + arg + "\"";
+    }
+    FILE* pipe = _popen(command.c_str(), "rb");
+    if (!pipe) {
+        return -1;
+    }
+    size_t read = 0;
+    while ((read = fread(buffer, 1, sizeof(buffer), pipe)) > 0) {
+        if (!sink(std::string_view(buffer, read))) {
+            break;
+        }
+    }
+    return _pclose(pipe);
+#else
+    std::vector<char*> args;
+    for (const auto& arg : argv) {
+        args.push_back(const_cast<char*>(arg.c_str()));
+    }
+    args.push_back(nullptr);
+    
+    int fds[2];
+    if (pipe(fds) != 0) {
+        return -1;
+    }
+    // Other workers spawn concurrently; a child of theirs holding our
+    // write end would keep this read from ever seeing EOF
+    fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+    fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+    
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, fds[1], STDOUT_FILENO);
+    posix_spawn_file_actions_addopen(&actions, STDERR_FILENO, "/dev/null", O_WRONLY, 0);
+    pid_t pid = 0;
+    const int spawned = posix_spawnp(&pid, args[0], &actions, nullptr, args.data(), environ);
+    posix_spawn_file_actions_destroy(&actions);
+    close(fds[1]);
+    if (spawned != 0) {
+        close(fds[0]);
+        return -1;
+    }
+    
+    while (true) {
+        const ssize_t read_bytes = read(fds[0], buffer, sizeof(buffer));
+        if (read_bytes < 0 && errno == EINTR) {
+            continue;
+        }
+        if (read_bytes <= 0 || !sink(std::string_view(buffer, static_cast<size_t>(read_bytes)))) {
+            break;
+        }
+    }
+    // Stopping early closes the pipe under the child, which then exits
+    close(fds[0]);
+    
+    int status = 0;
+    while (waitpid(pid, &status, 0) < 0) {
+        if (errno != EINTR) {
+            return -1;
+        }
+    }
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+#endif
+}
+
+
+} // namespace
+
 // Real Screenshot Capture Implementation
 class RealScreenshotCapture : public ScreenshotCapture {
 public:
     RealScreenshotCapture() {
-        std::cout << "🔧 Initializing Real Screenshot Capture..." << std::endl;
+        CP_LOG_INFO("real_data", "Initializing Real Screenshot Capture...");
     }
 
     ScreenshotResult CapturePage(const std::string& url, const ScreenshotOptions& options = {}) override {
-        std::cout << "📸 Capturing real screenshot of: " << url << std::endl;
+        CP_LOG_INFO("real_data", "Capturing real screenshot of: {}", url);
         
         ScreenshotResult result;
         result.success = false;
@@ -68,20 +178,18 @@ public:
             result.metadata.height = GetScreenHeight();
             result.metadata.format = StringToImageFormat(options.type);
             
-            std::cout << "✅ Real screenshot captured successfully!" << std::endl;
-            std::cout << "   File: " << result.file_path << std::endl;
-            std::cout << "   Size: " << result.image_data.size() << " bytes" << std::endl;
+            CP_LOG_INFO("real_data", "Real screenshot captured: {} ({} bytes)", result.file_path, result.image_data.size());
             
         } catch (const std::exception& e) {
             result.error_message = "Exception: " + std::string(e.what());
-            std::cout << "❌ Error: " << result.error_message << std::endl;
+            CP_LOG_ERROR("real_data", "Error: {}", result.error_message);
         }
         
         return result;
     }
 
     ScreenshotResult CaptureElement(const std::string& url, const std::string& selector, const ScreenshotOptions& options = {}) override {
-        std::cout << "📸 Capturing real element screenshot: " << selector << " from " << url << std::endl;
+        CP_LOG_INFO("real_data", "Capturing real element screenshot: {} from {}", selector, url);
         
         ScreenshotResult result;
         result.success = false;
@@ -101,13 +209,11 @@ public:
             // Simulate element-specific metadata
             result.metadata.clip_region = {100, 100, 400, 300}; // x, y, width, height
             
-            std::cout << "✅ Real element screenshot captured!" << std::endl;
-            std::cout << "   Element: " << selector << std::endl;
-            std::cout << "   File: " << result.file_path << std::endl;
+            CP_LOG_INFO("real_data", "Real element screenshot captured: {} -> {}", selector, result.file_path);
             
         } catch (const std::exception& e) {
             result.error_message = "Exception: " + std::string(e.what());
-            std::cout << "❌ Error: " << result.error_message << std::endl;
+            CP_LOG_ERROR("real_data", "Error: {}", result.error_message);
         }
         
         return result;
@@ -115,30 +221,32 @@ public:
 
 private:
     bool LaunchBrowser(const std::string& url) {
-        std::cout << "🌐 Launching browser for: " << url << std::endl;
+        CP_LOG_INFO("real_data", "Launching browser for: {}", url);
         
-        // Use system command to launch browser
-        std::string command;
+        // Anything else could name a local file or program for the opener to run
+        if (url.rfind("http://", 0) != 0 && url.rfind("https://", 0) != 0) {
+            CP_LOG_ERROR("real_data", "Refusing to open non-HTTP URL: {}", url);
+            return false;
+        }
         
 #ifdef _WIN32
-        command = "start \"\" \"" + url + "\"";
+        const bool launched =
+            reinterpret_cast<INT_PTR>(ShellExecuteA(nullptr, "open", url.c_str(), nullptr, nullptr, SW_SHOWNORMAL)) > 32;
 #else
-        command = "xdg-open \"" + url + "\"";
+        const bool launched = RunProgram({"xdg-open", url}, [](std::string_view) { return true; }) == 0;
 #endif
         
-        int result = std::system(command.c_str());
-        
-        if (result == 0) {
-            std::cout << "✅ Browser launched successfully" << std::endl;
+        if (launched) {
+            CP_LOG_INFO("real_data", "Browser launched successfully");
             return true;
         } else {
-            std::cout << "❌ Failed to launch browser" << std::endl;
+            CP_LOG_ERROR("real_data", "Failed to launch browser");
             return false;
         }
     }
     
     std::vector<uint8_t> CaptureScreen() {
-        std::cout << "📷 Capturing screen..." << std::endl;
+        CP_LOG_INFO("real_data", "Capturing screen...");
         
         std::vector<uint8_t> image_data;
         
@@ -181,7 +289,7 @@ private:
         XCloseDisplay(display);
 #endif
         
-        std::cout << "📷 Screen captured: " << image_data.size() << " bytes" << std::endl;
+        CP_LOG_INFO("real_data", "Screen captured: {} bytes", image_data.size());
         return image_data;
     }
     
@@ -196,9 +304,9 @@ private:
         if (file.is_open()) {
             file.write(reinterpret_cast<const char*>(data.data()), data.size());
             file.close();
-            std::cout << "💾 Saved to: " << file_path << std::endl;
+            CP_LOG_INFO("real_data", "Saved to: {}", file_path);
         } else {
-            std::cout << "❌ Failed to save file: " << file_path << std::endl;
+            CP_LOG_ERROR("real_data", "Failed to save file: {}", file_path);
         }
     }
     
@@ -284,126 +392,278 @@ private:
 };
 
 // Real Web Scraping Implementation
-class RealWebScraper {
+class RealWebScraperImpl : public RealWebScraper {
 public:
-    struct ScrapingResult {
-        std::string url;
-        std::string title;
-        std::string content;
-        std::vector<std::string> links;
-        std::map<std::string, std::string> metadata;
-        std::string screenshot_path;
-        bool success = false;
-        std::string error_message;
-    };
+    explicit RealWebScraperImpl(size_t worker_count = 0) : worker_count_(worker_count) {}
     
-    std::vector<ScrapingResult> ScrapeWebsite(const std::string& start_url, int max_depth = 3) {
-        std::cout << "🤖 Starting real web scraping..." << std::endl;
-        std::cout << "   Start URL: " << start_url << std::endl;
-        std::cout << "   Max Depth: " << max_depth << std::endl;
-        
+    std::vector<ScrapingResult> ScrapeWebsite(const std::string& start_url, int max_depth = 3) override {
+        std::vector<ScrapingResult> results;
+        Crawl({start_url}, max_depth, [&](ScrapingResult& page) {
+            results.push_back(std::move(page));
+            return true;
+        });
+        return results;
+    }
+    
+    // Hands each page to `stream` once stored instead of collecting them
+    // all; the crawl pauses while the consumer is behind and stops if it
+    // cancels. Finishes the stream and returns the pages crawled.
+    size_t StreamWebsite(const std::string& start_url, int max_depth,
+                         crawl::ResultStream<ScrapingResult>& stream) override {
+        size_t pages = Crawl({start_url}, max_depth, [&](ScrapingResult& page) {
+            return stream.Publish(std::move(page));
+        });
+        stream.Finish();
+        CP_LOG_INFO("real_data", "Streamed {} results, producer stalled {} times", stream.GetPublishedCount(),
+                    stream.GetStallCount());
+        return pages;
+    }
+    
+    void SetDiscoverySettings(const std::map<std::string, std::string>& custom_settings) override {
+        std::lock_guard<std::mutex> lock(settings_mutex_);
+        discovery_ = crawl::ParseDiscoverySettings(custom_settings);
+    }
+    
+    void SetRecrawlScheduler(std::shared_ptr<crawl::RecrawlScheduler> scheduler) override {
+        std::lock_guard<std::mutex> lock(settings_mutex_);
+        scheduler_ = std::move(scheduler);
+    }
+    
+    std::vector<ScrapingResult> Recrawl(size_t budget) override {
         std::vector<ScrapingResult> results;
-        std::vector<std::string> urls_to_visit = {start_url};
-        std::set<std::string> visited_urls;
+        std::vector<std::string> due;
+        {
+            std::lock_guard<std::mutex> lock(settings_mutex_);
+            if (scheduler_) due = scheduler_->Schedule(budget);
+        }
+        if (due.empty()) {
+            CP_LOG_INFO("real_data", "Recrawl: no recorded pages are due");
+            return results;
+        }
         
-        for (int depth = 0; depth < max_depth && !urls_to_visit.empty(); ++depth) {
-            std::vector<std::string> next_level_urls;
-            
-            for (const auto& url : urls_to_visit) {
-                if (visited_urls.find(url) != visited_urls.end()) {
-                    continue;
-                }
-                
-                visited_urls.insert(url);
-                
-                std::cout << "🔍 Scraping: " << url << " (depth " << depth << ")" << std::endl;
-                
-                auto result = ScrapePage(url);
-                if (result.success) {
-                    results.push_back(result);
-                    
-                    // Add new links for next depth level
-                    for (const auto& link : result.links) {
-                        if (visited_urls.find(link) == visited_urls.end()) {
-                            next_level_urls.push_back(link);
-                        }
+        // Depth 1 fetches the scheduled pages themselves and nothing they link to
+        Crawl(due, 1, [&](ScrapingResult& page) {
+            results.push_back(std::move(page));
+            return true;
+        });
+        return results;
+    }
+    
+private:
+    // CapturePage opens a browser window and grabs the whole screen, so two
+    // captures at once would photograph each other's pages
+    static constexpr size_t kCaptureThreads = 1;
+    
+    // Runs the crawl, passing each finished page to `store` on the single
+    // store thread; a false return stops the crawl
+    size_t Crawl(const std::vector<std::string>& seeds, int max_depth,
+                 const std::function<bool(ScrapingResult&)>& store) {
+        CP_LOG_INFO("real_data", "Starting real web scraping: {} ({} seeds, max depth {})",
+                    seeds.empty() ? "" : seeds.front(), seeds.size(), max_depth);
+        
+        std::shared_ptr<crawl::RecrawlScheduler> scheduler;
+        crawl::DiscoveryOptions discovery;
+        {
+            std::lock_guard<std::mutex> lock(settings_mutex_);
+            scheduler = scheduler_;
+            discovery = discovery_;
+        }
+        
+        crawl::CrawlOptions options;
+        options.worker_count = worker_count_;
+        options.max_depth = max_depth;
+        // One queue per host so no single site starves the rest
+        options.frontier_policy = crawl::FrontierPolicy::HOST_PRIORITY;
+        options.politeness_delay = std::chrono::milliseconds(500);
+        // Link-dense sites queue far faster than a polite crawl drains them
+        options.frontier_memory_limit = 100000;
+        // Calendars, facets and session ids would otherwise eat the depth budget
+        options.detect_traps = true;
+        crawl::CrawlEngine engine(options);
+        
+        std::shared_ptr<crawl::RobotsCache> robots;
+        if (discovery.respect_robots) {
+            robots = std::make_shared<crawl::RobotsCache>(
+                [this](const std::string& url, std::string& body) {
+                    // RFC 9309 tells 4xx from 5xx, so the status code is
+                    // appended to the body rather than failing with -f
+                    body = ExecuteCommand({"curl", "-s", "-L", "--max-redirs", "5", "--max-time", "30", "-w",
+                                           "\n%{http_code}", "--url", url});
+                    const size_t status_start = body.rfind('\n');
+                    if (status_start == std::string::npos) {
+                        body.clear();
+                        return crawl::RobotsFetchStatus::UNREACHABLE;
                     }
-                }
+                    const int status_code = std::atoi(body.c_str() + status_start + 1);
+                    body.resize(status_start);
+                    return crawl::RobotsFetchStatusForHttp(status_code);
+                },
+                discovery.user_agent);
+            engine.SetRobotsCache(robots);
+        }
+        
+        // Depth 1 only refetches known pages, so nothing new is discovered
+        std::vector<std::string> crawl_seeds = seeds;
+        if (discovery.use_sitemaps && max_depth > 1) {
+            AddSitemapSeeds(seeds, discovery, robots.get(), crawl_seeds);
+        }
+        
+        engine.SetProgressCallback([](const crawl::CrawlProgress& progress) {
+            CP_LOG_INFO("real_data", "Worker {} finished {} ({} pages done, {} queued)", progress.worker,
+                        progress.task->url, progress.total_pages, progress.queued);
+        });
+        
+        // Crawl workers fetch and parse links, which the frontier needs at
+        // once; the rest runs in its own stages so a slow screenshot never
+        // holds up fetching. Bounded queues push back on the crawl workers
+        // if the later stages, or the consumer behind `store`, fall behind.
+        size_t stored = 0;
+        crawl::Pipeline<ScrapingResult> pipeline;
+        pipeline.AddStage({"extract", 2, 64}, [this](ScrapingResult& page) {
+            page.title = ExtractTitle(page.content);
+            page.metadata = ExtractMetadata(page.content);
+            return true;
+        });
+        pipeline.AddStage({"capture", kCaptureThreads, 16}, [this](ScrapingResult& page) {
+            auto screenshot_result = screenshot_capture_.CapturePage(page.url);
+            if (screenshot_result.success) {
+                page.screenshot_path = screenshot_result.file_path;
+            }
+            return true;
+        });
+        pipeline.AddStage({"store", 1, 64}, [&](ScrapingResult& page) {
+            CP_LOG_INFO("real_data", "Page scraped: \"{}\" ({} links, screenshot {})", page.title, page.links.size(),
+                        page.screenshot_path);
+            if (!store(page)) {
+                engine.Stop();
+                return false;
+            }
+            ++stored;
+            return true;
+        });
+        pipeline.Start();
+        
+        crawl::NearDuplicateIndex near_duplicates;
+        engine.Run(crawl_seeds, [&](const crawl::CrawlTask& task, size_t) {
+            CP_LOG_INFO("real_data", "Scraping: {} (depth {})", task.url, task.depth);
+            
+            auto result = FetchPage(task.url);
+            if (!result.success) {
+                return std::vector<std::string>{};
+            }
+            
+            const std::string text = ExtractText(result.content);
+            if (scheduler && scheduler->RecordContent(task.url, text)) {
+                CP_LOG_DEBUG("real_data", "Changed since last visit: {}", task.url);
+            }
+            
+            // Mirrors and session- or tracking-tagged copies of a page already
+            // seen are neither stored nor expanded. Pages with no text give
+            // no verdict either way.
+            const uint64_t fingerprint = crawl::SimHash(text);
+            auto original = near_duplicates.InsertOrFind(task.url, fingerprint);
+            if (fingerprint != 0) engine.RecordContentNovelty(task, !original);
+            if (original) {
+                CP_LOG_DEBUG("real_data", "Skipping {}: near-duplicate of {}", task.url, *original);
+                return std::vector<std::string>{};
             }
             
-            urls_to_visit = next_level_urls;
+            // Links feed the frontier; the engine dedupes and tracks depth
+            std::vector<std::string> links = result.links;
+            pipeline.Submit(std::move(result));
+            return links;
+        });
+        
+        pipeline.Finish();
+        crawl::LogStageMetrics(pipeline.GetMetrics());
+        CP_LOG_INFO("real_data", "Scraping completed: {} pages, {} distinct", stored, near_duplicates.Size());
+        return stored;
+    }
+    
+    // Sitemaps listed in each seed origin's robots.txt, else /sitemap.xml
+    void AddSitemapSeeds(const std::vector<std::string>& seeds, const crawl::DiscoveryOptions& discovery,
+                         crawl::RobotsCache* robots, std::vector<std::string>& crawl_seeds) {
+        std::vector<std::string> sitemaps;
+        std::set<std::string> origins;
+        for (const auto& seed : seeds) {
+            const std::string origin = crawl::UrlOrigin(seed);
+            if (origin.empty() || !origins.insert(origin).second) continue;
+            
+            auto rules = robots ? robots->GetRules(seed) : nullptr;
+            if (rules && !rules->GetSitemaps().empty()) {
+                sitemaps.insert(sitemaps.end(), rules->GetSitemaps().begin(), rules->GetSitemaps().end());
+            } else {
+                sitemaps.push_back(origin + "/sitemap.xml");
+            }
         }
         
-        std::cout << "✅ Scraping completed!" << std::endl;
-        std::cout << "   Pages scraped: " << results.size() << std::endl;
-        
-        return results;
+        const size_t added = crawl::CollectSitemapUrls(
+            sitemaps,
+            [this](const std::string& url, const std::function<bool(std::string_view)>& sink) {
+                return StreamCommand(CurlCommand(url, true), sink);
+            },
+            discovery.sitemap_max_urls, [&](const crawl::SitemapEntry& entry) { crawl_seeds.push_back(entry.url); });
+        CP_LOG_INFO("real_data", "Seeded {} URLs from {} sitemaps", added, sitemaps.size());
     }
     
-private:
-    ScrapingResult ScrapePage(const std::string& url) {
+    // Fetch and link-parse stage; extraction and capture happen later
+    ScrapingResult FetchPage(const std::string& url) {
         ScrapingResult result;
         result.url = url;
         
         try {
             // Use curl to fetch page content
-            std::string command = "curl -s -L \"" + url + "\"";
-            std::string content = ExecuteCommand(command);
+            std::string content = ExecuteCommand(CurlCommand(url, false));
             
             if (content.empty()) {
                 result.error_message = "Failed to fetch page content";
                 return result;
             }
             
-            // Extract title
-            result.title = ExtractTitle(content);
-            
-            // Extract links
             result.links = ExtractLinks(content, url);
-            
-            // Extract metadata
-            result.metadata = ExtractMetadata(content);
-            
-            // Take screenshot
-            RealScreenshotCapture screenshot_capture;
-            auto screenshot_result = screenshot_capture.CapturePage(url);
-            if (screenshot_result.success) {
-                result.screenshot_path = screenshot_result.file_path;
-            }
-            
+            result.content = std::move(content);
             result.success = true;
-            result.content = content;
-            
-            std::cout << "   ✅ Page scraped successfully" << std::endl;
-            std::cout << "   Title: " << result.title << std::endl;
-            std::cout << "   Links found: " << result.links.size() << std::endl;
-            std::cout << "   Screenshot: " << result.screenshot_path << std::endl;
             
         } catch (const std::exception& e) {
             result.error_message = "Exception: " + std::string(e.what());
-            std::cout << "   ❌ Error: " << result.error_message << std::endl;
+            CP_LOG_ERROR("real_data", "Error: {}", result.error_message);
         }
         
         return result;
     }
     
-    std::string ExecuteCommand(const std::string& command) {
-        std::string result;
-        char buffer[128];
-        
-        FILE* pipe = popen(command.c_str(), "r");
-        if (!pipe) {
-            return "";
-        }
-        
-        while (fgets(buffer, sizeof(buffer), pipe) != nullptr) {
-            result += buffer;
+    // `--url` keeps a URL starting with '-' from being read as an option;
+    // `fail` makes HTTP errors produce no output instead of an error page
+    static std::vector<std::string> CurlCommand(const std::string& url, bool fail) {
+        std::vector<std::string> argv = {"curl", "-s", "-L"};
+        if (fail) {
+            argv.push_back("-f");
         }
-        
-        pclose(pipe);
+        argv.push_back("--url");
+        argv.push_back(url);
+        return argv;
+    }
+    
+    std::string ExecuteCommand(const std::vector<std::string>& argv) {
+        std::string result;
+        RunProgram(argv, [&](std::string_view chunk) {
+            result.append(chunk);
+            return true;
+        });
         return result;
     }
     
+    // Hands the command's output to `sink` as it arrives instead of
+    // collecting it; false if there was none
+    bool StreamCommand(const std::vector<std::string>& argv, const std::function<bool(std::string_view)>& sink) {
+        bool received = false;
+        RunProgram(argv, [&](std::string_view chunk) {
+            received = true;
+            return sink(chunk);
+        });
+        return received;
+    }
+    
     std::string ExtractTitle(const std::string& html) {
         size_t start = html.find("<title>");
         if (start == std::string::npos) {
@@ -419,6 +679,40 @@ private:
         return html.substr(start, end - start);
     }
     
+    // Markup, scripts and styles dropped so near-duplicate checks compare
+    // what the page says
+    std::string ExtractText(const std::string& html) {
+        std::string lower = html;
+        std::transform(lower.begin(), lower.end(), lower.begin(),
+                       [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+        std::string text;
+        text.reserve(html.size());
+        size_t pos = 0;
+        while (pos < html.size()) {
+            const size_t open = html.find('<', pos);
+            text.append(html, pos, (open == std::string::npos ? html.size() : open) - pos);
+            if (open == std::string::npos) break;
+            text += ' ';
+
+            const size_t close = html.find('>', open);
+            if (close == std::string::npos) break;
+            pos = close + 1;
+
+            for (const char* element : {"script", "style"}) {
+                const std::string name(element);
+                const bool opens = lower.compare(open + 1, name.size(), name) == 0 &&
+                                   !std::isalnum(static_cast<unsigned char>(lower[open + 1 + name.size()]));
+                if (opens) {
+                    const size_t end = lower.find("</" + name, pos);
+                    pos = end == std::string::npos ? html.size() : end;
+                    break;
+                }
+            }
+        }
+        return text;
+    }
+    
     std::vector<std::string> ExtractLinks(const std::string& html, const std::string& base_url) {
         std::vector<std::string> links;
         
@@ -488,6 +782,12 @@ private:
         
         return metadata;
     }
+    
+    size_t worker_count_;
+    RealScreenshotCapture screenshot_capture_;
+    std::mutex settings_mutex_;
+    std::shared_ptr<crawl::RecrawlScheduler> scheduler_;
+    crawl::DiscoveryOptions discovery_;
 };
 
 // Factory functions
@@ -495,8 +795,8 @@ std::unique_ptr<ScreenshotCapture> CreateRealScreenshotCapture() {
     return std::make_unique<RealScreenshotCapture>();
 }
 
-std::unique_ptr<RealWebScraper> CreateRealWebScraper() {
-    return std::make_unique<RealWebScraper>();
+std::unique_ptr<RealWebScraper> CreateRealWebScraper(size_t worker_count) {
+    return std::make_unique<RealWebScraperImpl>(worker_count);
 }
 
 } // namespace chromium_playwright::real_data
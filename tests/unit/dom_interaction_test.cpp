@@ -0,0 +1,553 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <atomic>
+#include <chrono>
+#include <sstream>
+#include <thread>
+#include "chromium_playwright/dom/blink_dom_agent.h"
+#include "chromium_playwright/dom/dom_tree.h"
+#include "chromium_playwright/dom/xpath_evaluator.h"
+#include "chromium_playwright/dom/text_index.h"
+#include "chromium_playwright/dom/dom_events.h"
+#include "chromium_playwright/dom/html_serializer.h"
+
+using namespace chromium_playwright::dom;
+using namespace testing;
+
+class DOMInteractionTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        // html > (head, body > (h1, div#list > (span, div > span), span))
+        NodeIndex html = tree_.CreateNode("html", "html");
+        NodeIndex head = tree_.CreateNode("head", "head");
+        NodeIndex body = tree_.CreateNode("body", "body");
+        NodeIndex h1 = tree_.CreateNode("h1", "h1", "Welcome");
+        NodeIndex list = tree_.CreateNode("list", "div");
+        NodeIndex first = tree_.CreateNode("first", "span", "one");
+        NodeIndex inner = tree_.CreateNode("inner", "div");
+        NodeIndex nested = tree_.CreateNode("nested", "span", "two");
+        NodeIndex last = tree_.CreateNode("last", "span", "three");
+
+        tree_.AppendChild(html, head);
+        tree_.AppendChild(html, body);
+        tree_.AppendChild(body, h1);
+        tree_.AppendChild(body, list);
+        tree_.AppendChild(list, first);
+        tree_.AppendChild(list, inner);
+        tree_.AppendChild(inner, nested);
+        tree_.AppendChild(list, last);
+
+        tree_.SetAttribute(list, "id", "items");
+        tree_.SetAttribute(nested, "class", "item highlighted");
+        tree_.SetAttribute(last, "data-count", "7");
+    }
+
+    std::vector<std::string> Ids(const std::vector<NodeIndex>& nodes) {
+        std::vector<std::string> ids;
+        for (NodeIndex node : nodes) {
+            ids.push_back(tree_.GetNode(node)->id);
+        }
+        return ids;
+    }
+
+    std::vector<std::string> Select(const std::string& expression) {
+        auto compiled = cache_.Get(expression);
+        return compiled ? Ids(compiled->Evaluate(tree_)) : std::vector<std::string>{};
+    }
+
+    DOMTree tree_;
+    xpath::XPathCache cache_;
+};
+
+TEST_F(DOMInteractionTest, XPathChildAndDescendantAxes) {
+    EXPECT_THAT(Select("/html/body/h1"), ElementsAre("h1"));
+    EXPECT_THAT(Select("//span"), ElementsAre("first", "nested", "last"));
+    EXPECT_THAT(Select("//div//span"), ElementsAre("first", "nested", "last"));
+    EXPECT_THAT(Select("//div[@id='items']/span"), ElementsAre("first", "last"));
+}
+
+TEST_F(DOMInteractionTest, XPathParentAndAttributeAxes) {
+    EXPECT_THAT(Select("//span/.."), ElementsAre("list", "inner"));
+    EXPECT_THAT(Select("//span[@class]"), ElementsAre("nested"));
+    EXPECT_THAT(Select("//*[contains(@class, 'highlighted')]/parent::div"), ElementsAre("inner"));
+    EXPECT_THAT(Select("//span[@data-count > 5]"), ElementsAre("last"));
+}
+
+TEST_F(DOMInteractionTest, XPathPositionalPredicates) {
+    EXPECT_THAT(Select("//span[1]"), ElementsAre("first", "nested"));
+    EXPECT_THAT(Select("(//span)[2]"), ElementsAre("nested"));
+    EXPECT_THAT(Select("//div[@id='items']/span[last()]"), ElementsAre("last"));
+}
+
+TEST_F(DOMInteractionTest, XPathTextAndStringResults) {
+    EXPECT_THAT(Select("//span[text()='two']"), ElementsAre("nested"));
+
+    auto count = cache_.Get("count(//span)");
+    ASSERT_NE(count, nullptr);
+    EXPECT_THAT(count->EvaluateStrings(tree_), ElementsAre("3"));
+
+    auto classes = cache_.Get("//span/@class");
+    ASSERT_NE(classes, nullptr);
+    EXPECT_THAT(classes->EvaluateStrings(tree_), ElementsAre("item highlighted"));
+}
+
+TEST_F(DOMInteractionTest, XPathInvalidExpression) {
+    std::string error;
+    EXPECT_EQ(xpath::CompiledXPath::Compile("//span[", &error), nullptr);
+    EXPECT_FALSE(error.empty());
+    EXPECT_EQ(cache_.Get("unknown-function()"), nullptr);
+}
+
+TEST_F(DOMInteractionTest, XPathCacheReusesCompiledExpressions) {
+    auto first = cache_.Get("//span");
+    auto second = cache_.Get("//span");
+
+    EXPECT_EQ(first, second);
+    EXPECT_EQ(cache_.GetMisses(), 1u);
+    EXPECT_EQ(cache_.GetHits(), 1u);
+
+    cache_.SetCapacity(0);
+    EXPECT_EQ(cache_.Size(), 0u);
+}
+
+TEST_F(DOMInteractionTest, AttributeIndexLookups) {
+    EXPECT_THAT(Ids(tree_.FindByAttribute(IndexedAttribute::TAG, "SPAN")), ElementsAre("first", "nested", "last"));
+    EXPECT_THAT(Ids(tree_.FindByAttribute(IndexedAttribute::ID, "items")), ElementsAre("list"));
+    EXPECT_THAT(Ids(tree_.FindByAttribute(IndexedAttribute::CLASS, "highlighted")), ElementsAre("nested"));
+    EXPECT_THAT(Ids(tree_.FindByAttribute(IndexedAttribute::ROLE, "heading")), ElementsAre("h1"));
+    EXPECT_TRUE(tree_.FindByAttribute(IndexedAttribute::TEST_ID, "missing").empty());
+}
+
+TEST_F(DOMInteractionTest, AttributeIndexFollowsMutations) {
+    NodeIndex nested = tree_.FindById("nested");
+    tree_.SetAttribute(nested, "data-testid", "row");
+    tree_.SetAttribute(nested, "class", "item");
+    EXPECT_THAT(Ids(tree_.FindByAttribute(IndexedAttribute::TEST_ID, "row")), ElementsAre("nested"));
+    EXPECT_TRUE(tree_.FindByAttribute(IndexedAttribute::CLASS, "highlighted").empty());
+
+    tree_.SetAttribute(nested, "role", "button");
+    EXPECT_THAT(Ids(tree_.FindByAttribute(IndexedAttribute::ROLE, "button")), ElementsAre("nested"));
+    tree_.RemoveAttribute(nested, "role");
+    EXPECT_TRUE(tree_.FindByAttribute(IndexedAttribute::ROLE, "button").empty());
+
+    tree_.Detach(tree_.FindById("inner"));
+    EXPECT_TRUE(tree_.FindByAttribute(IndexedAttribute::TEST_ID, "row").empty());
+}
+
+TEST_F(DOMInteractionTest, TextIndexMatchModes) {
+    TextIndex index;
+    EXPECT_THAT(Ids(index.Find(tree_, "two")), ElementsAre("nested"));
+    EXPECT_TRUE(index.IsBuilt());
+
+    EXPECT_THAT(Ids(index.Find(tree_, "o")), ElementsAre("h1", "first", "nested"));
+    EXPECT_TRUE(index.Find(tree_, "WELCOME").empty());
+    EXPECT_THAT(Ids(index.Find(tree_, "WELCOME", {false, true})), ElementsAre("h1"));
+
+    EXPECT_TRUE(index.Find(tree_, "Welc", {true, false}).empty());
+    EXPECT_THAT(Ids(index.Find(tree_, "  Welcome ", {true, false})), ElementsAre("h1"));
+    EXPECT_THAT(Ids(index.Find(tree_, "welcome", {true, true})), ElementsAre("h1"));
+}
+
+TEST_F(DOMInteractionTest, TextIndexFollowsMutations) {
+    TextIndex index;
+    NodeIndex first = tree_.FindById("first");
+    EXPECT_THAT(Ids(index.Find(tree_, "one")), ElementsAre("first"));
+
+    tree_.SetTextContent(first, "Sign   in\n now");
+    EXPECT_TRUE(index.Find(tree_, "one").empty());
+    EXPECT_THAT(Ids(index.Find(tree_, "sign in", {false, true})), ElementsAre("first"));
+
+    tree_.Detach(tree_.FindById("list"));
+    EXPECT_TRUE(index.Find(tree_, "Sign in").empty());
+}
+
+TEST_F(DOMInteractionTest, SpatialIndexQueries) {
+    tree_.SetBoundingBox(tree_.FindById("body"), {0, 0, 1280, 20000});
+    tree_.SetBoundingBox(tree_.FindById("h1"), {10, 10, 300, 40});
+    tree_.SetBoundingBox(tree_.FindById("first"), {10, 100, 50, 20});
+    tree_.SetBoundingBox(tree_.FindById("nested"), {40, 110, 50, 20});
+    tree_.SetBoundingBox(tree_.FindById("last"), {10, 5000, 50, 20});
+
+    EXPECT_THAT(Ids(tree_.FindInRect({0, 0, 1280, 720})), ElementsAre("body", "h1", "first", "nested"));
+    EXPECT_THAT(Ids(tree_.FindAtPoint(45, 115)), ElementsAre("body", "first", "nested"));
+    EXPECT_THAT(Ids(tree_.FindInRect({0, 4900, 100, 200})), ElementsAre("body", "last"));
+
+    tree_.SetBoundingBox(tree_.FindById("last"), {20, 20, 10, 10});
+    EXPECT_THAT(Ids(tree_.FindAtPoint(25, 25)), ElementsAre("body", "h1", "last"));
+    EXPECT_THAT(Ids(tree_.FindInRect({0, 4900, 100, 200})), ElementsAre("body"));
+
+    tree_.Detach(tree_.FindById("inner"));
+    EXPECT_THAT(Ids(tree_.FindAtPoint(45, 115)), ElementsAre("body", "first"));
+    EXPECT_EQ(tree_.GetSpatialIndex().Size(), 5u);
+}
+
+TEST_F(DOMInteractionTest, ConditionRegistryWakesOnMatchingSignals) {
+    ConditionRegistry conditions;
+    tree_.SetMutationObserver([&](DOMSignal signal, NodeIndex node) { conditions.Notify(signal, node); });
+
+    NodeIndex first = tree_.FindById("first");
+    std::atomic<bool> ready{false};
+    std::thread writer([&] {
+        while (conditions.GetWaiterCount() == 0) std::this_thread::yield();
+        tree_.SetTextContent(tree_.FindById("last"), "ignored");  // Other node
+        conditions.Notify(DOMSignal::LIFECYCLE);                  // Other signal
+        ready = true;
+        tree_.SetAttribute(first, "aria-busy", "false");
+    });
+
+    EXPECT_TRUE(conditions.WaitFor(static_cast<DOMSignalMask>(DOMSignal::ATTRIBUTE), first,
+                                   [&] { return ready.load(); }, std::chrono::seconds(5)));
+    writer.join();
+    EXPECT_EQ(conditions.GetWakeupCount(), 1u);
+    EXPECT_EQ(conditions.GetWaiterCount(), 0u);
+
+    EXPECT_FALSE(conditions.WaitFor(kAllDOMSignals, first, [] { return false; }, std::chrono::milliseconds(10)));
+}
+
+TEST_F(DOMInteractionTest, MutationJournalReportsDirtySubtrees) {
+    const uint64_t start = tree_.GetJournal().GetSequence();
+    std::vector<NodeIndex> roots;
+    EXPECT_TRUE(tree_.DirtySubtreesSince(start, roots));
+    EXPECT_TRUE(roots.empty());
+
+    tree_.SetTextContent(tree_.FindById("nested"), "TWO");
+    tree_.SetAttribute(tree_.FindById("inner"), "hidden", "");
+    tree_.SetAttribute(tree_.FindById("h1"), "title", "Greeting");
+
+    std::vector<MutationRecord> records;
+    EXPECT_TRUE(tree_.GetJournal().Since(start, records));
+    ASSERT_EQ(records.size(), 3u);
+    EXPECT_EQ(records[0].type, DOMMutationType::TEXT);
+    EXPECT_EQ(records[2].attribute_name, "title");
+    EXPECT_EQ(records[2].sequence, start + 3);
+
+    // "nested" is covered by its dirty ancestor "inner"
+    EXPECT_TRUE(tree_.DirtySubtreesSince(start, roots));
+    EXPECT_THAT(Ids(roots), ElementsAre("h1", "inner"));
+
+    const uint64_t mark = tree_.GetJournal().GetSequence();
+    tree_.Detach(tree_.FindById("first"));
+    EXPECT_TRUE(tree_.DirtySubtreesSince(mark, roots));
+    EXPECT_THAT(Ids(roots), ElementsAre("list"));
+
+    tree_.SetJournalCapacity(1);
+    EXPECT_FALSE(tree_.DirtySubtreesSince(start, roots));
+    EXPECT_THAT(Ids(roots), ElementsAre("html"));
+}
+
+TEST_F(DOMInteractionTest, SnapshotRestoreSharesUnchangedPages) {
+    NodeIndex first = tree_.FindById("first");
+    const AttributeIndex* attributes = &tree_.GetAttributeIndex();
+    const SpatialIndex* boxes = &tree_.GetSpatialIndex();
+    tree_.Restore(tree_.Snapshot());
+    EXPECT_EQ(&tree_.GetAttributeIndex(), attributes);
+    EXPECT_EQ(&tree_.GetSpatialIndex(), boxes);
+    DOMSnapshot snapshot = tree_.Snapshot();
+
+    tree_.SetTextContent(first, "changed");
+    tree_.SetAttribute(first, "class", "item");
+    tree_.Detach(tree_.FindById("inner"));
+    NodeIndex extra = tree_.CreateNode("extra", "span", "extra");
+    tree_.AppendChild(tree_.FindById("body"), extra);
+    tree_.GetMutableNode(first)->checked = true;
+    EXPECT_THAT(Ids(tree_.FindByAttribute(IndexedAttribute::TAG, "span")), ElementsAre("first", "last", "extra"));
+    // The first indexed write copied the attribute index; nothing moved a box
+    EXPECT_NE(&tree_.GetAttributeIndex(), attributes);
+    EXPECT_EQ(&tree_.GetSpatialIndex(), boxes);
+
+    const uint64_t before_restore = tree_.GetJournal().GetSequence();
+    tree_.Restore(snapshot);
+    EXPECT_EQ(&tree_.GetAttributeIndex(), attributes);
+    EXPECT_EQ(tree_.Size(), snapshot.Size());
+    EXPECT_EQ(tree_.GetNode(first)->text_content, "one");
+    EXPECT_FALSE(tree_.GetNode(first)->checked);
+    EXPECT_EQ(tree_.FindById("extra"), kInvalidNodeIndex);
+    EXPECT_THAT(Ids(tree_.FindByAttribute(IndexedAttribute::TAG, "span")), ElementsAre("first", "nested", "last"));
+    EXPECT_THAT(Select("//div[@id='items']/div/span"), ElementsAre("nested"));
+
+    // The journal keeps counting and reports the restore as a full change
+    std::vector<NodeIndex> roots;
+    EXPECT_FALSE(tree_.DirtySubtreesSince(before_restore, roots));
+    EXPECT_GT(tree_.GetJournal().GetSequence(), before_restore);
+
+    // Restoring twice from the same snapshot gives the same state
+    tree_.SetTextContent(first, "again");
+    tree_.Restore(snapshot);
+    EXPECT_EQ(tree_.GetNode(first)->text_content, "one");
+}
+
+TEST_F(DOMInteractionTest, NodeHandlesEncodeGeneration) {
+    NodeIndex nested = tree_.FindById("nested");
+    NodeHandle handle = tree_.GetHandle(nested);
+    EXPECT_FALSE(handle.IsNull());
+    EXPECT_EQ(handle.Index(), nested);
+    EXPECT_EQ(tree_.Resolve(handle), nested);
+    EXPECT_EQ(tree_.Resolve(NodeHandle{}), kInvalidNodeIndex);
+
+    const DOMNode* node = tree_.GetNode(tree_.Resolve(handle));
+    auto it = node->attributes.find(std::string_view("class"));
+    ASSERT_NE(it, node->attributes.end());
+    EXPECT_EQ(it->second, "item highlighted");
+
+    DOMSnapshot snapshot = tree_.Snapshot();
+    tree_.Restore(snapshot);
+    EXPECT_EQ(tree_.Resolve(handle), kInvalidNodeIndex);
+    EXPECT_EQ(tree_.Resolve(tree_.GetHandle(nested)), nested);
+}
+
+TEST_F(DOMInteractionTest, EventDispatchCaptureAndBubble) {
+    struct Recorder {
+        std::vector<std::string> calls;
+        const DOMTree* tree;
+        static void Record(DOMEvent& event, void* context) {
+            auto* self = static_cast<Recorder*>(context);
+            const char* phase = event.phase == EventPhase::CAPTURING ? "capture:" :
+                                event.phase == EventPhase::AT_TARGET ? "target:" : "bubble:";
+            self->calls.push_back(phase + self->tree->GetNode(event.current_target)->id);
+        }
+        static void Stop(DOMEvent& event, void*) { event.StopPropagation(); }
+    } recorder{{}, &tree_};
+
+    EventDispatcher events;
+    const EventTypeId click = ToEventTypeId(EventType::CLICK);
+    NodeIndex nested = tree_.FindById("nested");
+
+    events.AddListener(tree_.FindById("body"), click, &Recorder::Record, &recorder, true);
+    events.AddListener(tree_.FindById("list"), click, &Recorder::Record, &recorder);
+    events.AddListener(nested, click, &Recorder::Record, &recorder);
+    auto focus_id = events.AddListener(tree_.FindById("list"), ToEventTypeId(EventType::FOCUS), &Recorder::Record, &recorder);
+
+    EXPECT_TRUE(events.Dispatch(tree_, nested, click));
+    EXPECT_THAT(recorder.calls, ElementsAre("capture:body", "target:nested", "bubble:list"));
+
+    // Focus does not bubble, so the ancestor listener never fires
+    recorder.calls.clear();
+    events.Dispatch(tree_, nested, ToEventTypeId(EventType::FOCUS));
+    EXPECT_TRUE(recorder.calls.empty());
+    EXPECT_TRUE(events.RemoveListener(tree_.FindById("list"), focus_id));
+    EXPECT_EQ(events.GetListenerCount(ToEventTypeId(EventType::FOCUS)), 0u);
+
+    recorder.calls.clear();
+    events.AddListener(tree_.FindById("inner"), click, &Recorder::Stop, nullptr);
+    events.Dispatch(tree_, nested, click);
+    EXPECT_THAT(recorder.calls, ElementsAre("capture:body", "target:nested"));
+
+    // A listener snapshot keeps its table while the live one changes
+    const EventDispatcher::ListenerSnapshot listeners = events.SnapshotListeners();
+    EXPECT_EQ(events.RemoveListeners(tree_.FindById("inner"), click), 1u);
+    recorder.calls.clear();
+    events.Dispatch(tree_, nested, click);
+    EXPECT_THAT(recorder.calls, ElementsAre("capture:body", "target:nested", "bubble:list"));
+    events.RestoreListeners(listeners);
+    recorder.calls.clear();
+    events.Dispatch(tree_, nested, click);
+    EXPECT_THAT(recorder.calls, ElementsAre("capture:body", "target:nested"));
+
+    EXPECT_EQ(InternEventType("click"), click);
+    EventTypeId custom = InternEventType("x-custom");
+    EXPECT_GE(custom, ToEventTypeId(EventType::COUNT));
+    EXPECT_EQ(InternEventType("x-custom"), custom);
+    EXPECT_EQ(EventTypeName(custom), "x-custom");
+}
+
+TEST_F(DOMInteractionTest, SerializerWritesEscapedMarkupAndText) {
+    NodeIndex body = tree_.FindById("body");
+    NodeIndex h1 = tree_.FindById("h1");
+    tree_.SetTextContent(h1, "Fish & <Chips>");
+    tree_.SetAttribute(h1, "title", "say \"hi\"");
+    NodeIndex script = tree_.CreateNode("script", "script", "if (a < b) run();");
+    NodeIndex br = tree_.CreateNode("br", "br");
+    tree_.AppendChild(body, script);
+    tree_.AppendChild(body, br);
+
+    std::string html;
+    SerializeHTML(tree_, body, html);
+    EXPECT_EQ(html,
+              "<body><h1 title=\"say &quot;hi&quot;\">Fish &amp; &lt;Chips&gt;</h1>"
+              "<div id=\"items\"><span>one</span><div><span class=\"item highlighted\">two</span></div>"
+              "<span data-count=\"7\">three</span></div><script>if (a < b) run();</script><br></body>");
+    EXPECT_EQ(MeasureHTML(tree_, body), html.size());
+
+    // A short buffer is left untouched and reports the size it needs
+    std::vector<char> buffer(8, '#');
+    EXPECT_EQ(SerializeHTML(tree_, body, buffer.data(), buffer.size()), html.size());
+    EXPECT_EQ(std::string(buffer.begin(), buffer.end()), "########");
+    buffer.resize(html.size());
+    SerializeHTML(tree_, body, buffer.data(), buffer.size());
+    EXPECT_EQ(std::string(buffer.begin(), buffer.end()), html);
+
+    std::ostringstream stream;
+    EXPECT_EQ(SerializeHTML(tree_, body, stream), html.size());
+    EXPECT_EQ(stream.str(), html);
+
+    std::string text = "prefix:";
+    ExtractText(tree_, tree_.GetDocumentElement(), text);
+    EXPECT_EQ(text, "prefix:Fish & <Chips> one two three");
+    EXPECT_EQ(MeasureText(tree_, tree_.GetDocumentElement()), text.size() - 7);
+}
+
+TEST_F(DOMInteractionTest, AgentBatchMatchesIndividualQueries) {
+    auto agent = CreateBlinkDOMAgent();
+    auto ids = [](const std::vector<ElementHandle>& elements) {
+        std::vector<std::string> result;
+        for (const auto& element : elements) result.push_back(element.element_id);
+        return result;
+    };
+
+    const std::vector<std::pair<std::string, ElementSearchType>> queries = {
+        {"//*[@alt]", ElementSearchType::XPATH},
+        {"//button[@class='btn btn-primary']", ElementSearchType::XPATH},
+        {"//body/p", ElementSearchType::XPATH},  // Not simple: evaluated on its own
+        {"img, [type='text']", ElementSearchType::CSS_SELECTOR},
+        {"[placeholder]", ElementSearchType::CSS_SELECTOR},
+        {"Company Logo", ElementSearchType::ALT_TEXT},
+        {"//*[@alt]", ElementSearchType::XPATH},
+        {"//input[@type=\"submit\"]", ElementSearchType::XPATH},
+    };
+    auto results = agent->FindElementsBatch(queries);
+    ASSERT_EQ(results.size(), queries.size());
+    for (size_t i = 0; i < queries.size(); ++i) {
+        EXPECT_EQ(ids(results[i]), ids(agent->FindElements(queries[i].first, queries[i].second)))
+            << queries[i].first;
+    }
+    EXPECT_EQ(ids(results[0]), std::vector<std::string>{"img"});
+    EXPECT_EQ(ids(results[1]), std::vector<std::string>{"button"});
+    EXPECT_EQ(ids(results[2]), std::vector<std::string>{"p"});
+    EXPECT_EQ(ids(results[3]), (std::vector<std::string>{"input", "img"}));
+    EXPECT_EQ(ids(results[6]), ids(results[0]));
+    EXPECT_TRUE(results[7].empty());
+}
+
+TEST_F(DOMInteractionTest, AgentWaitsRaceFreeWithConcurrentMutations) {
+    auto agent = CreateBlinkDOMAgent();
+
+    // Waiters evaluate selectors and the lazily rebuilt text index while
+    // the main thread keeps mutating the same nodes
+    std::atomic<bool> attribute_found{false};
+    std::atomic<bool> text_found{false};
+    std::thread attribute_waiter([&] {
+        attribute_found = agent->WaitForElement("[data-ready]", ElementSearchType::CSS_SELECTOR, 5000);
+    });
+    std::thread text_waiter([&] {
+        text_found = agent->WaitForElement("done typing", ElementSearchType::TEXT_CONTENT, 5000);
+    });
+
+    for (int i = 0; i < 200; ++i) {
+        agent->SetElementAttribute("p", "data-step", std::to_string(i));
+        agent->TypeText("input", "typing " + std::to_string(i));
+    }
+    agent->TypeText("input", "done typing");
+    agent->SetElementAttribute("button", "data-ready", "1");
+
+    attribute_waiter.join();
+    text_waiter.join();
+    EXPECT_TRUE(attribute_found);
+    EXPECT_TRUE(text_found);
+    EXPECT_FALSE(agent->WaitForElement("[data-missing]", ElementSearchType::CSS_SELECTOR, 10));
+}
+
+TEST_F(DOMInteractionTest, AgentRestoreRollsBackEventListeners) {
+    auto agent = CreateBlinkDOMAgent();
+    int kept = 0;
+    int added_later = 0;
+    int typed_calls = 0;
+    agent->AddEventListener("button", "click", [&] { ++kept; });
+    const uint64_t snapshot = agent->Snapshot();
+
+    // Registered after the snapshot: gone once it is restored
+    agent->AddEventListener("button", "click", [&] { ++added_later; });
+    NodeHandle p = agent->FindElementHandles("p", ElementSearchType::CSS_SELECTOR).at(0);
+    const uint32_t typed_id = agent->AddEventListener(
+        p, "click", [](DOMEvent&, void* context) { ++*static_cast<int*>(context); }, &typed_calls);
+    ASSERT_NE(typed_id, 0u);
+
+    ASSERT_TRUE(agent->Restore(snapshot));
+    agent->ClickElement("button");
+    agent->ClickElement("p");
+    EXPECT_EQ(kept, 1);
+    EXPECT_EQ(added_later, 0);
+    EXPECT_EQ(typed_calls, 0);
+
+    // Removed after the snapshot: back once it is restored, and it outlives
+    // the snapshot's release
+    agent->RemoveEventListener("button", "click");
+    agent->ClickElement("button");
+    EXPECT_EQ(kept, 1);
+    ASSERT_TRUE(agent->Restore(snapshot));
+    agent->ReleaseSnapshot(snapshot);
+    agent->ClickElement("button");
+    EXPECT_EQ(kept, 2);
+
+    // Ids handed out before the restore are not reused
+    p = agent->FindElementHandles("p", ElementSearchType::CSS_SELECTOR).at(0);
+    EXPECT_GT(agent->AddEventListener(p, "click", [](DOMEvent&, void*) {}, nullptr), typed_id);
+}
+
+TEST_F(DOMInteractionTest, AgentFillFormCommitsBeforeEventsAndJournalsValues) {
+    auto agent = CreateBlinkDOMAgent();
+    const std::vector<std::string> controls = {"login-user", "plan-free",     "plan-pro",
+                                               "login-password", "login-remember", "login-country"};
+    std::vector<std::string> events;
+    std::vector<std::string> password_seen;  // By each listener, as it ran
+    for (const auto& id : controls) {
+        for (const std::string type : {"input", "change"}) {
+            agent->AddEventListener(id, type, [&, id, type] {
+                events.push_back(id + ":" + type);
+                password_seen.push_back(agent->GetFormData("login-form")["password"]);
+            });
+        }
+    }
+    const uint64_t sequence = agent->GetMutationSequence();
+
+    // One unknown key and nothing changes
+    EXPECT_FALSE(agent->FillForm({{"username", "ann"}, {"missing", "x"}}));
+    EXPECT_TRUE(events.empty());
+    EXPECT_EQ(agent->GetMutationSequence(), sequence);
+
+    // Ids and names mix; a radio group is set through its name
+    EXPECT_TRUE(agent->FillForm({{"login-user", "ann"},
+                                 {"password", "secret"},
+                                 {"remember", "true"},
+                                 {"plan", "pro"},
+                                 {"country", "nz"}}));
+    EXPECT_EQ(events, (std::vector<std::string>{"login-user:input", "login-user:change", "login-password:input",
+                                                "login-password:change", "login-remember:input",
+                                                "login-remember:change", "plan-free:input", "plan-free:change",
+                                                "plan-pro:input", "plan-pro:change", "login-country:input",
+                                                "login-country:change"}));
+    EXPECT_EQ(password_seen, std::vector<std::string>(events.size(), "secret"));
+
+    EXPECT_EQ(agent->GetFormData("login-form"), (std::map<std::string, std::string>{{"username", "ann"},
+                                                                                     {"password", "secret"},
+                                                                                     {"remember", "on"},
+                                                                                     {"plan", "pro"},
+                                                                                     {"country", "nz"}}));
+    EXPECT_TRUE(agent->IsElementChecked("plan-pro"));
+    EXPECT_FALSE(agent->IsElementChecked("plan-free"));
+
+    // Every changed control is journaled and is its own dirty subtree
+    std::vector<DOMMutation> mutations;
+    EXPECT_TRUE(agent->GetMutationsSince(sequence, mutations));
+    ASSERT_EQ(mutations.size(), 6u);
+    for (const auto& mutation : mutations) {
+        EXPECT_EQ(mutation.type, DOMMutationType::VALUE) << mutation.element_id;
+    }
+    std::vector<std::string> dirty;
+    EXPECT_TRUE(agent->GetDirtySubtreesSince(sequence, dirty));
+    EXPECT_EQ(dirty, (std::vector<std::string>{"login-user", "login-password", "login-remember", "plan-free",
+                                               "plan-pro", "login-country"}));
+
+    // Filling the same values again changes and fires nothing
+    const uint64_t filled = agent->GetMutationSequence();
+    events.clear();
+    EXPECT_TRUE(agent->FillForm({{"username", "ann"}, {"plan", "pro"}, {"remember", "on"}}));
+    EXPECT_TRUE(events.empty());
+    EXPECT_EQ(agent->GetMutationSequence(), filled);
+
+    EXPECT_TRUE(agent->UncheckElement("login-remember"));
+    mutations.clear();
+    EXPECT_TRUE(agent->GetMutationsSince(filled, mutations));
+    ASSERT_EQ(mutations.size(), 1u);
+    EXPECT_EQ(mutations[0].element_id, "login-remember");
+    EXPECT_EQ(agent->GetFormData("login-form").count("remember"), 0u);
+}
@@ -0,0 +1,227 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <condition_variable>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "chromium_playwright/logging/logger.h"
+
+using namespace chromium_playwright::logging;
+using namespace testing;
+
+class LoggerTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        previous_level_ = Logger::Instance().GetLevel();
+        Logger::Instance().SetSink([this](LogLevel level, std::string_view line) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            lines_.emplace_back(level, std::string(line));
+        });
+    }
+
+    void TearDown() override {
+        Logger& logger = Logger::Instance();
+        logger.SetLevel(previous_level_);
+        logger.SetSink([](LogLevel level, std::string_view line) {
+            std::ostream& out = level == LogLevel::ERROR ? std::cerr : std::cout;
+            out << line << '\n';
+        });
+    }
+
+    std::vector<std::string> Lines() {
+        Logger::Instance().Flush();
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::vector<std::string> lines;
+        for (const auto& entry : lines_) lines.push_back(entry.second);
+        return lines;
+    }
+
+    // Message part of a formatted line, after the "time [LEVEL] [component] " prefix
+    static std::string Message(const std::string& line) {
+        const size_t component_end = line.find("] ", line.find("] ") + 2);
+        return component_end == std::string::npos ? line : line.substr(component_end + 2);
+    }
+
+    LogLevel previous_level_ = LogLevel::INFO;
+    std::mutex mutex_;
+    std::vector<std::pair<LogLevel, std::string>> lines_;
+};
+
+enum class Color : uint8_t { RED = 3 };
+
+TEST(LogRingTest, RingRejectsWritesWhenFullUntilRead) {
+    auto ring = std::make_unique<LogRing>();
+    EXPECT_TRUE(ring->Empty());
+
+    for (size_t i = 0; i < LogRing::kCapacity; ++i) {
+        LogRecord* record = ring->BeginWrite();
+        ASSERT_NE(record, nullptr) << i;
+        record->timestamp_us = i;
+        record->payload_size = 0;
+        ring->CommitWrite();
+    }
+    EXPECT_EQ(ring->BeginWrite(), nullptr);
+
+    LogRecord record;
+    ASSERT_TRUE(ring->Read(record));
+    EXPECT_EQ(record.timestamp_us, 0u);
+    ASSERT_NE(ring->BeginWrite(), nullptr);
+
+    size_t drained = 1;
+    while (ring->Read(record)) {
+        EXPECT_EQ(record.timestamp_us, drained);
+        ++drained;
+    }
+    EXPECT_EQ(drained, LogRing::kCapacity);
+    EXPECT_TRUE(ring->Empty());
+}
+
+TEST_F(LoggerTest, FullRingDropsAndCountsRecordsInsteadOfBlocking) {
+    Logger& logger = Logger::Instance();
+
+    // Park the writer inside the sink so nothing drains while the ring fills
+    std::mutex gate_mutex;
+    std::condition_variable gate_cv;
+    bool writer_parked = false;
+    bool released = false;
+    size_t delivered = 0;
+    logger.SetSink([&](LogLevel, std::string_view) {
+        std::unique_lock<std::mutex> lock(gate_mutex);
+        ++delivered;
+        writer_parked = true;
+        gate_cv.notify_all();
+        gate_cv.wait(lock, [&] { return released; });
+    });
+
+    CP_LOG_INFO("test", "first");
+    {
+        std::unique_lock<std::mutex> lock(gate_mutex);
+        gate_cv.wait(lock, [&] { return writer_parked; });
+    }
+
+    constexpr size_t kOverflow = 10;
+    const uint64_t dropped_before = logger.GetDroppedCount();
+    for (size_t i = 0; i < LogRing::kCapacity + kOverflow; ++i) {
+        CP_LOG_INFO("test", "record {}", i);
+    }
+    EXPECT_EQ(logger.GetDroppedCount() - dropped_before, kOverflow);
+
+    {
+        std::lock_guard<std::mutex> lock(gate_mutex);
+        released = true;
+    }
+    gate_cv.notify_all();
+    logger.Flush();
+
+    std::lock_guard<std::mutex> lock(gate_mutex);
+    EXPECT_EQ(delivered, 1 + LogRing::kCapacity);
+}
+
+TEST_F(LoggerTest, FormatsBinaryEncodedArgumentsInPlaceholderOrder) {
+    const std::string owned = "owned";
+    const char* missing = nullptr;
+    CP_LOG_WARN("test", "i={} u={} d={} b={} s={} c={} n={} e={}",
+                -42, 7u, 2.5, true, owned, "literal", missing, Color::RED);
+    CP_LOG_INFO("test", "a={} b={}", 1);
+    CP_LOG_INFO("test", "no placeholders");
+
+    const auto lines = Lines();
+    ASSERT_EQ(lines.size(), 3u);
+    EXPECT_THAT(lines[0], MatchesRegex("[0-9]{2}:[0-9]{2}:[0-9]{2}\\.[0-9]{6} \\[WARN\\] \\[test\\] .*"));
+    EXPECT_EQ(Message(lines[0]), "i=-42 u=7 d=2.5 b=true s=owned c=literal n=(null) e=3");
+    EXPECT_EQ(Message(lines[1]), "a=1 b={?}");
+    EXPECT_EQ(Message(lines[2]), "no placeholders");
+}
+
+TEST_F(LoggerTest, OversizedArgumentsAreTruncatedAndFlagged) {
+    const std::string long_value(LogRecord::kPayloadSize * 2, 'x');
+    CP_LOG_INFO("test", "{} {}", long_value, 5);
+
+    const auto lines = Lines();
+    ASSERT_EQ(lines.size(), 1u);
+    const std::string message = Message(lines[0]);
+
+    // The string keeps the prefix that fits (tag + length header); the int is lost
+    const size_t kept = LogRecord::kPayloadSize - 1 - sizeof(uint16_t);
+    EXPECT_EQ(message, std::string(kept, 'x') + " {?} [truncated]");
+}
+
+TEST_F(LoggerTest, FormatRecordRendersTimestampLevelAndComponent) {
+    LogRecord record;
+    record.timestamp_us = ((1 * 3600 + 2 * 60 + 3) * 1000000ull) + 45;
+    record.level = LogLevel::ERROR;
+    record.component = "crawl";
+    record.format = "value={}";
+    record.arg_count = 1;
+    record.payload_size = 0;
+
+    EXPECT_EQ(Logger::FormatRecord(record), "01:02:03.000045 [ERROR] [crawl] value={?}");
+}
+
+TEST_F(LoggerTest, LevelsBelowCompileTimeMinimumAreNotEvaluated) {
+    Logger& logger = Logger::Instance();
+    logger.SetLevel(LogLevel::DEBUG);
+
+    int evaluated = 0;
+    CP_LOG_DEBUG("test", "debug {}", ++evaluated);
+#if CHROMIUM_PLAYWRIGHT_MIN_LOG_LEVEL > 0
+    EXPECT_EQ(evaluated, 0);
+    EXPECT_TRUE(Lines().empty());
+#else
+    EXPECT_EQ(evaluated, 1);
+    EXPECT_EQ(Lines().size(), 1u);
+#endif
+}
+
+TEST_F(LoggerTest, RuntimeLevelFiltersRecordsAboveCompileTimeMinimum) {
+    Logger& logger = Logger::Instance();
+    logger.SetLevel(LogLevel::WARN);
+
+    CP_LOG_INFO("test", "hidden");
+    CP_LOG_WARN("test", "shown");
+    CP_LOG_ERROR("test", "also shown");
+
+    const auto lines = Lines();
+    ASSERT_EQ(lines.size(), 2u);
+    EXPECT_EQ(Message(lines[0]), "shown");
+    EXPECT_EQ(Message(lines[1]), "also shown");
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    EXPECT_EQ(lines_[1].first, LogLevel::ERROR);
+}
+
+TEST_F(LoggerTest, FlushDeliversEverythingLoggedBeforeItInPerThreadOrder) {
+    constexpr int kThreads = 3;
+    constexpr int kPerThread = 200;  // Below ring capacity so nothing is dropped
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([t] {
+            for (int i = 0; i < kPerThread; ++i) {
+                CP_LOG_INFO("test", "{} {}", t, i);
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+
+    // Exited threads' rings must still be drained by the flush
+    const auto lines = Lines();
+    ASSERT_EQ(lines.size(), static_cast<size_t>(kThreads * kPerThread));
+
+    std::vector<int> next(kThreads, 0);
+    for (const auto& line : lines) {
+        int t = -1;
+        int i = -1;
+        ASSERT_EQ(std::sscanf(Message(line).c_str(), "%d %d", &t, &i), 2) << line;
+        ASSERT_GE(t, 0);
+        ASSERT_LT(t, kThreads);
+        EXPECT_EQ(i, next[static_cast<size_t>(t)]++) << line;
+    }
+
+    // A flush with nothing pending returns without delivering anything new
+    EXPECT_EQ(Lines().size(), lines.size());
+}
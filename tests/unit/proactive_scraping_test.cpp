@@ -0,0 +1,1174 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <zlib.h>
+#include "chromium_playwright/crawl/crawl_engine.h"
+#include "chromium_playwright/crawl/discovery.h"
+#include "chromium_playwright/crawl/domain_matcher.h"
+#include "chromium_playwright/crawl/near_duplicate.h"
+#include "chromium_playwright/crawl/pipeline.h"
+#include "chromium_playwright/crawl/recrawl_scheduler.h"
+#include "chromium_playwright/crawl/result_stream.h"
+#include "chromium_playwright/crawl/robots.h"
+#include "chromium_playwright/crawl/sitemap_parser.h"
+#include "chromium_playwright/crawl/trap_detector.h"
+
+using namespace chromium_playwright::crawl;
+using namespace testing;
+
+class ProactiveScrapingTest : public ::testing::Test {
+protected:
+    // Synthetic site: every page links to kFanout children and back to the root
+    static constexpr int kFanout = 4;
+
+    static std::vector<std::string> Links(const std::string& url) {
+        std::vector<std::string> links;
+        for (int i = 0; i < kFanout; ++i) {
+            links.push_back(url + "/" + std::to_string(i));
+        }
+        links.push_back("https://site.test");
+        return links;
+    }
+
+    static int PathDepth(const std::string& url) {
+        return static_cast<int>(std::count(url.begin(), url.end(), '/')) - 2;
+    }
+};
+
+TEST_F(ProactiveScrapingTest, CrawlVisitsEachPageOnceWithDepth) {
+    CrawlOptions options;
+    options.worker_count = 4;
+    options.max_depth = 4;
+    CrawlEngine engine(options);
+
+    std::mutex mutex;
+    std::map<std::string, int> visits;
+    std::atomic<size_t> progress_reports{0};
+    engine.SetProgressCallback([&](const CrawlProgress& progress) {
+        EXPECT_LT(progress.worker, 4u);
+        EXPECT_NE(progress.task, nullptr);
+        ++progress_reports;
+    });
+
+    size_t pages = engine.Run({"https://site.test"}, [&](const CrawlTask& task, size_t) {
+        EXPECT_EQ(task.depth, PathDepth(task.url));
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            ++visits[task.url];
+        }
+        return Links(task.url);
+    });
+
+    // 1 + 4 + 16 + 64 pages at depths 0..3
+    EXPECT_EQ(pages, 85u);
+    EXPECT_EQ(visits.size(), 85u);
+    for (const auto& [url, count] : visits) {
+        EXPECT_EQ(count, 1) << url;
+    }
+    EXPECT_EQ(progress_reports.load(), 85u);
+
+    CrawlStats stats = engine.GetStats();
+    EXPECT_EQ(stats.total_pages, 85u);
+    ASSERT_EQ(stats.pages_per_worker.size(), 4u);
+    size_t sum = 0;
+    for (size_t count : stats.pages_per_worker) sum += count;
+    EXPECT_EQ(sum, 85u);
+}
+
+TEST_F(ProactiveScrapingTest, CrawlHonorsPageLimitAndStop) {
+    CrawlOptions options;
+    options.worker_count = 3;
+    options.max_depth = 10;
+    options.max_pages = 20;
+    CrawlEngine limited(options);
+    EXPECT_EQ(limited.Run({"https://site.test"}, [](const CrawlTask& task, size_t) { return Links(task.url); }), 20u);
+
+    options.max_pages = 0;
+    CrawlEngine stopped(options);
+    std::atomic<size_t> handled{0};
+    std::atomic<bool> stop_returned{false};
+    std::atomic<size_t> started_after_stop{0};
+    size_t pages = stopped.Run({"https://site.test"}, [&](const CrawlTask& task, size_t) {
+        if (stop_returned) ++started_after_stop;
+        if (++handled == 10) {
+            stopped.Stop();
+            stop_returned = true;
+        }
+        return Links(task.url);
+    });
+    // Other workers may run on while the stopping one is descheduled, but
+    // only tasks already popped can start once Stop() has returned
+    EXPECT_GE(pages, 10u);
+    EXPECT_EQ(pages, handled.load());
+    EXPECT_LT(started_after_stop.load(), options.worker_count);
+    EXPECT_FALSE(stopped.IsRunning());
+}
+
+TEST_F(ProactiveScrapingTest, IdleWorkersStealQueuedTasks) {
+    WorkStealingFrontier frontier(2);
+    for (int i = 0; i < 4; ++i) {
+        frontier.Push(0, CrawlTask{"https://site.test/" + std::to_string(i), 1, ""});
+    }
+
+    // Owner pops newest first; the idle worker takes the oldest
+    CrawlTask task;
+    ASSERT_TRUE(frontier.Pop(0, task));
+    EXPECT_EQ(task.url, "https://site.test/3");
+    ASSERT_TRUE(frontier.Pop(1, task));
+    EXPECT_EQ(task.url, "https://site.test/0");
+    EXPECT_EQ(frontier.GetStealCount(1), 1u);
+    EXPECT_EQ(frontier.Size(), 2u);
+
+    // Drained once every popped task is done
+    for (int i = 0; i < 2; ++i) {
+        ASSERT_TRUE(frontier.Pop(1, task));
+    }
+    for (int i = 0; i < 4; ++i) {
+        frontier.TaskDone();
+    }
+    EXPECT_FALSE(frontier.Pop(0, task));
+}
+
+TEST_F(ProactiveScrapingTest, FrontierCountsStayConsistentUnderConcurrentPushPop) {
+    // Thieves pop tasks the moment they are published; the counters must
+    // already include them, or they wrap below zero
+    constexpr size_t kTasks = 4000;
+    constexpr size_t kThieves = 3;
+    FrontierOptions options;
+    options.memory_limit = 64;
+    options.segment_tasks = 128;
+    WorkStealingFrontier frontier(kThieves + 1, options);
+
+    const std::string root = "https://site.test/";
+    std::atomic<size_t> popped{0};
+    std::atomic<bool> root_held{false};
+    std::atomic<bool> wrapped{false};
+    // Pushed first so the thieves do not see an already drained frontier
+    frontier.Push(0, CrawlTask{root, 0, ""});
+    std::vector<std::thread> thieves;
+    for (size_t worker = 1; worker <= kThieves; ++worker) {
+        thieves.emplace_back([&, worker] {
+            CrawlTask task;
+            while (frontier.Pop(worker, task)) {
+                if (frontier.Size() > kTasks) wrapped = true;
+                popped.fetch_add(1);
+                // The root stays outstanding until every push is done
+                if (task.url == root) {
+                    root_held = true;
+                } else {
+                    frontier.TaskDone();
+                }
+            }
+        });
+    }
+
+    for (size_t i = 0; i < kTasks; ++i) {
+        frontier.Push(0, CrawlTask{root + std::to_string(i), 1, ""});
+        if (frontier.Size() > kTasks + 1) wrapped = true;
+    }
+    while (!root_held) std::this_thread::yield();
+    frontier.TaskDone();
+    for (auto& thief : thieves) thief.join();
+
+    EXPECT_FALSE(wrapped);
+    EXPECT_EQ(popped.load(), kTasks + 1);
+    EXPECT_EQ(frontier.Size(), 0u);
+    EXPECT_EQ(frontier.GetSpilledCount(), 0u);
+}
+
+TEST_F(ProactiveScrapingTest, VisitedSetDedupesCanonicalUrls) {
+    EXPECT_EQ(CanonicalizeUrl("HTTPS://Example.COM:443?q=1#top"), "https://example.com/?q=1");
+    EXPECT_EQ(CanonicalizeUrl("http://example.com:8080/A"), "http://example.com:8080/A");
+
+    VisitedUrlSet visited;
+    EXPECT_TRUE(visited.Insert("https://example.com"));
+    EXPECT_FALSE(visited.Insert("https://EXAMPLE.com/#section"));
+    EXPECT_TRUE(visited.Insert("https://example.com/Path"));
+    EXPECT_FALSE(visited.Contains("https://example.com/path"));
+
+    // Growth keeps every fingerprint; misses are mostly filtered without probing
+    FingerprintSet fingerprints;
+    for (uint64_t i = 1; i <= 20000; ++i) {
+        ASSERT_TRUE(fingerprints.Insert(UrlFingerprint("https://site.test/" + std::to_string(i))));
+    }
+    for (uint64_t i = 1; i <= 20000; ++i) {
+        ASSERT_TRUE(fingerprints.Contains(UrlFingerprint("https://site.test/" + std::to_string(i))));
+    }
+    size_t false_hits = 0;
+    for (uint64_t i = 20001; i <= 40000; ++i) {
+        false_hits += fingerprints.Contains(UrlFingerprint("https://site.test/" + std::to_string(i)));
+    }
+    EXPECT_EQ(false_hits, 0u);
+
+    VisitedSetStats stats = fingerprints.GetStats();
+    EXPECT_EQ(stats.urls, 20000u);
+    EXPECT_GT(stats.bloom_rejections, 16000u);
+    EXPECT_LT(stats.BytesPerUrl(), 24.0);
+}
+
+TEST_F(ProactiveScrapingTest, SpillQueueKeepsFifoOrderAcrossSegments) {
+    std::vector<CrawlTask> tasks = {{"https://site.test/a/1", 2, "https://site.test/a"},
+                                    {"https://site.test/a/2", 2, "https://site.test/a"},
+                                    {"https://other.test/", 0, ""}};
+    std::string encoded = SpillQueue::EncodeSegment(tasks);
+    std::deque<CrawlTask> decoded;
+    ASSERT_TRUE(SpillQueue::DecodeSegment(encoded, decoded));
+    ASSERT_EQ(decoded.size(), 3u);
+    for (size_t i = 0; i < tasks.size(); ++i) {
+        EXPECT_EQ(decoded[i].url, tasks[i].url);
+        EXPECT_EQ(decoded[i].depth, tasks[i].depth);
+        EXPECT_EQ(decoded[i].parent_url, tasks[i].parent_url);
+    }
+    decoded.clear();
+    EXPECT_FALSE(SpillQueue::DecodeSegment(encoded.substr(0, encoded.size() - 1), decoded));
+
+    std::filesystem::path directory;
+    {
+        SpillQueue queue({}, 16);
+        directory = queue.GetDirectory();
+        for (int i = 0; i < 100; ++i) {
+            queue.Push(CrawlTask{"https://site.test/page/" + std::to_string(i), i % 5, "https://site.test/"});
+        }
+        SpillQueueStats stats = queue.GetStats();
+        EXPECT_EQ(stats.segments_written, 6u);
+        EXPECT_EQ(stats.tasks_on_disk, 96u);
+        EXPECT_LT(stats.encoded_bytes, stats.raw_bytes / 2);
+        EXPECT_LE(queue.InMemory(), 16u);
+
+        CrawlTask task;
+        for (int i = 0; i < 50; ++i) {
+            ASSERT_TRUE(queue.Pop(task));
+            EXPECT_EQ(task.url, "https://site.test/page/" + std::to_string(i));
+            EXPECT_EQ(task.depth, i % 5);
+        }
+        EXPECT_EQ(queue.Size(), 50u);
+        EXPECT_LE(queue.InMemory(), 32u);
+    }
+    // Remaining segments and the temp directory go with the queue
+    EXPECT_FALSE(std::filesystem::exists(directory));
+
+    // The frontier spills past its limit and refills workers from disk
+    FrontierOptions options;
+    options.memory_limit = 8;
+    options.segment_tasks = 16;
+    WorkStealingFrontier frontier(2, options);
+    for (size_t i = 0; i < 200; ++i) {
+        frontier.Push(i, CrawlTask{"https://site.test/" + std::to_string(i), 1, ""});
+    }
+    EXPECT_EQ(frontier.Size(), 200u);
+    EXPECT_EQ(frontier.GetSpilledCount(), 192u);
+    EXPECT_GT(frontier.GetSpillStats().segments_written, 0u);
+
+    std::set<std::string> popped;
+    CrawlTask task;
+    while (popped.size() < 200) {
+        ASSERT_TRUE(frontier.Pop(popped.size() % 2, task));
+        EXPECT_TRUE(popped.insert(task.url).second) << task.url;
+        frontier.TaskDone();
+    }
+    EXPECT_EQ(frontier.GetSpilledCount(), 0u);
+    EXPECT_FALSE(frontier.Pop(0, task));
+}
+
+TEST_F(ProactiveScrapingTest, CrawlWithFrontierMemoryLimitVisitsEveryPage) {
+    CrawlOptions options;
+    options.worker_count = 4;
+    options.max_depth = 4;
+    options.frontier_memory_limit = 4;
+    CrawlEngine engine(options);
+
+    std::mutex mutex;
+    std::set<std::string> visits;
+    size_t pages = engine.Run({"https://site.test"}, [&](const CrawlTask& task, size_t) {
+        std::lock_guard<std::mutex> lock(mutex);
+        EXPECT_TRUE(visits.insert(task.url).second) << task.url;
+        return Links(task.url);
+    });
+    EXPECT_EQ(pages, 85u);
+    EXPECT_EQ(visits.size(), 85u);
+    EXPECT_EQ(engine.GetStats().spill.tasks_on_disk, 0u);
+}
+
+TEST_F(ProactiveScrapingTest, HostFrontierRotatesHostsByScore) {
+    EXPECT_EQ(UrlHost("HTTPS://user@Site.Test:8080/a?b"), "site.test:8080");
+    EXPECT_EQ(UrlHost("relative/path"), "");
+    EXPECT_GT(ScoreCrawlTask(CrawlTask{"u", 1, "", 10}), ScoreCrawlTask(CrawlTask{"u", 2, "", 10}));
+    EXPECT_GT(ScoreCrawlTask(CrawlTask{"u", 2, "", 2}), ScoreCrawlTask(CrawlTask{"u", 2, "", 200}));
+    EXPECT_GT(ScoreCrawlTask(CrawlTask{"u", 2, "", 2, 1.0}), ScoreCrawlTask(CrawlTask{"u", 2, "", 2, 0.0}));
+
+    HostFrontierOptions options;
+    options.politeness_delay = std::chrono::milliseconds(50);
+    HostPriorityFrontier frontier(options);
+    for (int depth : {3, 1, 2}) {
+        frontier.Push(0, CrawlTask{"https://big.test/" + std::to_string(depth), depth, ""});
+    }
+    frontier.Push(0, CrawlTask{"https://small.test/", 3, ""});
+    EXPECT_EQ(frontier.GetHostCount(), 2u);
+
+    // Both hosts are fetchable at once; the big one then cools down
+    CrawlTask first;
+    CrawlTask second;
+    ASSERT_TRUE(frontier.Pop(0, first));
+    ASSERT_TRUE(frontier.Pop(1, second));
+    EXPECT_NE(UrlHost(first.url), UrlHost(second.url));
+    CrawlTask big = UrlHost(first.url) == "big.test" ? first : second;
+    EXPECT_EQ(big.url, "https://big.test/1");
+
+    const auto start = std::chrono::steady_clock::now();
+    CrawlTask task;
+    ASSERT_TRUE(frontier.Pop(0, task));
+    EXPECT_EQ(task.url, "https://big.test/2");
+    EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(30));
+    ASSERT_TRUE(frontier.Pop(0, task));
+    EXPECT_EQ(task.url, "https://big.test/3");
+
+    for (int i = 0; i < 4; ++i) frontier.TaskDone();
+    EXPECT_FALSE(frontier.Pop(0, task));
+
+    // A host's own delay survives the sweep of idle hosts its push triggers
+    HostPriorityFrontier sweeping;
+    for (int i = 0; i < 1024; ++i) sweeping.Push(0, CrawlTask{"https://h" + std::to_string(i) + ".test/", 1, ""});
+    for (int i = 0; i < 1024; ++i) {
+        ASSERT_TRUE(sweeping.Pop(0, task));
+        sweeping.TaskDone();
+    }
+    sweeping.SetHostDelay("slow.test", std::chrono::milliseconds(100));
+    sweeping.Push(0, CrawlTask{"https://slow.test/1", 1, ""});
+    sweeping.Push(0, CrawlTask{"https://slow.test/2", 1, ""});
+    ASSERT_TRUE(sweeping.Pop(0, task));
+    const auto slow_start = std::chrono::steady_clock::now();
+    ASSERT_TRUE(sweeping.Pop(0, task));
+    EXPECT_GE(std::chrono::steady_clock::now() - slow_start, std::chrono::milliseconds(90));
+    sweeping.TaskDone();
+    sweeping.TaskDone();
+
+    // Past the memory limit tasks spill to disk and come back exactly once
+    HostFrontierOptions spill_options;
+    spill_options.memory_limit = 4;
+    spill_options.segment_tasks = 8;
+    HostPriorityFrontier spilling(spill_options);
+    constexpr size_t kSpillTasks = 50;
+    for (size_t i = 0; i < kSpillTasks; ++i) {
+        spilling.Push(0, CrawlTask{"https://h" + std::to_string(i % 3) + ".test/" + std::to_string(i), 1, ""});
+    }
+    EXPECT_EQ(spilling.Size(), kSpillTasks);
+    EXPECT_GT(spilling.GetSpillStats().segments_written, 0u);
+    std::set<std::string> queued;
+    EXPECT_TRUE(spilling.ForEachQueued([&](const CrawlTask& queued_task) { queued.insert(queued_task.url); }));
+    EXPECT_EQ(queued.size(), kSpillTasks);
+
+    std::set<std::string> popped;
+    while (popped.size() < kSpillTasks && spilling.Pop(0, task)) {
+        EXPECT_TRUE(popped.insert(task.url).second) << task.url;
+        EXPECT_LE(spilling.GetHostCount(), 3u);
+        spilling.TaskDone();
+    }
+    EXPECT_EQ(popped, queued);
+    EXPECT_EQ(spilling.Size(), 0u);
+    EXPECT_FALSE(spilling.Pop(0, task));
+
+    // One worker on one host: score order is breadth-first
+    CrawlOptions crawl_options;
+    crawl_options.worker_count = 1;
+    crawl_options.max_depth = 4;
+    crawl_options.frontier_policy = FrontierPolicy::HOST_PRIORITY;
+    CrawlEngine engine(crawl_options);
+    int last_depth = 0;
+    size_t pages = engine.Run({"https://site.test"}, [&](const CrawlTask& task, size_t) {
+        EXPECT_GE(task.depth, last_depth) << task.url;
+        last_depth = task.depth;
+        return Links(task.url);
+    });
+    EXPECT_EQ(pages, 85u);
+
+    crawl_options.worker_count = 3;
+    crawl_options.frontier_memory_limit = 8;
+    CrawlEngine bounded(crawl_options);
+    EXPECT_EQ(bounded.Run({"https://site.test"}, [](const CrawlTask& task, size_t) { return Links(task.url); }), 85u);
+}
+
+TEST_F(ProactiveScrapingTest, CheckpointResumeSkipsFetchedPages) {
+    const auto stamp = std::chrono::steady_clock::now().time_since_epoch().count();
+    const std::filesystem::path path =
+        std::filesystem::temp_directory_path() / ("crawl_checkpoint_test_" + std::to_string(stamp) + ".bin");
+    std::filesystem::remove(path);
+
+    CrawlOptions options;
+    options.worker_count = 3;
+    options.max_depth = 4;
+    options.checkpoint_path = path;
+    options.checkpoint_interval = std::chrono::seconds(0);  // After every page
+    options.blocked_domains = {"ads.test"};
+
+    std::mutex mutex;
+    std::map<std::string, int> visits;
+    auto handler = [&](const CrawlTask& task, size_t) {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++visits[task.url];
+        return Links(task.url);
+    };
+
+    CrawlEngine first(options);
+    first.SetCheckpointMetadata({{"start_url", "https://site.test"}});
+    std::atomic<size_t> handled{0};
+    first.Run({"https://site.test"}, [&](const CrawlTask& task, size_t worker) {
+        if (++handled == 30) first.Stop();
+        return handler(task, worker);
+    });
+    EXPECT_GT(first.GetStats().checkpoints, 1u);
+
+    CrawlCheckpoint checkpoint;
+    ASSERT_TRUE(ReadCheckpoint(path, checkpoint));
+    EXPECT_EQ(checkpoint.metadata.at("start_url"), "https://site.test");
+    EXPECT_EQ(checkpoint.options.max_depth, 4);
+    EXPECT_EQ(checkpoint.total_pages, visits.size());
+    EXPECT_EQ(checkpoint.visited.size(), checkpoint.total_pages + checkpoint.frontier.size());
+
+    // A fresh engine finishes the crawl without refetching anything
+    CrawlOptions resume_options;
+    resume_options.worker_count = 2;
+    CrawlEngine second(resume_options);
+    EXPECT_EQ(second.ResumeFromCheckpoint(path, handler), 85u);
+    EXPECT_EQ(second.GetCheckpointMetadata().at("start_url"), "https://site.test");
+    EXPECT_EQ(second.GetOptions().max_depth, 4);
+    EXPECT_EQ(second.GetOptions().blocked_domains, std::vector<std::string>{"ads.test"});
+    EXPECT_EQ(visits.size(), 85u);
+    for (const auto& [url, count] : visits) {
+        EXPECT_EQ(count, 1) << url;
+    }
+
+    // A spilled frontier and the sharded visited set stream into the file
+    // without being consumed, in more than one frontier segment
+    {
+        constexpr size_t kQueued = 5000;
+        FrontierOptions spill_options;
+        spill_options.memory_limit = 8;
+        spill_options.segment_tasks = 64;
+        WorkStealingFrontier spilled(2, spill_options);
+        VisitedUrlSet seen;
+        for (size_t i = 0; i < kQueued; ++i) {
+            const std::string url = "https://site.test/deep/" + std::to_string(i);
+            seen.Insert(url);
+            spilled.Push(i, CrawlTask{url, 2, "https://site.test/"});
+        }
+        ASSERT_GT(spilled.GetSpillStats().segments_written, 0u);
+
+        CrawlCheckpoint header;
+        header.total_pages = 7;
+        ASSERT_TRUE(WriteCheckpoint(path, header, seen, spilled));
+        EXPECT_FALSE(std::filesystem::exists(path.string() + ".tmp"));
+        EXPECT_EQ(spilled.Size(), kQueued);
+
+        CrawlCheckpoint streamed;
+        ASSERT_TRUE(ReadCheckpoint(path, streamed));
+        EXPECT_EQ(streamed.total_pages, 7u);
+        ASSERT_EQ(streamed.visited.size(), kQueued);
+        EXPECT_TRUE(std::is_sorted(streamed.visited.begin(), streamed.visited.end()));
+        ASSERT_EQ(streamed.frontier.size(), kQueued);
+        std::set<std::string> urls;
+        for (const auto& task : streamed.frontier) {
+            urls.insert(task.url);
+            EXPECT_EQ(task.parent_url, "https://site.test/");
+            EXPECT_TRUE(std::binary_search(streamed.visited.begin(), streamed.visited.end(), UrlFingerprint(task.url)))
+                << task.url;
+        }
+        EXPECT_EQ(urls.size(), kQueued);
+    }
+
+    // Torn or corrupted files are rejected
+    std::string data;
+    {
+        std::ifstream file(path, std::ios::binary);
+        data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+    data[data.size() / 2] ^= 0x40;
+    {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file.write(data.data(), static_cast<std::streamsize>(data.size()));
+    }
+    EXPECT_FALSE(ReadCheckpoint(path, checkpoint));
+    EXPECT_EQ(CrawlEngine().ResumeFromCheckpoint(path, handler), 0u);
+    std::filesystem::remove(path);
+}
+
+TEST_F(ProactiveScrapingTest, PipelineStagesDrainWithBackpressure) {
+    // A full queue blocks its producer until a consumer makes room
+    BoundedQueue<int> queue(2);
+    ASSERT_TRUE(queue.Push(1));
+    ASSERT_TRUE(queue.Push(2));
+    std::atomic<bool> pushed{false};
+    std::thread producer([&] {
+        queue.Push(3);
+        pushed = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_FALSE(pushed.load());
+    int value = 0;
+    ASSERT_TRUE(queue.Pop(value));
+    EXPECT_EQ(value, 1);
+    producer.join();
+    EXPECT_TRUE(pushed.load());
+    EXPECT_EQ(queue.GetFullWaits(), 1u);
+    queue.Close();
+    EXPECT_FALSE(queue.Push(4));
+    ASSERT_TRUE(queue.Pop(value));
+    ASSERT_TRUE(queue.Pop(value));
+    EXPECT_EQ(value, 3);
+    EXPECT_FALSE(queue.Pop(value));
+
+    // Odd items are dropped, multiples of 7 throw, the slow stage backs up
+    std::mutex mutex;
+    std::vector<int> stored;
+    Pipeline<int> pipeline;
+    pipeline.AddStage({"filter", 2, 8}, [](int& item) {
+        if (item % 7 == 0) throw std::runtime_error("unlucky");
+        return item % 2 == 0;
+    });
+    pipeline.AddStage({"slow", 3, 4}, [](int& item) {
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+        item *= 10;
+        return true;
+    });
+    pipeline.AddStage({"store", 1, 4}, [&](int& item) {
+        std::lock_guard<std::mutex> lock(mutex);
+        stored.push_back(item);
+        return true;
+    });
+    pipeline.Start();
+    for (int i = 1; i <= 200; ++i) {
+        ASSERT_TRUE(pipeline.Submit(i));
+    }
+    pipeline.Finish();
+    EXPECT_FALSE(pipeline.Submit(1));
+
+    // Even numbers not divisible by 7: 100 - 14
+    ASSERT_EQ(stored.size(), 86u);
+    std::sort(stored.begin(), stored.end());
+    EXPECT_EQ(stored.front(), 20);
+    EXPECT_EQ(stored.back(), 2000);
+
+    std::vector<StageMetrics> metrics = pipeline.GetMetrics();
+    ASSERT_EQ(metrics.size(), 3u);
+    EXPECT_EQ(metrics[0].name, "filter");
+    EXPECT_EQ(metrics[0].processed, 86u);
+    EXPECT_EQ(metrics[0].dropped, 114u);
+    EXPECT_EQ(metrics[1].processed, 86u);
+    EXPECT_GT(metrics[1].mean_latency_ms, 0.1);
+    EXPECT_LE(metrics[1].max_queue_depth, 4u);
+    EXPECT_GT(metrics[1].full_waits, 0u);
+    EXPECT_EQ(metrics[2].processed, 86u);
+    for (const StageMetrics& stage : metrics) {
+        EXPECT_EQ(stage.queue_depth, 0u);
+    }
+}
+
+TEST_F(ProactiveScrapingTest, ResultStreamPausesCrawlUntilConsumed) {
+    // The crawl feeds a stream of depth-tagged URLs; the consumer lags
+    ResultStream<std::string> stream(4);
+    CrawlOptions options;
+    options.worker_count = 2;
+    options.max_depth = 4;
+    CrawlEngine engine(options);
+    std::atomic<size_t> backlog_max{0};
+    std::thread producer([&] {
+        engine.Run({"https://site.test"}, [&](const CrawlTask& task, size_t) {
+            if (!stream.Publish(task.url)) engine.Stop();
+            const size_t backlog = stream.Pending();
+            size_t seen = backlog_max.load();
+            while (backlog > seen && !backlog_max.compare_exchange_weak(seen, backlog)) {
+            }
+            return Links(task.url);
+        });
+        stream.Finish();
+    });
+
+    std::set<std::string> received;
+    std::string url;
+    while (stream.Next(url)) {
+        EXPECT_TRUE(received.insert(url).second) << url;
+        std::this_thread::sleep_for(std::chrono::microseconds(300));
+    }
+    producer.join();
+    EXPECT_EQ(received.size(), 85u);
+    EXPECT_EQ(stream.GetDeliveredCount(), 85u);
+    EXPECT_LE(backlog_max.load(), 4u);
+    EXPECT_GT(stream.GetStallCount(), 0u);
+
+    // Cancelling releases what is queued and stops the producer
+    ResultStream<std::string> cancelled(2);
+    CrawlEngine stopped(options);
+    std::thread stopped_producer([&] {
+        stopped.Run({"https://site.test"}, [&](const CrawlTask& task, size_t) {
+            if (!cancelled.Publish(task.url)) stopped.Stop();
+            return Links(task.url);
+        });
+        cancelled.Finish();
+    });
+    ASSERT_TRUE(cancelled.Next(url));
+    cancelled.Cancel();
+    stopped_producer.join();
+    EXPECT_FALSE(cancelled.Next(url));
+    EXPECT_EQ(cancelled.Pending(), 0u);
+    EXPECT_LT(stopped.GetStats().total_pages, 85u);
+}
+
+TEST_F(ProactiveScrapingTest, NearDuplicatePagesAreNotExpanded) {
+    std::string article;
+    for (int i = 0; i < 200; ++i) {
+        article += "paragraph " + std::to_string(i) + " of the product catalogue with prices and reviews ";
+    }
+    const std::string tagged = article + "session 8f3a2c visited 2024-05-01";
+    std::string rewritten;
+    for (int i = 0; i < 200; ++i) {
+        rewritten += "entry " + std::to_string(i * 7) + " in an unrelated forum thread about gardening tools ";
+    }
+
+    EXPECT_EQ(SimHash(article), SimHash(article));
+    EXPECT_LE(HammingDistance(SimHash(article), SimHash(tagged)), 3);
+    EXPECT_GT(HammingDistance(SimHash(article), SimHash(rewritten)), 3);
+    EXPECT_EQ(SimHash("The  QUICK brown fox!"), SimHash("the quick, brown fox"));
+
+    // Within max_distance bits is found through whichever band still matches
+    NearDuplicateIndex index(3);
+    const uint64_t base = SimHash(article);
+    EXPECT_FALSE(index.InsertOrFind("https://site.test/a", base).has_value());
+    for (int bit = 0; bit < 64; bit += 5) {
+        const uint64_t near = base ^ (1ULL << bit) ^ (1ULL << ((bit + 21) % 64)) ^ (1ULL << ((bit + 43) % 64));
+        auto found = index.Find(near);
+        ASSERT_TRUE(found.has_value()) << bit;
+        EXPECT_EQ(*found, "https://site.test/a");
+    }
+    EXPECT_FALSE(index.Find(base ^ 0xFULL).has_value());
+    EXPECT_FALSE(index.InsertOrFind("https://site.test/b", SimHash(rewritten)).has_value());
+    EXPECT_EQ(index.InsertOrFind("https://site.test/a?sid=2", SimHash(tagged)), "https://site.test/a");
+    EXPECT_EQ(index.Size(), 2u);
+
+    // Pages without words are neither stored nor duplicates of each other
+    EXPECT_EQ(SimHash(" \n <> -- "), 0u);
+    EXPECT_FALSE(index.InsertOrFind("https://site.test/image-only", SimHash("")).has_value());
+    EXPECT_FALSE(index.InsertOrFind("https://site.test/redirect-stub", SimHash(" ")).has_value());
+    EXPECT_FALSE(index.Find(0).has_value());
+    EXPECT_EQ(index.Size(), 2u);
+
+    // Every /copy page mirrors the seed: fetched once linked, never expanded
+    CrawlOptions options;
+    options.worker_count = 4;
+    options.max_depth = 4;
+    CrawlEngine engine(options);
+    NearDuplicateIndex seen;
+    std::mutex fetched_mutex;
+    std::set<std::string> fetched;
+    engine.Run({"https://site.test"}, [&](const CrawlTask& task, size_t) {
+        {
+            std::lock_guard<std::mutex> lock(fetched_mutex);
+            fetched.insert(task.url);
+        }
+        const bool copy = task.url.find("/copy") != std::string::npos;
+        const std::string& body = copy ? tagged : article;
+        if (seen.InsertOrFind(task.url, SimHash(body + task.url))) return std::vector<std::string>{};
+        std::vector<std::string> links;
+        for (int i = 0; i < 5; ++i) links.push_back(task.url + "/copy" + std::to_string(i));
+        return links;
+    });
+    EXPECT_EQ(fetched.size(), 6u);
+    EXPECT_EQ(seen.Size(), 1u);
+}
+
+TEST_F(ProactiveScrapingTest, RecrawlSchedulerSpendsBudgetOnChangingPages) {
+    using namespace std::chrono_literals;
+    RecrawlOptions options;
+    options.revisit_horizon = 24h;
+    RecrawlScheduler scheduler(options);
+
+    // Ten daily revisits: never, every other time, or always changed
+    const auto start = RecrawlScheduler::Clock::time_point(std::chrono::hours(24 * 20000));
+    for (int day = 0; day <= 10; ++day) {
+        const auto at = start + std::chrono::hours(24 * day);
+        scheduler.RecordVisit("https://site.test/about", false, at);
+        scheduler.RecordVisit("https://site.test/news", day % 2 == 0, at);
+        scheduler.RecordVisit("https://site.test/ticker", true, at);
+    }
+    scheduler.RecordVisit("https://site.test/new", false, start + std::chrono::hours(24 * 10));
+
+    EXPECT_EQ(scheduler.EstimateChangeRate("https://site.test/about"), 0.0);
+    const double news_rate = scheduler.EstimateChangeRate("https://site.test/news");
+    EXPECT_NEAR(news_rate * 24 * 3600, std::log(10.5 / 5.5), 1e-9);
+    EXPECT_GT(scheduler.EstimateChangeRate("https://site.test/ticker"), news_rate);
+
+    // Pages changing faster than the horizon rank below ones a fetch keeps fresh
+    const auto now = start + std::chrono::hours(24 * 11);
+    const std::vector<std::string> expected = {"https://site.test/news", "https://site.test/ticker",
+                                               "https://site.test/new"};
+    EXPECT_EQ(scheduler.Schedule(10, now), expected);
+    EXPECT_EQ(scheduler.Schedule(2, now), std::vector<std::string>(expected.begin(), expected.begin() + 2));
+    EXPECT_EQ(scheduler.RevisitGain("https://site.test/about", now), 0.0);
+    EXPECT_LT(scheduler.RevisitGain("https://site.test/news", start + std::chrono::hours(24 * 10) + 1h),
+              scheduler.RevisitGain("https://site.test/news", now));
+
+    EXPECT_FALSE(scheduler.RecordContent("https://site.test/page", "hash-a", start));
+    EXPECT_FALSE(scheduler.RecordContent("https://site.test/page", "hash-a", start + 1h));
+    EXPECT_TRUE(scheduler.RecordContent("https://site.test/page", "hash-b", start + 2h));
+    UrlChangeHistory history;
+    ASSERT_TRUE(scheduler.GetHistory("https://site.test/page", history));
+    EXPECT_EQ(history.visits, 3u);
+    EXPECT_EQ(history.changes, 1u);
+
+    // State survives a restart; a damaged file leaves the loaded state alone
+    const auto path = std::filesystem::temp_directory_path() /
+                      ("recrawl_test_" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()));
+    ASSERT_TRUE(scheduler.Save(path));
+    RecrawlScheduler restored(options);
+    ASSERT_TRUE(restored.Load(path));
+    EXPECT_EQ(restored.Size(), scheduler.Size());
+    EXPECT_EQ(restored.Schedule(10, now), scheduler.Schedule(10, now));
+    EXPECT_TRUE(restored.RecordContent("https://site.test/page", "hash-c", start + 3h));
+
+    std::string data;
+    {
+        std::ifstream file(path, std::ios::binary);
+        data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+    data[data.size() / 2] ^= 0x5a;
+    {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file << data;
+    }
+    EXPECT_FALSE(restored.Load(path));
+    EXPECT_EQ(restored.Size(), scheduler.Size());
+    std::filesystem::remove(path);
+}
+
+TEST_F(ProactiveScrapingTest, DomainRulesFilterLinksByLabelAndPath) {
+    DomainMatcher matcher;
+    EXPECT_TRUE(matcher.Add("Example.com"));
+    EXPECT_TRUE(matcher.Add("*.cdn.test"));
+    EXPECT_TRUE(matcher.Add("https://shop.test:443/private"));
+    EXPECT_FALSE(matcher.Add("/just/a/path"));
+
+    EXPECT_TRUE(matcher.Matches("https://example.com"));
+    EXPECT_TRUE(matcher.Matches("http://user@WWW.example.COM.:8080/a?b#c"));
+    EXPECT_FALSE(matcher.Matches("https://notexample.com/"));
+    EXPECT_FALSE(matcher.Matches("https://example.com.evil.test/"));
+    EXPECT_FALSE(matcher.Matches("https://cdn.test/"));
+    EXPECT_TRUE(matcher.Matches("https://img.eu.cdn.test/logo.png"));
+    EXPECT_TRUE(matcher.Matches("https://shop.test/private/orders"));
+    EXPECT_TRUE(matcher.Matches("https://m.shop.test/private"));
+    EXPECT_FALSE(matcher.Matches("https://shop.test/public/private"));
+    EXPECT_FALSE(matcher.Matches("https://shop.test"));
+    EXPECT_TRUE(matcher.Matches("example.com/path"));
+    EXPECT_FALSE(matcher.Matches(""));
+
+    // A large block list still answers from a walk over the host's labels
+    std::vector<std::string> blocked;
+    for (int i = 0; i < 50000; ++i) {
+        blocked.push_back("ads" + std::to_string(i) + ".tracker.test");
+    }
+    blocked.push_back("*.spam.test");
+    DomainFilter filter({"site.test", "tracker.test", "spam.test"}, blocked);
+    EXPECT_TRUE(filter.IsAllowed("https://site.test/page"));
+    EXPECT_TRUE(filter.IsAllowed("https://tracker.test/"));
+    EXPECT_FALSE(filter.IsAllowed("https://ads49999.tracker.test/pixel"));
+    EXPECT_FALSE(filter.IsAllowed("https://x.ads7.tracker.test/"));
+    EXPECT_TRUE(filter.IsAllowed("https://spam.test/"));
+    EXPECT_FALSE(filter.IsAllowed("https://www.spam.test/"));
+    EXPECT_FALSE(filter.IsAllowed("https://other.test/"));
+    EXPECT_TRUE(DomainFilter({}, {"other.test"}).IsAllowed("https://site.test/"));
+
+    // Links outside the rules are never queued
+    CrawlOptions options;
+    options.worker_count = 2;
+    options.max_depth = 3;
+    options.allowed_domains = {"site.test"};
+    options.blocked_domains = {"site.test/admin"};
+    CrawlEngine engine(options);
+    std::mutex fetched_mutex;
+    std::set<std::string> fetched;
+    engine.Run({"https://site.test", "https://elsewhere.test"}, [&](const CrawlTask& task, size_t) {
+        {
+            std::lock_guard<std::mutex> lock(fetched_mutex);
+            fetched.insert(task.url);
+        }
+        if (task.depth > 0) return std::vector<std::string>{};
+        return std::vector<std::string>{"https://site.test/a", "https://blog.site.test/b", "https://site.test/admin/x",
+                                        "https://elsewhere.test/c"};
+    });
+    const std::set<std::string> expected = {"https://site.test", "https://site.test/a", "https://blog.site.test/b"};
+    EXPECT_EQ(fetched, expected);
+    EXPECT_EQ(engine.GetStats().filtered_links, 3u);
+}
+
+TEST_F(ProactiveScrapingTest, TrapDetectorPrunesInfiniteSpaces) {
+    EXPECT_EQ(UrlTemplate("https://site.test/events/2024-05-01?view=day&sid=9f#top"), "/events/{n}-{n}-{n}?sid&view");
+    EXPECT_EQ(UrlTemplate("https://site.test/item/0123456789abcdef0123/page2.html"), "/item/{id}/page{n}.html");
+    EXPECT_EQ(UrlTemplate("https://site.test"), "/");
+
+    TrapOptions options;
+    options.min_samples = 4;
+    options.max_template_urls = 10;
+    options.throttle_keep = 5;
+    TrapDetector detector(options);
+    std::vector<TrapReport> reports;
+    detector.SetReportCallback([&](const TrapReport& report) { reports.push_back(report); });
+
+    // Faceted listings keep producing URLs: throttled past the cap
+    size_t admitted = 0;
+    for (int i = 0; i < 60; ++i) {
+        admitted += detector.Admit("https://shop.test/list?color=" + std::to_string(i) + "&size=2");
+    }
+    EXPECT_EQ(admitted, 10u + 10u);
+    EXPECT_EQ(detector.GetAction("https://shop.test/list?size=1&color=x"), TrapAction::THROTTLE);
+    EXPECT_EQ(detector.GetAction("https://shop.test/list"), TrapAction::ADMIT);
+
+    // Pages that only repeat content are pruned once enough are judged
+    for (int i = 0; i < 21; ++i) {
+        detector.RecordContent("https://shop.test/list?color=" + std::to_string(i) + "&size=2", i == 0);
+        if (i == 19) {
+            EXPECT_EQ(detector.GetAction("https://shop.test/list?color=a&size=b"), TrapAction::THROTTLE);
+        }
+    }
+    EXPECT_EQ(detector.GetAction("https://shop.test/list?color=a&size=b"), TrapAction::PRUNE);
+    EXPECT_FALSE(detector.Admit("https://shop.test/list?color=100&size=2"));
+
+    // Looping relative links are pruned on sight, under one shared template
+    EXPECT_TRUE(detector.Admit("https://site.test/a/b/a/b"));
+    EXPECT_FALSE(detector.Admit("https://site.test/a/b/a/b/a/b"));
+    EXPECT_FALSE(detector.Admit("https://site.test/x/x/x/x"));
+
+    ASSERT_EQ(reports.size(), 3u);
+    EXPECT_EQ(reports[0].action, TrapAction::THROTTLE);
+    EXPECT_EQ(reports[0].host, "shop.test");
+    EXPECT_EQ(reports[0].url_template, "/list?color&size");
+    EXPECT_EQ(reports[1].action, TrapAction::PRUNE);
+    EXPECT_EQ(reports[1].judged, 21u);
+    EXPECT_EQ(reports[1].novel, 1u);
+    EXPECT_EQ(reports[2].host, "site.test");
+    EXPECT_EQ(detector.GetReports().size(), 3u);
+    EXPECT_EQ(detector.GetStats().pruned, 3u);
+
+    // Slugs collapse into {*} once a prefix has too many distinct segments,
+    // so a slug space is one template that can be throttled
+    TrapOptions slug_options;
+    slug_options.max_segment_values = 5;
+    slug_options.max_template_urls = 10;
+    slug_options.max_host_templates = 8;
+    TrapDetector slugs(slug_options);
+    std::vector<TrapReport> slug_reports;
+    slugs.SetReportCallback([&](const TrapReport& report) { slug_reports.push_back(report); });
+    for (int i = 0; i < 40; ++i) {
+        std::string slug = "story-";
+        slug += static_cast<char>('a' + i / 26);
+        slug += static_cast<char>('a' + i % 26);
+        slugs.Admit("https://blog.test/post/" + slug);
+    }
+    EXPECT_EQ(slugs.GetStats().templates, 5u + 1u);
+    EXPECT_EQ(slugs.GetAction("https://blog.test/post/another-story"), TrapAction::THROTTLE);
+    ASSERT_EQ(slug_reports.size(), 1u);
+    EXPECT_EQ(slug_reports[0].url_template, "/post/{*}");
+
+    // Templates per host are capped; the rest share one overflow pattern
+    for (int i = 0; i < 20; ++i) {
+        slugs.Admit("https://wide.test/search?" + std::string(1, static_cast<char>('a' + i)) + "=1");
+    }
+    EXPECT_EQ(slugs.GetStats().templates, 6u + 8u + 1u);
+    EXPECT_EQ(slugs.GetAction("https://wide.test/search?zz=1"), TrapAction::THROTTLE);
+
+    // An endless calendar stops draining the crawl once judged a trap
+    CrawlOptions crawl_options;
+    crawl_options.worker_count = 3;
+    crawl_options.max_depth = 100;
+    crawl_options.detect_traps = true;
+    crawl_options.trap_options.min_samples = 4;
+    CrawlEngine engine(crawl_options);
+    std::vector<TrapReport> crawl_reports;
+    engine.SetTrapCallback([&](const TrapReport& report) { crawl_reports.push_back(report); });
+    std::mutex fetched_mutex;
+    std::set<std::string> fetched;
+    engine.Run({"https://site.test/"}, [&](const CrawlTask& task, size_t) {
+        {
+            std::lock_guard<std::mutex> lock(fetched_mutex);
+            fetched.insert(task.url);
+        }
+        const std::string prefix = "https://site.test/calendar/";
+        if (task.url.rfind(prefix, 0) == 0) {
+            engine.RecordContentNovelty(task, false);
+            return std::vector<std::string>{prefix + std::to_string(std::stoi(task.url.substr(prefix.size())) + 1)};
+        }
+        engine.RecordContentNovelty(task, true);
+        std::vector<std::string> links = {prefix + "0"};
+        if (task.depth == 0) {
+            for (int i = 0; i < 5; ++i) links.push_back("https://site.test/article/" + std::to_string(i));
+        }
+        return links;
+    });
+
+    size_t calendar_pages = 0;
+    for (const auto& url : fetched) calendar_pages += url.find("/calendar/") != std::string::npos;
+    EXPECT_EQ(calendar_pages, 4u);
+    EXPECT_EQ(fetched.size(), 1u + 5u + 4u);
+    ASSERT_EQ(crawl_reports.size(), 1u);
+    EXPECT_EQ(crawl_reports[0].url_template, "/calendar/{n}");
+    EXPECT_EQ(crawl_reports[0].action, TrapAction::PRUNE);
+    EXPECT_EQ(engine.GetStats().traps.pruned, 1u);
+}
+
+TEST_F(ProactiveScrapingTest, SitemapAndRobotsSeedAndFilterTheCrawl) {
+    const std::string sitemap =
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        "<!-- generated <url> -->\n"
+        "<sm:urlset xmlns:sm=\"http://www.sitemaps.org/schemas/sitemap/0.9\">\n"
+        "  <sm:url><sm:loc>https://site.test/a?x=1&amp;y=2</sm:loc><sm:lastmod>2024-05-01</sm:lastmod>"
+        "<sm:priority>0.8</sm:priority></sm:url>\n"
+        "  <sm:url><sm:loc><![CDATA[https://site.test/b?<c>]]></sm:loc></sm:url>\n"
+        "  <sm:url><sm:loc> https://site.test/&#x63; </sm:loc></sm:url>\n"
+        "  <sm:url><sm:loc>https://site.test/f</sm:loc><image:image><image:loc>https://img.test/1.png</image:loc>"
+        "</image:image><image:loc>https://img.test/2.png</image:loc></sm:url>\n"
+        "</sm:urlset>\n";
+
+    // Fed a byte at a time, so every construct straddles chunk boundaries
+    std::vector<SitemapEntry> entries;
+    SitemapParser parser([&](const SitemapEntry& entry) {
+        entries.push_back(entry);
+        return true;
+    });
+    for (char c : sitemap) {
+        ASSERT_TRUE(parser.Feed(std::string_view(&c, 1)));
+    }
+    EXPECT_TRUE(parser.Finish());
+    ASSERT_EQ(entries.size(), 4u);
+    EXPECT_EQ(entries[0].url, "https://site.test/a?x=1&y=2");
+    EXPECT_EQ(entries[0].lastmod, "2024-05-01");
+    EXPECT_DOUBLE_EQ(entries[0].priority, 0.8);
+    EXPECT_EQ(entries[1].url, "https://site.test/b?<c>");
+    EXPECT_DOUBLE_EQ(entries[1].priority, -1.0);
+    EXPECT_EQ(entries[2].url, "https://site.test/c");
+    EXPECT_FALSE(entries[2].is_sitemap);
+    EXPECT_EQ(entries[3].url, "https://site.test/f");  // Image extension locs are not the page
+
+    // The same document gzipped decodes identically
+    std::string gzipped(compressBound(sitemap.size()) + 64, '\0');
+    z_stream stream{};
+    ASSERT_EQ(deflateInit2(&stream, Z_BEST_COMPRESSION, Z_DEFLATED, 16 + MAX_WBITS, 8, Z_DEFAULT_STRATEGY), Z_OK);
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(sitemap.data()));
+    stream.avail_in = static_cast<uInt>(sitemap.size());
+    stream.next_out = reinterpret_cast<Bytef*>(gzipped.data());
+    stream.avail_out = static_cast<uInt>(gzipped.size());
+    ASSERT_EQ(deflate(&stream, Z_FINISH), Z_STREAM_END);
+    gzipped.resize(stream.total_out);
+    deflateEnd(&stream);
+
+    std::vector<std::string> gzip_urls;
+    SitemapParser gzip_parser([&](const SitemapEntry& entry) {
+        gzip_urls.push_back(entry.url);
+        return true;
+    });
+    for (size_t i = 0; i < gzipped.size(); i += 7) {
+        ASSERT_TRUE(gzip_parser.Feed(std::string_view(gzipped).substr(i, 7)));
+    }
+    EXPECT_TRUE(gzip_parser.Finish());
+    EXPECT_EQ(gzip_urls, (std::vector<std::string>{entries[0].url, entries[1].url, entries[2].url, entries[3].url}));
+
+    SitemapParser truncated([](const SitemapEntry&) { return true; });
+    truncated.Feed(std::string_view(gzipped).substr(0, gzipped.size() / 2));
+    EXPECT_FALSE(truncated.Finish());
+
+    // Indexes are followed, each file fetched once, and max_urls caps the total
+    const std::map<std::string, std::string> files = {
+        {"https://site.test/sitemap.xml",
+         "<sitemapindex><sitemap><loc>https://site.test/pages.xml.gz</loc></sitemap>"
+         "<sitemap><loc>https://site.test/more.xml</loc></sitemap>"
+         "<sitemap><loc>https://site.test/sitemap.xml</loc></sitemap></sitemapindex>"},
+        {"https://site.test/pages.xml.gz", gzipped},
+        {"https://site.test/more.xml",
+         "<urlset><url><loc>https://site.test/d</loc></url><url><loc>https://site.test/e</loc></url></urlset>"},
+    };
+    std::map<std::string, int> fetches;
+    ChunkFetcher fetch = [&](const std::string& url, const std::function<bool(std::string_view)>& sink) {
+        ++fetches[url];
+        auto it = files.find(url);
+        if (it == files.end()) return false;
+        for (size_t i = 0; i < it->second.size(); i += 5) {
+            if (!sink(std::string_view(it->second).substr(i, 5))) break;
+        }
+        return true;
+    };
+    std::vector<std::string> collected;
+    auto collect = [&](const SitemapEntry& entry) { collected.push_back(entry.url); };
+    EXPECT_EQ(CollectSitemapUrls({"https://site.test/sitemap.xml", "https://missing.test/sitemap.xml"}, fetch, 100,
+                                 collect),
+              6u);
+    EXPECT_EQ(collected.back(), "https://site.test/e");
+    EXPECT_EQ(fetches["https://site.test/sitemap.xml"], 1);
+    EXPECT_EQ(fetches["https://missing.test/sitemap.xml"], 1);
+    collected.clear();
+    EXPECT_EQ(CollectSitemapUrls({"https://site.test/sitemap.xml"}, fetch, 4, collect), 4u);
+    EXPECT_EQ(collected.size(), 4u);
+
+    // Longest match wins, Allow wins ties, and the group naming us beats *
+    const std::string robots_txt =
+        "User-agent: *\n"
+        "Disallow: /\n"
+        "\n"
+        "User-agent: other-bot\n"
+        "User-agent: Chromium-Playwright\n"
+        "Disallow: /private\n"
+        "Allow: /private/open\n"
+        "Disallow: /*.pdf$\n"
+        "Allow: /tie\n"
+        "Disallow: /tie\n"
+        "Disallow: /search?*q=\n"
+        "Crawl-delay: 2.5\n"
+        "\n"
+        "Sitemap: https://site.test/sitemap.xml\n";
+    RobotsRules rules = RobotsRules::Parse(robots_txt, "chromium-playwright/1.0");
+    EXPECT_TRUE(rules.IsAllowed("/"));
+    EXPECT_FALSE(rules.IsAllowed("/private/notes"));
+    EXPECT_TRUE(rules.IsAllowed("/private/open/1"));
+    EXPECT_FALSE(rules.IsAllowed("/docs/a.pdf"));
+    EXPECT_TRUE(rules.IsAllowed("/docs/a.pdf?page=2"));
+    EXPECT_TRUE(rules.IsAllowed("/tie"));
+    EXPECT_FALSE(rules.IsAllowed("/search?lang=en&q=x"));
+    EXPECT_TRUE(rules.IsAllowed("/search?lang=en"));
+    EXPECT_EQ(rules.GetCrawlDelay(), std::chrono::milliseconds(2500));
+    EXPECT_EQ(rules.GetSitemaps(), std::vector<std::string>{"https://site.test/sitemap.xml"});
+
+    RobotsRules fallback = RobotsRules::Parse(robots_txt, "unknown-bot");
+    EXPECT_FALSE(fallback.IsAllowed("/anything"));
+    EXPECT_TRUE(fallback.IsAllowed("/robots.txt"));
+    EXPECT_TRUE(RobotsRules().IsAllowed("/anything"));
+
+    // One fetch per origin, however many workers ask at once
+    std::atomic<int> robots_fetches{0};
+    auto robots = std::make_shared<RobotsCache>(
+        [&](const std::string& url, std::string& body) {
+            ++robots_fetches;
+            if (url == "https://down.test/robots.txt") return RobotsFetchStatus::UNREACHABLE;
+            if (url != "https://site.test/robots.txt") return RobotsFetchStatus::UNAVAILABLE;
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            body = robots_txt;
+            return RobotsFetchStatus::OK;
+        },
+        "chromium-playwright");
+    EXPECT_EQ(UrlOrigin("HTTPS://Site.Test/a/b?c"), "https://site.test");
+    EXPECT_TRUE(robots->IsAllowed("/relative"));
+
+    CrawlOptions options;
+    options.worker_count = 4;
+    options.max_depth = 3;
+    CrawlEngine engine(options);
+    engine.SetRobotsCache(robots);
+    std::mutex mutex;
+    std::set<std::string> visited;
+    size_t pages = engine.Run({"https://site.test/private", "https://site.test/"}, [&](const CrawlTask& task, size_t) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            visited.insert(task.url);
+        }
+        if (task.url != "https://site.test/") return std::vector<std::string>{};
+        return std::vector<std::string>{"https://site.test/private/x", "https://site.test/private/open/y",
+                                        "https://site.test/doc.pdf", "https://other.test/private",
+                                        "https://down.test/page"};
+    });
+    // A missing robots.txt allows everything; an unreachable one nothing
+    EXPECT_EQ(pages, 3u);
+    EXPECT_EQ(visited, (std::set<std::string>{"https://site.test/", "https://site.test/private/open/y",
+                                              "https://other.test/private"}));
+    EXPECT_EQ(engine.GetStats().robots_blocked, 4u);
+    EXPECT_EQ(robots_fetches.load(), 3);
+    EXPECT_EQ(robots->Size(), 3u);
+    EXPECT_EQ(robots->GetFetchCount(), 3u);
+    EXPECT_EQ(RobotsFetchStatusForHttp(200), RobotsFetchStatus::OK);
+    EXPECT_EQ(RobotsFetchStatusForHttp(404), RobotsFetchStatus::UNAVAILABLE);
+    EXPECT_EQ(RobotsFetchStatusForHttp(429), RobotsFetchStatus::UNREACHABLE);
+    EXPECT_EQ(RobotsFetchStatusForHttp(503), RobotsFetchStatus::UNREACHABLE);
+    EXPECT_EQ(RobotsFetchStatusForHttp(0), RobotsFetchStatus::UNREACHABLE);
+
+    // Unreachable origins are retried after unreachable_ttl, not the full ttl;
+    // a throwing fetcher counts as unreachable
+    RobotsCacheOptions retry_options;
+    retry_options.unreachable_ttl = std::chrono::seconds(0);
+    bool server_up = false;
+    RobotsCache retrying(
+        [&](const std::string&, std::string&) {
+            if (!server_up) throw std::runtime_error("connection refused");
+            return RobotsFetchStatus::UNAVAILABLE;
+        },
+        "chromium-playwright", retry_options);
+    EXPECT_FALSE(retrying.IsAllowed("https://flaky.test/a"));
+    server_up = true;
+    EXPECT_TRUE(retrying.IsAllowed("https://flaky.test/a"));
+    EXPECT_TRUE(retrying.IsAllowed("https://flaky.test/b"));
+    EXPECT_EQ(retrying.GetFetchCount(), 2u);
+
+    // A link refused while its origin was unreachable is not marked visited,
+    // so finding it again once robots.txt is back gets it crawled
+    std::map<std::string, int> recovering_fetches;
+    auto recovering = std::make_shared<RobotsCache>(
+        [&](const std::string& url, std::string&) {
+            if (++recovering_fetches[url] == 1 && url == "https://b.test/robots.txt") {
+                return RobotsFetchStatus::UNREACHABLE;
+            }
+            return RobotsFetchStatus::UNAVAILABLE;
+        },
+        "chromium-playwright", retry_options);
+    CrawlOptions recovery_options;
+    recovery_options.worker_count = 1;
+    recovery_options.max_depth = 3;
+    CrawlEngine recovery_engine(recovery_options);
+    recovery_engine.SetRobotsCache(recovering);
+    std::vector<std::string> recovery_order;
+    recovery_engine.Run({"https://a.test/"}, [&](const CrawlTask& task, size_t) {
+        recovery_order.push_back(task.url);
+        if (task.url == "https://a.test/") return std::vector<std::string>{"https://b.test/x", "https://a.test/2"};
+        if (task.url == "https://a.test/2") return std::vector<std::string>{"https://b.test/x"};
+        return std::vector<std::string>{};
+    });
+    EXPECT_EQ(recovery_order,
+              (std::vector<std::string>{"https://a.test/", "https://a.test/2", "https://b.test/x"}));
+    EXPECT_EQ(recovery_engine.GetStats().robots_blocked, 1u);
+    EXPECT_EQ(recovering_fetches["https://b.test/robots.txt"], 2);
+
+    // Crawl-delay spaces fetches from its host under HOST_PRIORITY
+    auto delayed = std::make_shared<RobotsCache>(
+        [](const std::string&, std::string& body) {
+            body = "User-agent: *\nCrawl-delay: 0.1\n";
+            return RobotsFetchStatus::OK;
+        },
+        "chromium-playwright");
+    CrawlOptions polite_options;
+    polite_options.worker_count = 2;
+    polite_options.max_depth = 2;
+    polite_options.frontier_policy = FrontierPolicy::HOST_PRIORITY;
+    CrawlEngine polite_engine(polite_options);
+    polite_engine.SetRobotsCache(delayed);
+    std::vector<std::chrono::steady_clock::time_point> fetch_times;
+    polite_engine.Run({"https://slow.test/"}, [&](const CrawlTask& task, size_t) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            fetch_times.push_back(std::chrono::steady_clock::now());
+        }
+        if (task.depth > 0) return std::vector<std::string>{};
+        return std::vector<std::string>{"https://slow.test/a", "https://slow.test/b"};
+    });
+    ASSERT_EQ(fetch_times.size(), 3u);
+    EXPECT_GE(fetch_times[2] - fetch_times[1], std::chrono::milliseconds(90));
+
+    const DiscoveryOptions discovery = ParseDiscoverySettings(
+        {{"crawl.sitemaps", "true"}, {"crawl.sitemap_max_urls", "12"}, {"crawl.robots", "yes?"}, {"other", "1"}});
+    EXPECT_TRUE(discovery.use_sitemaps);
+    EXPECT_EQ(discovery.sitemap_max_urls, 12u);
+    EXPECT_FALSE(discovery.respect_robots);
+    EXPECT_EQ(discovery.user_agent, "chromium-playwright");
+}